@@ -7,10 +7,12 @@ import { SimulationParamsViewer } from "@/components/load-simulation-modal";
 import { SaveSimulationModal } from "@/components/save-simulation-modal";
 import { FolderNameModal } from "@/components/folder-name-modal";
 import { useToast } from "@/components/ui/use-toast"
+import { withResult, type ResultModule } from "@/lib/wasm-results";
 
 // Define global function types that will be called from WASM
 declare global {
   function storeCsvData(jsonData: string): Promise<void>;
+  function storeResultBuffer(name: string): Promise<void>;
   function storeTextData(data: string): Promise<void>;
   function viewStorageFiles(): void;
   function loadTextData(): Promise<string>;
@@ -127,6 +129,57 @@ export default function ProtectedPage() {
       }
     };
 
+    // Uploads a result buffer straight from the WASM heap, as raw float64 columns and a JSON
+    // description of them, without turning it into text
+    window.storeResultBuffer = async (name: string) => {
+      try {
+        const module = (iframeRef.current?.contentWindow as unknown as { Module?: ResultModule })?.Module;
+        if (!module) {
+          throw new Error('The simulation is not loaded');
+        }
+
+        const folderName = await new Promise<string>((resolve) => {
+          setResolveFolderName(() => resolve);
+          setIsFolderNameModalOpen(true);
+        });
+        if (!folderName) {
+          return;
+        }
+
+        const supabase = createClient();
+        const uploaded = await withResult(module, name, async ({ info, data }) => {
+          // Copied out before the first await, while the view is current. The heap is shared with
+          // the app's threads and a Blob does not take shared memory.
+          const values = new Blob([data().slice()], { type: 'application/octet-stream' });
+          const description = new Blob([JSON.stringify({ rows: info.rows, columns: info.columns, layout: 'column-major float64' })], { type: 'application/json' });
+
+          const results = await Promise.all([
+            supabase.storage.from('simulation-results').upload(`${folderName}/${name}.f64`, values),
+            supabase.storage.from('simulation-results').upload(`${folderName}/${name}.json`, description),
+          ]);
+          const failed = results.find((result) => result.error);
+          if (failed) {
+            throw failed.error;
+          }
+          return true;
+        });
+
+        if (!uploaded) {
+          throw new Error(`No result buffer named ${name}`);
+        }
+        toast({
+          description: "Results uploaded successfully",
+          variant: "success",
+        });
+      } catch (error) {
+        console.error('Error in storeResultBuffer:', error);
+        toast({
+          description: "Failed to upload results",
+          variant: "destructive",
+        });
+      }
+    };
+
     // Handles storing simulation parameters to Supabase database
     window.storeTextData = async (data: string) => {
       try {
@@ -0,0 +1,356 @@
+/**
+*** Headless flowsheet solver. Loads a flowsheet saved by the editor, solves it and writes
+*** the results, without any windowing or graphics dependencies.
+**/
+
+#include "FlowsheetIO.h"
+#include "FlowsheetSolver.h"
+#include "EquationOrientedSolver.h"
+#include "CaseStudy.h"
+#include "Benchmarks.h"
+#include "ResultFile.h"
+
+// STL Includes
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: thermatix_batch <flowsheet.json|flowsheet.thxf> [options]\n"
+            "  -o, --output <file>            Write the results to a file instead of stdout\n"
+            "  --set <unit>.<parameter>=<v>   Override a unit parameter, may be repeated\n"
+            "  --sweep <unit>.<parameter>=<first>:<last>:<points>\n"
+            "                                 Run a case study over this range, may be repeated\n"
+            "  --monitor <unit>.<parameter>   Variable reported for every case, may be repeated\n"
+            "  --eo                           Use the equation-oriented solver\n"
+            "  --threads <n>                  Worker threads of the solver or the case study\n"
+            "  --binary                       Write the case study as a columnar binary result file (needs -o)\n"
+            "  --convert <results> <csv|json> Convert a binary result file to text and exit\n"
+            "  --snapshot <file>              Write the flowsheet, with any --set applied, as a binary snapshot and exit\n"
+            "  --benchmark                    Run the Jacobian, property, isotherm, kernel, column, cycle, multi-bed, plot, result file, flowsheet file, hit-test and undo benchmarks and exit\n";
+    }
+
+    bool ReadFile(const std::string& path, std::string& text)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        text = buffer.str();
+        return true;
+    }
+
+    // "<unit>.<parameter>". Unit names may contain dots, parameters usually do not, so the last
+    // dot separates them.
+    bool ParseVariable(const std::string& text, VariableRef& variable)
+    {
+        size_t dot = text.rfind('.');
+        if (dot == std::string::npos || dot == 0 || dot + 1 == text.size()) return false;
+        variable.unit = text.substr(0, dot);
+        variable.parameter = text.substr(dot + 1);
+        return true;
+    }
+
+    bool ParseNumber(const std::string& text, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        return end != text.c_str() && *end == '\0';
+    }
+
+    // "<unit>.<parameter>=<value>"
+    bool ApplyOverride(Flowsheet& flowsheet, const std::string& assignment)
+    {
+        size_t equals = assignment.find('=');
+        VariableRef ref;
+        double value = 0.0;
+        if (equals == std::string::npos || !ParseVariable(assignment.substr(0, equals), ref) || !ParseNumber(assignment.substr(equals + 1), value))
+            return false;
+
+        DoubleDataVariable* variable = flowsheet.FindVariable(ref.unit, ref.parameter);
+        if (!variable) return false;
+
+        variable->value = value;
+        return true;
+    }
+
+    // "<unit>.<parameter>=<first>:<last>:<points>"
+    bool ParseSweep(const std::string& text, SweepRange& range)
+    {
+        size_t equals = text.find('=');
+        if (equals == std::string::npos || !ParseVariable(text.substr(0, equals), range.variable)) return false;
+
+        std::string bounds = text.substr(equals + 1);
+        size_t colon1 = bounds.find(':');
+        size_t colon2 = colon1 == std::string::npos ? std::string::npos : bounds.find(':', colon1 + 1);
+        if (colon2 == std::string::npos) return false;
+
+        double points = 0.0;
+        if (!ParseNumber(bounds.substr(0, colon1), range.first) ||
+            !ParseNumber(bounds.substr(colon1 + 1, colon2 - colon1 - 1), range.last) ||
+            !ParseNumber(bounds.substr(colon2 + 1), points) || points < 1.0)
+            return false;
+
+        range.numPoints = static_cast<int>(points);
+        return true;
+    }
+
+    // Case number, the swept variables, the monitored variables, converged and iterations
+    std::vector<std::string> GetCaseColumns(const CaseStudy& study)
+    {
+        std::vector<std::string> columns{ "case" };
+        for (const auto& range : study.ranges) columns.push_back(range.variable.unit + "." + range.variable.parameter);
+        for (const auto& output : study.outputs) columns.push_back(output.unit + "." + output.parameter);
+        columns.push_back("converged");
+        columns.push_back("iterations");
+        return columns;
+    }
+
+    void GetCaseRow(const CaseStudy& study, const CaseResult& result, std::vector<double>& row)
+    {
+        row.assign(1, result.index);
+        row.insert(row.end(), result.inputs.begin(), result.inputs.end());
+        row.insert(row.end(), result.outputs.begin(), result.outputs.end());
+        row.push_back(result.report.converged ? 1.0 : 0.0);
+        row.push_back(study.useEquationOriented ? result.report.newtonIterations : result.report.maxRecycleIterations);
+    }
+
+    int ReportCaseStudy(const CaseStudyReport& summary)
+    {
+        std::cerr << summary.message << " in " << summary.seconds << " s on " << summary.numWorkers << " worker(s), "
+            << summary.numWarmStarted << " warm started, " << summary.numSteals << " steals\n";
+        return summary.numCases > 0 && summary.numConverged == summary.numCases ? 0 : 1;
+    }
+
+    // Streams one CSV row per case as the cases finish
+    int RunCaseStudy(const Flowsheet& flowsheet, const NodeFactory& factory, CaseStudy& study, std::ostream& out)
+    {
+        const std::vector<std::string> columns = GetCaseColumns(study);
+        for (size_t j = 0; j < columns.size(); ++j) out << (j > 0 ? "," : "") << columns[j];
+        out << "\n";
+        out.precision(10);
+
+        std::vector<double> row;
+        CaseStudyReport summary = study.Run(flowsheet, factory, [&](const CaseResult& result) {
+            GetCaseRow(study, result, row);
+            for (size_t j = 0; j < row.size(); ++j) out << (j > 0 ? "," : "") << row[j];
+            out << "\n";
+            out.flush();
+        });
+        return ReportCaseStudy(summary);
+    }
+
+    // Streams the cases into a result file as they finish, keyed by case number
+    int RunCaseStudyBinary(const Flowsheet& flowsheet, const NodeFactory& factory, CaseStudy& study, const std::string& path)
+    {
+        std::vector<ResultColumn> columns;
+        for (const auto& name : GetCaseColumns(study)) columns.push_back({ name, "", ResultType::Float64 });
+
+        std::string message;
+        ResultWriter writer;
+        if (!writer.Open(path, columns, message, 1024)) {
+            std::cerr << message << "\n";
+            return 2;
+        }
+
+        std::vector<double> row;
+        CaseStudyReport summary = study.Run(flowsheet, factory, [&](const CaseResult& result) {
+            GetCaseRow(study, result, row);
+            writer.Append(row.data());
+        });
+
+        if (!writer.Close(message)) {
+            std::cerr << path << ": " << message << "\n";
+            return 2;
+        }
+        return ReportCaseStudy(summary);
+    }
+
+    // Binary result file to CSV or JSON
+    int ConvertResults(const std::string& path, const std::string& format, const std::string& outputPath)
+    {
+        if (format != "csv" && format != "json") {
+            std::cerr << "Unknown format " << format << ", use csv or json\n";
+            return 2;
+        }
+
+        std::string message;
+        ResultReader reader;
+        if (!reader.Open(path, message)) {
+            std::cerr << message << "\n";
+            return 2;
+        }
+
+        std::ofstream file;
+        if (!outputPath.empty()) {
+            file.open(outputPath, std::ios::binary);
+            if (!file) {
+                std::cerr << "Cannot write " << outputPath << "\n";
+                return 2;
+            }
+        }
+        std::ostream& out = outputPath.empty() ? std::cout : file;
+        if (format == "csv") ExportCsv(reader, out);
+        else ExportJson(reader, out);
+        return out ? 0 : 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string inputPath, outputPath, convertPath, convertFormat, snapshotPath;
+    std::vector<std::string> overrides;
+    CaseStudy study;
+    bool useEquationOriented = false;
+    bool binary = false;
+    size_t numThreads = ThreadPool::DefaultThreadCount();
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--set" && i + 1 < argc) {
+            overrides.push_back(argv[++i]);
+        }
+        else if (arg == "--sweep" && i + 1 < argc) {
+            SweepRange range;
+            if (!ParseSweep(argv[++i], range)) {
+                std::cerr << "Invalid --sweep " << argv[i] << "\n";
+                return 2;
+            }
+            study.ranges.push_back(range);
+        }
+        else if (arg == "--monitor" && i + 1 < argc) {
+            VariableRef variable;
+            if (!ParseVariable(argv[++i], variable)) {
+                std::cerr << "Invalid --monitor " << argv[i] << "\n";
+                return 2;
+            }
+            study.outputs.push_back(variable);
+        }
+        else if (arg == "--eo") {
+            useEquationOriented = true;
+        }
+        else if (arg == "--binary") {
+            binary = true;
+        }
+        else if (arg == "--convert" && i + 2 < argc) {
+            convertPath = argv[++i];
+            convertFormat = argv[++i];
+        }
+        else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            numThreads = static_cast<size_t>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--benchmark") {
+            std::cout << RunJacobianBenchmark() << "\n" << RunPropertyBenchmark() << "\n" << RunIsothermBenchmark() << "\n" << RunKernelBenchmark() << "\n" << RunColumnBenchmark() << "\n" << RunCycleBenchmark() << "\n" << RunMultiBedBenchmark() << "\n" << RunPlotBenchmark() << "\n" << RunResultFileBenchmark() << "\n" << RunFlowsheetIOBenchmark() << "\n" << RunHitTestBenchmark() << "\n" << RunUndoBenchmark();
+            return 0;
+        }
+        else if (arg == "-h" || arg == "--help") {
+            PrintUsage();
+            return 0;
+        }
+        else if (inputPath.empty() && arg[0] != '-') {
+            inputPath = arg;
+        }
+        else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (!convertPath.empty())
+        return ConvertResults(convertPath, convertFormat, outputPath);
+
+    if (inputPath.empty()) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::string text, error;
+    if (!ReadFile(inputPath, text)) {
+        std::cerr << "Cannot read " << inputPath << "\n";
+        return 2;
+    }
+
+    NodeFactory factory;
+    Flowsheet flowsheet;
+    const bool loaded = IsFlowsheetSnapshot(text) ? LoadFlowsheetSnapshot(text, factory, flowsheet, error) : LoadFlowsheet(text, factory, flowsheet, error);
+    if (!loaded) {
+        std::cerr << inputPath << ": " << error << "\n";
+        return 2;
+    }
+
+    for (const auto& assignment : overrides) {
+        if (!ApplyOverride(flowsheet, assignment)) {
+            std::cerr << "Invalid --set " << assignment << "\n";
+            return 2;
+        }
+    }
+
+    if (!snapshotPath.empty()) {
+        std::ofstream file(snapshotPath, std::ios::binary);
+        if (!(file << SaveFlowsheetSnapshot(flowsheet))) {
+            std::cerr << "Cannot write " << snapshotPath << "\n";
+            return 2;
+        }
+        return 0;
+    }
+
+    if (!study.ranges.empty()) {
+        study.useEquationOriented = useEquationOriented;
+        study.numWorkers = numThreads;
+        if (outputPath.empty()) {
+            if (binary) {
+                std::cerr << "--binary needs an output file\n";
+                return 2;
+            }
+            return RunCaseStudy(flowsheet, factory, study, std::cout);
+        }
+        if (binary)
+            return RunCaseStudyBinary(flowsheet, factory, study, outputPath);
+
+        std::ofstream file(outputPath, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot write " << outputPath << "\n";
+            return 2;
+        }
+        return RunCaseStudy(flowsheet, factory, study, file);
+    }
+
+    SolveReport report;
+    if (useEquationOriented) {
+        EquationOrientedSolver solver;
+        report = solver.Solve(flowsheet.nodes, flowsheet.connections);
+    }
+    else {
+        FlowsheetSolver solver(numThreads);
+        report = solver.Solve(flowsheet.nodes, flowsheet.connections);
+    }
+
+    std::string results = SaveResults(flowsheet, report);
+    if (outputPath.empty()) {
+        std::cout << results << "\n";
+    }
+    else {
+        std::ofstream file(outputPath, std::ios::binary);
+        if (!(file << results << "\n")) {
+            std::cerr << "Cannot write " << outputPath << "\n";
+            return 2;
+        }
+    }
+
+    std::cerr << report.message << "\n";
+    return report.converged ? 0 : 1;
+}
@@ -4,6 +4,7 @@
 **/
 
 #include "DragAndDrop.h"
+#include "AdsorptionWindows.h"
 #include "MenuBar.h"
 
 // ImGui Includes
@@ -65,6 +66,12 @@ void InitializeImGuiFonts()
     //Fonts::fontLarge = io.Fonts->AddFontFromFileTTF("assets/fonts/DroidSans.ttf", 36.0f);
 }
 
+static AdsorptionWorkspace& GetAdsorptionWorkspace()
+{
+    static AdsorptionWorkspace workspace;
+    return workspace;
+}
+
 HelloImGui::DockingParams CreateDefaultLayout()
 {
     HelloImGui::DockingParams dockingParams;
@@ -73,13 +80,13 @@ HelloImGui::DockingParams CreateDefaultLayout()
     // Now assign your windows to either "LeftSpace", "MainDockSpace" (the middle), or "RightSpace".
     dockingParams.dockableWindows = {
         // Left column:
-        { "Adsorption Model",               "LeftSpace",         []() {}, false, true },
+        { "Adsorption Model",               "LeftSpace",         []() { GetAdsorptionWorkspace().ShowAdsorptionModel(); }, false, true },
 
         // Middle column ("MainDockSpace" is now the center):
-        { "Reactor Properties",             "MainDockSpace",     []() {}, false, true },
+        { "Reactor Properties",             "MainDockSpace",     []() { GetAdsorptionWorkspace().ShowReactorProperties(); }, false, true },
 
         // Right column:
-        { "Results",                        "RightSpace",        []() {}, false, true }
+        { "Results",                        "RightSpace",        []() { GetAdsorptionWorkspace().ShowResults(); }, false, true }
     };
 
     return dockingParams;
@@ -114,6 +121,7 @@ int main(int , char *[])
     params.imGuiWindowParams.showMenu_App = false;
     params.imGuiWindowParams.showMenu_View = false;
     params.callbacks.ShowMenus = []() { ShowMainMenuBar(); };
+    FramePacing::Get().Configure(params);
 
     HelloImGui::SetAssetsFolder("C:/Users/samaf/Documents/Thermatix/gui/assets/");
 
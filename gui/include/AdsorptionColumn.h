@@ -0,0 +1,166 @@
+#pragma once
+
+#include "ComponentDatabase.h"
+#include "Isotherm.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <functional>
+
+struct ColumnProperties {
+    double length = 1.0;                    // [m]
+    double diameter = 0.2;                  // [m]
+    double bedVoidage = 0.37;               // Interparticle [-]
+    double particleDiameter = 2e-3;         // [m]
+    double bulkDensity = 700.0;             // Adsorbent mass per bed volume [kg/m3]
+    double solidHeatCapacity = 920.0;       // [J/kg/K]
+    double axialDispersion = 1e-4;          // [m2/s]
+    double thermalConductivity = 0.1;       // Axial, effective [W/m/K]
+    double wallHeatTransferCoefficient = 10.0; // Bed to ambient [W/m2/K]
+    double ambientTemperature = 298.15;     // [K]
+    double gasViscosity = 1.7e-5;           // [Pa s]
+};
+
+// Gas through one end of the column at an instant, per unit bed cross section. Fluxes follow the
+// sign convention of ColumnFlows.
+struct ColumnStreamSample {
+    double time = 0.0;                      // Since the start of the integration [s]
+    double temperature = 0.0;               // Of the end cell [K]
+    std::vector<double> flux;               // [component] [mol/m2/s]
+};
+
+// Condition at one end of the column. Flow ends impose the superficial velocity in +z, pressure
+// ends take the velocity from the Ergun equation across the half cell at the boundary. Gas
+// entering the bed has the boundary composition and temperature. Stream ends replay recorded
+// samples, usually the outflow of another bed, as the molar flux entering the bed, interpolated
+// linearly in time.
+//
+// With a ramp time, a pressure end relaxes exponentially from the bed pressure at the start of
+// the integration to its set point, like a valve opening, rather than stepping at once.
+struct ColumnBoundary {
+    enum class Type { Closed, Flow, Pressure, Stream };
+
+    Type type = Type::Closed;
+    double velocity = 0.0;                  // [m/s]
+    double pressure = 1.0;                  // [bar]
+    double rampTime = 0.0;                  // [s]
+    double temperature = 298.15;            // [K]
+    std::vector<double> moleFraction;
+    std::vector<ColumnStreamSample> stream; // Ordered by time, fluxes entering the bed
+
+    static ColumnBoundary Closed() { return ColumnBoundary(); }
+    static ColumnBoundary Flow(double velocity, double temperature, const std::vector<double>& moleFraction);
+    static ColumnBoundary Pressure(double pressure, double temperature, const std::vector<double>& moleFraction, double rampTime = 0.0);
+    static ColumnBoundary Stream(const std::vector<ColumnStreamSample>& stream);
+};
+
+struct ColumnIntegratorSettings {
+    int numCells = 200;
+    double relativeTolerance = 1e-4;
+    double absoluteTolerance = 1e-6;        // On mole fractions, and relative to the capacity and temperature
+    double initialStep = 1e-3;              // [s]
+    double maxStep = 50.0;                  // [s]
+    int maxSteps = 200000;
+};
+
+struct ColumnStatistics {
+    int numSteps = 0;
+    int numRejectedSteps = 0;
+    int numNewtonIterations = 0;
+    int numJacobians = 0;
+    int numFactorizations = 0;
+    double seconds = 0.0;
+};
+
+// Amount of each component through the ends of the column, in +z and per unit bed cross section
+// [mol/m2]. Positive inlet amounts enter the bed, positive outlet amounts leave it.
+struct ColumnFlows {
+    std::vector<double> inlet;
+    std::vector<double> outlet;
+
+    // With record set, the end streams at the start and after every accepted step are appended
+    bool record = false;
+    std::vector<ColumnStreamSample> inletStream, outletStream;
+};
+
+// Axial profiles, one value per cell
+struct ColumnProfile {
+    std::vector<double> position;                       // Cell centres [m]
+    std::vector<std::vector<double>> moleFraction;      // [component][cell]
+    std::vector<std::vector<double>> loading;           // [component][cell] [mol/kg]
+    std::vector<double> temperature;                    // [K]
+    std::vector<double> pressure;                       // [bar]
+};
+
+struct BreakthroughResult {
+    std::vector<double> time;                           // [s]
+    std::vector<std::vector<double>> outletMoleFraction; // [component][sample]
+    std::vector<double> outletTemperature;              // [K]
+    std::vector<double> pressureDrop;                   // Inlet cell to outlet [bar]
+    ColumnProfile finalProfile;
+    ColumnStatistics statistics;
+
+    bool completed = false;
+    std::string message;
+};
+
+// One dimensional, axially dispersed, non-isothermal fixed bed. Gas composition, adsorbed
+// loadings and the bed temperature are discretised by the method of lines on uniform cells with
+// upwind convection. The superficial velocity at each face follows from the Ergun equation across
+// it, which closes the momentum balance without a velocity state.
+//
+// Every cell only couples to its neighbours, so the Jacobian is block tridiagonal. It is built
+// exactly with Dual numbers, seeding every third cell at once, and factorized by block
+// elimination. The isotherm is evaluated for all cells in one batch, and its analytic
+// derivatives carry the Dual tangents rather than differentiating it again for every seed.
+// Time integration is variable step BDF2 with a modified Newton iteration that reuses the
+// Jacobian and its factorization across steps while they keep converging.
+//
+// The state vector holds one block per cell: pressure [bar], the mole fractions of all but the
+// last component, the loadings [mol/kg] and the temperature [K].
+class AdsorptionColumn {
+public:
+    AdsorptionColumn();
+
+    // Returns false and sets message if a component is unknown or a property is out of range
+    bool Validate(std::string& message) const;
+
+    size_t GetNumComponents() const { return adsorbates.size(); }
+    size_t GetBlockSize() const { return 2 * adsorbates.size() + 1; }
+
+    // Bed filled with gas of the given composition and loadings in equilibrium with it
+    std::vector<double> GetEquilibriumState(const std::vector<double>& moleFraction, double pressure, double temperature) const;
+    ColumnProfile GetProfile(const std::vector<double>& state) const;
+
+    // Moles of each component held in the gas and on the adsorbent per unit cross section [mol/m2]
+    std::vector<double> GetInventory(const std::vector<double>& state) const;
+
+    // Advances state by duration with the given end conditions. observer is called after every
+    // accepted step with the time since the start and returns false to stop early. The amounts
+    // through the ends are added to flows if given. Returns false and sets message if the
+    // integrator fails.
+    using StepObserver = std::function<bool(double time, const std::vector<double>& state)>;
+    bool Integrate(std::vector<double>& state, double duration, const ColumnBoundary& inlet, const ColumnBoundary& outlet,
+        ColumnStatistics& statistics, std::string& message, const StepObserver& observer = nullptr, ColumnFlows* flows = nullptr) const;
+
+    // Feed at the inlet and fixed pressure at the outlet, starting from a bed equilibrated with
+    // initialMoleFraction at the outlet pressure. observer gets the result so far after every
+    // sample and returns false to stop.
+    using BreakthroughObserver = std::function<bool(const BreakthroughResult& partial)>;
+    BreakthroughResult RunBreakthrough(const BreakthroughObserver& observer = nullptr) const;
+
+    // Configuration
+    IsothermModel isotherm = IsothermModel::ExtendedLangmuir;
+    std::vector<AdsorbateProperties> adsorbates;
+    ColumnProperties column;
+    ColumnIntegratorSettings integrator;
+
+    // Breakthrough run
+    std::vector<double> feedMoleFraction;
+    double feedVelocity = 0.1;              // Superficial [m/s]
+    double feedTemperature = 298.15;        // [K]
+    double outletPressure = 1.0;            // [bar]
+    std::vector<double> initialMoleFraction;
+    double duration = 5000.0;               // [s]
+};
@@ -0,0 +1,907 @@
+#pragma once
+
+#include "AdsorptionColumn.h"
+#include "PsaCycle.h"
+#include "MultiBedPsa.h"
+#include "Decimation.h"
+#include "SeriesStream.h"
+#include "ResultFile.h"
+#include "ResultBuffers.h"
+#include "ComponentDatabase.h"
+#include "DragAndDrop.h"
+#include "FramePacing.h"
+
+// ImGui Includes
+#include "hello_imgui/hello_imgui.h"
+
+// ImPlot Includes
+#include "implot.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+
+// The studies run on a worker thread so Stop, the progress and the live plots stay responsive.
+// Running one on the page's main thread would freeze the tab until it ends.
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+#error "The editor needs pthreads in the browser, link with -pthread (see CMakeLists.txt)"
+#endif
+
+
+// Label, input and unit in one row, like ShowIntInput in DragAndDrop.h
+static bool ShowValueInput(double& val, const std::string& label, const std::string& unit, const char* format = "%.4g")
+{
+    bool changed = false;
+
+    if (ImGui::BeginTable("##table", 3, ImGuiTableFlags_SizingStretchSame))
+    {
+        ImGui::PushID(label.c_str());
+
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(label.c_str());
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+        changed = ImGui::InputDouble("##input", &val, 0.0, 0.0, format);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(unit.c_str());
+
+        ImGui::PopID();
+        ImGui::EndTable();
+    }
+
+    return changed;
+}
+
+
+// Breakthrough and cyclic steady state studies behind the "Adsorption Model", "Reactor
+// Properties" and "Results" windows. The column is integrated on a worker thread from a copy of
+// the inputs, so they stay editable while it runs and the frame rate does not depend on the solver.
+class AdsorptionWorkspace {
+public:
+    ~AdsorptionWorkspace()
+    {
+        cancel = true;
+        if (worker.joinable()) worker.join();
+    }
+
+    // Isotherms, kinetics and gas compositions
+    void ShowAdsorptionModel()
+    {
+        auto& adsorbates = column.adsorbates;
+        const auto& database = GetComponentDatabase();
+
+        ImGui::SeparatorText("Isotherm");
+
+        ImGui::SetNextItemWidth(200.0f);
+        if (ImGui::BeginCombo("Model", Isotherm::GetName(column.isotherm)))
+        {
+            for (IsothermModel model : { IsothermModel::Langmuir, IsothermModel::ExtendedLangmuir, IsothermModel::DualSiteLangmuir,
+                                         IsothermModel::Sips, IsothermModel::Toth })
+            {
+                if (ImGui::Selectable(Isotherm::GetName(model), model == column.isotherm))
+                    column.isotherm = model;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::TextWrapped("%s", GetIsothermHelp(column.isotherm));
+
+        ImGui::SeparatorText("Components");
+
+        // Second site and exponent columns only for the models that use them
+        const bool dualSite = column.isotherm == IsothermModel::DualSiteLangmuir;
+        const bool exponent = column.isotherm == IsothermModel::Sips || column.isotherm == IsothermModel::Toth;
+        const int numColumns = 9 + (dualSite ? 3 : 0) + (exponent ? 1 : 0);
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_ScrollX;
+        if (ImGui::BeginTable("##Adsorbates", numColumns, flags))
+        {
+            ImGui::TableSetupColumn("Component", ImGuiTableColumnFlags_WidthFixed, 130.0f);
+            ImGui::TableSetupColumn("qs [mol/kg]");
+            ImGui::TableSetupColumn("b0 [1/bar]");
+            ImGui::TableSetupColumn("dH [kJ/mol]");
+            if (dualSite)
+            {
+                ImGui::TableSetupColumn("qs2 [mol/kg]");
+                ImGui::TableSetupColumn("b02 [1/bar]");
+                ImGui::TableSetupColumn("dH2 [kJ/mol]");
+            }
+            if (exponent)
+                ImGui::TableSetupColumn(column.isotherm == IsothermModel::Sips ? "n [-]" : "t [-]");
+            ImGui::TableSetupColumn("k [1/s]");
+            ImGui::TableSetupColumn("Feed y");
+            ImGui::TableSetupColumn("Initial y");
+            ImGui::TableSetupColumn("Light product y");
+            ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 24.0f);
+            ImGui::TableHeadersRow();
+
+            int removeIndex = -1;
+            for (size_t i = 0; i < adsorbates.size(); ++i)
+            {
+                auto& adsorbate = adsorbates[i];
+                ImGui::PushID(static_cast<int>(i));
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                ImGui::SetNextItemWidth(-FLT_MIN);
+                if (ImGui::BeginCombo("##component", adsorbate.component.c_str()))
+                {
+                    for (const auto& component : database)
+                    {
+                        if (ImGui::Selectable(component.name.c_str(), component.name == adsorbate.component))
+                            adsorbate.component = component.name;
+                    }
+                    ImGui::EndCombo();
+                }
+
+                double heat = adsorbate.heatOfAdsorption / 1000.0;
+                ShowCell("##qs", adsorbate.saturationLoading);
+                ShowCell("##b0", adsorbate.affinity);
+                if (ShowCell("##dH", heat)) adsorbate.heatOfAdsorption = heat * 1000.0;
+                if (dualSite)
+                {
+                    double heat2 = adsorbate.heatOfAdsorption2 / 1000.0;
+                    ShowCell("##qs2", adsorbate.saturationLoading2);
+                    ShowCell("##b02", adsorbate.affinity2);
+                    if (ShowCell("##dH2", heat2)) adsorbate.heatOfAdsorption2 = heat2 * 1000.0;
+                }
+                if (exponent)
+                    ShowCell("##n", adsorbate.heterogeneity);
+                ShowCell("##k", adsorbate.massTransferCoefficient);
+                ShowCell("##feed", column.feedMoleFraction[i]);
+                ShowCell("##initial", column.initialMoleFraction[i]);
+                ShowCell("##light", cycle.lightProductMoleFraction[i]);
+
+                ImGui::TableNextColumn();
+                if (adsorbates.size() > 1 && ImGui::SmallButton("x"))
+                    removeIndex = static_cast<int>(i);
+
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+
+            if (removeIndex >= 0)
+            {
+                adsorbates.erase(adsorbates.begin() + removeIndex);
+                column.feedMoleFraction.erase(column.feedMoleFraction.begin() + removeIndex);
+                column.initialMoleFraction.erase(column.initialMoleFraction.begin() + removeIndex);
+                cycle.lightProductMoleFraction.erase(cycle.lightProductMoleFraction.begin() + removeIndex);
+            }
+        }
+
+        if (ImGui::Button("Add Component"))
+        {
+            AdsorbateProperties adsorbate;
+            adsorbate.component = database.front().name;
+            adsorbate.saturationLoading = 1.0;
+            adsorbate.affinity = 1e-4;
+            adsorbate.heatOfAdsorption = 15000.0;
+            adsorbate.massTransferCoefficient = 0.5;
+            adsorbates.push_back(adsorbate);
+            column.feedMoleFraction.push_back(0.0);
+            column.initialMoleFraction.push_back(0.0);
+            cycle.lightProductMoleFraction.push_back(0.0);
+        }
+
+        ImGui::TextWrapped("Uptake follows the linear driving force dq/dt = k (q* - q). The last component is usually the carrier gas.");
+
+        ShowIsothermPlot();
+    }
+
+    // Column, feed and integrator settings, and the run controls
+    void ShowReactorProperties()
+    {
+        ColumnProperties& bed = column.column;
+
+        ImGui::SeparatorText("Column");
+        ShowValueInput(bed.length, "Length", "m");
+        ShowValueInput(bed.diameter, "Diameter", "m");
+        ShowValueInput(bed.bedVoidage, "Bed voidage", "-");
+        ShowValueInput(bed.particleDiameter, "Particle diameter", "m");
+        ShowValueInput(bed.bulkDensity, "Bulk density", "kg/m3");
+        ShowValueInput(bed.solidHeatCapacity, "Solid heat capacity", "J/kg/K");
+        ShowValueInput(bed.axialDispersion, "Axial dispersion", "m2/s");
+        ShowValueInput(bed.thermalConductivity, "Thermal conductivity", "W/m/K");
+        ShowValueInput(bed.wallHeatTransferCoefficient, "Wall heat transfer", "W/m2/K");
+        ShowValueInput(bed.ambientTemperature, "Ambient temperature", "K");
+        ShowValueInput(bed.gasViscosity, "Gas viscosity", "Pa s");
+
+        ImGui::SeparatorText("Feed");
+        ShowValueInput(column.feedVelocity, "Superficial velocity", "m/s");
+        ShowValueInput(column.feedTemperature, "Temperature", "K");
+        ShowValueInput(column.outletPressure, "Outlet pressure", "bar");
+        ShowValueInput(column.duration, "Duration", "s");
+
+        ImGui::SeparatorText("Numerics");
+        ShowIntInput(column.integrator.numCells, "Cells", "-");
+        ShowValueInput(column.integrator.relativeTolerance, "Relative tolerance", "-");
+        ShowValueInput(column.integrator.absoluteTolerance, "Absolute tolerance", "-");
+
+#ifndef EMSCRIPTEN
+        ShowResultFile();
+#endif
+
+        ShowCycle();
+
+        ImGui::Separator();
+        if (running)
+        {
+            if (ImGui::Button("Stop")) cancel = true;
+            ImGui::SameLine();
+            if (runningCycle)
+            {
+                ImGui::Text("Cycle %d, residual %.2e", progressCycle.load(), progressResidual.load());
+            }
+            else
+            {
+                float fraction = static_cast<float>(progressTime.load() / std::max(runDuration, 1e-12));
+                ImGui::ProgressBar(fraction);
+            }
+        }
+        else
+        {
+            if (ImGui::Button("Run Breakthrough")) RunBreakthrough();
+            ImGui::SameLine();
+            if (ImGui::Button("Run Cyclic Steady State")) RunCycle();
+            ImGui::SameLine();
+            if (ImGui::Button("Run Multi-Bed")) RunMultiBed();
+        }
+
+        if (!errorMessage.empty())
+        {
+            ImGui::TextWrapped("%s", errorMessage.c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (result)
+        {
+            ShowStatistics(result->message, result->statistics);
+        }
+        if (cycleResult)
+        {
+            ShowStatistics(cycleResult->message, cycleResult->statistics);
+        }
+        if (multiBedResult)
+        {
+            ImGui::TextWrapped("%s: %d beds, %d slots and %d bed to bed transfers per cycle in %.2f s",
+                multiBedResult->message.c_str(), static_cast<int>(multiBedResult->states.size()),
+                multiBedResult->numSlots, multiBedResult->numLinks, multiBedResult->seconds);
+        }
+    }
+
+    // Breakthrough curves and axial profiles, and the convergence monitor of the cycle. The
+    // breakthrough streams in while it runs, and long series are decimated to the plot width.
+    void ShowResults()
+    {
+        // Samples the worker could not hand over at the end, the ring was full. It is done with
+        // the stream, so this thread can write them.
+        if (liveFlushPending && !running && liveStream->Flush()) liveFlushPending = false;
+        const size_t arrived = liveStream ? liveStream->Drain(liveColumns) : 0;
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (arrived > 0 && liveColumns[0].size() == arrived) selectTab = Study::Breakthrough;
+        const bool live = !result && !liveColumns.empty() && !liveColumns[0].empty();
+        if (!result && !live && cycleHistory.empty() && multiBedHistory.empty())
+        {
+            ImGui::TextUnformatted("Run a breakthrough, a cyclic steady state or a multi-bed cycle from the Reactor Properties window.");
+            return;
+        }
+
+        ImGui::SetNextItemWidth(120.0f);
+        if (ImGui::BeginCombo("Downsampling", GetDecimationName(decimation)))
+        {
+            for (auto method : { DecimationMethod::MinMax, DecimationMethod::Lttb, DecimationMethod::None })
+            {
+                if (ImGui::Selectable(GetDecimationName(method), method == decimation))
+                    decimation = method;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SetItemTooltip("Long series are cut to about two points per pixel column of the visible range before they are drawn. "
+            "Min-max keeps spikes and steps, LTTB follows smooth curves. Zoom in to see every point.");
+
+#ifdef EMSCRIPTEN
+        // The page uploads the published buffers straight from the heap
+        for (const char* name : { "breakthrough", "cycle", "multi-bed" })
+        {
+            if (ResultBuffers::Get().Find(name) == 0) continue;
+            ImGui::SameLine();
+            const std::string label = std::string("Save ") + name;
+            if (ImGui::Button(label.c_str()))
+                EM_ASM({ window.parent.storeResultBuffer(UTF8ToString($0)); }, name);
+        }
+#endif
+
+        if (ImGui::BeginTabBar("##Results"))
+        {
+            if ((result || live) && ImGui::BeginTabItem("Breakthrough", nullptr, selectTab == Study::Breakthrough ? ImGuiTabItemFlags_SetSelected : 0))
+            {
+                if (result)
+                {
+                    ShowBreakthrough(result->time, result->outletMoleFraction.data(), result->outletMoleFraction.size(), result->outletTemperature, &result->finalProfile);
+                }
+                else
+                {
+                    // Time, the mole fractions and the temperature, as they arrive
+                    ShowBreakthrough(liveColumns.front(), &liveColumns[1], liveColumns.size() - 2, liveColumns.back(), nullptr);
+                }
+                ImGui::EndTabItem();
+            }
+            if (!cycleHistory.empty() && ImGui::BeginTabItem("Cyclic Steady State", nullptr, selectTab == Study::Cycle ? ImGuiTabItemFlags_SetSelected : 0))
+            {
+                const float height = ImGui::GetContentRegionAvail().y / 3.0f - ImGui::GetStyle().ItemSpacing.y;
+                ShowConvergence(cycleHistory, cycleTolerance, height);
+                if (cycleResult)
+                    ShowLoadingProfile("Loading at the Start of the Cycle", cycleResult->profile, cycleNames, height);
+                ImGui::EndTabItem();
+            }
+            if (!multiBedHistory.empty() && ImGui::BeginTabItem("Multi-Bed", nullptr, selectTab == Study::MultiBed ? ImGuiTabItemFlags_SetSelected : 0))
+            {
+                const float height = ImGui::GetContentRegionAvail().y / 3.0f - ImGui::GetStyle().ItemSpacing.y;
+                ShowConvergence(multiBedHistory, multiBedTolerance, height);
+                if (multiBedResult)
+                    ShowBedLoadings(*multiBedResult, height);
+                ImGui::EndTabItem();
+            }
+            selectTab = Study::None;
+            ImGui::EndTabBar();
+        }
+    }
+
+private:
+    static bool ShowCell(const char* id, double& value)
+    {
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        return ImGui::InputDouble(id, &value, 0.0, 0.0, "%.4g");
+    }
+
+    static const char* GetIsothermHelp(IsothermModel model)
+    {
+        switch (model)
+        {
+        case IsothermModel::Langmuir:
+            return "q*_i = qs b p_i / (1 + b p_i), every component on its own, with b = b0 exp(dH / RT).";
+        case IsothermModel::ExtendedLangmuir:
+            return "q*_i = qs b p_i / (1 + sum b_j p_j), with b = b0 exp(dH / RT).";
+        case IsothermModel::DualSiteLangmuir:
+            return "Extended Langmuir on two independent sites, qs b p_i / (1 + sum b_j p_j) + qs2 b2 p_i / (1 + sum b2_j p_j).";
+        case IsothermModel::Sips:
+            return "q*_i = qs (b p_i)^n / (1 + sum (b_j p_j)^n_j), with b = b0 exp(dH / RT). n = 1 is Extended Langmuir.";
+        case IsothermModel::Toth:
+            return "q*_i = qs b p_i / (1 + (sum b_j p_j)^t)^(1/t), with b = b0 exp(dH / RT). t = 1 is Extended Langmuir.";
+        }
+        return "";
+    }
+
+    // Pure component isotherms at the feed temperature, up to the column pressure
+    void ShowIsothermPlot()
+    {
+        std::string message;
+        const size_t nc = column.adsorbates.size();
+        if (column.outletPressure <= 0.0 || !column.Validate(message))
+            return;
+
+        const int points = 100;
+        plotBatch.Resize(points * nc, nc);
+        plotPressure.resize(points);
+        for (int k = 0; k < points; ++k)
+            plotPressure[k] = column.outletPressure * k / (points - 1);
+
+        for (size_t i = 0; i < nc; ++i)
+        {
+            for (int k = 0; k < points; ++k)
+            {
+                const size_t state = i * points + k;
+                plotBatch.temperature[state] = column.feedTemperature;
+                for (size_t j = 0; j < nc; ++j)
+                    plotBatch.partialPressure[j][state] = j == i ? plotPressure[k] : 0.0;
+            }
+        }
+        Isotherm(column.isotherm, column.adsorbates).Evaluate(plotBatch, false);
+
+        if (ImPlot::BeginPlot("Pure Component Isotherms", ImVec2(-1, 300.0f)))
+        {
+            ImPlot::SetupAxes("Pressure [bar]", "Loading [mol/kg]", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            for (size_t i = 0; i < nc; ++i)
+                ImPlot::PlotLine(column.adsorbates[i].component.c_str(), plotPressure.data(), plotBatch.loading[i].data() + i * points, points);
+            ImPlot::EndPlot();
+        }
+    }
+
+    static void ShowStatistics(const std::string& message, const ColumnStatistics& statistics)
+    {
+        ImGui::TextWrapped("%s: %d steps (%d rejected), %d Newton iterations, %d Jacobians, %d factorizations in %.2f s",
+            message.c_str(), statistics.numSteps, statistics.numRejectedSteps, statistics.numNewtonIterations,
+            statistics.numJacobians, statistics.numFactorizations, statistics.seconds);
+    }
+
+    // Breakthrough samples written to a binary result file while the run goes, and its text
+    // conversions
+    void ShowResultFile()
+    {
+        ImGui::SeparatorText("Results File");
+        ImGui::Checkbox("Write breakthrough", &writeResultFile);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+        ImGui::InputText("##ResultPath", resultPath, sizeof(resultPath));
+
+        if (!running && !writtenResultPath.empty())
+        {
+            if (ImGui::Button("Export CSV")) ExportResultFile("csv");
+            ImGui::SameLine();
+            if (ImGui::Button("Export JSON")) ExportResultFile("json");
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (!resultFileMessage.empty())
+            ImGui::TextWrapped("%s", resultFileMessage.c_str());
+    }
+
+    void ExportResultFile(const std::string& extension)
+    {
+        std::string message;
+        ResultReader reader;
+        if (reader.Open(writtenResultPath, message))
+        {
+            const size_t dot = writtenResultPath.find_last_of('.');
+            const std::string path = writtenResultPath.substr(0, dot == std::string::npos ? writtenResultPath.size() : dot) + "." + extension;
+            std::ofstream file(path, std::ios::binary);
+            if (extension == "csv") ExportCsv(reader, file);
+            else ExportJson(reader, file);
+            message = file ? "Exported " + path : "Cannot write " + path;
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        resultFileMessage = message;
+    }
+
+    // Steps of the PSA cycle and the cyclic steady state settings
+    void ShowCycle()
+    {
+        auto& steps = cycle.steps;
+        auto& settings = cycle.settings;
+
+        ImGui::SeparatorText("Cycle");
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+        if (ImGui::BeginTable("##CycleSteps", 6, flags))
+        {
+            ImGui::TableSetupColumn("Step", ImGuiTableColumnFlags_WidthFixed, 130.0f);
+            ImGui::TableSetupColumn("Duration [s]");
+            ImGui::TableSetupColumn("Pressure [bar]");
+            ImGui::TableSetupColumn("Purge u [m/s]");
+            ImGui::TableSetupColumn("Ramp [s]");
+            ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 24.0f);
+            ImGui::TableHeadersRow();
+
+            int removeIndex = -1;
+            for (size_t i = 0; i < steps.size(); ++i)
+            {
+                auto& step = steps[i];
+                ImGui::PushID(static_cast<int>(i));
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                ImGui::SetNextItemWidth(-FLT_MIN);
+                if (ImGui::BeginCombo("##type", CycleStep::GetName(step.type)))
+                {
+                    for (int t = 0; t <= static_cast<int>(CycleStep::Type::EqualisationUp); ++t)
+                    {
+                        const auto type = static_cast<CycleStep::Type>(t);
+                        if (ImGui::Selectable(CycleStep::GetName(type), type == step.type))
+                            step.type = type;
+                    }
+                    ImGui::EndCombo();
+                }
+
+                ShowCell("##duration", step.duration);
+                ShowCell("##pressure", step.pressure);
+                ShowCell("##velocity", step.velocity);
+                ShowCell("##ramp", step.rampTime);
+
+                ImGui::TableNextColumn();
+                if (steps.size() > 1 && ImGui::SmallButton("x"))
+                    removeIndex = static_cast<int>(i);
+
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+
+            if (removeIndex >= 0) steps.erase(steps.begin() + removeIndex);
+        }
+
+        if (ImGui::Button("Add Step")) steps.push_back(CycleStep());
+
+        ImGui::TextWrapped("The feed end is the column inlet. Adsorption, pressurisation and LPP go to the outlet pressure, "
+            "blowdown and purge steps to their own pressure.");
+
+        ImGui::Checkbox("Anderson acceleration", &settings.accelerate);
+        ShowIntInput(settings.historySize, "History", "cycles");
+        ShowIntInput(settings.maxCycles, "Maximum cycles", "-");
+        ShowValueInput(settings.tolerance, "CSS tolerance", "-");
+
+        ImGui::SeparatorText("Multi-Bed");
+        if (ImGui::Button("Two-Bed Equalisation Schedule")) steps = MultiBedPsa().cycle.steps;
+        ImGui::TextWrapped("Every bed runs the steps above, each one a fraction of the cycle behind the previous. "
+            "EQ Up takes the gas of a bed on EQ Down, purge and LPP the light product of a bed on adsorption.");
+        ShowIntInput(multiBedSettings.numBeds, "Beds", "-");
+        ShowIntInput(multiBedSettings.maxCycles, "Maximum bed cycles", "-");
+        ShowValueInput(multiBedSettings.tolerance, "Bed CSS tolerance", "-");
+        ImGui::Checkbox("One thread per bed", &multiBedSettings.parallel);
+    }
+
+    // The series are plotted in place, so the decimated copies stay valid while nothing arrives
+    void ShowBreakthrough(const std::vector<double>& time, const std::vector<double>* moleFraction, size_t numComponents,
+        const std::vector<double>& temperature, const ColumnProfile* finalProfile)
+    {
+        const int count = static_cast<int>(time.size());
+        const float height = ImGui::GetContentRegionAvail().y / 3.0f - ImGui::GetStyle().ItemSpacing.y;
+
+        if (ImPlot::BeginPlot("Outlet Composition", ImVec2(-1, height)))
+        {
+            ImPlot::SetupAxes("Time [s]", "Mole fraction", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            for (size_t i = 0; i < numComponents && i < breakthroughNames.size(); ++i)
+                PlotSeries(breakthroughNames[i].c_str(), time.data(), moleFraction[i].data(), count);
+            ImPlot::EndPlot();
+        }
+
+        if (ImPlot::BeginPlot("Outlet Temperature", ImVec2(-1, height)))
+        {
+            ImPlot::SetupAxes("Time [s]", "Temperature [K]", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            PlotSeries("Outlet", time.data(), temperature.data(), count);
+            ImPlot::EndPlot();
+        }
+
+        if (finalProfile)
+            ShowLoadingProfile("Final Loading Profile", *finalProfile, breakthroughNames, height);
+        else
+            ImGui::Text("%d samples so far", count);
+    }
+
+    // Line through at most about two points per pixel column of the visible range, see Decimation.h
+    void PlotSeries(const char* label, const double* x, const double* y, int count)
+    {
+        const ImPlotRect limits = ImPlot::GetPlotLimits();
+        const int pixels = static_cast<int>(ImPlot::GetPlotSize().x);
+
+        // The plot's items are on the ID stack once its setup is done
+        DecimatedSeries& series = plotSeries[ImGui::GetID(label)];
+        series.Update(decimation, x, y, static_cast<size_t>(count), limits.X.Min, limits.X.Max, pixels);
+        ImPlot::PlotLine(label, series.x.data(), series.y.data(), static_cast<int>(series.x.size()));
+    }
+
+    // Residual and mass balance against the cycle number, live while the cycle runs
+    void ShowConvergence(const std::vector<CycleSummary>& history, const double& tolerance, float height)
+    {
+        const int count = static_cast<int>(history.size());
+
+        std::vector<double> cycles(count), residual(count), massBalance(count), purity(count), recovery(count);
+        for (int j = 0; j < count; ++j)
+        {
+            const CycleSummary& summary = history[j];
+            cycles[j] = summary.cycle;
+            residual[j] = std::max(summary.residual, 1e-16);
+            massBalance[j] = std::max(summary.massBalanceError, 1e-16);
+            purity[j] = summary.purity;
+            recovery[j] = summary.recovery;
+        }
+
+        if (ImPlot::BeginPlot("Convergence", ImVec2(-1, height)))
+        {
+            ImPlot::SetupAxes("Cycle", "", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot::SetupAxisScale(ImAxis_Y1, ImPlotScale_Log10);
+            PlotSeries("Residual", cycles.data(), residual.data(), count);
+            PlotSeries("Mass balance", cycles.data(), massBalance.data(), count);
+            ImPlot::PlotInfLines("Tolerance", &tolerance, 1, ImPlotInfLinesFlags_Horizontal);
+            ImPlot::EndPlot();
+        }
+
+        if (ImPlot::BeginPlot("Heavy Product", ImVec2(-1, height)))
+        {
+            ImPlot::SetupAxes("Cycle", "Fraction", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            PlotSeries("Purity", cycles.data(), purity.data(), count);
+            PlotSeries("Recovery", cycles.data(), recovery.data(), count);
+            ImPlot::EndPlot();
+        }
+    }
+
+    // Heavy component loading of every bed, at the end of the last cycle
+    void ShowBedLoadings(const MultiBedResult& multiBed, float height)
+    {
+        if (multiBed.profiles.empty() || multiBedNames.empty()) return;
+
+        const std::string title = multiBedNames[0] + " Loading of Every Bed";
+        if (ImPlot::BeginPlot(title.c_str(), ImVec2(-1, height)))
+        {
+            ImPlot::SetupAxes("Position [m]", "Loading [mol/kg]", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            for (size_t b = 0; b < multiBed.profiles.size(); ++b)
+            {
+                const ColumnProfile& profile = multiBed.profiles[b];
+                if (profile.loading.empty()) continue;
+                const std::string label = "Bed " + std::to_string(b + 1);
+                PlotSeries(label.c_str(), profile.position.data(), profile.loading[0].data(), static_cast<int>(profile.position.size()));
+            }
+            ImPlot::EndPlot();
+        }
+    }
+
+    void ShowLoadingProfile(const char* title, const ColumnProfile& profile, const std::vector<std::string>& names, float height)
+    {
+        if (!profile.position.empty() && ImPlot::BeginPlot(title, ImVec2(-1, height)))
+        {
+            const int cells = static_cast<int>(profile.position.size());
+            ImPlot::SetupAxes("Position [m]", "Loading [mol/kg]", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            for (size_t i = 0; i < profile.loading.size() && i < names.size(); ++i)
+                PlotSeries(names[i].c_str(), profile.position.data(), profile.loading[i].data(), cells);
+            ImPlot::EndPlot();
+        }
+    }
+
+    std::vector<std::string> GetComponentNames() const
+    {
+        std::vector<std::string> names;
+        for (const auto& adsorbate : column.adsorbates) names.push_back(adsorbate.component);
+        return names;
+    }
+
+    void RunBreakthrough()
+    {
+        if (worker.joinable()) worker.join();
+
+        errorMessage.clear();
+        if (!column.Validate(errorMessage)) return;
+
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result.reset();
+            breakthroughNames = GetComponentNames();
+        }
+
+        // Time, the outlet mole fractions and the outlet temperature of every sample
+        liveStream = std::make_unique<SeriesStream>(column.GetNumComponents() + 2);
+        liveColumns.clear();
+        liveFlushPending = false;
+
+        // The same columns go to the result file as they arrive
+        auto writer = std::make_shared<ResultWriter>();
+        writtenResultPath.clear();
+        resultFileMessage.clear();
+        if (writeResultFile)
+        {
+            std::vector<ResultColumn> columns{ { "time", "s", ResultType::Float64 } };
+            for (const auto& name : GetComponentNames()) columns.push_back({ "y " + name, "-", ResultType::Float64 });
+            columns.push_back({ "outlet temperature", "K", ResultType::Float64 });
+
+            if (!writer->Open(resultPath, columns, errorMessage)) return;
+            writtenResultPath = resultPath;
+        }
+
+        runDuration = column.duration;
+        progressTime = 0.0;
+        cancel = false;
+        runningCycle = false;
+        running = true;
+
+        worker = std::thread([this, study = column, stream = liveStream.get(), writer]() {
+            std::vector<double> row(stream->GetNumColumns());
+            auto breakthrough = std::make_unique<BreakthroughResult>(study.RunBreakthrough([this, stream, &writer, &row](const BreakthroughResult& partial) {
+                const size_t last = partial.time.size() - 1;
+                row.front() = partial.time[last];
+                for (size_t i = 0; i < partial.outletMoleFraction.size(); ++i) row[1 + i] = partial.outletMoleFraction[i][last];
+                row.back() = partial.outletTemperature[last];
+                stream->Append(row.data());
+                if (writer->IsOpen()) writer->Append(row.data());
+
+                progressTime = row.front();
+                FramePacing::Get().Request();
+                return !cancel.load();
+            }));
+            const bool flushed = stream->Flush();
+
+            std::string message;
+            const size_t rows = writer->GetNumRows();
+            const bool written = writer->IsOpen() && writer->Close(message);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (written)
+                resultFileMessage = "Wrote " + std::to_string(rows) + " samples";
+            else if (!message.empty())
+                resultFileMessage = message;
+#ifdef EMSCRIPTEN
+            PublishBreakthrough(*breakthrough, breakthroughNames);
+#endif
+            result = std::move(breakthrough);
+            selectTab = Study::Breakthrough;
+            liveFlushPending = !flushed;
+            running = false;
+            FramePacing::Get().Request();
+        });
+    }
+
+    void RunCycle()
+    {
+        if (worker.joinable()) worker.join();
+
+        PsaCycle study = cycle;
+        study.column = column;
+
+        errorMessage.clear();
+        if (!study.Validate(errorMessage)) return;
+
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            cycleResult.reset();
+            cycleHistory.clear();
+            cycleNames = GetComponentNames();
+            cycleTolerance = study.settings.tolerance;
+        }
+
+        progressCycle = 0;
+        progressResidual = 0.0;
+        cancel = false;
+        runningCycle = true;
+        running = true;
+
+        worker = std::thread([this, study = std::move(study)]() {
+            auto css = std::make_unique<CyclicSteadyStateResult>(study.SolveCyclicSteadyState([this](const CycleSummary& summary) {
+                progressCycle = summary.cycle;
+                progressResidual = summary.residual;
+                {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    cycleHistory.push_back(summary);
+                    if (cycleHistory.size() == 1) selectTab = Study::Cycle;
+                }
+                FramePacing::Get().Request();
+                return !cancel.load();
+            }));
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+#ifdef EMSCRIPTEN
+            PublishHistory("cycle", css->history);
+#endif
+            cycleResult = std::move(css);
+            running = false;
+            FramePacing::Get().Request();
+        });
+    }
+
+    void RunMultiBed()
+    {
+        if (worker.joinable()) worker.join();
+
+        MultiBedPsa study;
+        study.cycle = cycle;
+        study.cycle.column = column;
+        study.settings = multiBedSettings;
+
+        errorMessage.clear();
+        if (!study.Validate(errorMessage)) return;
+
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            multiBedResult.reset();
+            multiBedHistory.clear();
+            multiBedNames = GetComponentNames();
+            multiBedTolerance = study.settings.tolerance;
+        }
+
+        progressCycle = 0;
+        progressResidual = 0.0;
+        cancel = false;
+        runningCycle = true;
+        running = true;
+
+        worker = std::thread([this, study = std::move(study)]() {
+            auto multiBed = std::make_unique<MultiBedResult>(study.Run([this](const CycleSummary& summary) {
+                progressCycle = summary.cycle;
+                progressResidual = summary.residual;
+                {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    multiBedHistory.push_back(summary);
+                    if (multiBedHistory.size() == 1) selectTab = Study::MultiBed;
+                }
+                FramePacing::Get().Request();
+                return !cancel.load();
+            }));
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+#ifdef EMSCRIPTEN
+            PublishHistory("multi-bed", multiBed->history);
+#endif
+            multiBedResult = std::move(multiBed);
+            running = false;
+            FramePacing::Get().Request();
+        });
+    }
+
+#ifdef EMSCRIPTEN
+    // Finished results for the page, one column after the other, see ResultBuffers.h
+    static void PublishBreakthrough(const BreakthroughResult& breakthrough, const std::vector<std::string>& names)
+    {
+        const size_t rows = breakthrough.time.size();
+        std::vector<ResultColumn> columns{ { "time", "s" } };
+        std::vector<double> values(breakthrough.time);
+        for (size_t i = 0; i < breakthrough.outletMoleFraction.size() && i < names.size(); ++i)
+        {
+            columns.push_back({ "y " + names[i], "-" });
+            values.insert(values.end(), breakthrough.outletMoleFraction[i].begin(), breakthrough.outletMoleFraction[i].end());
+        }
+        columns.push_back({ "outlet temperature", "K" });
+        values.insert(values.end(), breakthrough.outletTemperature.begin(), breakthrough.outletTemperature.end());
+        columns.push_back({ "pressure drop", "bar" });
+        values.insert(values.end(), breakthrough.pressureDrop.begin(), breakthrough.pressureDrop.end());
+
+        ResultBuffers::Get().Publish("breakthrough", columns, rows, std::move(values));
+    }
+
+    static void PublishHistory(const std::string& name, const std::vector<CycleSummary>& history)
+    {
+        const size_t rows = history.size();
+        const std::vector<ResultColumn> columns{ { "cycle", "" }, { "residual", "-" }, { "mass balance", "-" }, { "purity", "-" }, { "recovery", "-" } };
+        std::vector<double> values(rows * columns.size());
+        for (size_t j = 0; j < rows; ++j)
+        {
+            values[j] = history[j].cycle;
+            values[rows + j] = history[j].residual;
+            values[2 * rows + j] = history[j].massBalanceError;
+            values[3 * rows + j] = history[j].purity;
+            values[4 * rows + j] = history[j].recovery;
+        }
+
+        ResultBuffers::Get().Publish(name, columns, rows, std::move(values));
+    }
+#endif
+
+    enum class Study { None, Breakthrough, Cycle, MultiBed };
+
+    AdsorptionColumn column;
+    IsothermBatch plotBatch;                // Pure component isotherms of the Adsorption Model window
+    std::vector<double> plotPressure;
+    PsaCycle cycle;                         // Steps and settings, the column is the one above
+    MultiBedSettings multiBedSettings;      // Every bed runs the steps of cycle
+
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> runningCycle{ false };
+    std::atomic<bool> cancel{ false };
+    std::atomic<double> progressTime{ 0.0 };
+    std::atomic<int> progressCycle{ 0 };
+    std::atomic<double> progressResidual{ 0.0 };
+    double runDuration = 0.0;
+    std::string errorMessage;
+
+    // Written by the worker, guarded by resultMutex
+    std::mutex resultMutex;
+    std::unique_ptr<BreakthroughResult> result;
+    std::vector<std::string> breakthroughNames;
+    std::unique_ptr<CyclicSteadyStateResult> cycleResult;
+    std::vector<CycleSummary> cycleHistory;
+    std::vector<std::string> cycleNames;
+    double cycleTolerance = 0.0;
+    std::unique_ptr<MultiBedResult> multiBedResult;
+    std::vector<CycleSummary> multiBedHistory;
+    std::vector<std::string> multiBedNames;
+    double multiBedTolerance = 0.0;
+    Study selectTab = Study::None;                  // Brought to front once by the next frame
+
+    // Breakthrough samples on their way from the worker, read by the Results window only
+    std::unique_ptr<SeriesStream> liveStream;
+    std::atomic<bool> liveFlushPending{ false };    // The last samples are still with the writer
+
+    // Breakthrough result file, written by the worker while it runs
+    bool writeResultFile = false;
+    char resultPath[256] = "breakthrough.thxr";
+    std::string writtenResultPath;
+    std::string resultFileMessage;                  // Guarded by resultMutex
+    std::vector<std::vector<double>> liveColumns;
+
+    // Plotted lines, decimated to the plot width
+    DecimationMethod decimation = DecimationMethod::MinMax;
+    std::unordered_map<ImGuiID, DecimatedSeries> plotSeries;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+// STL Includes
+#include <string>
+
+// Micro benchmarks. Each one returns a plain text report.
+
+// Per unit model: cost and accuracy of forward-difference Jacobians against forward-mode AD
+std::string RunJacobianBenchmark(int evaluations = 100000);
+
+// Cubic equation of state: one state per call against structure-of-arrays batches
+std::string RunPropertyBenchmark(int states = 100000);
+
+// Isotherm models: one state per call against batches, and the analytic derivatives against
+// central differences
+std::string RunIsothermBenchmark(int states = 100000);
+
+// Mixture property and isotherm kernels compiled for 2, 3 and 4 components against the runtime
+// kernels, on a column sized batch and a large one
+std::string RunKernelBenchmark(int states = 100000);
+
+// Adsorption column breakthrough on increasingly fine grids
+std::string RunColumnBenchmark();
+
+// Cycles to the cyclic steady state of a PSA cycle, repeated against Anderson accelerated
+std::string RunCycleBenchmark();
+
+// Multi-bed PSA with 2, 4 and 6 beds over a few cycles, beds taking turns on one thread against
+// one thread per bed
+std::string RunMultiBedBenchmark(int cycles = 3);
+
+// Results window plotting: decimation of long series to a plot width, and rows streamed from a
+// solver thread to the GUI thread
+std::string RunPlotBenchmark(int points = 5000000);
+
+// Columnar binary result file against CSV text: writing rows, reading a column back and reading
+// a time window
+std::string RunResultFileBenchmark(int rows = 2000000);
+
+// Saving and loading a large flowsheet as JSON and as a binary snapshot
+std::string RunFlowsheetIOBenchmark(int units = 10000);
+
+// Clicking, port snapping and finding the units in view on a large canvas: every unit tested
+// against the spatial grid
+std::string RunHitTestBenchmark(int units = 10000);
+
+// Undo and redo of drags, value edits and deletes on a large flowsheet, against a snapshot per
+// step, and the journal's memory over a long session
+std::string RunUndoBenchmark(int units = 10000);
@@ -0,0 +1,46 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <cstddef>
+
+// Block tridiagonal matrix with square blocks, as produced by one dimensional discretisations
+// where each cell only couples to its two neighbours. Blocks are dense and row-major.
+//
+// Factorize() runs block Gaussian elimination (the block Thomas algorithm) with partial pivoting
+// inside the diagonal blocks. The cost is linear in the number of block rows, where a general
+// sparse LU would fill in. The stored blocks are kept, so a caller can refactorize after changing
+// them without rebuilding anything.
+class BlockTridiagonal {
+public:
+    void Resize(size_t numBlocks, size_t blockSize);
+    void SetZero();
+
+    // Block (k, k - 1), (k, k) and (k, k + 1)
+    double* Lower(size_t k) { return &lower[k * blockSize * blockSize]; }
+    double* Diagonal(size_t k) { return &diagonal[k * blockSize * blockSize]; }
+    double* Upper(size_t k) { return &upper[k * blockSize * blockSize]; }
+    const double* Lower(size_t k) const { return &lower[k * blockSize * blockSize]; }
+    const double* Diagonal(size_t k) const { return &diagonal[k * blockSize * blockSize]; }
+    const double* Upper(size_t k) const { return &upper[k * blockSize * blockSize]; }
+
+    // Returns false if a diagonal block became singular
+    bool Factorize();
+
+    // Solve A x = b in place, after Factorize()
+    void Solve(double* b) const;
+
+    size_t GetNumBlocks() const { return numBlocks; }
+    size_t GetBlockSize() const { return blockSize; }
+
+private:
+    size_t numBlocks = 0;
+    size_t blockSize = 0;
+
+    std::vector<double> lower, diagonal, upper;
+
+    // Factors: LU of the eliminated diagonal blocks and W_k = D_k^-1 U_k
+    std::vector<double> factor;
+    std::vector<int> pivot;
+    std::vector<double> eliminated;
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+// ImGui Includes
+#include <imgui.h>
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+
+// Background grid of the flowsheet canvas. The lines of a patch one major cell larger than the
+// canvas are built once as one pixel wide quads. Drawing copies the patch into the draw list,
+// shifted by the pan modulo the major spacing, so panning never rebuilds it. Only a resize or a
+// zoom does.
+class CanvasGrid {
+public:
+    // offset is the screen offset of the flowsheet origin in the canvas, scale the zoom
+    void Draw(ImDrawList* drawList, ImVec2 canvasPos, ImVec2 canvasSize, ImVec2 offset, float scale) {
+        const float spacing = minorSpacing * scale;
+        const ImVec2 uv = ImGui::GetFontTexUvWhitePixel();
+        if (spacing != builtSpacing || canvasSize.x != builtSize.x || canvasSize.y != builtSize.y ||
+            uv.x != builtUv.x || uv.y != builtUv.y) Build(canvasSize, spacing, uv);
+        if (vertices.empty()) return;
+
+        // Top-left of the patch, at or above and left of the canvas corner
+        const float majorSpacing = spacing * majorEvery;
+        const float shiftX = canvasPos.x + FirstLine(offset.x, majorSpacing);
+        const float shiftY = canvasPos.y + FirstLine(offset.y, majorSpacing);
+
+        const int numVertices = static_cast<int>(vertices.size());
+        const int numIndices = static_cast<int>(indices.size());
+        drawList->PrimReserve(numIndices, numVertices);
+        const unsigned int base = drawList->_VtxCurrentIdx;
+        ImDrawVert* vtx = drawList->_VtxWritePtr;
+        for (int i = 0; i < numVertices; ++i) {
+            vtx[i] = vertices[i];
+            vtx[i].pos.x += shiftX;
+            vtx[i].pos.y += shiftY;
+        }
+        ImDrawIdx* idx = drawList->_IdxWritePtr;
+        for (int i = 0; i < numIndices; ++i) idx[i] = static_cast<ImDrawIdx>(base + indices[i]);
+        drawList->_VtxWritePtr += numVertices;
+        drawList->_IdxWritePtr += numIndices;
+        drawList->_VtxCurrentIdx += numVertices;
+    }
+
+    size_t GetNumVertices() const { return vertices.size(); }
+
+    static constexpr float minorSpacing = 20.0f;     // Flowsheet units between minor lines
+    static constexpr int majorEvery = 5;             // Minor spacings between major lines
+    static constexpr float minVisibleSpacing = 8.0f; // Minor lines closer than this in pixels are left out
+
+    // First line at or left of the canvas edge for a given pan
+    static float FirstLine(float offset, float spacing) {
+        float first = fmodf(offset, spacing);
+        return first > 0.0f ? first - spacing : first;
+    }
+
+private:
+    void Build(ImVec2 canvasSize, float spacing, ImVec2 uv) {
+        builtSpacing = spacing;
+        builtSize = canvasSize;
+        builtUv = uv;
+        vertices.clear();
+        indices.clear();
+
+        const float majorSpacing = spacing * majorEvery;
+        const float width = canvasSize.x + majorSpacing;
+        const float height = canvasSize.y + majorSpacing;
+
+        auto addLine = [&](float x0, float y0, float x1, float y1, ImU32 col) {
+            const unsigned int first = static_cast<unsigned int>(vertices.size());
+            vertices.push_back({ ImVec2(x0, y0), uv, col });
+            vertices.push_back({ ImVec2(x1, y0), uv, col });
+            vertices.push_back({ ImVec2(x1, y1), uv, col });
+            vertices.push_back({ ImVec2(x0, y1), uv, col });
+            for (unsigned int corner : { 0u, 1u, 2u, 0u, 2u, 3u }) indices.push_back(first + corner);
+        };
+
+        // Minor lines under the major ones, as the lines were drawn one by one before
+        if (spacing >= minVisibleSpacing) {
+            for (int i = 0; i * spacing < width; ++i) addLine(i * spacing, 0.0f, i * spacing + 1.0f, height, IM_COL32(50, 50, 50, 40));
+            for (int i = 0; i * spacing < height; ++i) addLine(0.0f, i * spacing, width, i * spacing + 1.0f, IM_COL32(50, 50, 50, 40));
+        }
+        if (majorSpacing >= 1.0f) {
+            for (int i = 0; i * majorSpacing < width; ++i) addLine(i * majorSpacing, 0.0f, i * majorSpacing + 1.0f, height, IM_COL32(50, 50, 50, 80));
+            for (int i = 0; i * majorSpacing < height; ++i) addLine(0.0f, i * majorSpacing, width, i * majorSpacing + 1.0f, IM_COL32(50, 50, 50, 80));
+        }
+    }
+
+    std::vector<ImDrawVert> vertices;    // The patch, with its top-left corner at zero
+    std::vector<unsigned int> indices;   // Into vertices
+    float builtSpacing = -1.0f;
+    ImVec2 builtSize;
+    ImVec2 builtUv;
+};
+
+// Grid drawing cost per frame on a 3840 x 2160 canvas, line by line with AddLine against the
+// cached patch, panned a little every frame. Needs a current ImGui context.
+static std::string RunGridBenchmark(int frames = 500)
+{
+    using Clock = std::chrono::steady_clock;
+    const ImVec2 canvasPos(0.0f, 0.0f);
+    const ImVec2 canvasSize(3840.0f, 2160.0f);
+    const float endX = canvasPos.x + canvasSize.x;
+    const float endY = canvasPos.y + canvasSize.y;
+
+    ImDrawList drawList(ImGui::GetDrawListSharedData());
+    auto newFrame = [&]() {
+        drawList._ResetForNewFrame();
+        drawList.PushClipRect(canvasPos, ImVec2(endX, endY));
+        drawList.PushTextureID(ImGui::GetIO().Fonts->TexID);
+    };
+
+    std::ostringstream out;
+    out << "Canvas grid on a 3840 x 2160 canvas, " << frames << " panned frames\n";
+    out << std::left << std::setw(8) << "Zoom" << std::right << std::setw(16) << "Lines [us]" << std::setw(16) << "Cached [us]"
+        << std::setw(16) << "Lines [verts]" << std::setw(16) << "Cached [verts]" << "\n";
+
+    for (float scale : { 1.0f, 0.5f, 2.0f }) {
+        // The grid as it was drawn before, one AddLine per line
+        int lineVertices = 0;
+        auto start = Clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            newFrame();
+            const ImVec2 offset(frame * 3.7f, frame * 1.3f);
+            const float gridSize = CanvasGrid::minorSpacing * scale;
+            if (gridSize >= CanvasGrid::minVisibleSpacing) {
+                for (float x = canvasPos.x + CanvasGrid::FirstLine(offset.x, gridSize); x < endX; x += gridSize)
+                    drawList.AddLine(ImVec2(x, canvasPos.y), ImVec2(x, endY), IM_COL32(50, 50, 50, 40));
+                for (float y = canvasPos.y + CanvasGrid::FirstLine(offset.y, gridSize); y < endY; y += gridSize)
+                    drawList.AddLine(ImVec2(canvasPos.x, y), ImVec2(endX, y), IM_COL32(50, 50, 50, 40));
+            }
+            const float majorGridSize = gridSize * CanvasGrid::majorEvery;
+            for (float x = canvasPos.x + CanvasGrid::FirstLine(offset.x, majorGridSize); x < endX; x += majorGridSize)
+                drawList.AddLine(ImVec2(x, canvasPos.y), ImVec2(x, endY), IM_COL32(50, 50, 50, 80));
+            for (float y = canvasPos.y + CanvasGrid::FirstLine(offset.y, majorGridSize); y < endY; y += majorGridSize)
+                drawList.AddLine(ImVec2(canvasPos.x, y), ImVec2(endX, y), IM_COL32(50, 50, 50, 80));
+            lineVertices = drawList.VtxBuffer.Size;
+        }
+        const double lines = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+
+        CanvasGrid grid;
+        int cachedVertices = 0;
+        start = Clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            newFrame();
+            grid.Draw(&drawList, canvasPos, canvasSize, ImVec2(frame * 3.7f, frame * 1.3f), scale);
+            cachedVertices = drawList.VtxBuffer.Size;
+        }
+        const double cached = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+
+        out << std::fixed << std::setprecision(1);
+        out << std::left << std::setw(8) << scale << std::right << std::setw(16) << lines << std::setw(16) << cached
+            << std::setw(16) << lineVertices << std::setw(16) << cachedVertices << "\n";
+    }
+    out << std::defaultfloat << "Panning reuses the cached patch, only a resize or a zoom rebuilds it\n";
+    return out.str();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Flowsheet.h"
+#include "NodeFactory.h"
+#include "FlowsheetSolver.h"
+#include "ThreadPool.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <functional>
+
+// Unit data variable addressed by unit and parameter name
+struct VariableRef {
+    std::string unit;
+    std::string parameter;
+};
+
+// numPoints values evenly spaced from first to last, inclusive
+struct SweepRange {
+    VariableRef variable;
+    double first = 0.0;
+    double last = 0.0;
+    int numPoints = 1;
+
+    double GetValue(int point) const {
+        return numPoints > 1 ? first + (last - first) * point / (numPoints - 1) : first;
+    }
+};
+
+struct CaseResult {
+    int index = 0;                   // Row-major position in the sweep grid
+    std::vector<double> inputs;      // Value of each sweep range
+    std::vector<double> outputs;     // Value of each monitored variable
+    bool warmStarted = false;        // Started from a converged neighbour instead of the base flowsheet
+    SolveReport report;
+};
+
+struct CaseStudyReport {
+    int numCases = 0;
+    int numConverged = 0;
+    int numWarmStarted = 0;
+    size_t numWorkers = 0;
+    size_t numSteals = 0;
+    double seconds = 0.0;
+    std::string message;
+};
+
+// Parameter sweep over the Cartesian product of the ranges. Every worker solves its own copy of
+// the flowsheet. Cases are visited in boustrophedon order, so consecutive cases differ in a single
+// grid step, and each case starts from the state of its nearest converged neighbour in the grid.
+// Results are passed to the callback as soon as each case finishes, one call at a time and in
+// completion order.
+class CaseStudy {
+public:
+    std::vector<SweepRange> ranges;
+    std::vector<VariableRef> outputs;
+    bool useEquationOriented = false;
+    bool warmStart = true;
+    size_t numWorkers = ThreadPool::DefaultThreadCount();
+
+    int GetNumCases() const;
+
+    CaseStudyReport Run(const Flowsheet& flowsheet, const NodeFactory& factory, const std::function<void(const CaseResult&)>& onCaseFinished);
+
+private:
+    // Grid coordinates of a row-major case index and back
+    void GetGridPoint(int index, std::vector<int>& point) const;
+    int GetIndex(const std::vector<int>& point) const;
+
+    // Case indices with each successive pair one grid step apart
+    std::vector<int> GetSnakeOrder() const;
+};
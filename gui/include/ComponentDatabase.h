@@ -0,0 +1,43 @@
+#pragma once
+
+// STL Includes
+#include <string>
+#include <vector>
+
+// Pure component constants for the cubic equations of state
+struct Component {
+    std::string name;
+    double molarMass;            // [kg/mol]
+    double criticalTemperature;  // [K]
+    double criticalPressure;     // [bar]
+    double acentricFactor;       // [-]
+    double cp[4];                // Ideal gas heat capacity, cp = c0 + c1 T + c2 T^2 + c3 T^3 [J/mol/K]
+};
+
+// Common permanent gases and light hydrocarbons. Critical constants and ideal gas heat capacities
+// from Reid, Prausnitz and Poling, The Properties of Gases and Liquids, 4th edition.
+inline const std::vector<Component>& GetComponentDatabase()
+{
+    static const std::vector<Component> components = {
+        { "Nitrogen",       0.028014, 126.2,  33.98,  0.037, { 31.15, -1.357e-2,  2.680e-5, -1.168e-8 } },
+        { "Oxygen",         0.031999, 154.6,  50.46,  0.022, { 28.11, -3.680e-6,  1.746e-5, -1.065e-8 } },
+        { "Argon",          0.039948, 150.8,  48.74,  0.001, { 20.80,  0.0,       0.0,       0.0      } },
+        { "Carbon Dioxide", 0.044010, 304.1,  73.83,  0.239, { 19.80,  7.344e-2, -5.602e-5,  1.715e-8 } },
+        { "Carbon Monoxide",0.028010, 132.9,  34.99,  0.066, { 30.87, -1.285e-2,  2.789e-5, -1.272e-8 } },
+        { "Methane",        0.016043, 190.4,  46.00,  0.011, { 19.25,  5.213e-2,  1.197e-5, -1.132e-8 } },
+        { "Ethane",         0.030070, 305.4,  48.80,  0.099, {  5.409, 1.781e-1, -6.938e-5,  8.713e-9 } },
+        { "Hydrogen",       0.002016,  33.2,  13.00, -0.218, { 27.14,  9.274e-3, -1.381e-5,  7.645e-9 } },
+        { "Helium",         0.004003,   5.19,  2.27, -0.390, { 20.80,  0.0,       0.0,       0.0      } },
+        { "Water",          0.018015, 647.3, 221.20,  0.344, { 32.24,  1.924e-3,  1.055e-5, -3.596e-9 } },
+    };
+    return components;
+}
+
+// nullptr if the name is not in the database
+inline const Component* FindComponent(const std::string& name)
+{
+    for (const auto& component : GetComponentDatabase()) {
+        if (component.name == name) return &component;
+    }
+    return nullptr;
+}
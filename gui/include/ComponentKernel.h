@@ -0,0 +1,30 @@
+#pragma once
+
+// STL Includes
+#include <cstddef>
+
+// Property kernels are compiled for the common mixture sizes, where the component loops unroll and
+// the per-state arrays live on the stack. Runtime handles any number of components.
+enum class ComponentKernel { Runtime, Two, Three, Four };
+
+// Fastest kernel for a number of components
+inline ComponentKernel SelectComponentKernel(size_t numComponents)
+{
+    switch (numComponents) {
+    case 2: return ComponentKernel::Two;
+    case 3: return ComponentKernel::Three;
+    case 4: return ComponentKernel::Four;
+    default: return ComponentKernel::Runtime;
+    }
+}
+
+inline const char* GetComponentKernelName(ComponentKernel kernel)
+{
+    switch (kernel) {
+    case ComponentKernel::Runtime: return "Runtime";
+    case ComponentKernel::Two: return "2 components";
+    case ComponentKernel::Three: return "3 components";
+    case ComponentKernel::Four: return "4 components";
+    }
+    return "";
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ComponentDatabase.h"
+#include "ComponentKernel.h"
+
+// STL Includes
+#include <vector>
+#include <cstddef>
+
+enum class CubicModel { PengRobinson, SoaveRedlichKwong };
+
+// Which compressibility root to use. Stable picks the root with the lower Gibbs energy.
+enum class Phase { Vapour, Liquid, Stable };
+
+// Structure-of-arrays batch of mixture states. Fill the inputs, call CubicEOS::Evaluate and read
+// the outputs. Reusing a batch does not allocate.
+struct PropertyBatch {
+    // Inputs
+    std::vector<double> temperature;                    // [K]
+    std::vector<double> pressure;                       // [bar]
+    std::vector<std::vector<double>> moleFraction;      // [component][state]
+
+    // Outputs
+    std::vector<double> compressibility;                // Z [-]
+    std::vector<double> density;                        // [kg/m3]
+    std::vector<double> molarMass;                      // [kg/mol]
+    std::vector<double> enthalpy;                       // Relative to ideal gas at 298.15 K [J/mol]
+    std::vector<std::vector<double>> lnFugacityCoefficient; // [component][state]
+
+    void Resize(size_t numStates, size_t numComponents);
+    size_t GetSize() const { return temperature.size(); }
+
+private:
+    friend class CubicEOS;
+
+    // Per state work arrays
+    std::vector<std::vector<double>> sqrtA;             // sqrt(a_i(T)) [component][state]
+    std::vector<std::vector<double>> mixingSum;         // sum_j x_j (1 - k_ij) sqrt(a_j) [component][state]
+    std::vector<double> a, dadT, b, A, B, zVapour, zLiquid;
+};
+
+// Peng-Robinson and Soave-Redlich-Kwong equations of state for a fixed set of components with van
+// der Waals mixing rules. Batches are evaluated as a sequence of loops over the states, so the
+// mixing rules and the compressibility roots vectorise. The largest root is found by Newton steps
+// from the Cauchy bound, where the cubic is increasing and convex, so the steps need no branches.
+// The liquid root comes from the quadratic left after dividing out the largest root. Two to four
+// components use kernels compiled for that count, which run every step on a chunk of states held
+// on the stack, with the component loops unrolled, before moving to the next chunk.
+class CubicEOS {
+public:
+    CubicEOS(CubicModel model, const std::vector<Component>& components);
+
+    // Binary interaction parameter, symmetric, zero by default
+    void SetInteraction(size_t i, size_t j, double kij);
+
+    void Evaluate(PropertyBatch& batch, Phase phase = Phase::Vapour) const;
+
+    size_t GetNumComponents() const { return components.size(); }
+    const std::vector<Component>& GetComponents() const { return components; }
+    CubicModel GetModel() const { return model; }
+
+    // Chosen from the number of components on construction. A fixed count kernel that does not
+    // match the components falls back to the runtime one.
+    void SetKernel(ComponentKernel kernel);
+    ComponentKernel GetKernel() const { return kernel; }
+
+private:
+    void ComputeMixtureParameters(PropertyBatch& batch) const;
+    void SolveCompressibility(const double* A, const double* B, double* zVapour, double* zLiquid, double* Z, size_t n, Phase phase) const;
+    void ComputeProperties(PropertyBatch& batch) const;
+
+    template <size_t N>
+    void EvaluateFixed(PropertyBatch& batch, Phase phase) const;
+
+    CubicModel model;
+    ComponentKernel kernel = ComponentKernel::Runtime;
+    std::vector<Component> components;
+    double delta1 = 0.0, delta2 = 0.0;          // P = RT / (V - b) - a / ((V + delta1 b) (V + delta2 b))
+
+    // Per component constants
+    std::vector<double> ac;                     // a at the critical point [Pa m6/mol2]
+    std::vector<double> bc;                     // Co-volume [m3/mol]
+    std::vector<double> kappa;
+    std::vector<double> criticalTemperature;
+    std::vector<double> molarMass;
+    std::vector<double> kij;                    // Row-major components x components
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <cstddef>
+
+// How a long series is thinned before it is drawn
+enum class DecimationMethod { None, MinMax, Lttb };
+
+const char* GetDecimationName(DecimationMethod method);
+
+// Thins the points of a series with non-decreasing x that lie between xMin and xMax to about two
+// per pixel column. MinMax keeps the lowest and highest point of every column, so spikes and steps
+// survive. Lttb, largest triangle three buckets, keeps the point of every bucket that spans the
+// largest triangle with its neighbours, which follows smooth curves closely. The neighbours just
+// outside the range and the first and last points are always kept, so lines run to the edges and
+// fitting the axes still finds the whole series.
+void DecimateSeries(DecimationMethod method, const double* x, const double* y, size_t count,
+    double xMin, double xMax, int pixels, std::vector<double>& xOut, std::vector<double>& yOut);
+
+// Decimated copy of a series, redone only when the series or the view changes
+class DecimatedSeries {
+public:
+    void Update(DecimationMethod method, const double* x, const double* y, size_t count, double xMin, double xMax, int pixels);
+
+    std::vector<double> x;
+    std::vector<double> y;
+
+private:
+    DecimationMethod method = DecimationMethod::None;
+    const double* sourceX = nullptr;
+    const double* sourceY = nullptr;
+    size_t count = 0;
+    double lastX = 0.0;
+    double lastY = 0.0;
+    double xMin = 0.0;
+    double xMax = 0.0;
+    int pixels = 0;
+};
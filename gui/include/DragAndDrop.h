@@ -1,7 +1,22 @@
 #pragma once
 
+#include "Flowsheet.h"
+#include "FlowsheetIO.h"
+#include "NodeFactory.h"
+#include "SpatialGrid.h"
+#include "IconAtlas.h"
+#include "CanvasGrid.h"
+#include "FramePacing.h"
+#include "UndoJournal.h"
+#include "FlowsheetSolver.h"
+#include "EquationOrientedSolver.h"
+
 // ImGui Includes
 #include "hello_imgui/hello_imgui.h"
+#ifdef HELLOIMGUI_HAS_OPENGL
+#include "hello_imgui/internal/image_opengl.h"
+#endif
+#include "stb_image.h"
 
 #include <imgui.h>
 #include <imgui_internal.h> // For advanced features
@@ -10,20 +25,37 @@
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#ifdef EMSCRIPTEN
+#include <emscripten/emscripten.h>
+
+// Text the page's loadTextData resolved with, picked up by the editor on its next frame
+static std::string pendingFlowsheetText;
+static bool hasPendingFlowsheet = false;
 
-// Forward declarations
-class Node;
-class Connection;
+extern "C" EMSCRIPTEN_KEEPALIVE void thermatix_flowsheet_loaded(const char* text)
+{
+    pendingFlowsheetText = text ? text : "";
+    hasPendingFlowsheet = true;
+    FramePacing::Get().Request();
+}
+#endif
 
 
 static const ImGuiInputTextFlags_ inputDoubleFlags = ImGuiInputTextFlags_::ImGuiInputTextFlags_None; //ImGuiInputTextFlags_EnterReturnsTrue
 
 
-static void ShowDoubleInput(double& val, const std::string& label, const std::string& unit, const std::string& format, bool* isSelected)
+// Returns true if the value or its selection was changed
+static bool ShowDoubleInput(double& val, const std::string& label, const std::string& unit, const std::string& format, bool* isSelected)
 {
+    bool changed = false;
+
     ImGuiInputTextFlags_ flags = ImGuiInputTextFlags_::ImGuiInputTextFlags_ReadOnly;
     
-    if (isSelected)
+    if (isSelected && *isSelected)
         flags = ImGuiInputTextFlags_::ImGuiInputTextFlags_None;
     
     if (ImGui::BeginTable("##table", 3, ImGuiTableFlags_SizingStretchSame))
@@ -31,18 +63,20 @@ static void ShowDoubleInput(double& val, const std::string& label, const std::st
         ImGui::PushID(label.c_str());
 
         ImGui::TableNextColumn();
-        ImGui::Checkbox("##check", isSelected);
+        changed |= ImGui::Checkbox("##check", isSelected);
         ImGui::SameLine();
         ImGui::Text(label.c_str());
         ImGui::TableNextColumn();
         ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
-        ImGui::InputDouble("##input", &val, 0.0f, 0.0f, format.c_str(), flags);
+        changed |= ImGui::InputDouble("##input", &val, 0.0f, 0.0f, format.c_str(), flags);
         ImGui::TableNextColumn();
         ImGui::Text(unit.c_str());
 
         ImGui::PopID();
         ImGui::EndTable();
     }
+
+    return changed;
 }
 
 
@@ -65,485 +99,229 @@ static void ShowIntInput(int& val, const std::string& label, const std::string&
     }
 }
 
-// Vector math helpers
-struct Vec2 {
-    float x, y;
-    Vec2(float _x = 0.0f, float _y = 0.0f) : x(_x), y(_y) {}
-
-    Vec2 operator+(const Vec2& other) const { return Vec2(x + other.x, y + other.y); }
-    Vec2 operator-(const Vec2& other) const { return Vec2(x - other.x, y - other.y); }
-    Vec2 operator*(float scalar) const { return Vec2(x * scalar, y * scalar); }
-    float Length() const { return sqrt(x * x + y * y); }
-    Vec2 Normalized() const {
-        float len = Length();
-        if (len < 1e-6f) return Vec2(0, 0);
-        return Vec2(x / len, y / len);
-    }
-};
+// How much of the flowsheet is drawn, by zoom. Labels and text measurement go first, then icons
+// and ports, so a zoomed out plant-wide flowsheet is only boxes and lines.
+enum class CanvasDetail { Full, NoLabels, Boxes };
 
-// Connection point (inlet/outlet)
-struct ConnectionPoint {
-    Vec2 pos;               // Position relative to node
-    std::string name;       // Name of the connection point
-    bool isInput;           // Is this an input or output
-    Node* node;             // Parent node
-    Connection* connection; // Connection attached to this point, nullptr if none
-
-    ConnectionPoint(const std::string& _name, bool _isInput, const Vec2& _pos, Node* _node)
-        : name(_name), isInput(_isInput), pos(_pos), node(_node), connection(nullptr) {
-    }
-};
+// Render a node. origin is the screen position of the flowsheet origin, scale the zoom.
+static void RenderNode(const Node& node, ImDrawList* drawList, ImVec2 origin, float scale, CanvasDetail detail) {
+    // Convert position to screen coordinates
+    ImVec2 nodePos = ImVec2(origin.x + node.pos.x * scale, origin.y + node.pos.y * scale);
+    ImVec2 nodeEnd = ImVec2(nodePos.x + node.size.x * scale, nodePos.y + node.size.y * scale);
 
-// Base node class for all process elements
-class Node {
-public:
-    std::string imagePath; 
-    Vec2 pos;                                // Position in the canvas
-    Vec2 size;                               // Size of the node
-    std::string name;                        // Name of the node
-    std::string type;                        // Type of the node (valve, compressor, etc.)
-    bool isSelected;                         // Is the node currently selected
-    bool isBeingDragged;                     // Is the node being dragged
-    std::vector<ConnectionPoint> inputs;     // Input connection points
-    std::vector<ConnectionPoint> outputs;    // Output connection points
-
-    Node(const std::string& _name, const std::string& _type, const Vec2& _pos, const Vec2& _size)
-        : name(_name), type(_type), pos(_pos), size(_size), isSelected(false), isBeingDragged(false) {}
-
-    virtual ~Node() {}
-
-    // Get the absolute position of a connection point
-    Vec2 GetConnectionPointPos(const ConnectionPoint& point) const {
-        return pos + point.pos;
+    if (detail == CanvasDetail::Boxes) {
+        drawList->AddRectFilled(nodePos, nodeEnd, node.isSelected ? IM_COL32(200, 200, 200, 255) : IM_COL32(110, 110, 130, 255));
+        return;
     }
 
-    // Add an input connection point
-    void AddInputPoint(const std::string& name, const Vec2& relPos) {
-        inputs.emplace_back(name, true, relPos, this);
-    }
+    // Text follows the zoom
+    ImFont* font = ImGui::GetFont();
+    const float fontSize = ImGui::GetFontSize() * scale;
 
-    // Add an output connection point
-    void AddOutputPoint(const std::string& name, const Vec2& relPos) {
-        outputs.emplace_back(name, false, relPos, this);
+    // Draw node name above the node box
+    if (detail == CanvasDetail::Full) {
+        float nameWidth = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, node.name.c_str()).x;
+        ImVec2 namePos = ImVec2(nodePos.x + (node.size.x * scale - nameWidth) * 0.5f, nodePos.y - fontSize - 5 * scale);
+        drawList->AddText(font, fontSize, namePos, IM_COL32(220, 220, 220, 255), node.name.c_str());
     }
 
-    // Find the nearest connection point to the given position
-    ConnectionPoint* FindNearestConnectionPoint(const Vec2& testPos, float maxDist, bool inputsOnly = false, bool outputsOnly = false) {
-        
-        if (maxDist < 25.0f) maxDist = 25.0f;  // Ensure minimum snapping distance
-
-        ConnectionPoint* nearest = nullptr;
-        float minDist = maxDist;
-
-        if (!inputsOnly) {
-            for (auto& point : outputs) {
-                Vec2 pointPos = GetConnectionPointPos(point);
-                float dist = (pointPos - testPos).Length();
-                if (dist < minDist) {
-                    minDist = dist;
-                    nearest = &point;
-                }
-            }
-        }
+    // Draw node background
+    //ImU32 nodeColor = isSelected ? IM_COL32(100, 150, 250, 255) : IM_COL32(60, 60, 60, 255);
+    //drawList->AddRectFilled(nodePos,
+    //    ImVec2(nodePos.x + node.size.x, nodePos.y + node.size.y),
+    //    nodeColor,
+    //    4.0f);
 
-        if (!outputsOnly) {
-            for (auto& point : inputs) {
-                Vec2 pointPos = GetConnectionPointPos(point);
-                float dist = (pointPos - testPos).Length();
-                if (dist < minDist) {
-                    minDist = dist;
-                    nearest = &point;
-                }
-            }
+    // The icon is drawn beforehand, with the icons of all the other units in view
+    
+    // Draw border (always show border)
+    if (node.isSelected)
+        drawList->AddRect(nodePos,
+            nodeEnd,
+            IM_COL32(200, 200, 200, 255),
+            4.0f * scale,
+            ImDrawFlags_None,
+            2.0f);
+
+
+    // Draw connection points
+    const float pointRadius = 10.0f * scale;
+    for (const auto& input : node.inputs) {
+        ImVec2 pointPos = ImVec2(nodePos.x + input.pos.x * scale, nodePos.y + input.pos.y * scale);
+        drawList->AddCircleFilled(pointPos, pointRadius, IM_COL32(150, 150, 250, 255));
+
+        // Draw connection point name
+        if (detail == CanvasDetail::Full) {
+            float textWidth = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, input.name.c_str()).x;
+            ImVec2 textPos = ImVec2(pointPos.x + pointRadius - textWidth - 15 * scale, pointPos.y);
+            drawList->AddText(font, fontSize, textPos, IM_COL32(200, 200, 200, 255), input.name.c_str());
         }
-
-        return nearest;
     }
 
-    // Check if a point is inside the node
-    bool Contains(const Vec2& point) const {
-        return (point.x >= pos.x && point.x <= pos.x + size.x &&
-            point.y >= pos.y && point.y <= pos.y + size.y);
-    }
+    for (const auto& output : node.outputs) {
+        ImVec2 pointPos = ImVec2(nodePos.x + output.pos.x * scale, nodePos.y + output.pos.y * scale);
+        drawList->AddCircleFilled(pointPos, pointRadius, IM_COL32(250, 150, 150, 255));
 
-    // Render the node
-    virtual void Render(const ImVec2& canvasPos) {
-        ImDrawList* drawList = ImGui::GetWindowDrawList();
-
-        // Convert position to screen coordinates
-        ImVec2 nodePos = ImVec2(canvasPos.x + pos.x, canvasPos.y + pos.y);
-
-        // Draw node name above the node box
-        float textHeight = ImGui::GetTextLineHeight();
-        float nameWidth = ImGui::CalcTextSize(name.c_str()).x;
-        ImVec2 namePos = ImVec2(nodePos.x + (size.x - nameWidth) * 0.5f, nodePos.y - textHeight - 5);
-        drawList->AddText(namePos, IM_COL32(220, 220, 220, 255), name.c_str());
-
-        // Draw node background
-        //ImU32 nodeColor = isSelected ? IM_COL32(100, 150, 250, 255) : IM_COL32(60, 60, 60, 255);
-        //drawList->AddRectFilled(nodePos,
-        //    ImVec2(nodePos.x + size.x, nodePos.y + size.y),
-        //    nodeColor,
-        //    4.0f);
-
-        // Draw image using ImDrawList
-        if (!imagePath.empty()) {
-            ImTextureID texId = HelloImGui::ImageAndSizeFromAsset(imagePath.c_str()).textureId; // Returns ImTextureID
-            if (texId)
-                drawList->AddImage(texId, nodePos, ImVec2(nodePos.x + size.x, nodePos.y + size.y));
-        }
-        
-        // Draw border (always show border)
-        if (isSelected)
-            drawList->AddRect(nodePos,
-                ImVec2(nodePos.x + size.x, nodePos.y + size.y),
-                IM_COL32(200, 200, 200, 255),
-                4.0f,
-                ImDrawFlags_None,
-                2.0f);
-
-
-        // Draw connection points
-        const float pointRadius = 10.0f;
-        for (const auto& input : inputs) {
-            ImVec2 pointPos = ImVec2(nodePos.x + input.pos.x, nodePos.y + input.pos.y);
-            drawList->AddCircleFilled(pointPos, pointRadius, IM_COL32(150, 150, 250, 255));
-
-            // Draw connection point name
-            float textWidth = ImGui::CalcTextSize(input.name.c_str()).x;
-            ImVec2 textPos = ImVec2(pointPos.x + pointRadius - textWidth - 15, pointPos.y);
-            drawList->AddText(textPos, IM_COL32(200, 200, 200, 255), input.name.c_str());
-        }
-
-        for (const auto& output : outputs) {
-            ImVec2 pointPos = ImVec2(nodePos.x + output.pos.x, nodePos.y + output.pos.y);
-            drawList->AddCircleFilled(pointPos, pointRadius, IM_COL32(250, 150, 150, 255));
-
-            // Draw connection point name
-            float textWidth = ImGui::CalcTextSize(output.name.c_str()).x;
-            ImVec2 textPos = ImVec2(pointPos.x - pointRadius + 15, pointPos.y);
-            drawList->AddText(textPos, IM_COL32(200, 200, 200, 255), output.name.c_str());
+        // Draw connection point name
+        if (detail == CanvasDetail::Full) {
+            ImVec2 textPos = ImVec2(pointPos.x - pointRadius + 15 * scale, pointPos.y);
+            drawList->AddText(font, fontSize, textPos, IM_COL32(200, 200, 200, 255), output.name.c_str());
         }
     }
+}
 
-    // Open the properties window for this node
-    virtual void OpenPropertiesWindow() = 0;
-};
-
-struct DoubleDataVariable
-{
-    DoubleDataVariable(double& val, const std::string& param, const std::string& u, bool isSelected)
-        : value(val), parameter(param), unit(u), isSelected(isSelected) {}
-
-    bool isSelected = false;
-    double& value;
-    std::string parameter;
-    std::string unit;
-};
-
-class Valve : public Node
-{
-public:
-    Valve(const std::string& name, const Vec2& pos) : Node(name, "Valve", pos, Vec2(80,50))
-    {
-        AddInputPoint("In", Vec2(0, 25));
-        AddOutputPoint("Out", Vec2(80, 25));
-        imagePath = "icons/valve.png";
-
-        // Register all the "double" data
-        data.emplace_back(percentOpen, "Percent Open", "[-]", true);
-        data.emplace_back(CV, "Flow Coefficient (CV)", "[USGPM]", true);
-        data.emplace_back(dP, "Pressure Drop", "[bar]", false);
-    }
-
-    std::vector<DoubleDataVariable> data{};
-    double percentOpen = 50.0;
-    double CV = 100.0;
-    double dP = 0.1;
+// Render a connection as a bezier curve with an arrow at the inlet, or a straight line when
+// only boxes are drawn
+static void RenderConnection(const Connection& connection, ImDrawList* drawList, ImVec2 origin, float scale, CanvasDetail detail) {
+    const ConnectionPoint* from = connection.from;
+    const ConnectionPoint* to = connection.to;
+    if (!from || !to) return;
 
-    void OpenPropertiesWindow()
-    {
-        if (ImGui::Begin((name + " Properties###NodeProps").c_str(), nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-            ImGui::Text(type.c_str());
+    Vec2 startPos = from->node->GetConnectionPointPos(*from);
+    Vec2 endPos = to->node->GetConnectionPointPos(*to);
 
-            char nameBuf[256];
-            strcpy(nameBuf, name.c_str());
-            if (ImGui::InputText("##Name", nameBuf, sizeof(nameBuf))) {
-                name = nameBuf;
-            }
+    // Convert to screen coordinates
+    ImVec2 startPosScreen = ImVec2(origin.x + startPos.x * scale, origin.y + startPos.y * scale);
+    ImVec2 endPosScreen = ImVec2(origin.x + endPos.x * scale, origin.y + endPos.y * scale);
 
-            if (ImGui::CollapsingHeader("Properties"))
-            {
-                for (auto& parameter : data)
-                {
-                    ShowDoubleInput(parameter.value, parameter.parameter, parameter.unit, "%.6f", &parameter.isSelected);
-                }
-            }
-        }
-
-        ImGui::End();
+    if (detail == CanvasDetail::Boxes) {
+        drawList->AddLine(startPosScreen, endPosScreen, IM_COL32(200, 200, 200, 255), 1.0f);
+        return;
     }
 
-};
+    // Calculate control points for a bezier curve
+    Vec2 delta = endPos - startPos;
+    float curvature = std::min(100.0f, delta.Length() * 0.5f) * scale;
+
+    ImVec2 cp1 = ImVec2(startPosScreen.x + curvature, startPosScreen.y);
+    ImVec2 cp2 = ImVec2(endPosScreen.x - curvature, endPosScreen.y);
+
+    // Draw the curve
+    drawList->AddBezierCubic(
+        startPosScreen, cp1, cp2, endPosScreen,
+        IM_COL32(200, 200, 200, 255), 2.0f
+    );
+
+    // Draw arrow at the end
+    Vec2 dir = ((endPos - startPos).Normalized());
+    Vec2 normal = Vec2(-dir.y, dir.x) * 5.0f;
+    Vec2 arrowEnd = endPos - dir * 10.0f;
+    Vec2 arrowP1 = arrowEnd + normal;
+    Vec2 arrowP2 = arrowEnd - normal;
+
+    drawList->AddTriangleFilled(
+        endPosScreen,
+        ImVec2(origin.x + arrowP1.x * scale, origin.y + arrowP1.y * scale),
+        ImVec2(origin.x + arrowP2.x * scale, origin.y + arrowP2.y * scale),
+        IM_COL32(200, 200, 200, 255)
+    );
+}
 
-class Inlet : public Node
+// Properties window of a node, generated from its registered "double" data
+// Edits go into the journal, typing into one field is one step
+static void ShowPropertiesWindow(Node& node, UndoJournal& journal)
 {
-public:
-    Inlet(const std::string& name, const Vec2& pos) : Node(name, "Inlet", pos, Vec2(40, 50))
-    {
-        AddInputPoint("In", Vec2(0, 25));
-        AddOutputPoint("Out", Vec2(40, 25));
-        imagePath = "icons/inlet.png";
-
-        // Register all the "double" data
-        data.emplace_back(pressure, "Pressure", "[bar]", true);
-        data.emplace_back(massFlowRate, "Mass Flow Rate", "[kg/s]", false);
-        data.emplace_back(temperature, "Temperature", "[K]", true);
-    }
-
-    std::vector<DoubleDataVariable> data{};
-    double pressure = 1.01325;
-    double massFlowRate = 1;
-    double temperature = 298.0;
-
-    void OpenPropertiesWindow()
-    {
-        if (ImGui::Begin((name + " Properties###NodeProps").c_str(), nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-            ImGui::Text(type.c_str());
-
-            char nameBuf[256];
-            strcpy(nameBuf, name.c_str());
-            if (ImGui::InputText("##Name", nameBuf, sizeof(nameBuf))) {
-                name = nameBuf;
-            }
+    if (ImGui::Begin((node.name + " Properties###NodeProps").c_str(), nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text(node.type.c_str());
+
+        char nameBuf[Node::MaxNameLength + 1];
+        snprintf(nameBuf, sizeof(nameBuf), "%s", node.name.c_str());
+        if (ImGui::InputText("##Name", nameBuf, sizeof(nameBuf))) {
+            const std::string oldName = node.name;
+            node.name = nameBuf;
+            journal.RecordRename(&node, oldName);
+        }
 
-            if (ImGui::CollapsingHeader("Properties"))
+        if (ImGui::CollapsingHeader("Properties"))
+        {
+            for (size_t i = 0; i < node.data.size(); ++i)
             {
-                for (auto& parameter : data)
-                {
-                    ShowDoubleInput(parameter.value, parameter.parameter, parameter.unit, "%.6f", &parameter.isSelected);
+                auto& parameter = node.data[i];
+                const double oldValue = parameter.value;
+                const bool oldSelected = parameter.isSelected;
+                if (ShowDoubleInput(parameter.value, parameter.parameter, parameter.unit, "%.6f", &parameter.isSelected)) {
+                    node.isDirty = true;
+                    journal.RecordValue(&node, i, oldValue, oldSelected);
                 }
             }
         }
-
-        ImGui::End();
-    }
-
-};
-
-// Connection between nodes
-class Connection {
-public:
-    ConnectionPoint* from;
-    ConnectionPoint* to;
-
-    Connection(ConnectionPoint* _from, ConnectionPoint* _to) : from(_from), to(_to) {
-        from->connection = this;
-        to->connection = this;
-    }
-
-    ~Connection() {
-        // Disconnect points
-        if (from) from->connection = nullptr;
-        if (to) to->connection = nullptr;
-    }
-
-    void Render(ImDrawList* drawList, ImVec2 offset) {
-        if (!from || !to) return;
-
-        Vec2 startPos = from->node->GetConnectionPointPos(*from);
-        Vec2 endPos = to->node->GetConnectionPointPos(*to);
-
-        // Convert to screen coordinates
-        ImVec2 startPosScreen = ImVec2(offset.x + startPos.x, offset.y + startPos.y);
-        ImVec2 endPosScreen = ImVec2(offset.x + endPos.x, offset.y + endPos.y);
-
-        // Calculate control points for a bezier curve
-        Vec2 delta = endPos - startPos;
-        float curvature = std::min(100.0f, delta.Length() * 0.5f);
-
-        ImVec2 cp1 = ImVec2(startPosScreen.x + curvature, startPosScreen.y);
-        ImVec2 cp2 = ImVec2(endPosScreen.x - curvature, endPosScreen.y);
-
-        // Draw the curve
-        drawList->AddBezierCubic(
-            startPosScreen, cp1, cp2, endPosScreen,
-            IM_COL32(200, 200, 200, 255), 2.0f
-        );
-
-        // Draw arrow at the end
-        Vec2 dir = ((endPos - startPos).Normalized());
-        Vec2 normal = Vec2(-dir.y, dir.x) * 5.0f;
-        Vec2 arrowEnd = endPos - dir * 10.0f;
-        Vec2 arrowP1 = arrowEnd + normal;
-        Vec2 arrowP2 = arrowEnd - normal;
-
-        drawList->AddTriangleFilled(
-            ImVec2(offset.x + endPos.x, offset.y + endPos.y),
-            ImVec2(offset.x + arrowP1.x, offset.y + arrowP1.y),
-            ImVec2(offset.x + arrowP2.x, offset.y + arrowP2.y),
-            IM_COL32(200, 200, 200, 255)
-        );
-    }
-};
-
-// Factory for creating nodes
-class NodeFactory {
-private:
-    std::unordered_map<std::string, std::function<std::unique_ptr<Node>(const std::string&, const Vec2&)>> factories;
-
-public:
-    NodeFactory() {
-        // Register node types
-        RegisterNodeType("Valve", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> 
-        {
-            return std::make_unique<Valve>(name, pos);
-        });
-
-        //RegisterNodeType("Compressor", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Compressor", pos, Vec2(140, 100));
-        //    node->AddInputPoint("Suction", Vec2(0, 50));
-        //    node->AddOutputPoint("Discharge", Vec2(140, 50));
-        //    node->parameters["Pressure Ratio"] = 2.0f;
-        //    node->parameters["Efficiency"] = 0.75f;
-        //    node->parameters["Power"] = 100.0f;
-        //    node->imagePath = "icons/valve.png";
-        //
-        //    return node;
-        //});
-        //
-        //RegisterNodeType("Tank", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Tank", pos, Vec2(120, 160));
-        //    node->AddInputPoint("In", Vec2(0, 60));
-        //    node->AddOutputPoint("Out", Vec2(120, 100));
-        //    node->parameters["Volume"] = 10.0f;
-        //    node->parameters["Initial Level"] = 5.0f;
-        //    node->parameters["Max Pressure"] = 100.0f;
-        //    node->imagePath = "icons/tank.png";
-        //
-        //    return node;
-        //});
-        //
-        //RegisterNodeType("Pipe", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Pipe", pos, Vec2(160, 70));
-        //    node->AddInputPoint("In", Vec2(0, 35));
-        //    node->AddOutputPoint("Out", Vec2(160, 35));
-        //    node->parameters["Length"] = 10.0f;
-        //    node->parameters["Diameter"] = 0.1f;
-        //    node->parameters["Roughness"] = 0.001f;
-        //    node->imagePath = "icons/pipe.png";
-        //
-        //    return node;
-        //});
-        //
-        //RegisterNodeType("Inlet", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Inlet", pos, Vec2(100, 60));
-        //    node->AddOutputPoint("Out", Vec2(100, 30));
-        //    node->parameters["Flow Rate"] = 10.0f;
-        //    node->parameters["Temperature"] = 25.0f;
-        //    node->parameters["Pressure"] = 101.3f;
-        //    node->imagePath = "icons/valve.png";
-        //
-        //    return node;
-        //});
-        //
-        //RegisterNodeType("Outlet", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Outlet", pos, Vec2(100, 60));
-        //    node->AddInputPoint("In", Vec2(0, 30));
-        //    node->parameters["Pressure"] = 101.3f;
-        //    node->imagePath = "icons/valve.png";
-        //
-        //    return node;
-        //});
-        //
-        //RegisterNodeType("Splitter", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Splitter", pos, Vec2(120, 120));
-        //    node->AddInputPoint("In", Vec2(0, 60));
-        //    node->AddOutputPoint("Out1", Vec2(120, 30));
-        //    node->AddOutputPoint("Out2", Vec2(120, 60));
-        //    node->AddOutputPoint("Out3", Vec2(120, 90));
-        //    node->parameters["Split Ratio 1"] = 0.33f;
-        //    node->parameters["Split Ratio 2"] = 0.33f;
-        //    node->parameters["Split Ratio 3"] = 0.34f;
-        //    node->imagePath = "icons/splitter.png";
-        //
-        //    return node;
-        //});
-        //
-        //RegisterNodeType("Mixer", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
-        //    auto node = std::make_unique<Node>(name, "Mixer", pos, Vec2(120, 120));
-        //    node->AddInputPoint("In1", Vec2(0, 30));
-        //    node->AddInputPoint("In2", Vec2(0, 60));
-        //    node->AddInputPoint("In3", Vec2(0, 90));
-        //    node->AddOutputPoint("Out", Vec2(120, 60));
-        //    node->parameters["Pressure Drop"] = 5.0f;
-        //    node->parameters["Efficiency"] = 0.95f;
-        //    node->imagePath = "icons/mixer.png";
-        //
-        //    return node;
-        //});
-    }
-
-    // Register a new node type
-    void RegisterNodeType(const std::string& type, std::function<std::unique_ptr<Node>(const std::string&, const Vec2&)> factory) {
-        factories[type] = factory;
-    }
-
-    // Create a node of the specified type
-    std::unique_ptr<Node> CreateNode(const std::string& type, const std::string& name, const Vec2& pos) {
-        if (factories.find(type) != factories.end()) {
-            return factories[type](name, pos);
-        }
-        return nullptr;
     }
 
-    std::string NodeFactory::GetImagePathForType(const std::string& type) {
-        auto tempNode = CreateNode(type, "temp", Vec2(0, 0));
-        return tempNode ? tempNode->imagePath : "icons/valve.png";
-    }
+    ImGui::End();
+}
 
-    // Get all registered node types
-    std::vector<std::string> GetNodeTypes() const {
-        std::vector<std::string> types;
-        for (const auto& pair : factories) {
-            types.push_back(pair.first);
-        }
-        return types;
-    }
-};
 
 // Main application state
 class FlowsheetEditor {
 private:
-    std::vector<std::unique_ptr<Node>> nodes;
-    std::vector<std::unique_ptr<Connection>> connections;
+    Flowsheet flowsheet;
     NodeFactory nodeFactory;
-    std::unordered_map<std::string, ImTextureID> textureCache;
+    SpatialGrid spatialGrid;                 // Unit bounds and ports for clicks and snapping
+    UndoJournal journal;
+    std::vector<std::pair<NodeHandle, Vec2>> dragStarts; // Units being dragged and where they were picked up
+    std::vector<Node*> nearbyNodes;
+
+    // Unit icons, packed into one texture the first time the canvas is drawn. Without OpenGL
+    // every icon is its own asset texture instead, in iconTextures by handle.
+    IconAtlas iconAtlas;
+    bool iconsLoaded = false;
+    ImTextureID iconTexture = nullptr;
+    std::vector<ImTextureID> iconTextures;
+#ifdef HELLOIMGUI_HAS_OPENGL
+    std::unique_ptr<HelloImGui::ImageOpenGl> iconImage;
+#endif
+
+    // Solver state
+    FlowsheetSolver solver;
+    EquationOrientedSolver equationSolver;
+    bool useEquationOriented = false;
+    bool autoSolve = true;                   // Re-solve the stale part of the flowsheet after every edit
+    bool flowsheetEdited = false;            // Set by edits made during this frame
+    bool isModified = false;                 // Changed since the last save, load or autosave
+    SolveReport lastSolveReport;
+    bool hasSolved = false;
 
     // UI State
-    Vec2 canvasOffset;
-    float canvasScale;
+    Vec2 canvasOffset;                       // Screen offset of the flowsheet origin in the canvas
+    float canvasScale;                       // Zoom, screen pixels per flowsheet unit
+    Vec2 canvasViewSize;                     // Size of the canvas last frame
+    std::vector<Node*> visibleNodes;
+    std::vector<Connection*> visibleConnections;
+    CanvasGrid canvasGrid;                   // Background lines, rebuilt only on resize or zoom
     bool isDraggingCanvas;
     Vec2 dragStartPos;
 
     // Drag state for connections
     bool isCreatingConnection;
-    ConnectionPoint* connectionStartPoint;
+    PortHandle connectionStartPort;
     Vec2 connectionEndPos;
 
-    // Node state
-    Node* selectedNode;
+    // Node state. Units are held by handle, which resolves to nullptr once a unit was deleted.
+    NodeHandle selectedNode;
     bool showPropertiesWindow;
 
+    // Zoom range and the zoom below which labels, then icons and ports, are left out
+    const float minScale = 0.05f;
+    const float maxScale = 3.0f;
+    const float fullDetailScale = 0.6f;
+    const float boxDetailScale = 0.3f;
+
     // Double-click detection
     float lastClickTime;
-    Node* lastClickedNode;
+    NodeHandle lastClickedNode;
+
+    // Files. A path ending in .thxf is a binary snapshot, anything else JSON. Native builds
+    // also write a snapshot of unsaved work every autosaveInterval seconds.
+    char flowsheetPath[256] = "flowsheet.json";
+    std::string fileMessage;
+    const char* autosavePath = "autosave.thxf";
+    double autosaveInterval = 30.0;
+    double lastAutosaveTime = 0.0;
 
 public:
     FlowsheetEditor()
         : canvasOffset(0, 0), canvasScale(1.0f), isDraggingCanvas(false), isCreatingConnection(false),
-        connectionStartPoint(nullptr), selectedNode(nullptr), showPropertiesWindow(false),
-        lastClickTime(0), lastClickedNode(nullptr) {
+        showPropertiesWindow(false), lastClickTime(0) {
     }
 
     void Render() 
@@ -567,22 +345,36 @@ public:
             ImDrawList* drawList = ImGui::GetWindowDrawList();
 
             // Draw grid
-            DrawGrid(drawList, canvasPos, canvasSize);
-
-            // Draw existing connections
-            for (const auto& connection : connections) {
-                connection->Render(drawList, canvasPos);
+            canvasGrid.Draw(drawList, canvasPos, canvasSize, ImVec2(canvasOffset.x, canvasOffset.y), canvasScale);
+
+            // Flowsheet to screen: origin + position * canvasScale
+            const ImVec2 origin = ImVec2(canvasPos.x + canvasOffset.x, canvasPos.y + canvasOffset.y);
+            const CanvasDetail detail = canvasScale >= fullDetailScale ? CanvasDetail::Full
+                : canvasScale >= boxDetailScale ? CanvasDetail::NoLabels : CanvasDetail::Boxes;
+            canvasViewSize = Vec2(canvasSize.x, canvasSize.y);
+
+            // Visible part of the flowsheet, with room for names and port labels sticking out
+            const float pad = 100.0f;
+            const Vec2 viewMin(-canvasOffset.x / canvasScale - pad, -canvasOffset.y / canvasScale - pad);
+            const Vec2 viewMax((canvasSize.x - canvasOffset.x) / canvasScale + pad, (canvasSize.y - canvasOffset.y) / canvasScale + pad);
+
+            // Draw the connections whose end points span a box overlapping the view, found
+            // through the units around it
+            spatialGrid.QueryConnections(viewMin, viewMax, visibleConnections);
+            for (Connection* connection : visibleConnections) {
+                RenderConnection(*connection, drawList, origin, canvasScale, detail);
             }
 
             // Draw new connection if creating one
-            if (isCreatingConnection && connectionStartPoint) {
+            const ConnectionPoint* connectionStartPoint = isCreatingConnection ? flowsheet.Get(connectionStartPort) : nullptr;
+            if (connectionStartPoint) {
                 Vec2 startPos = connectionStartPoint->node->GetConnectionPointPos(*connectionStartPoint);
-                ImVec2 startPosScreen = ImVec2(canvasPos.x + startPos.x, canvasPos.y + startPos.y);
-                ImVec2 endPosScreen = ImVec2(canvasPos.x + connectionEndPos.x, canvasPos.y + connectionEndPos.y);
+                ImVec2 startPosScreen = ImVec2(origin.x + startPos.x * canvasScale, origin.y + startPos.y * canvasScale);
+                ImVec2 endPosScreen = ImVec2(origin.x + connectionEndPos.x * canvasScale, origin.y + connectionEndPos.y * canvasScale);
 
                 // Calculate control points
                 Vec2 delta = connectionEndPos - startPos;
-                float curvature = std::min(100.0f, delta.Length() * 0.5f);
+                float curvature = std::min(100.0f, delta.Length() * 0.5f) * canvasScale;
 
                 ImVec2 cp1 = ImVec2(startPosScreen.x + curvature, startPosScreen.y);
                 ImVec2 cp2 = ImVec2(endPosScreen.x - curvature, endPosScreen.y);
@@ -592,11 +384,20 @@ public:
                     startPosScreen, cp1, cp2, endPosScreen,
                     IM_COL32(200, 200, 200, 128), 2.0f
                 );
+
+                // Ring around the port the connection would snap to
+                if (const ConnectionPoint* target = FindSnapTarget()) {
+                    Vec2 targetPos = target->node->GetConnectionPointPos(*target);
+                    drawList->AddCircle(ImVec2(origin.x + targetPos.x * canvasScale, origin.y + targetPos.y * canvasScale),
+                        13.0f * canvasScale, IM_COL32(250, 250, 150, 255), 0, 2.0f);
+                }
             }
 
-            // Draw all nodes
-            for (const auto& node : nodes) {
-                node->Render(canvasPos);
+            // Draw the nodes in view
+            spatialGrid.QueryRect(viewMin, viewMax, visibleNodes);
+            if (detail != CanvasDetail::Boxes) DrawIcons(drawList, origin);
+            for (Node* node : visibleNodes) {
+                RenderNode(*node, drawList, origin, canvasScale, detail);
             }
 
             // Handle canvas interactions
@@ -607,46 +408,182 @@ public:
         ImGui::End(); // End main window
 
         // Show properties window if needed
-        if (showPropertiesWindow && selectedNode) {
-            selectedNode->OpenPropertiesWindow();
+        Node* selected = flowsheet.Get(selectedNode);
+        if (showPropertiesWindow && selected) {
+            ShowPropertiesWindow(*selected, journal);
+            if (selected->isDirty) flowsheetEdited = true;
         }
-    }
 
-private:
-    void DrawGrid(ImDrawList* drawList, ImVec2 canvasPos, ImVec2 canvasSize) {
-        const float gridSize = 20.0f;
+        // Typing or dragging in a widget is one step, up to letting go of it
+        if (!ImGui::IsAnyItemActive()) journal.Seal();
 
-        // Calculate grid bounds
-        float startX = canvasPos.x + canvasOffset.x;
-        float startY = canvasPos.y + canvasOffset.y;
-        float endX = canvasPos.x + canvasSize.x;
-        float endY = canvasPos.y + canvasSize.y;
+        if (autoSolve && hasSolved && flowsheetEdited) {
+            RunSolver(true);
+        }
+        if (flowsheetEdited) isModified = true;
+        flowsheetEdited = false;
+
+#ifdef EMSCRIPTEN
+        if (hasPendingFlowsheet) {
+            hasPendingFlowsheet = false;
+            if (!pendingFlowsheetText.empty()) LoadFlowsheetData(pendingFlowsheetText);
+            pendingFlowsheetText.clear();
+        }
+#else
+        if (isModified && ImGui::GetTime() - lastAutosaveTime > autosaveInterval) {
+            std::ofstream file(autosavePath, std::ios::binary);
+            file << SaveFlowsheetSnapshot(flowsheet);
+            lastAutosaveTime = ImGui::GetTime();
+            isModified = false;
+        }
+#endif
+    }
 
-        // Calculate grid lines starting positions
-        float gridOffsetX = fmodf(canvasOffset.x, gridSize);
-        float gridOffsetY = fmodf(canvasOffset.y, gridSize);
+    // JSON to the page's storeTextData on the web, to flowsheetPath otherwise
+    void Save()
+    {
+#ifdef EMSCRIPTEN
+        const std::string text = SaveFlowsheet(flowsheet);
+        EM_ASM({ window.parent.storeTextData(UTF8ToString($0)); }, text.c_str());
+        isModified = false;
+#else
+        const std::string path = flowsheetPath;
+        const bool snapshot = path.size() > 5 && path.compare(path.size() - 5, 5, ".thxf") == 0;
+        std::ofstream file(path, std::ios::binary);
+        if (file << (snapshot ? SaveFlowsheetSnapshot(flowsheet) : SaveFlowsheet(flowsheet))) {
+            fileMessage = "Saved " + path;
+            isModified = false;
+        }
+        else {
+            fileMessage = "Cannot write " + path;
+        }
+#endif
+    }
 
-        // Draw minor grid lines
-        for (float x = startX + gridOffsetX; x < endX; x += gridSize) {
-            drawList->AddLine(ImVec2(x, startY), ImVec2(x, endY), IM_COL32(50, 50, 50, 40));
+    // On the web the page calls thermatix_flowsheet_loaded once the user picked a flowsheet
+    void Load()
+    {
+#ifdef EMSCRIPTEN
+        EM_ASM({
+            window.parent.loadTextData().then(function(text) {
+                Module.ccall('thermatix_flowsheet_loaded', null, ['string'], [text || '']);
+            });
+        });
+#else
+        std::ifstream file(flowsheetPath, std::ios::binary);
+        if (!file) {
+            fileMessage = std::string("Cannot read ") + flowsheetPath;
+            return;
         }
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        if (LoadFlowsheetData(buffer.str())) fileMessage = std::string("Loaded ") + flowsheetPath;
+#endif
+    }
 
-        for (float y = startY + gridOffsetY; y < endY; y += gridSize) {
-            drawList->AddLine(ImVec2(startX, y), ImVec2(endX, y), IM_COL32(50, 50, 50, 40));
+    void RunSolver(bool incremental)
+    {
+        if (useEquationOriented)
+            lastSolveReport = equationSolver.Solve(flowsheet.nodes, flowsheet.connections); // Newton starts from the current state
+        else if (incremental)
+            lastSolveReport = solver.SolveIncremental(flowsheet.nodes, flowsheet.connections);
+        else
+            lastSolveReport = solver.Solve(flowsheet.nodes, flowsheet.connections);
+
+        hasSolved = true;
+    }
+
+private:
+    // JSON or snapshot. The current flowsheet is kept if data is not a valid flowsheet.
+    bool LoadFlowsheetData(const std::string& data)
+    {
+        Flowsheet loaded;
+        std::string error;
+        const bool ok = IsFlowsheetSnapshot(data) ? LoadFlowsheetSnapshot(data, nodeFactory, loaded, error) : LoadFlowsheet(data, nodeFactory, loaded, error);
+        if (!ok) {
+            fileMessage = error;
+            return false;
         }
 
-        // Draw major grid lines
-        const float majorGridSize = gridSize * 5;
-        float majorGridOffsetX = fmodf(canvasOffset.x, majorGridSize);
-        float majorGridOffsetY = fmodf(canvasOffset.y, majorGridSize);
+        // Connections go before the nodes they point into
+        flowsheet.Clear();
+        flowsheet = std::move(loaded);
+        spatialGrid.Rebuild(flowsheet.nodes);
+        journal.Clear();
+        dragStarts.clear();
+
+        showPropertiesWindow = false;
+        isCreatingConnection = false;
+        hasSolved = false;
+        isModified = false;
+        fileMessage.clear();
+        return true;
+    }
+
+    // Port of another node the connection being created would snap to, an input if it started
+    // at an output and the other way round
+    ConnectionPoint* FindSnapTarget() const
+    {
+        const ConnectionPoint* connectionStartPoint = isCreatingConnection ? flowsheet.Get(connectionStartPort) : nullptr;
+        if (!connectionStartPoint) return nullptr;
+        return spatialGrid.FindNearestPort(connectionEndPos, spatialGrid.GetMargin(), !connectionStartPoint->isInput,
+            connectionStartPoint->isInput, connectionStartPoint->node);
+    }
 
-        for (float x = startX + majorGridOffsetX; x < endX; x += majorGridSize) {
-            drawList->AddLine(ImVec2(x, startY), ImVec2(x, endY), IM_COL32(50, 50, 50, 80));
+    // Decodes the icon of every unit type into the atlas and uploads it as one texture
+    void LoadIcons() {
+        iconsLoaded = true;
+        std::vector<std::string> paths;
+        for (const auto& type : nodeFactory.GetNodeTypes()) {
+            const std::string path = nodeFactory.GetImagePathForType(type);
+            if (iconAtlas.Find(path) != IconAtlas::NoIcon || !HelloImGui::AssetExists(path)) continue;
+
+            HelloImGui::AssetFileData file = HelloImGui::LoadAssetFileData(path.c_str());
+            int width = 0, height = 0, channels = 0;
+            unsigned char* rgba = stbi_load_from_memory(static_cast<const stbi_uc*>(file.data), static_cast<int>(file.dataSize),
+                &width, &height, &channels, 4);
+            HelloImGui::FreeAssetFileData(&file);
+            if (!rgba) continue;
+
+            if (iconAtlas.Add(path, rgba, width, height) != IconAtlas::NoIcon) paths.push_back(path);
+            stbi_image_free(rgba);
         }
 
-        for (float y = startY + majorGridOffsetY; y < endY; y += majorGridSize) {
-            drawList->AddLine(ImVec2(startX, y), ImVec2(endX, y), IM_COL32(50, 50, 50, 80));
+#ifdef HELLOIMGUI_HAS_OPENGL
+        if (iconAtlas.Build()) {
+            // The pixels are only read
+            iconImage = std::make_unique<HelloImGui::ImageOpenGl>();
+            iconImage->_impl_StoreTexture(iconAtlas.GetWidth(), iconAtlas.GetHeight(), const_cast<unsigned char*>(iconAtlas.GetPixels().data()));
+            iconTexture = iconImage->TextureID();
+            return;
         }
+#endif
+        iconTextures.resize(iconAtlas.GetNumIcons(), nullptr);
+        for (const auto& path : paths) iconTextures[iconAtlas.Find(path)] = HelloImGui::ImTextureIdFromAsset(path.c_str());
+    }
+
+    // Icons of the units in view, as one batch of quads from the atlas. A unit looks its icon
+    // up once, after that it is drawn by handle.
+    void DrawIcons(ImDrawList* drawList, ImVec2 origin) {
+        if (!iconsLoaded) LoadIcons();
+
+        if (iconTexture) drawList->PushTextureID(iconTexture);
+        for (Node* node : visibleNodes) {
+            if (node->iconHandle == Node::UnresolvedIcon) node->iconHandle = iconAtlas.Find(node->imagePath);
+            if (node->iconHandle == IconAtlas::NoIcon) continue;
+
+            const ImVec2 nodePos(origin.x + node->pos.x * canvasScale, origin.y + node->pos.y * canvasScale);
+            const ImVec2 nodeEnd(nodePos.x + node->size.x * canvasScale, nodePos.y + node->size.y * canvasScale);
+            if (iconTexture) {
+                const IconAtlas::Icon& icon = iconAtlas.GetIcon(node->iconHandle);
+                drawList->PrimReserve(6, 4);
+                drawList->PrimRectUV(nodePos, nodeEnd, ImVec2(icon.u0, icon.v0), ImVec2(icon.u1, icon.v1), IM_COL32_WHITE);
+            }
+            else if (iconTextures[node->iconHandle]) {
+                drawList->AddImage(iconTextures[node->iconHandle], nodePos, nodeEnd);
+            }
+        }
+        if (iconTexture) drawList->PopTextureID();
     }
 
     void HandleCanvasInteractions() {
@@ -657,7 +594,7 @@ private:
         // Get canvas position and mouse position
         ImVec2 canvasPos = ImGui::GetCursorScreenPos();
         ImVec2 mousePos = ImGui::GetMousePos();
-        Vec2 mouseCanvasPos = Vec2(mousePos.x - canvasPos.x, mousePos.y - canvasPos.y);
+        Vec2 mouseCanvasPos = Vec2((mousePos.x - canvasPos.x - canvasOffset.x) / canvasScale, (mousePos.y - canvasPos.y - canvasOffset.y) / canvasScale);
 
         // Handle mouse dragging (panning)
         if (ImGui::IsMouseDragging(ImGuiMouseButton_Middle)) {
@@ -676,27 +613,25 @@ private:
             isDraggingCanvas = false;
         }
 
-        // Handle zooming (for future implementation)
-        //float wheel = ImGui::GetIO().MouseWheel;
-        //if (wheel != 0) {
-        //    canvasScale = ImClamp(canvasScale + wheel * 0.1f, 0.1f, 3.0f);
-        //}
+        // Zoom about the mouse, the flowsheet point under it stays where it is
+        float wheel = ImGui::GetIO().MouseWheel;
+        if (wheel != 0) {
+            canvasScale = ImClamp(canvasScale * powf(1.1f, wheel), minScale, maxScale);
+            canvasOffset.x = mousePos.x - canvasPos.x - mouseCanvasPos.x * canvasScale;
+            canvasOffset.y = mousePos.y - canvasPos.y - mouseCanvasPos.y * canvasScale;
+        }
 
         // Handle node selection
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-            // Check if clicked on a node
-            Node* clickedNode = nullptr;
-            float minDistSq = 999999.0f;
-            const float SNAP_RADIUS = 20.0f;
-
-            for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
-                Node* node = it->get();
-                if (node->Contains(mouseCanvasPos)) {
-                    // Direct hit, prioritize this
-                    clickedNode = node;
-                    break;
-                }
-                else {
+            // Direct hit on the topmost node, else the node whose right edge is nearest, within
+            // snapping distance
+            Node* clickedNode = spatialGrid.FindNodeAt(mouseCanvasPos);
+            if (!clickedNode) {
+                float minDistSq = 999999.0f;
+                const float SNAP_RADIUS = 20.0f;
+
+                spatialGrid.QueryPoint(mouseCanvasPos, nearbyNodes);
+                for (Node* node : nearbyNodes) {
                     // Calculate distance from mouse to node center
                     ImVec2 center = ImVec2(node->pos.x + node->size.x,
                         node->pos.y + node->size.y * 0.5f);
@@ -715,13 +650,14 @@ private:
             if (clickedNode) {
                 // Handle double click
                 float currentTime = ImGui::GetTime();
-                if (clickedNode == lastClickedNode && currentTime - lastClickTime < 0.3f) {
+                const NodeHandle clickedHandle = flowsheet.GetHandle(clickedNode);
+                if (clickedHandle == lastClickedNode && currentTime - lastClickTime < 0.3f) {
                     // Double click detected
-                    selectedNode = clickedNode;
+                    selectedNode = clickedHandle;
                     showPropertiesWindow = true;
                 }
 
-                lastClickedNode = clickedNode;
+                lastClickedNode = clickedHandle;
                 lastClickTime = currentTime;
 
                 // Check if clicked on a connection point
@@ -729,30 +665,31 @@ private:
                 if (clickedPoint) {
                     // Start creating a new connection
                     isCreatingConnection = true;
-                    connectionStartPoint = clickedPoint;
+                    connectionStartPort = flowsheet.GetHandle(clickedPoint);
                     connectionEndPos = mouseCanvasPos;
                 }
                 else {
                     // Select the node
                     if (!(ImGui::GetIO().KeyCtrl || ImGui::GetIO().KeyShift)) {
                         // Deselect all nodes first if not multi-selecting
-                        for (const auto& node : nodes) {
+                        for (const auto& node : flowsheet.nodes) {
                             node->isSelected = false;
                         }
                     }
 
                     clickedNode->isSelected = true;
-                    selectedNode = clickedNode;
+                    selectedNode = clickedHandle;
                     clickedNode->isBeingDragged = true;
+                    dragStarts.assign(1, { clickedHandle, clickedNode->pos });
                 }
             }
             else {
                 // Clicked on empty space, deselect all if not holding Ctrl
                 if (!(ImGui::GetIO().KeyCtrl || ImGui::GetIO().KeyShift)) {
-                    for (const auto& node : nodes) {
+                    for (const auto& node : flowsheet.nodes) {
                         node->isSelected = false;
                     }
-                    selectedNode = nullptr;
+                    selectedNode = NodeHandle();
                 }
             }
         }
@@ -767,10 +704,12 @@ private:
                 // Drag selected nodes
                 ImVec2 dragDelta = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left);
 
-                for (auto& node : nodes) {
+                for (auto& node : flowsheet.nodes) {
                     if (node->isBeingDragged) {
-                        node->pos.x += dragDelta.x;
-                        node->pos.y += dragDelta.y;
+                        node->pos.x += dragDelta.x / canvasScale;
+                        node->pos.y += dragDelta.y / canvasScale;
+                        spatialGrid.Update(node.get());
+                        isModified = true;
                     }
                 }
 
@@ -780,33 +719,24 @@ private:
 
         // Handle mouse release
         if (ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
-            // Finish node dragging
-            for (auto& node : nodes) {
+            // Finish node dragging, the whole drag is one step
+            for (auto& node : flowsheet.nodes) {
                 node->isBeingDragged = false;
             }
+            std::vector<UndoJournal::Move> moves;
+            for (const auto& start : dragStarts) {
+                Node* node = flowsheet.Get(start.first);
+                if (node && (node->pos.x != start.second.x || node->pos.y != start.second.y)) moves.push_back({ node, start.second, node->pos });
+            }
+            journal.RecordMove(std::move(moves));
+            dragStarts.clear();
 
             // Finish connection creation
-            if (isCreatingConnection && connectionStartPoint) {
+            ConnectionPoint* connectionStartPoint = isCreatingConnection ? flowsheet.Get(connectionStartPort) : nullptr;
+            if (connectionStartPoint) {
                 // Find connection point under mouse
-                ConnectionPoint* endPoint = nullptr;
-
-                for (const auto& node : nodes) {
-                    // Don't connect to the same node
-                    if (node.get() == connectionStartPoint->node) continue;
-
-                    // Find nearest connection point
-                    ConnectionPoint* point = node->FindNearestConnectionPoint(
-                        mouseCanvasPos,
-                        15.0f,
-                        !connectionStartPoint->isInput,  // If starting point is output, only look for inputs
-                        connectionStartPoint->isInput    // If starting point is input, only look for outputs
-                    );
-
-                    if (point) {
-                        endPoint = point;
-                        break;
-                    }
-                }
+                connectionEndPos = mouseCanvasPos;
+                ConnectionPoint* endPoint = FindSnapTarget();
 
                 // If found a valid end point, create the connection
                 if (endPoint) {
@@ -815,14 +745,14 @@ private:
                     ConnectionPoint* to = connectionStartPoint->isInput ? connectionStartPoint : endPoint;
 
                     // Check if points are already connected
-                    if (!from->connection && !to->connection) {
-                        connections.push_back(std::make_unique<Connection>(from, to));
+                    if (Connection* connection = flowsheet.Connect(from, to)) {
+                        journal.RecordConnect(connection);
+                        spatialGrid.UpdateConnection(connection);
+                        flowsheetEdited = true;
                     }
                 }
-
-                isCreatingConnection = false;
-                connectionStartPoint = nullptr;
             }
+            isCreatingConnection = false;
         }
     }
 
@@ -834,6 +764,70 @@ private:
             ImGui::OpenPopup("AddNodePopup");
         }
 
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!journal.CanUndo());
+        if (ImGui::Button("Undo")) Undo();
+        ImGui::EndDisabled();
+        ImGui::SetItemTooltip("Ctrl+Z");
+
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!journal.CanRedo());
+        if (ImGui::Button("Redo")) Redo();
+        ImGui::EndDisabled();
+        ImGui::SetItemTooltip("Ctrl+Y or Ctrl+Shift+Z");
+
+        ImGui::SameLine();
+        if (ImGui::Button("Solve")) {
+            RunSolver(false);
+        }
+
+        ImGui::SameLine();
+        ImGui::Checkbox("Equation Oriented", &useEquationOriented);
+
+        ImGui::SameLine();
+        ImGui::Checkbox("Auto Solve", &autoSolve);
+
+        ImGui::SameLine();
+        if (ImGui::Button("Save")) {
+            Save();
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Load")) {
+            Load();
+        }
+
+#ifndef EMSCRIPTEN
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200.0f);
+        ImGui::InputText("##FlowsheetPath", flowsheetPath, sizeof(flowsheetPath));
+        ImGui::SetItemTooltip("JSON file, or a binary snapshot if the name ends in .thxf");
+#endif
+
+        if (!fileMessage.empty()) {
+            ImGui::SameLine();
+            ImGui::TextUnformatted(fileMessage.c_str());
+        }
+
+        if (hasSolved) {
+            ImGui::SameLine();
+            if (useEquationOriented) {
+                ImGui::Text("%s (%d equations, %d unknowns, %d Newton iterations, residual %.2e)",
+                    lastSolveReport.message.c_str(),
+                    lastSolveReport.numEquations,
+                    lastSolveReport.numUnknowns,
+                    lastSolveReport.newtonIterations,
+                    lastSolveReport.residualNorm);
+            }
+            else {
+                ImGui::Text("%s (%d units, %d recycle loop iterations, %d tear streams)",
+                    lastSolveReport.message.c_str(),
+                    lastSolveReport.unitsEvaluated,
+                    lastSolveReport.maxRecycleIterations,
+                    lastSolveReport.numTearStreams);
+            }
+        }
+
         // Add node popup
         if (ImGui::BeginPopup("AddNodePopup")) {
             ImGui::Text("Select node type:");
@@ -842,15 +836,16 @@ private:
             for (const auto& type : nodeFactory.GetNodeTypes()) {
                 if (ImGui::MenuItem(type.c_str())) {
                     // Create a new node at the center of the view
-                    ImVec2 viewCenter = ImGui::GetWindowSize();
-                    viewCenter.x *= 0.5f;
-                    viewCenter.y *= 0.5f;
+                    Vec2 viewCenter = (canvasViewSize * 0.5f - canvasOffset) * (1.0f / canvasScale);
 
-                    std::string newName = type + " " + std::to_string(nodes.size() + 1);
+                    std::string newName = type + " " + std::to_string(flowsheet.nodes.size() + 1);
                     auto node = nodeFactory.CreateNode(type, newName, Vec2(viewCenter.x, viewCenter.y));
 
                     if (node) {
-                        nodes.push_back(std::move(node));
+                        Node* added = flowsheet.AddNode(std::move(node));
+                        spatialGrid.Insert(added);
+                        journal.RecordAdd(flowsheet, added);
+                        isModified = true;
                     }
                 }
             }
@@ -870,52 +865,65 @@ private:
         }
 
         // Properties with Enter key
-        if (ImGui::IsKeyPressed(ImGuiKey_Enter) && selectedNode) {
+        if (ImGui::IsKeyPressed(ImGuiKey_Enter) && flowsheet.Get(selectedNode)) {
             showPropertiesWindow = true;
         }
+
+        // Text fields undo their own typing
+        if (!ImGui::GetIO().WantTextInput) {
+            if (ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_Z)) Undo();
+            if (ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_Y) || ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiMod_Shift | ImGuiKey_Z)) Redo();
+        }
+    }
+
+    void Undo() {
+        JournalChange change;
+        if (journal.Undo(flowsheet, change)) ApplyJournalChange(change);
     }
 
+    void Redo() {
+        JournalChange change;
+        if (journal.Redo(flowsheet, change)) ApplyJournalChange(change);
+    }
+
+    // Brings the canvas index and the selection in line with an undo or redo
+    void ApplyJournalChange(const JournalChange& change) {
+        for (Node* node : change.added) spatialGrid.Insert(node);
+        for (Node* node : change.moved) spatialGrid.Update(node);
+        for (Connection* connection : change.connected) spatialGrid.UpdateConnection(connection);
+        for (Node* node : change.removed) {
+            spatialGrid.Remove(node);
+            node->isSelected = false;
+        }
+
+        // Handles to removed units no longer resolve. A connection being drawn may start at a
+        // port that got connected.
+        if (!flowsheet.Get(selectedNode)) showPropertiesWindow = false;
+        isCreatingConnection = false;
+        dragStarts.clear();
+
+        if (change.edited) flowsheetEdited = true;
+        isModified = true;
+    }
+
+    // One step in the journal, which keeps the units for undo
     void DeleteSelectedNodes() {
-        // First collect all nodes to delete
         std::vector<Node*> nodesToDelete;
-        for (const auto& node : nodes) {
+        for (const auto& node : flowsheet.nodes) {
             if (node->isSelected) {
                 nodesToDelete.push_back(node.get());
             }
         }
+        if (nodesToDelete.empty()) return;
 
-        // Remove all connections connected to these nodes
-        auto connIt = connections.begin();
-        while (connIt != connections.end()) {
-            bool connected = false;
-            for (Node* node : nodesToDelete) {
-                if ((*connIt)->from->node == node || (*connIt)->to->node == node) {
-                    connected = true;
-                    break;
-                }
-            }
-
-            if (connected) {
-                connIt = connections.erase(connIt);
-            }
-            else {
-                ++connIt;
-            }
-        }
-
-        // Now remove the nodes
-        auto nodeIt = nodes.begin();
-        while (nodeIt != nodes.end()) {
-            if ((*nodeIt)->isSelected) {
-                if (selectedNode == nodeIt->get()) {
-                    selectedNode = nullptr;
-                    showPropertiesWindow = false;
-                }
-                nodeIt = nodes.erase(nodeIt);
-            }
-            else {
-                ++nodeIt;
-            }
+        journal.DeleteNodes(flowsheet, nodesToDelete);
+        for (Node* node : nodesToDelete) {
+            spatialGrid.Remove(node);
+            node->isSelected = false;
         }
+        if (!flowsheet.Get(selectedNode)) showPropertiesWindow = false;
+        dragStarts.clear();
+        flowsheetEdited = true;
+        isModified = true;
     }
 };
@@ -0,0 +1,42 @@
+#pragma once
+
+// STL Includes
+#include <cmath>
+
+// Forward-mode automatic differentiation number: a value and its derivative along one seed
+// direction. Seeding one variable with derivative 1 and evaluating a residual function
+// gives the exact Jacobian column of that variable.
+struct Dual {
+    double value = 0.0;
+    double derivative = 0.0;
+
+    Dual() = default;
+    Dual(double v) : value(v), derivative(0.0) {}
+    Dual(double v, double d) : value(v), derivative(d) {}
+
+    Dual& operator+=(const Dual& b) { value += b.value; derivative += b.derivative; return *this; }
+    Dual& operator-=(const Dual& b) { value -= b.value; derivative -= b.derivative; return *this; }
+    Dual& operator*=(const Dual& b) { derivative = derivative * b.value + value * b.derivative; value *= b.value; return *this; }
+    Dual& operator/=(const Dual& b) { derivative = (derivative * b.value - value * b.derivative) / (b.value * b.value); value /= b.value; return *this; }
+};
+
+inline Dual operator+(Dual a, const Dual& b) { return a += b; }
+inline Dual operator-(Dual a, const Dual& b) { return a -= b; }
+inline Dual operator*(Dual a, const Dual& b) { return a *= b; }
+inline Dual operator/(Dual a, const Dual& b) { return a /= b; }
+inline Dual operator-(const Dual& a) { return Dual(-a.value, -a.derivative); }
+
+inline bool operator<(const Dual& a, const Dual& b) { return a.value < b.value; }
+inline bool operator>(const Dual& a, const Dual& b) { return a.value > b.value; }
+inline bool operator<=(const Dual& a, const Dual& b) { return a.value <= b.value; }
+inline bool operator>=(const Dual& a, const Dual& b) { return a.value >= b.value; }
+
+inline Dual sqrt(const Dual& a) { double s = std::sqrt(a.value); return Dual(s, a.derivative / (2.0 * s)); }
+inline Dual exp(const Dual& a) { double e = std::exp(a.value); return Dual(e, a.derivative * e); }
+inline Dual log(const Dual& a) { return Dual(std::log(a.value), a.derivative / a.value); }
+inline Dual fabs(const Dual& a) { return a.value < 0.0 ? -a : a; }
+inline Dual pow(const Dual& a, double n) { double p = std::pow(a.value, n - 1.0); return Dual(p * a.value, n * p * a.derivative); }
+
+// Plain value of a double or a Dual, for code templated on the scalar type
+inline double ValueOf(double a) { return a; }
+inline double ValueOf(const Dual& a) { return a.value; }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FlowsheetSolver.h"
+#include "Stream.h"
+#include "SparseMatrix.h"
+#include "SparseLU.h"
+
+// STL Includes
+#include <vector>
+#include <memory>
+
+// Forward declarations
+class Node;
+class Connection;
+
+// Equation-oriented solver. Every calculated (unselected) DoubleDataVariable and every
+// output stream of the flowsheet is an unknown, every unit contributes its residual
+// equations, and the whole system is solved at once with a damped Newton method.
+// The sparse LU pattern is analysed once and reused until the flowsheet structure or
+// the pivot sequence has to change.
+class EquationOrientedSolver {
+public:
+    SolveReport Solve(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections);
+
+    int maxIterations = 50;
+    double tolerance = 1e-9;    // Infinity norm of the residuals
+
+private:
+    // Returns false if the degrees of freedom do not match
+    bool BuildSystem(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections, SolveReport& report);
+
+    void ScatterUnknowns(const std::vector<double>& x);
+    void GatherUnknowns(std::vector<double>& x) const;
+    void EvaluateResiduals(std::vector<double>& residuals);
+    void EvaluateJacobian();
+
+    struct UnitEquations {
+        Node* node = nullptr;
+        int firstEquation = 0;
+        int numEquations = 0;
+        std::vector<double*> locals;      // Variables the residuals read
+        std::vector<int> globalOfLocal;   // Unknown index of each local, -1 if fixed
+        int firstEntry = 0;               // First Jacobian entry, numEquations * locals.size() of them
+    };
+
+    std::vector<UnitEquations> units;
+    std::vector<double*> unknowns;                          // Storage behind every unknown
+    std::vector<std::pair<Stream*, const Stream*>> links;   // Input stream <- connected output stream
+    int numEquations = 0;
+
+    SparseMatrix jacobian;
+    std::vector<int> slotOfEntry;
+    std::vector<std::pair<int, int>> pattern;
+    SparseLU lu;
+};
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "Stream.h"
+#include "Dual.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+
+// UI-free flowsheet model: units, their ports and the streams between them. The ImGui
+// editor in DragAndDrop.h draws and edits these, the batch executable only solves them.
+
+// Forward declarations
+class Node;
+class Connection;
+
+// Vector math helpers
+struct Vec2 {
+    float x, y;
+    Vec2(float _x = 0.0f, float _y = 0.0f) : x(_x), y(_y) {}
+
+    Vec2 operator+(const Vec2& other) const { return Vec2(x + other.x, y + other.y); }
+    Vec2 operator-(const Vec2& other) const { return Vec2(x - other.x, y - other.y); }
+    Vec2 operator*(float scalar) const { return Vec2(x * scalar, y * scalar); }
+    float Length() const { return sqrt(x * x + y * y); }
+    Vec2 Normalized() const {
+        float len = Length();
+        if (len < 1e-6f) return Vec2(0, 0);
+        return Vec2(x / len, y / len);
+    }
+};
+
+// Stable reference to a unit of a flowsheet. Resolves to the unit while it is in the flowsheet
+// and to nullptr once it was taken out, even after its slot went to a newer unit.
+struct NodeHandle {
+    static constexpr uint32_t NoSlot = 0xffffffffu;
+
+    uint32_t slot = NoSlot;
+    uint32_t generation = 0;
+
+    bool operator==(const NodeHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const NodeHandle& other) const { return !(*this == other); }
+};
+
+// A port, by the handle of its unit and its id within the unit
+struct PortHandle {
+    NodeHandle node;
+    uint32_t port = 0;
+};
+
+// Connection point (inlet/outlet). Units add their points in their constructor and never after,
+// so pointers to points stay valid for the life of the unit.
+struct ConnectionPoint {
+    Vec2 pos;               // Position relative to node
+    std::string name;       // Name of the connection point
+    bool isInput;           // Is this an input or output
+    Node* node;             // Parent node
+    Connection* connection; // Connection attached to this point, nullptr if none
+    Stream stream;          // Stream state at this point
+    bool isDirty = false;   // Stream changed during the last solve
+    uint32_t id = 0;        // Stable within its node, the order the unit added its points in
+
+    ConnectionPoint(const std::string& _name, bool _isInput, const Vec2& _pos, Node* _node, uint32_t _id)
+        : name(_name), isInput(_isInput), pos(_pos), node(_node), connection(nullptr), id(_id) {
+    }
+};
+
+// A "double" parameter of a node. Selected variables are specified by the user, the others
+// are calculated and become unknowns of the equation-oriented solver.
+struct DoubleDataVariable
+{
+    DoubleDataVariable(double& val, const std::string& param, const std::string& u, bool isSelected)
+        : value(val), parameter(param), unit(u), isSelected(isSelected) {}
+
+    bool isSelected = false;
+    double& value;
+    std::string parameter;
+    std::string unit;
+};
+
+// Base node class for all process elements
+class Node {
+public:
+    static constexpr int UnresolvedIcon = -2;
+    static constexpr size_t MaxNameLength = 255;   // Longest name the properties window edits, loaders reject longer ones
+
+    std::string imagePath; 
+    int iconHandle = UnresolvedIcon;         // Icon in the canvas atlas, looked up from imagePath on first draw
+    Vec2 pos;                                // Position in the canvas
+    Vec2 size;                               // Size of the node
+    std::string name;                        // Name of the node
+    std::string type;                        // Type of the node (valve, compressor, etc.)
+    uint32_t id = 0;                         // Stable unit id, assigned by Flowsheet::AddNode and kept in saved files
+    uint32_t slot = NodeHandle::NoSlot;      // Slot in the flowsheet, indexes per-unit arrays such as the canvas grid's
+    bool isSelected;                         // Is the node currently selected
+    bool isBeingDragged;                     // Is the node being dragged
+    bool isDirty = true;                     // Needs recalculating, set by edits and connection changes
+    std::vector<ConnectionPoint> inputs;     // Input connection points
+    std::vector<ConnectionPoint> outputs;    // Output connection points
+    std::vector<DoubleDataVariable> data;    // Registered "double" parameters
+
+    Node(const std::string& _name, const std::string& _type, const Vec2& _pos, const Vec2& _size)
+        : name(_name), type(_type), pos(_pos), size(_size), isSelected(false), isBeingDragged(false) {}
+
+    virtual ~Node() {}
+
+    // Get the absolute position of a connection point
+    Vec2 GetConnectionPointPos(const ConnectionPoint& point) const {
+        return pos + point.pos;
+    }
+
+    // Add an input connection point
+    void AddInputPoint(const std::string& name, const Vec2& relPos) {
+        inputs.emplace_back(name, true, relPos, this, GetNumPoints());
+    }
+
+    // Add an output connection point
+    void AddOutputPoint(const std::string& name, const Vec2& relPos) {
+        outputs.emplace_back(name, false, relPos, this, GetNumPoints());
+    }
+
+    uint32_t GetNumPoints() const { return static_cast<uint32_t>(inputs.size() + outputs.size()); }
+
+    // Connection point by its stable id, nullptr if there is none
+    ConnectionPoint* FindPoint(uint32_t id) {
+        for (auto* points : { &inputs, &outputs }) {
+            for (auto& point : *points) {
+                if (point.id == id) return &point;
+            }
+        }
+        return nullptr;
+    }
+
+    const ConnectionPoint* FindPoint(uint32_t id) const {
+        return const_cast<Node*>(this)->FindPoint(id);
+    }
+
+    // Streams entering and leaving the unit, in port order. Every connection attaches itself
+    // to both its ports, so the ports are the adjacency of the unit and this costs its degree,
+    // not the size of the flowsheet.
+    void GetIncoming(std::vector<Connection*>& connections) const {
+        connections.clear();
+        for (const auto& point : inputs) {
+            if (point.connection) connections.push_back(point.connection);
+        }
+    }
+
+    void GetOutgoing(std::vector<Connection*>& connections) const {
+        connections.clear();
+        for (const auto& point : outputs) {
+            if (point.connection) connections.push_back(point.connection);
+        }
+    }
+
+    // Find the nearest connection point to the given position
+    ConnectionPoint* FindNearestConnectionPoint(const Vec2& testPos, float maxDist, bool inputsOnly = false, bool outputsOnly = false) {
+        
+        if (maxDist < 25.0f) maxDist = 25.0f;  // Ensure minimum snapping distance
+
+        // Squared distances, no square root per port
+        ConnectionPoint* nearest = nullptr;
+        float minDistSq = maxDist * maxDist;
+
+        if (!inputsOnly) {
+            for (auto& point : outputs) {
+                Vec2 delta = GetConnectionPointPos(point) - testPos;
+                float distSq = delta.x * delta.x + delta.y * delta.y;
+                if (distSq < minDistSq) {
+                    minDistSq = distSq;
+                    nearest = &point;
+                }
+            }
+        }
+
+        if (!outputsOnly) {
+            for (auto& point : inputs) {
+                Vec2 delta = GetConnectionPointPos(point) - testPos;
+                float distSq = delta.x * delta.x + delta.y * delta.y;
+                if (distSq < minDistSq) {
+                    minDistSq = distSq;
+                    nearest = &point;
+                }
+            }
+        }
+
+        return nearest;
+    }
+
+    // Check if a point is inside the node
+    bool Contains(const Vec2& point) const {
+        return (point.x >= pos.x && point.x <= pos.x + size.x &&
+            point.y >= pos.y && point.y <= pos.y + size.y);
+    }
+
+    // Calculate the output streams from the input streams
+    virtual void Calculate() {}
+
+    // Equation-oriented interface. Residuals are functions of the local variables listed by
+    // GetEquationVariables: the data values, then P, T and mass flow of every input and output.
+    // The Dual overload gives exact Jacobian columns, see UnitKernels.h.
+    virtual int GetNumEquations() const { return 0; }
+    virtual void EvaluateResiduals(const double* /*locals*/, double* /*residuals*/) const {}
+    virtual void EvaluateResiduals(const Dual* /*locals*/, Dual* /*residuals*/) const {}
+
+    void GetEquationVariables(std::vector<double*>& variables) {
+        variables.clear();
+        for (auto& variable : data) {
+            variables.push_back(&variable.value);
+        }
+        for (auto* points : { &inputs, &outputs }) {
+            for (auto& point : *points) {
+                variables.push_back(&point.stream.pressure);
+                variables.push_back(&point.stream.temperature);
+                variables.push_back(&point.stream.massFlowRate);
+            }
+        }
+    }
+};
+
+// Connection between nodes
+class Connection {
+public:
+    ConnectionPoint* from;
+    ConnectionPoint* to;
+    size_t index = 0;       // Position in Flowsheet::connections, kept up to date by whoever inserts or erases
+
+    Connection(ConnectionPoint* _from, ConnectionPoint* _to) : from(_from), to(_to) {
+        from->connection = this;
+        to->connection = this;
+        to->node->isDirty = true;
+    }
+
+    ~Connection() {
+        // Disconnect points, the downstream node lost its feed
+        if (from) from->connection = nullptr;
+        if (to) {
+            to->connection = nullptr;
+            to->node->isDirty = true;
+        }
+    }
+
+};
+
+// Units and the streams between them. Connections are declared after the nodes so they
+// are destroyed first, while the ports they detach from still exist.
+//
+// Every unit also holds a slot, reused after the unit leaves, with a generation that changes
+// each time the slot is given out. Generations come from one counter for all flowsheets, so a
+// handle never resolves to a unit it was not made for, not even after a load replaced the
+// flowsheet.
+class Flowsheet {
+public:
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    // Keeps the id of a loaded unit, gives a new one to a unit without
+    Node* AddNode(std::unique_ptr<Node> node) {
+        if (node->id == 0) node->id = nextNodeId;
+        nextNodeId = std::max(nextNodeId, node->id + 1);
+        Attach(node.get());
+        nodes.push_back(std::move(node));
+        return nodes.back().get();
+    }
+
+    // For code that moves units in and out of nodes itself, the undo journal: a unit put back
+    // gets a slot, the handles of a unit taken out go stale. The unit keeps its old slot number
+    // until it is attached again.
+    void Attach(Node* node) {
+        if (freeSlots.empty()) {
+            node->slot = static_cast<uint32_t>(slotNodes.size());
+            slotNodes.push_back(nullptr);
+            generations.push_back(0);
+        }
+        else {
+            node->slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        slotNodes[node->slot] = node;
+        generations[node->slot] = NextGeneration();
+    }
+
+    void Detach(Node* node) {
+        if (node->slot >= slotNodes.size() || slotNodes[node->slot] != node) return;
+        slotNodes[node->slot] = nullptr;
+        generations[node->slot] = 0;
+        freeSlots.push_back(node->slot);
+    }
+
+    NodeHandle GetHandle(const Node* node) const {
+        if (!node || node->slot >= slotNodes.size() || slotNodes[node->slot] != node) return NodeHandle();
+        return { node->slot, generations[node->slot] };
+    }
+
+    // nullptr once the unit is out of the flowsheet
+    Node* Get(NodeHandle handle) const {
+        if (handle.slot >= slotNodes.size() || handle.generation == 0 || generations[handle.slot] != handle.generation) return nullptr;
+        return slotNodes[handle.slot];
+    }
+
+    PortHandle GetHandle(const ConnectionPoint* point) const {
+        if (!point) return PortHandle();
+        return { GetHandle(point->node), point->id };
+    }
+
+    ConnectionPoint* Get(PortHandle handle) const {
+        Node* node = Get(handle.node);
+        return node ? node->FindPoint(handle.port) : nullptr;
+    }
+
+    // One past the highest slot, the size of per-unit arrays
+    size_t GetNumSlots() const { return slotNodes.size(); }
+
+    // Returns nullptr if either point is already connected
+    Connection* Connect(ConnectionPoint* from, ConnectionPoint* to) {
+        if (!from || !to || from->connection || to->connection) return nullptr;
+        connections.push_back(std::make_unique<Connection>(from, to));
+        connections.back()->index = connections.size() - 1;
+        return connections.back().get();
+    }
+
+    // After connections were inserted into or erased from connections, at first or later
+    void RenumberConnections(size_t first = 0) {
+        for (size_t i = first; i < connections.size(); ++i) connections[i]->index = i;
+    }
+
+    Node* FindNode(const std::string& name) const {
+        for (const auto& node : nodes) {
+            if (node->name == name) return node.get();
+        }
+        return nullptr;
+    }
+
+    // Registered "double" parameter of a unit, nullptr if either name is unknown
+    DoubleDataVariable* FindVariable(const std::string& nodeName, const std::string& parameter) const {
+        Node* node = FindNode(nodeName);
+        if (!node) return nullptr;
+        for (auto& variable : node->data) {
+            if (variable.parameter == parameter) return &variable;
+        }
+        return nullptr;
+    }
+
+    void Clear() {
+        connections.clear();
+        nodes.clear();
+        slotNodes.clear();
+        generations.clear();
+        freeSlots.clear();
+        nextNodeId = 1;
+    }
+
+private:
+    static uint32_t NextGeneration() {
+        static std::atomic<uint32_t> counter{ 0 };
+        uint32_t generation = ++counter;
+        return generation != 0 ? generation : ++counter;
+    }
+
+    uint32_t nextNodeId = 1;
+    std::vector<Node*> slotNodes;            // By slot, nullptr if free
+    std::vector<uint32_t> generations;       // By slot, 0 if free
+    std::vector<uint32_t> freeSlots;
+};
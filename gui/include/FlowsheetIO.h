@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Flowsheet.h"
+#include "NodeFactory.h"
+#include "FlowsheetSolver.h"
+
+// STL Includes
+#include <string>
+
+// Flowsheet files. A file lists the units (id, type, name, position, data values with their
+// selection and the stream at every port) and the streams between them as unit id and port id
+// pairs. Port streams are stored so unconnected inlets keep their boundary values and a loaded
+// flowsheet starts from its last solution.
+//
+// There are two encodings of the same content: JSON, for files people read and the page's
+// storeTextData/loadTextData, and a compact binary snapshot for autosave and batch runs.
+
+// Version 1 files have no version field and refer to units by index and ports by name
+const int FlowsheetVersion = 2;
+
+std::string SaveFlowsheet(const Flowsheet& flowsheet);
+
+// Replaces the contents of flowsheet. Returns false and sets error if the text is not a valid
+// flowsheet file or uses a unit type the factory does not know. The file is read as a stream of
+// parser events straight into units, without building a JSON document first.
+bool LoadFlowsheet(const std::string& text, const NodeFactory& factory, Flowsheet& flowsheet, std::string& error);
+
+// Binary snapshot, little endian: "THXF", version, then a table of the unit types with their
+// parameter names and port count, every unit's values in that layout and the streams as id
+// quadruples. Parameters are matched by name on load, ports by id.
+std::string SaveFlowsheetSnapshot(const Flowsheet& flowsheet);
+bool LoadFlowsheetSnapshot(const std::string& data, const NodeFactory& factory, Flowsheet& flowsheet, std::string& error);
+
+// True if data starts like a snapshot, false for JSON text
+bool IsFlowsheetSnapshot(const std::string& data);
+
+// Solve report, unit data and port streams as JSON
+std::string SaveResults(const Flowsheet& flowsheet, const SolveReport& report);
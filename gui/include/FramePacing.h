@@ -0,0 +1,90 @@
+#pragma once
+
+// ImGui Includes
+#include "hello_imgui/hello_imgui.h"
+#ifdef EMSCRIPTEN
+#include <emscripten/threading.h>
+#else
+#if defined(HELLOIMGUI_USE_GLFW3)
+#include <GLFW/glfw3.h>
+#elif defined(HELLOIMGUI_USE_SDL2)
+#include <SDL.h>
+#endif
+#endif
+
+// STL Includes
+#include <atomic>
+
+// When the editor redraws. The runner draws at full rate while there is input, and for
+// activeSeconds after it, then drops to idleFps. Anything else that changes the screen, a
+// background solve reporting progress or finishing, a file arriving from the page or an
+// animation, calls Request(), which draws the next few frames at full rate. A request from a
+// worker wakes the runner at once instead of waiting for the next idle frame.
+class FramePacing {
+public:
+    static FramePacing& Get()
+    {
+        static FramePacing pacing;
+        return pacing;
+    }
+
+    // Call before HelloImGui::Run
+    void Configure(HelloImGui::RunnerParams& params)
+    {
+        params.fpsIdling.fpsIdle = idleFps;
+        params.fpsIdling.timeActiveAfterLastEvent = activeSeconds;
+        params.fpsIdling.enableIdling = true;
+        params.callbacks.PreNewFrame = HelloImGui::SequenceFunctions(params.callbacks.PreNewFrame, [this]() { OnNewFrame(); });
+    }
+
+    // Safe from any thread. An animation calls it every frame it runs.
+    void Request()
+    {
+#ifdef EMSCRIPTEN
+        // Idle frames are skipped before any callback runs, so stop idling right away. Only the
+        // main thread touches the runner, a worker queues the first request since the last frame
+        // to it.
+        if (!emscripten_is_main_runtime_thread()) {
+            if (!requested.exchange(true)) emscripten_async_run_in_main_runtime_thread(EM_FUNC_SIG_V, reinterpret_cast<void*>(&StopIdling));
+            return;
+        }
+        requested = true;
+        StopIdling();
+#else
+        // Only the first request since the last frame has to wake the runner from its wait
+        if (requested.exchange(true)) return;
+#if defined(HELLOIMGUI_USE_GLFW3)
+        glfwPostEmptyEvent();
+#elif defined(HELLOIMGUI_USE_SDL2)
+        SDL_Event event{};
+        event.type = SDL_USEREVENT;
+        SDL_PushEvent(&event);
+#endif
+#endif
+    }
+
+private:
+    FramePacing() = default;
+
+#ifdef EMSCRIPTEN
+    static void StopIdling()
+    {
+        HelloImGui::GetRunnerParams()->fpsIdling.enableIdling = false;
+    }
+#endif
+
+    // Before every drawn frame. Decides whether the runner may idle before the next one.
+    void OnNewFrame()
+    {
+        if (requested.exchange(false)) awakeFrames = framesPerRequest;
+        else if (awakeFrames > 0) --awakeFrames;
+        HelloImGui::GetRunnerParams()->fpsIdling.enableIdling = awakeFrames == 0;
+    }
+
+    static constexpr float idleFps = 2.0f;
+    static constexpr float activeSeconds = 1.0f;
+    static constexpr int framesPerRequest = 3;   // Windows that change size settle over a couple of frames
+
+    std::atomic<bool> requested{ false };
+    int awakeFrames = 0;
+};
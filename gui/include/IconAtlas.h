@@ -0,0 +1,56 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+// Unit icons packed into one RGBA image, so the canvas draws every icon from a single texture.
+// Icons are added once at startup, shrunk to at most maxIconSize pixels on their longer side,
+// and packed in shelves sorted by height. Nodes keep the handle of their icon instead of its
+// path, so drawing one is an index into the UV rectangles rather than a string lookup.
+class IconAtlas {
+public:
+    static constexpr int NoIcon = -1;
+
+    struct Icon {
+        float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;   // UV rectangle in the atlas
+        int width = 0, height = 0;                          // Size in the atlas
+    };
+
+    explicit IconAtlas(int maxIconSize = 256) : maxIconSize(maxIconSize) {}
+
+    // rgba holds width * height pixels of 4 bytes. Returns the handle of the icon, the existing
+    // one if the path was added before.
+    int Add(const std::string& path, const unsigned char* rgba, int width, int height);
+
+    // Packs the added icons into the atlas image. Returns false if they do not fit in a square
+    // of maxAtlasSize pixels, the atlas is then empty.
+    bool Build(int maxAtlasSize = 4096);
+
+    // NoIcon if the path was not added
+    int Find(const std::string& path) const;
+
+    const Icon& GetIcon(int handle) const { return icons[handle]; }
+    size_t GetNumIcons() const { return icons.size(); }
+
+    // RGBA pixels of the built atlas, width * height * 4 bytes
+    const std::vector<unsigned char>& GetPixels() const { return pixels; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+private:
+    struct Source {
+        int width = 0, height = 0;
+        std::vector<unsigned char> rgba;
+    };
+
+    int maxIconSize;
+    std::unordered_map<std::string, int> handles;
+    std::vector<Source> sources;
+    std::vector<Icon> icons;
+
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ComponentKernel.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <cstddef>
+
+// Multi-component isotherms. Every affinity follows b = b0 exp(dH / RT) and p is the partial
+// pressure in bar.
+//   Langmuir            q_i = qs b p_i / (1 + b p_i), each component on its own
+//   ExtendedLangmuir    q_i = qs b p_i / (1 + sum_j b_j p_j)
+//   DualSiteLangmuir    Extended Langmuir on two independent sites, summed
+//   Sips                q_i = qs (b p_i)^n / (1 + sum_j (b_j p_j)^n_j)
+//   Toth                q_i = qs b p_i / (1 + (sum_j b_j p_j)^t)^(1/t)
+enum class IsothermModel { Langmuir, ExtendedLangmuir, DualSiteLangmuir, Sips, Toth };
+
+// Equilibrium and kinetics of one gas component on the adsorbent, with linear driving force
+// uptake, dq/dt = k (q* - q).
+struct AdsorbateProperties {
+    std::string component;                  // Name in the component database
+    double saturationLoading = 0.0;         // qs [mol/kg]
+    double affinity = 0.0;                  // b0 [1/bar]
+    double heatOfAdsorption = 0.0;          // dH, positive as adsorption releases heat [J/mol]
+    double massTransferCoefficient = 0.0;   // k [1/s]
+
+    double saturationLoading2 = 0.0;        // Second site of the dual-site Langmuir [mol/kg]
+    double affinity2 = 0.0;                 // [1/bar]
+    double heatOfAdsorption2 = 0.0;         // [J/mol]
+    double heterogeneity = 1.0;             // Sips n or Toth t [-]
+
+    // Loading when every site is full [mol/kg]
+    double GetCapacity() const { return saturationLoading + saturationLoading2; }
+};
+
+// Structure-of-arrays batch of states, usually the cells of a column. Fill the inputs, call
+// Isotherm::Evaluate and read the outputs. Reusing a batch does not allocate.
+struct IsothermBatch {
+    // Inputs
+    std::vector<double> temperature;                            // [K]
+    std::vector<std::vector<double>> partialPressure;           // [component][state] [bar]
+
+    // Outputs
+    std::vector<std::vector<double>> loading;                   // q* [component][state] [mol/kg]
+    std::vector<std::vector<double>> dLoadingdPressure;         // dq*_i / dp_j [i * components + j][state] [mol/kg/bar]
+    std::vector<std::vector<double>> dLoadingdTemperature;      // [component][state] [mol/kg/K]
+
+    void Resize(size_t numStates, size_t numComponents);
+    size_t GetSize() const { return temperature.size(); }
+
+private:
+    friend class Isotherm;
+
+    // Per state work arrays
+    std::vector<std::vector<double>> affinity, dAffinitydT;     // b_i(T) and its derivative [component][state]
+    std::vector<std::vector<double>> site, dSitedT;             // Term of each component in the sum, and its derivatives
+    std::vector<std::vector<double>> dSitedP;
+    std::vector<double> sum, dSumdT, factor, dFactor;
+};
+
+// Loadings and their analytic derivatives with respect to the partial pressures and the
+// temperature. The model is chosen once per batch and every loop after that runs over the states
+// without branches, so everything but the exponentials vectorises. Sips terms turn linear below
+// a micro bar, where the fractional power would have an infinite slope. Two to four components
+// run a kernel compiled for that count, which evaluates each state in one pass on the stack.
+class Isotherm {
+public:
+    Isotherm() = default;
+    Isotherm(IsothermModel model, const std::vector<AdsorbateProperties>& adsorbates);
+
+    // Loadings, and with derivatives set their derivatives as well
+    void Evaluate(IsothermBatch& batch, bool derivatives = true) const;
+
+    // Loadings of a single state
+    std::vector<double> GetLoading(const std::vector<double>& partialPressure, double temperature) const;
+
+    size_t GetNumComponents() const { return saturationLoading.size(); }
+    IsothermModel GetModel() const { return model; }
+
+    // Chosen from the number of components on construction. A fixed count kernel that does not
+    // match the components falls back to the runtime one.
+    void SetKernel(ComponentKernel kernel);
+    ComponentKernel GetKernel() const { return kernel; }
+
+    static const char* GetName(IsothermModel model);
+
+private:
+    void ComputeAffinities(IsothermBatch& batch, const std::vector<double>& b0, const std::vector<double>& heat) const;
+    void Competitive(IsothermBatch& batch, const std::vector<double>& qs, bool accumulate, bool derivatives) const;
+    void Independent(IsothermBatch& batch, bool derivatives) const;
+    void Sips(IsothermBatch& batch, bool derivatives) const;
+    void Toth(IsothermBatch& batch, bool derivatives) const;
+
+    template <size_t N>
+    void EvaluateFixed(IsothermBatch& batch, bool derivatives) const;
+
+    IsothermModel model = IsothermModel::ExtendedLangmuir;
+    ComponentKernel kernel = ComponentKernel::Runtime;
+
+    // Per component constants
+    std::vector<double> saturationLoading, affinity, heatOfAdsorption;
+    std::vector<double> saturationLoading2, affinity2, heatOfAdsorption2;
+    std::vector<double> heterogeneity;
+};
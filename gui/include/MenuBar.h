@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Benchmarks.h"
+#include "CanvasGrid.h"
+
 // ImGui Includes
 #include "hello_imgui/hello_imgui.h"
 
@@ -143,6 +146,84 @@ void ShowMainMenuBar()
         ImGui::EndMenu();
     }
 
+    static bool showBenchmark = false;
+    static std::string benchmarkReport;
+
+    if (ImGui::BeginMenu("Tools"))
+    {
+        if (ImGui::MenuItem("Jacobian Benchmark"))
+        {
+            benchmarkReport = RunJacobianBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Property Benchmark"))
+        {
+            benchmarkReport = RunPropertyBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Isotherm Benchmark"))
+        {
+            benchmarkReport = RunIsothermBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Kernel Benchmark"))
+        {
+            benchmarkReport = RunKernelBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Column Benchmark"))
+        {
+            benchmarkReport = RunColumnBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Cycle Benchmark"))
+        {
+            benchmarkReport = RunCycleBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Multi-Bed Benchmark"))
+        {
+            benchmarkReport = RunMultiBedBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Plot Benchmark"))
+        {
+            benchmarkReport = RunPlotBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Result File Benchmark"))
+        {
+            benchmarkReport = RunResultFileBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Flowsheet File Benchmark"))
+        {
+            benchmarkReport = RunFlowsheetIOBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Hit-Test Benchmark"))
+        {
+            benchmarkReport = RunHitTestBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Grid Benchmark"))
+        {
+            benchmarkReport = RunGridBenchmark();
+            showBenchmark = true;
+        }
+        if (ImGui::MenuItem("Undo Benchmark"))
+        {
+            benchmarkReport = RunUndoBenchmark();
+            showBenchmark = true;
+        }
+        ImGui::EndMenu();
+    }
+
+    if (showBenchmark)
+    {
+        ShowModalPopUp(benchmarkReport, showBenchmark);
+    }
+
     if (ImGui::MenuItem("Exit"))
     {
         showExitPopUp = true;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "PsaCycle.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <functional>
+
+struct MultiBedSettings {
+    int numBeds = 2;
+    int maxCycles = 100;
+    double tolerance = 1e-4;        // On the scaled change of every bed over one cycle
+    bool parallel = true;           // One thread per bed, otherwise the beds take turns on the calling thread
+};
+
+struct MultiBedResult {
+    std::vector<CycleSummary> history;              // Residual of the worst bed, performance of the whole unit
+    std::vector<std::vector<double>> states;        // Each bed at the end of the last cycle
+    std::vector<ColumnProfile> profiles;
+    std::vector<ColumnStatistics> statistics;       // Per bed
+    int numSlots = 0;                               // Intervals between step boundaries of any bed
+    int numLinks = 0;                               // Bed to bed gas transfers per cycle
+    double seconds = 0.0;                           // Wall time
+
+    bool converged = false;
+    std::string message;
+};
+
+// Identical beds running the same steps, each one 1 / numBeds of the cycle behind the previous.
+// The cycle is cut into slots at the step boundaries of every bed, and the beds only synchronise
+// at the ends of slots, so with parallel set each bed advances on its own thread.
+//
+// Gas moves between beds through recorded streams. A bed equalising up takes the product end
+// outflow of the bed equalising down beside it, and purge and LPP take the composition of the
+// light product of a bed on adsorption. The donor records its outflow over the slot and hands it
+// to the receiver through a lock-free single producer, single consumer buffer. The receiver uses
+// it in the same slot of the next cycle, which is exact at the cyclic steady state. Until a
+// stream arrives, and for steps without a donor, the single bed boundaries of PsaCycle apply.
+// A step cut across slots restarts its valve ramp from the bed pressure at every slot.
+class MultiBedPsa {
+public:
+    // Two bed cycle with pressure equalisation
+    MultiBedPsa();
+
+    bool Validate(std::string& message) const;
+
+    // Starts every bed saturated with feed at the high pressure and repeats cycles until every
+    // bed changes by less than the tolerance. observer is called after every cycle and returns
+    // false to stop.
+    using CycleObserver = std::function<bool(const CycleSummary& summary)>;
+    MultiBedResult Run(const CycleObserver& observer = nullptr) const;
+
+    // Configuration. The column, the steps of one bed and the light product composition.
+    PsaCycle cycle;
+    MultiBedSettings settings;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "UnitOperations.h"
+
+// STL Includes
+#include <unordered_map>
+#include <functional>
+
+// Factory for creating nodes
+class NodeFactory {
+private:
+    std::unordered_map<std::string, std::function<std::unique_ptr<Node>(const std::string&, const Vec2&)>> factories;
+
+public:
+    NodeFactory() {
+        // Register node types
+        RegisterNodeType("Valve", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> 
+        {
+            return std::make_unique<Valve>(name, pos);
+        });
+
+        RegisterNodeType("Inlet", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node>
+        {
+            return std::make_unique<Inlet>(name, pos);
+        });
+
+        //RegisterNodeType("Compressor", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Compressor", pos, Vec2(140, 100));
+        //    node->AddInputPoint("Suction", Vec2(0, 50));
+        //    node->AddOutputPoint("Discharge", Vec2(140, 50));
+        //    node->parameters["Pressure Ratio"] = 2.0f;
+        //    node->parameters["Efficiency"] = 0.75f;
+        //    node->parameters["Power"] = 100.0f;
+        //    node->imagePath = "icons/valve.png";
+        //
+        //    return node;
+        //});
+        //
+        //RegisterNodeType("Tank", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Tank", pos, Vec2(120, 160));
+        //    node->AddInputPoint("In", Vec2(0, 60));
+        //    node->AddOutputPoint("Out", Vec2(120, 100));
+        //    node->parameters["Volume"] = 10.0f;
+        //    node->parameters["Initial Level"] = 5.0f;
+        //    node->parameters["Max Pressure"] = 100.0f;
+        //    node->imagePath = "icons/tank.png";
+        //
+        //    return node;
+        //});
+        //
+        //RegisterNodeType("Pipe", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Pipe", pos, Vec2(160, 70));
+        //    node->AddInputPoint("In", Vec2(0, 35));
+        //    node->AddOutputPoint("Out", Vec2(160, 35));
+        //    node->parameters["Length"] = 10.0f;
+        //    node->parameters["Diameter"] = 0.1f;
+        //    node->parameters["Roughness"] = 0.001f;
+        //    node->imagePath = "icons/pipe.png";
+        //
+        //    return node;
+        //});
+        //
+        //RegisterNodeType("Inlet", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Inlet", pos, Vec2(100, 60));
+        //    node->AddOutputPoint("Out", Vec2(100, 30));
+        //    node->parameters["Flow Rate"] = 10.0f;
+        //    node->parameters["Temperature"] = 25.0f;
+        //    node->parameters["Pressure"] = 101.3f;
+        //    node->imagePath = "icons/valve.png";
+        //
+        //    return node;
+        //});
+        //
+        //RegisterNodeType("Outlet", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Outlet", pos, Vec2(100, 60));
+        //    node->AddInputPoint("In", Vec2(0, 30));
+        //    node->parameters["Pressure"] = 101.3f;
+        //    node->imagePath = "icons/valve.png";
+        //
+        //    return node;
+        //});
+        //
+        //RegisterNodeType("Splitter", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Splitter", pos, Vec2(120, 120));
+        //    node->AddInputPoint("In", Vec2(0, 60));
+        //    node->AddOutputPoint("Out1", Vec2(120, 30));
+        //    node->AddOutputPoint("Out2", Vec2(120, 60));
+        //    node->AddOutputPoint("Out3", Vec2(120, 90));
+        //    node->parameters["Split Ratio 1"] = 0.33f;
+        //    node->parameters["Split Ratio 2"] = 0.33f;
+        //    node->parameters["Split Ratio 3"] = 0.34f;
+        //    node->imagePath = "icons/splitter.png";
+        //
+        //    return node;
+        //});
+        //
+        //RegisterNodeType("Mixer", [](const std::string& name, const Vec2& pos) -> std::unique_ptr<Node> {
+        //    auto node = std::make_unique<Node>(name, "Mixer", pos, Vec2(120, 120));
+        //    node->AddInputPoint("In1", Vec2(0, 30));
+        //    node->AddInputPoint("In2", Vec2(0, 60));
+        //    node->AddInputPoint("In3", Vec2(0, 90));
+        //    node->AddOutputPoint("Out", Vec2(120, 60));
+        //    node->parameters["Pressure Drop"] = 5.0f;
+        //    node->parameters["Efficiency"] = 0.95f;
+        //    node->imagePath = "icons/mixer.png";
+        //
+        //    return node;
+        //});
+    }
+
+    // Register a new node type
+    void RegisterNodeType(const std::string& type, std::function<std::unique_ptr<Node>(const std::string&, const Vec2&)> factory) {
+        factories[type] = factory;
+    }
+
+    // Create a node of the specified type
+    std::unique_ptr<Node> CreateNode(const std::string& type, const std::string& name, const Vec2& pos) const {
+        auto factory = factories.find(type);
+        if (factory != factories.end()) {
+            return factory->second(name, pos);
+        }
+        return nullptr;
+    }
+
+    std::string GetImagePathForType(const std::string& type) const {
+        auto tempNode = CreateNode(type, "temp", Vec2(0, 0));
+        return tempNode ? tempNode->imagePath : "icons/valve.png";
+    }
+
+    // Get all registered node types
+    std::vector<std::string> GetNodeTypes() const {
+        std::vector<std::string> types;
+        for (const auto& pair : factories) {
+            types.push_back(pair.first);
+        }
+        return types;
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CubicEOS.h"
+
+// STL Includes
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+
+struct PropertyTableSettings {
+    double minTemperature = 250.0;      // [K]
+    double maxTemperature = 450.0;      // [K]
+    double minPressure = 0.5;           // [bar]
+    double maxPressure = 50.0;          // [bar]
+    int temperatureCells = 4;           // Root grid
+    int pressureCells = 4;
+    int maxDepth = 10;                  // Each level halves a cell in T and P, at most 20
+    double tolerance = 1e-7;            // Scaled interpolation error, see PropertyTable
+};
+
+// Vapour properties of one mixture composition tabulated over (T, P). The domain starts as a
+// coarse grid of cells. Each cell holds a bicubic Hermite patch built from the EOS values and the
+// T, P and cross derivatives at its corners. The first query landing in a cell checks the patch
+// against the EOS at the cell centre and edge midpoints and splits the cell into four while the
+// error is above the tolerance. Errors are relative for Z and density, relative to RT for the
+// enthalpy and absolute for ln(phi). States outside the domain go to the EOS.
+//
+// Queries are safe from several threads. Refinement takes an exclusive lock, warm lookups only a
+// shared one.
+class PropertyTable {
+public:
+    PropertyTable(const CubicEOS& eos, const std::vector<double>& composition, const PropertyTableSettings& settings);
+
+    // Fills the outputs of batch for this table's composition, the batch mole fractions are ignored
+    void Evaluate(PropertyBatch& batch);
+
+    const std::vector<double>& GetComposition() const { return composition; }
+    size_t GetNumLeaves() const;
+    size_t GetNumEquationOfStateCalls() const { return numEquationOfStateCalls; }
+
+    void Write(std::ostream& out) const;
+    // Returns nullptr and sets error if the stream does not hold a table for this EOS
+    static std::unique_ptr<PropertyTable> Read(std::istream& in, const CubicEOS& eos, std::string& error);
+
+private:
+    struct Cell {
+        int i = 0, j = 0;               // Lower corner on the finest lattice
+        int depth = 0;
+        int firstChild = -1;            // Children are stored consecutively, (T, P) = (0,0) (1,0) (0,1) (1,1)
+        int patch = -1;                 // Offset of the verified patch coefficients, -1 if not checked yet
+    };
+
+    size_t GetNumProperties() const { return 3 + composition.size(); }
+    int GetCellSize(int depth) const { return 1 << (settings.maxDepth - depth); }
+    double GetTemperature(int i) const { return settings.minTemperature + i * latticeTemperature; }
+    double GetPressure(int j) const { return settings.minPressure + j * latticePressure; }
+
+    // Indices of a table read from a file point into cells and patches
+    bool HasValidCells() const;
+
+    bool IsInside(double T, double P) const;
+    int FindLeaf(double T, double P) const;
+    int RefineLeaf(double T, double P);    // Refines on the way down, needs the exclusive lock
+
+    // Values and derivatives at lattice nodes, evaluated on first use
+    const double* GetNode(int i, int j);
+    void EvaluateNodes(const std::vector<std::pair<int, int>>& nodes);
+
+    void BuildPatch(const Cell& cell, std::vector<double>& patch);
+    double GetPatchError(const Cell& cell, const std::vector<double>& patch);
+    void Interpolate(const Cell& cell, double T, double P, PropertyBatch& batch, size_t k) const;
+
+    const CubicEOS& eos;
+    std::vector<double> composition;
+    PropertyTableSettings settings;
+    double latticeTemperature = 0.0;    // Finest lattice spacing
+    double latticePressure = 0.0;
+    double mixtureMolarMass = 0.0;      // [kg/mol]
+
+    std::vector<Cell> cells;            // Root cells first, row-major in T
+    std::vector<double> patches;        // 16 coefficients per property for every verified leaf
+    std::unordered_map<uint64_t, std::vector<double>> nodes; // Value, dT, dP, dTdP per property
+    PropertyBatch work;
+    size_t numEquationOfStateCalls = 0;
+    mutable std::shared_mutex mutex;
+};
+
+// Tables per composition, created on first use and persisted to a single file
+class PropertyTableCache {
+public:
+    PropertyTableCache(const CubicEOS& eos, const PropertyTableSettings& settings = PropertyTableSettings());
+
+    PropertyTable& GetTable(const std::vector<double>& composition);
+
+    bool Save(const std::string& path) const;
+    // Adds the tables in the file. Returns false and sets error if the file does not match the EOS.
+    bool Load(const std::string& path, std::string& error);
+
+    size_t GetNumTables() const;
+
+private:
+    const CubicEOS& eos;
+    PropertyTableSettings settings;
+    std::map<std::vector<double>, std::unique_ptr<PropertyTable>> tables;
+    mutable std::mutex mutex;
+};
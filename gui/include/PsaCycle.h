@@ -0,0 +1,110 @@
+#pragma once
+
+#include "AdsorptionColumn.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <functional>
+
+// One step of a single bed pressure swing cycle. The feed end is the column inlet and the product
+// end its outlet. Steps that end at the high pressure go to the outlet pressure of the column.
+struct CycleStep {
+    enum class Type {
+        Adsorption,                 // Feed in, light product out at the high pressure
+        Pressurisation,             // Feed in, product end closed
+        CoBlowdown,                 // Feed end closed, gas leaves the product end (CoBLO)
+        CnBlowdown,                 // Product end closed, heavy product leaves the feed end (CnBLO)
+        LightProductPressurisation, // Feed end closed, light product in at the product end (LPP)
+        Purge,                      // Light product in at the product end, heavy product out at the feed end
+        EqualisationDown,           // Feed end closed, gas leaves the product end for a bed equalising up
+        EqualisationUp              // Feed end closed, gas from a bed equalising down enters the product end
+    };
+
+    Type type = Type::Adsorption;
+    double duration = 100.0;        // [s]
+    double pressure = 1.0;          // End pressure of blowdown, purge and equalisation steps [bar]
+    double velocity = 0.0;          // Purge inflow, superficial [m/s]
+    double rampTime = 2.0;          // Valve time constant of pressure ends [s]
+
+    static const char* GetName(Type type);
+};
+
+struct CyclicSteadyStateSettings {
+    bool accelerate = true;         // Anderson acceleration, otherwise successive substitution
+    int historySize = 10;           // Cycles kept by the Anderson update
+    int plainCycles = 2;            // Cycles run before the acceleration starts
+    int maxCycles = 500;
+    double tolerance = 1e-5;        // On the scaled change of the bed state over one cycle
+};
+
+// Convergence and performance of one cycle. Purity and recovery are those of the first component
+// in the heavy product, the gas leaving the feed end.
+struct CycleSummary {
+    int cycle = 0;
+    double residual = 0.0;          // Scaled RMS change of the bed state over the cycle
+    double massBalanceError = 0.0;  // Net gain of the first component over what entered the bed
+    double purity = 0.0;
+    double recovery = 0.0;
+    bool accelerated = false;       // Started from an extrapolated state
+};
+
+// Running totals of the first component over one cycle, from the flows of every step
+struct CycleBalance {
+    double fed = 0.0;               // Entered with the feed
+    double heavy = 0.0;             // Left through the feed end
+    double heavyTotal = 0.0;        // All components that left through the feed end
+    double entered = 0.0;           // Entered through either end
+    double gained = 0.0;            // Net gain of the bed
+
+    void Add(const ColumnFlows& flows);
+    void Add(const CycleBalance& other);
+
+    // Purity, recovery and mass balance error
+    void Summarise(CycleSummary& summary) const;
+};
+
+struct CyclicSteadyStateResult {
+    std::vector<CycleSummary> history;
+    std::vector<double> state;      // Bed at the start of the last cycle
+    ColumnProfile profile;
+    ColumnStatistics statistics;
+
+    bool converged = false;
+    std::string message;
+};
+
+// Cyclic steady state of a single bed. One cycle maps the bed state at its start to the state at
+// its end, and the cyclic steady state is the fixed point of that map. Repeating cycles converges
+// slowly when the bed has a long memory, so the fixed point iteration is accelerated with
+// Anderson mixing of the last few cycles, in variables scaled by the pressure, the capacity and
+// the ambient temperature. Extrapolated states are clipped to physical bounds, and the history is
+// dropped if a cycle fails or the residual grows.
+class PsaCycle {
+public:
+    // Adsorption, CoBLO, CnBLO and LPP on the default column
+    PsaCycle();
+
+    bool Validate(std::string& message) const;
+
+    // End conditions of a step on its own. Gas entering the product end has the light product
+    // composition, and equalising up goes to the step pressure like LPP.
+    void GetBoundaries(const CycleStep& step, ColumnBoundary& inlet, ColumnBoundary& outlet) const;
+
+    // Bed state scales of the convergence test: pressure, mole fractions, capacity and temperature
+    std::vector<double> GetStateScale() const;
+
+    // Runs one cycle from state. Fills the performance fields of summary.
+    bool RunCycle(std::vector<double>& state, CycleSummary& summary, ColumnStatistics& statistics, std::string& message) const;
+
+    // Starts from a bed equilibrated with the feed at the high pressure. observer is called after
+    // every cycle and returns false to stop.
+    using CycleObserver = std::function<bool(const CycleSummary& summary)>;
+    CyclicSteadyStateResult SolveCyclicSteadyState(const CycleObserver& observer = nullptr) const;
+
+    // Configuration. Feed, temperature and high pressure are those of the column.
+    AdsorptionColumn column;
+    std::vector<CycleStep> steps;
+    std::vector<double> lightProductMoleFraction;
+    CyclicSteadyStateSettings settings;
+};
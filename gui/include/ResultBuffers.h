@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ResultFile.h"
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+
+// Result buffers the web page reads in place instead of receiving them as text. Each buffer is one
+// block of doubles, column after column, at a fixed address in the WASM heap. The page finds a
+// buffer by name, pins it, builds Float64Array views on the heap over its columns, reads or
+// uploads them and unpins it. Publishing a newer result under the same name, or releasing it,
+// only frees the old block once the page has unpinned it, so a view taken while pinned never
+// points at freed memory.
+//
+// Growing the WASM heap replaces its ArrayBuffer and detaches every view on it, so the page makes
+// its views right before use and does not call back into the app while it holds them.
+class ResultBuffers {
+public:
+    // The buffers of the exported functions below
+    static ResultBuffers& Get();
+
+    // values holds the columns one after the other, each rows long. Replaces any buffer of the
+    // same name and returns the handle of the new one.
+    int Publish(const std::string& name, const std::vector<ResultColumn>& columns, size_t rows, std::vector<double>&& values);
+    void Release(const std::string& name);
+
+    // 0 if there is no current buffer of that name
+    int Find(const std::string& name) const;
+
+    // A pinned buffer stays where it is until it is unpinned as often as it was pinned. Returns
+    // false if the handle is unknown or already freed.
+    bool Pin(int handle);
+    void Unpin(int handle);
+
+    // Start of the block, nullptr for an unknown handle
+    const double* GetData(int handle) const;
+    size_t GetNumRows(int handle) const;
+    size_t GetNumColumns(int handle) const;
+
+    // JSON array with the handle, name, rows and columns of every current buffer
+    std::string GetManifest() const;
+
+    // Buffers alive, current or still pinned
+    size_t GetNumBuffers() const;
+
+private:
+    struct Buffer {
+        int handle = 0;
+        std::string name;
+        std::vector<ResultColumn> columns;
+        size_t rows = 0;
+        std::vector<double> values;
+        int pins = 0;
+        bool released = false;              // Replaced or released, freed when unpinned
+    };
+
+    Buffer* FindHandle(int handle) const;
+    void Collect();
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    int nextHandle = 1;
+};
+
+#ifdef EMSCRIPTEN
+#include <emscripten/emscripten.h>
+#define THERMATIX_EXPORT EMSCRIPTEN_KEEPALIVE
+#else
+#define THERMATIX_EXPORT
+#endif
+
+// Page side of ResultBuffers. Pointers are byte offsets into the WASM heap.
+extern "C" {
+    THERMATIX_EXPORT const char* thermatix_result_manifest();
+    THERMATIX_EXPORT int thermatix_result_find(const char* name);
+    THERMATIX_EXPORT int thermatix_result_pin(int handle);
+    THERMATIX_EXPORT void thermatix_result_unpin(int handle);
+    THERMATIX_EXPORT const double* thermatix_result_data(int handle);
+    THERMATIX_EXPORT int thermatix_result_rows(int handle);
+    THERMATIX_EXPORT int thermatix_result_columns(int handle);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+// Columnar binary result files. A file is a header naming the columns, chunks of rows with every
+// column stored contiguously in its own type, and an index of the chunks written on close. The
+// first column is the key (time, case number) and the index keeps its range in every chunk, so a
+// reader can pick out a time window without touching the rest of the file.
+//
+// Layout, little endian:
+//   "THXR", version, column count, then per column its type, name and unit
+//   chunks: per column, the values of every row padded to 8 bytes
+//   index: per chunk, its offset, row count and key range
+//   footer: index offset, chunk count, row count, "THXREND"
+
+enum class ResultType : uint8_t { Float64, Float32 };
+
+struct ResultColumn {
+    std::string name;
+    std::string unit;
+    ResultType type = ResultType::Float64;
+};
+
+// Index entry of one chunk
+struct ResultChunk {
+    uint64_t offset = 0;
+    uint64_t rows = 0;
+    double keyMin = 0.0;
+    double keyMax = 0.0;
+};
+
+// Writes rows as they are produced. Rows are held until a chunk is full, so a file being written
+// only ever holds whole chunks.
+class ResultWriter {
+public:
+    ResultWriter() = default;
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    bool Open(const std::string& path, const std::vector<ResultColumn>& columns, std::string& message, size_t chunkRows = 4096);
+    bool IsOpen() const { return file.is_open(); }
+
+    // values holds one entry per column
+    void Append(const double* values);
+
+    // Writes the last chunk, the index and the footer
+    bool Close(std::string& message);
+
+    size_t GetNumRows() const { return numRows; }
+
+private:
+    void WriteChunk();
+
+    std::ofstream file;
+    std::vector<ResultColumn> columns;
+    std::vector<std::vector<double>> pending;       // [column][row] of the chunk being filled
+    std::vector<ResultChunk> chunks;
+    size_t chunkRows = 0;
+    size_t numRows = 0;
+};
+
+// Reads a closed result file. Desktop builds map the file into memory, mmap on POSIX and
+// MapViewOfFile on Windows, so opening it costs nothing and only the chunks that are read are paged
+// in. The browser build, or a file that cannot be mapped, is read whole.
+class ResultReader {
+public:
+    ResultReader() = default;
+    ~ResultReader();
+
+    ResultReader(const ResultReader&) = delete;
+    ResultReader& operator=(const ResultReader&) = delete;
+
+    bool Open(const std::string& path, std::string& message);
+    void Close();
+
+    bool IsMapped() const { return mapping != nullptr; }
+    const std::vector<ResultColumn>& GetColumns() const { return columns; }
+    size_t GetNumRows() const { return numRows; }
+    size_t GetNumChunks() const { return chunks.size(); }
+
+    // -1 if there is no column of that name
+    int FindColumn(const std::string& name) const;
+
+    // Every value of a column, as double
+    void ReadColumn(size_t column, std::vector<double>& values) const;
+
+    // Values of a column in the rows whose key lies between from and to. Chunks whose key range
+    // misses the window are skipped.
+    void ReadRange(size_t column, double from, double to, std::vector<double>& values) const;
+
+    // Float64 values of one column of one chunk in place, nullptr for Float32 columns
+    const double* GetChunkData(size_t chunk, size_t column, size_t& rows) const;
+
+private:
+    bool Parse(std::string& message);
+
+    // Start of the values of a column in a chunk
+    const unsigned char* GetColumnData(const ResultChunk& chunk, size_t column) const;
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    void* mapping = nullptr;                    // Mapped file, or nullptr when read into buffer
+    std::vector<unsigned char> buffer;
+
+    std::vector<ResultColumn> columns;
+    std::vector<ResultChunk> chunks;
+    size_t numRows = 0;
+};
+
+// Optional text conversions. CSV has a header row of "name [unit]", JSON is an object of
+// column name to array of values.
+void ExportCsv(const ResultReader& reader, std::ostream& out);
+void ExportJson(const ResultReader& reader, std::ostream& out);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "SpscBuffer.h"
+
+// STL Includes
+#include <vector>
+#include <cstddef>
+
+// Rows of samples written by a solver thread and read by the GUI thread while the solver runs.
+// The writer fills a chunk of rows and hands it over a lock-free ring, so neither side waits for
+// the other. While the ring is full the writer keeps filling its chunk and hands it over once
+// there is room, so no sample is lost.
+class SeriesStream {
+public:
+    SeriesStream(size_t numColumns, size_t chunkRows = 256, size_t capacity = 64);
+
+    size_t GetNumColumns() const { return numColumns; }
+
+    // Writer only. values holds one entry per column.
+    void Append(const double* values);
+
+    // Writer only. Hands over a partly filled chunk, returns false if the ring is full.
+    bool Flush();
+
+    // Reader only. Appends every row handed over so far to columns, one vector per column, and
+    // returns the number of rows added.
+    size_t Drain(std::vector<std::vector<double>>& columns);
+
+private:
+    size_t numColumns;
+    size_t chunkRows;
+    SpscBuffer<std::vector<double>> ring;
+    std::vector<double> pending;            // Writer's chunk, row major
+};
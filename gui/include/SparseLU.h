@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SparseMatrix.h"
+
+// STL Includes
+#include <vector>
+
+// Sparse LU factorisation of a square matrix, split into a symbolic and a numeric phase.
+//
+// Analyze() eliminates row by row (sparsest rows first) and picks each pivot column by
+// threshold partial pivoting, preferring sparse columns. It records the row order, the
+// pivot columns and the L and U patterns. Factorize() then reuses all of that and only
+// recomputes values, which is what a Newton iteration on a fixed structure needs.
+// Factorize() returns false when a reused pivot has become too small, in which case the
+// caller should run Analyze() again.
+class SparseLU {
+public:
+    bool Analyze(const SparseMatrix& A);
+    bool Factorize(const SparseMatrix& A);
+
+    // Solve A x = b in place
+    void Solve(std::vector<double>& b) const;
+
+    bool IsAnalyzed() const { return analyzed; }
+    int GetNumAnalyses() const { return numAnalyses; }
+    int GetFillIn() const;
+
+    double pivotThreshold = 0.1;   // Accept pivots within this fraction of the largest entry in the row
+    double refactorThreshold = 1e-3; // Reject reused pivots smaller than this fraction of the row
+
+private:
+    bool EliminateRow(const SparseMatrix& A, int step);
+
+    int n = 0;
+    bool analyzed = false;
+    int numAnalyses = 0;
+
+    std::vector<int> rowOrder;     // Matrix row eliminated at each step
+    std::vector<int> pivotCol;     // Pivot column chosen at each step
+    std::vector<int> stepOfCol;    // Inverse of pivotCol, -1 while unassigned
+
+    // L: multipliers of each step against earlier steps, in elimination order
+    std::vector<int> lStart;
+    std::vector<int> lStep;
+    std::vector<double> lValue;
+
+    // U: the pivot entry first, then the columns that are pivoted at later steps
+    std::vector<int> uStart;
+    std::vector<int> uCol;
+    std::vector<double> uValue;
+
+    std::vector<double> work;      // Dense row accumulator indexed by column
+    std::vector<char> marked;
+};
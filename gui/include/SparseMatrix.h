@@ -0,0 +1,61 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+// Square or rectangular matrix in compressed sparse row storage
+struct SparseMatrix {
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> rowStart;      // Size rows + 1
+    std::vector<int> colIndex;      // Column of each stored value, sorted within a row
+    std::vector<double> values;
+
+    int NonZeros() const { return static_cast<int>(values.size()); }
+
+    void Multiply(const std::vector<double>& x, std::vector<double>& y) const {
+        y.assign(rows, 0.0);
+        for (int i = 0; i < rows; ++i) {
+            double sum = 0.0;
+            for (int p = rowStart[i]; p < rowStart[i + 1]; ++p) {
+                sum += values[p] * x[colIndex[p]];
+            }
+            y[i] = sum;
+        }
+    }
+
+    // Build the pattern from (row, col) pairs. Duplicates are merged.
+    // slotOfEntry[e] receives the position in values that entry e accumulates into, so a
+    // caller can refill the values every iteration without rebuilding the pattern.
+    static SparseMatrix FromPattern(int rows, int cols, const std::vector<std::pair<int, int>>& entries, std::vector<int>& slotOfEntry) {
+        SparseMatrix m;
+        m.rows = rows;
+        m.cols = cols;
+
+        std::vector<int> order(entries.size());
+        for (size_t e = 0; e < entries.size(); ++e) order[e] = static_cast<int>(e);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return entries[a] < entries[b]; });
+
+        m.rowStart.assign(rows + 1, 0);
+        slotOfEntry.assign(entries.size(), -1);
+
+        for (size_t k = 0; k < order.size(); ++k) {
+            const auto& entry = entries[order[k]];
+            bool duplicate = k > 0 && entries[order[k - 1]] == entry;
+            if (!duplicate) {
+                m.colIndex.push_back(entry.second);
+                ++m.rowStart[entry.first + 1];
+            }
+            slotOfEntry[order[k]] = static_cast<int>(m.colIndex.size()) - 1;
+        }
+
+        for (int i = 0; i < rows; ++i) {
+            m.rowStart[i + 1] += m.rowStart[i];
+        }
+
+        m.values.assign(m.colIndex.size(), 0.0);
+        return m;
+    }
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Flowsheet.h"
+
+// STL Includes
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+// Uniform grid over the canvas for hit-testing units and snapping to ports. Every unit is listed
+// in the cells its bounds cover, grown by a margin as wide as the largest snap distance, so a
+// query near a point only has to look at the units of the one cell the point lies in. Units
+// that move are only re-listed when the cells they cover change.
+//
+// Units are kept by their flowsheet slot, with their bounds and drawing order in arrays indexed
+// by slot, so clicks and culling read packed floats instead of following a pointer per unit.
+// Only units of a flowsheet, which have a slot, can be listed.
+//
+// Streams are found through the ports of the units near a rectangle. A stream longer than
+// linkReach, which may cross the rectangle with both ends far outside it, is kept aside by its
+// outlet port, so the grid has to hear about every stream made and every unit moved.
+class SpatialGrid {
+public:
+    explicit SpatialGrid(float cellSize = 128.0f, float margin = 25.0f)
+        : cellSize(cellSize), margin(margin), linkReach(2.0f * cellSize) {}
+
+    void Clear();
+
+    // Lists every unit, in drawing order
+    void Rebuild(const std::vector<std::unique_ptr<Node>>& nodes);
+
+    // A new unit is drawn above the ones already listed
+    void Insert(Node* node);
+
+    // Call after the unit moved
+    void Update(Node* node);
+    void Remove(Node* node);
+
+    // Call after a stream was made, removed ones are noticed by their ports
+    void UpdateConnection(Connection* connection);
+
+    // Units whose grown bounds may contain point, topmost first
+    void QueryPoint(const Vec2& point, std::vector<Node*>& nodes) const;
+
+    // Units whose grown bounds overlap the rectangle, each once, in drawing order
+    void QueryRect(const Vec2& min, const Vec2& max, std::vector<Node*>& nodes) const;
+
+    // Streams whose end points span a box overlapping the rectangle, each once, in flowsheet order
+    void QueryConnections(const Vec2& min, const Vec2& max, std::vector<Connection*>& connections) const;
+
+    // Topmost unit whose bounds contain point, nullptr if none
+    Node* FindNodeAt(const Vec2& point) const;
+
+    // Nearest port within maxDist of point, at most the margin, nullptr if none. Ports of
+    // exclude are skipped.
+    ConnectionPoint* FindNearestPort(const Vec2& point, float maxDist, bool inputsOnly, bool outputsOnly, const Node* exclude = nullptr) const;
+
+    size_t GetNumNodes() const { return numNodes; }
+    float GetMargin() const { return margin; }
+
+private:
+    // Cells covered by a unit, inclusive
+    struct CellRange {
+        int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+        bool operator==(const CellRange& other) const { return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1; }
+    };
+
+    int GetCell(float coordinate) const;
+    CellRange GetRange(uint32_t slot) const;
+    static uint64_t GetKey(int x, int y) { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y); }
+
+    bool IsListed(const Node* node) const { return node && node->slot < slotNodes.size() && slotNodes[node->slot] == node; }
+    void SetBounds(uint32_t slot, const Node& node);
+    bool Overlaps(uint32_t slot, const Vec2& min, const Vec2& max) const;
+    bool Contains(uint32_t slot, const Vec2& point) const;
+
+    // Files the streams of the unit as long or not
+    void UpdateConnections(const Node& node);
+
+    void AddToCells(uint32_t slot, const CellRange& range);
+    void RemoveFromCells(uint32_t slot, const CellRange& range);
+
+    // Slots listed in the cell holding point, nullptr if it is empty
+    const std::vector<uint32_t>* GetSlots(const Vec2& point) const;
+
+    float cellSize;
+    float margin;
+    float linkReach;                         // Longest stream, in x or y, found through its units
+    uint64_t nextOrder = 0;
+    size_t numNodes = 0;
+
+    // By slot, structure of arrays. slotNodes is nullptr where no unit is listed.
+    std::vector<Node*> slotNodes;
+    std::vector<float> minX, minY, maxX, maxY;    // Bounds of the unit, not grown
+    std::vector<uint64_t> orders;                 // Drawing order, higher is drawn later and on top
+    std::vector<CellRange> ranges;
+
+    mutable std::vector<std::pair<uint64_t, uint32_t>> scratch;   // Order and slot of units found by queries
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+    std::unordered_set<ConnectionPoint*> longLinks;                 // Outlets of streams longer than linkReach
+    mutable std::vector<Node*> nearNodes;                           // Found by QueryConnections
+    mutable std::vector<Connection*> adjacent;
+};
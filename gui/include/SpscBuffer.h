@@ -0,0 +1,50 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+// Bounded ring buffer between one producer thread and one consumer thread. Push and Pop never
+// lock or wait: the producer owns the tail and the consumer the head, and each publishes its index
+// with release ordering only after it is done with the slot. One slot stays empty to tell a full
+// buffer from an empty one.
+template <typename T>
+class SpscBuffer {
+public:
+    explicit SpscBuffer(size_t capacity) : slots(capacity + 1) {}
+
+    SpscBuffer(const SpscBuffer&) = delete;
+    SpscBuffer& operator=(const SpscBuffer&) = delete;
+
+    // Producer only. Returns false and leaves value alone if the buffer is full.
+    bool Push(T& value)
+    {
+        const size_t current = tail.load(std::memory_order_relaxed);
+        const size_t next = Next(current);
+        if (next == head.load(std::memory_order_acquire)) return false;
+
+        slots[current] = std::move(value);
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the buffer is empty.
+    bool Pop(T& value)
+    {
+        const size_t current = head.load(std::memory_order_relaxed);
+        if (current == tail.load(std::memory_order_acquire)) return false;
+
+        value = std::move(slots[current]);
+        head.store(Next(current), std::memory_order_release);
+        return true;
+    }
+
+private:
+    size_t Next(size_t index) const { return index + 1 == slots.size() ? 0 : index + 1; }
+
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> head{ 0 };  // Next slot to read
+    alignas(64) std::atomic<size_t> tail{ 0 };  // Next slot to write
+};
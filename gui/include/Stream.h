@@ -0,0 +1,20 @@
+#pragma once
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+
+// Material stream state carried by a connection point
+struct Stream {
+    double pressure = 1.01325;   // [bar]
+    double temperature = 298.0;  // [K]
+    double massFlowRate = 0.0;   // [kg/s]
+
+    // Largest scaled difference between two stream states, used for tear stream convergence
+    static double Difference(const Stream& a, const Stream& b) {
+        double dP = std::fabs(a.pressure - b.pressure) / std::max(1.0, std::fabs(b.pressure));
+        double dT = std::fabs(a.temperature - b.temperature) / std::max(1.0, std::fabs(b.temperature));
+        double dM = std::fabs(a.massFlowRate - b.massFlowRate) / std::max(1.0, std::fabs(b.massFlowRate));
+        return std::max(dP, std::max(dT, dM));
+    }
+};
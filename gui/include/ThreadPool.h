@@ -0,0 +1,45 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstddef>
+
+// Fixed size pool of worker threads fed from a single FIFO queue.
+// A pool created with zero workers runs the queued tasks on the thread that calls Wait(),
+// which is what the single threaded WASM build falls back to.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t numThreads = DefaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task. Exceptions thrown by the task are captured and rethrown by Wait().
+    void Submit(std::function<void()> task);
+
+    // Block until the queue is empty and no task is running.
+    void Wait();
+
+    size_t GetThreadCount() const { return workers.size(); }
+
+    static size_t DefaultThreadCount();
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    size_t activeTasks = 0;
+    bool stopping = false;
+    std::exception_ptr firstError;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Flowsheet.h"
+
+// STL Includes
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+
+// What an undo or redo changed, for the editor to update its canvas index and selection
+struct JournalChange {
+    std::vector<Node*> added;        // Back in the flowsheet
+    std::vector<Node*> removed;      // Taken out, kept by the journal
+    std::vector<Node*> moved;
+    std::vector<Connection*> connected;  // Made again, removed ones are gone
+    bool edited = false;             // Connections or values changed, the flowsheet needs solving
+};
+
+// Undo and redo of editor changes. Every step holds only what the edit touched: the units that
+// moved with their old and new positions, the one value that changed, the units and streams that
+// were added or deleted. Deleted units are moved out of the flowsheet into the journal, not
+// copied, so a unit keeps its address across undo and redo and steps refer to units and ports by
+// pointer. Handles to a unit go stale while it is out; putting it back gives it new ones. Undo
+// and redo cost the size of the step.
+//
+// Continuous edits, typing into a field, merge into one step until Seal() is called. The
+// editor seals the journal when no widget is active any more. Steps past maxBytes are dropped,
+// oldest first, so memory stays flat over a long session.
+class UndoJournal {
+public:
+    explicit UndoJournal(size_t maxBytes = 16u << 20) : maxBytes(maxBytes) {}
+
+    // The edits below have already been made, except DeleteNodes which makes it
+
+    // node is the last unit of the flowsheet
+    void RecordAdd(const Flowsheet& flowsheet, Node* node);
+
+    // connection was just made and is in the flowsheet at connection->index
+    void RecordConnect(Connection* connection);
+
+    struct Move {
+        Node* node;
+        Vec2 from;
+        Vec2 to;
+    };
+    // A whole drag, from where the units were picked up to where they were dropped
+    void RecordMove(std::vector<Move> moves);
+
+    // Value and selection of node->data[variable] before the edit. Merges with an open step
+    // on the same variable.
+    void RecordValue(Node* node, size_t variable, double oldValue, bool oldSelected);
+
+    // Merges with an open step renaming the same unit
+    void RecordRename(Node* node, const std::string& oldName);
+
+    // Removes the units and every connection to them from the flowsheet, as one step
+    void DeleteNodes(Flowsheet& flowsheet, const std::vector<Node*>& nodes);
+
+    // The next edit starts a new step
+    void Seal() { isOpen = false; }
+
+    bool Undo(Flowsheet& flowsheet, JournalChange& change);
+    bool Redo(Flowsheet& flowsheet, JournalChange& change);
+
+    bool CanUndo() const { return !done.empty(); }
+    bool CanRedo() const { return !undone.empty(); }
+
+    // After the flowsheet was replaced
+    void Clear();
+
+    size_t GetNumSteps() const { return done.size() + undone.size(); }
+    size_t GetNumBytes() const { return numBytes; }
+
+private:
+    enum class Kind { Add, Delete, Connect, Move, Value, Rename };
+
+    struct Link {
+        ConnectionPoint* from;
+        ConnectionPoint* to;
+        size_t index;                        // In flowsheet.connections
+    };
+
+    struct Step {
+        Kind kind;
+        size_t bytes = 0;
+
+        // Add and Delete: the units, their indices in flowsheet.nodes ascending, and the
+        // units themselves while they are out of the flowsheet
+        std::vector<Node*> nodes;
+        std::vector<size_t> indices;
+        std::vector<std::unique_ptr<Node>> removed;
+
+        // Connect and Delete, ascending indices
+        std::vector<Link> links;
+
+        std::vector<Move> moves;
+
+        // Value and Rename
+        Node* node = nullptr;
+        size_t variable = 0;
+        double values[2] = {};               // Before and after
+        bool selected[2] = {};
+        std::string names[2];
+    };
+
+    void Push(Step step);
+    void Apply(Flowsheet& flowsheet, Step& step, bool redo, JournalChange& change);
+    static size_t GetBytes(const Step& step);
+
+    size_t maxBytes;
+    size_t numBytes = 0;
+    bool isOpen = false;                     // The last step may still merge with the next edit
+    std::deque<Step> done;                   // Oldest first
+    std::vector<Step> undone;                // Most recently undone last
+};
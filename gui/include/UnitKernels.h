@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Dual.h"
+
+// STL Includes
+#include <cmath>
+
+// Unit model equations written once over the scalar type T. They are evaluated with
+// double for residuals and with Dual for exact Jacobian columns.
+namespace UnitKernels
+{
+    constexpr double GasConstant = 8.314462618;     // [J/mol/K]
+    constexpr double AirMolarMass = 0.02896;        // [kg/mol]
+    constexpr double ValveFlowConstant = 7.598e-3;  // m [kg/s] = c * CV * opening * sqrt(dP [bar] * rho [kg/m3])
+    constexpr double ValveFlowRegularisation = 1e-4; // [kg/s], keeps the flow equation differentiable at zero flow
+
+    // Offsets of the stream variables in a unit's local variable vector
+    enum StreamVariable { Pressure = 0, Temperature = 1, MassFlowRate = 2 };
+
+    // Ideal gas density [kg/m3] from pressure [bar] and temperature [K]
+    template <typename T>
+    T GasDensity(const T& pressure, const T& temperature)
+    {
+        return pressure * (1e5 * AirMolarMass / GasConstant) / temperature;
+    }
+
+    template <typename T>
+    T ValveCapacity(const T& percentOpen, const T& CV)
+    {
+        return ValveFlowConstant * CV * (percentOpen / 100.0);
+    }
+
+    // m |m| smoothed near zero flow so that its derivative never vanishes
+    template <typename T>
+    T SignedFlowSquared(const T& massFlowRate)
+    {
+        using std::sqrt;
+        return massFlowRate * sqrt(massFlowRate * massFlowRate + ValveFlowRegularisation * ValveFlowRegularisation);
+    }
+
+    // Locals: percentOpen, CV, dP, inlet (P, T, m), outlet (P, T, m)
+    template <typename T>
+    void ValveResiduals(const T* x, T* residuals)
+    {
+        const T& percentOpen = x[0];
+        const T& CV = x[1];
+        const T& dP = x[2];
+        const T* in = x + 3;
+        const T* out = x + 6;
+
+        T rho = GasDensity(in[Pressure], in[Temperature]);
+        T capacity = ValveCapacity(percentOpen, CV);
+
+        residuals[0] = out[MassFlowRate] - in[MassFlowRate];
+        residuals[1] = out[Temperature] - in[Temperature];
+        residuals[2] = out[Pressure] - (in[Pressure] - dP);
+        residuals[3] = SignedFlowSquared(in[MassFlowRate]) - capacity * capacity * dP * rho;
+    }
+
+    // Locals: pressure, massFlowRate, temperature, inlet (P, T, m, unused), outlet (P, T, m)
+    template <typename T>
+    void InletResiduals(const T* x, T* residuals)
+    {
+        const T* out = x + 6;
+
+        residuals[0] = out[Pressure] - x[0];
+        residuals[1] = out[Temperature] - x[2];
+        residuals[2] = out[MassFlowRate] - x[1];
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Flowsheet.h"
+#include "UnitKernels.h"
+
+// STL Includes
+#include <algorithm>
+
+class Valve : public Node
+{
+public:
+    Valve(const std::string& name, const Vec2& pos) : Node(name, "Valve", pos, Vec2(80,50))
+    {
+        AddInputPoint("In", Vec2(0, 25));
+        AddOutputPoint("Out", Vec2(80, 25));
+        imagePath = "icons/valve.png";
+
+        // Register all the "double" data
+        data.emplace_back(percentOpen, "Percent Open", "[-]", true);
+        data.emplace_back(CV, "Flow Coefficient (CV)", "[USGPM]", true);
+        data.emplace_back(dP, "Pressure Drop", "[bar]", false);
+    }
+
+    double percentOpen = 50.0;
+    double CV = 100.0;
+    double dP = 0.1;
+
+    // Rating mode: the pressure drop follows from the flow through the valve, see UnitKernels::ValveResiduals
+    // for the valve equation.
+    void Calculate() override
+    {
+        const Stream& in = inputs[0].stream;
+        Stream& out = outputs[0].stream;
+
+        double rho = UnitKernels::GasDensity(in.pressure, in.temperature);
+        double capacity = UnitKernels::ValveCapacity(percentOpen, CV);
+
+        if (capacity > 0.0 && rho > 0.0) {
+            dP = std::min(UnitKernels::SignedFlowSquared(in.massFlowRate) / (capacity * capacity * rho), in.pressure);
+        }
+        else {
+            dP = in.pressure; // Closed valve
+        }
+
+        out = in;
+        out.pressure = in.pressure - dP;
+    }
+
+    int GetNumEquations() const override { return 4; }
+
+    void EvaluateResiduals(const double* locals, double* residuals) const override { UnitKernels::ValveResiduals(locals, residuals); }
+    void EvaluateResiduals(const Dual* locals, Dual* residuals) const override { UnitKernels::ValveResiduals(locals, residuals); }
+};
+
+class Inlet : public Node
+{
+public:
+    Inlet(const std::string& name, const Vec2& pos) : Node(name, "Inlet", pos, Vec2(40, 50))
+    {
+        AddInputPoint("In", Vec2(0, 25));
+        AddOutputPoint("Out", Vec2(40, 25));
+        imagePath = "icons/inlet.png";
+
+        // Register all the "double" data
+        data.emplace_back(pressure, "Pressure", "[bar]", true);
+        data.emplace_back(massFlowRate, "Mass Flow Rate", "[kg/s]", false);
+        data.emplace_back(temperature, "Temperature", "[K]", true);
+    }
+
+    double pressure = 1.01325;
+    double massFlowRate = 1;
+    double temperature = 298.0;
+
+    void Calculate() override
+    {
+        Stream& out = outputs[0].stream;
+        out.pressure = pressure;
+        out.temperature = temperature;
+        out.massFlowRate = massFlowRate;
+    }
+
+    int GetNumEquations() const override { return 3; }
+
+    void EvaluateResiduals(const double* locals, double* residuals) const override { UnitKernels::InletResiduals(locals, residuals); }
+    void EvaluateResiduals(const Dual* locals, Dual* residuals) const override { UnitKernels::InletResiduals(locals, residuals); }
+};
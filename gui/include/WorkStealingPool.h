@@ -0,0 +1,41 @@
+#pragma once
+
+// STL Includes
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+// Runs a fixed batch of independent tasks on per-worker deques. The task order is split into
+// contiguous chunks, one per worker. A worker takes tasks from the front of its own deque and,
+// when it runs dry, steals the back half of the fullest other deque, so neighbouring tasks in
+// the order tend to run on the same worker. The calling thread is worker 0.
+class WorkStealingPool {
+public:
+    // numWorkers = 0 runs everything on the calling thread
+    explicit WorkStealingPool(size_t numWorkers);
+
+    // Calls task(taskIndex, workerIndex) once for every entry of order and returns when all have
+    // finished. The first exception thrown by a task stops the batch and is rethrown here.
+    void Run(const std::vector<int>& order, const std::function<void(int, int)>& task);
+
+    size_t GetWorkerCount() const { return numWorkers; }
+    size_t GetNumSteals() const { return numSteals; }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    bool Pop(size_t worker, int& task);
+    bool Steal(size_t worker);
+    void WorkerLoop(size_t worker, const std::function<void(int, int)>& task);
+
+    size_t numWorkers;
+    std::vector<WorkerQueue> queues;
+    std::atomic<bool> aborted{ false };
+    std::atomic<size_t> numSteals{ 0 };
+};
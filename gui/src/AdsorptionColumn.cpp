@@ -0,0 +1,827 @@
+#include "AdsorptionColumn.h"
+#include "BlockTridiagonal.h"
+#include "Dual.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    constexpr double GasConstant = 8.314462618;     // [J/mol/K]
+    constexpr double Pascal = 1e5;                  // [Pa/bar]
+    constexpr double PressureToleranceFactor = 1e-3;
+
+    // Constants of one integration, derived from the column configuration
+    struct ColumnModel {
+        size_t numComponents = 0;
+        size_t blockSize = 0;
+        size_t numCells = 0;
+        double dz = 0.0;
+
+        double voidage = 0.0;
+        double bulkDensity = 0.0;
+        double solidHeatCapacity = 0.0;
+        double dispersion = 0.0;
+        double conductivity = 0.0;
+        double wallLoss = 0.0;              // 4 h / D [W/m3/K]
+        double ambientTemperature = 0.0;
+        double ergunViscous = 0.0;          // dP/dz = viscous u + inertial rho |u| u
+        double ergunInertial = 0.0;
+
+        std::vector<double> molarMass;
+        std::vector<const double*> heatCapacityCoefficients;
+        std::vector<double> heatOfAdsorption, massTransfer;
+        Isotherm isotherm;
+
+        ColumnBoundary inlet, outlet;
+        double inletStartPressure = 0.0;    // Bed pressure at the ends when the integration starts [Pa]
+        double outletStartPressure = 0.0;
+
+        ColumnModel(const AdsorptionColumn& column, const ColumnBoundary& inlet, const ColumnBoundary& outlet);
+
+        template <typename T>
+        T MolarHeatCapacity(const T& temperature, size_t i) const
+        {
+            const double* c = heatCapacityCoefficients[i];
+            return ((c[3] * temperature + c[2]) * temperature + c[1]) * temperature + c[0];
+        }
+
+        // Superficial velocity from the Ergun equation for a pressure gradient [Pa/m]
+        template <typename T>
+        T ErgunVelocity(const T& gradient, const T& density) const
+        {
+            using std::sqrt;
+            using std::fabs;
+            return 2.0 * gradient / (ergunViscous + sqrt(ergunViscous * ergunViscous + 4.0 * ergunInertial * density * fabs(gradient)));
+        }
+
+        // Set point of a pressure end at time [Pa]
+        static double BoundaryPressure(const ColumnBoundary& boundary, double startPressure, double time)
+        {
+            if (boundary.rampTime <= 0.0) return boundary.pressure * Pascal;
+            return boundary.pressure * Pascal + (startPressure - boundary.pressure * Pascal) * std::exp(-time / boundary.rampTime);
+        }
+
+        // Concentrations [mol/m3], their total, pressure [Pa], mass density and molar heat capacity of one cell
+        template <typename T>
+        void CellGas(const T* cell, T* c, T& total, T& pressure, T& density, T& heatCapacity) const;
+
+        // Molar flux of each component in +z through an end face at time [mol/m2/s] and the heat
+        // it brings into the end cell [W/m2]. startPressure is that of the end cell when the
+        // integration started [Pa].
+        template <typename T>
+        void EndFlux(const ColumnBoundary& boundary, double time, double startPressure, bool isInlet, const T* c, const T& pressure,
+            const T& density, const T& temperature, T* flux, T& heat) const;
+
+        // Partial pressures and temperatures of every cell
+        void FillIsothermBatch(const double* y, IsothermBatch& batch) const;
+
+        // Equilibrium loadings for Derivatives. Doubles evaluate the isotherm, Dual numbers reuse
+        // the batch Jacobian evaluated at their values.
+        void PrepareEquilibrium(const double* y, IsothermBatch& batch) const
+        {
+            FillIsothermBatch(y, batch);
+            isotherm.Evaluate(batch, false);
+        }
+        void PrepareEquilibrium(const Dual*, IsothermBatch&) const {}
+
+        template <typename T>
+        void Derivatives(double time, const T* y, T* dydt, IsothermBatch& batch) const;
+
+        void Jacobian(double time, const std::vector<double>& y, BlockTridiagonal& jacobian, std::vector<Dual>& values,
+            std::vector<Dual>& derivatives, IsothermBatch& batch) const;
+
+        // Component fluxes in +z through both ends at time [mol/m2/s]
+        void EndFluxes(double time, const double* y, double* inletFlux, double* outletFlux) const;
+    };
+
+    ColumnModel::ColumnModel(const AdsorptionColumn& column, const ColumnBoundary& inlet, const ColumnBoundary& outlet)
+        : inlet(inlet), outlet(outlet)
+    {
+        const ColumnProperties& bed = column.column;
+        numComponents = column.GetNumComponents();
+        blockSize = column.GetBlockSize();
+        numCells = static_cast<size_t>(column.integrator.numCells);
+        dz = bed.length / numCells;
+
+        voidage = bed.bedVoidage;
+        bulkDensity = bed.bulkDensity;
+        solidHeatCapacity = bed.solidHeatCapacity;
+        dispersion = bed.axialDispersion;
+        conductivity = bed.thermalConductivity;
+        wallLoss = 4.0 * bed.wallHeatTransferCoefficient / bed.diameter;
+        ambientTemperature = bed.ambientTemperature;
+
+        const double e3 = voidage * voidage * voidage;
+        ergunViscous = 150.0 * bed.gasViscosity * (1.0 - voidage) * (1.0 - voidage) / (e3 * bed.particleDiameter * bed.particleDiameter);
+        ergunInertial = 1.75 * (1.0 - voidage) / (e3 * bed.particleDiameter);
+        isotherm = Isotherm(column.isotherm, column.adsorbates);
+
+        for (const auto& adsorbate : column.adsorbates) {
+            const Component* component = FindComponent(adsorbate.component);
+            molarMass.push_back(component->molarMass);
+            heatCapacityCoefficients.push_back(component->cp);
+            heatOfAdsorption.push_back(adsorbate.heatOfAdsorption);
+            massTransfer.push_back(adsorbate.massTransferCoefficient);
+        }
+    }
+
+    // Recorded stream at time, held constant outside the samples
+    template <typename T>
+    void SampleStream(const std::vector<ColumnStreamSample>& stream, double time, T* flux, double& temperature)
+    {
+        auto after = std::upper_bound(stream.begin(), stream.end(), time,
+            [](double t, const ColumnStreamSample& sample) { return t < sample.time; });
+        const ColumnStreamSample& next = after == stream.end() ? stream.back() : *after;
+        const ColumnStreamSample& previous = after == stream.begin() ? stream.front() : *(after - 1);
+
+        const double span = next.time - previous.time;
+        const double weight = span > 0.0 ? std::clamp((time - previous.time) / span, 0.0, 1.0) : 0.0;
+        for (size_t i = 0; i < next.flux.size(); ++i) flux[i] = (1.0 - weight) * previous.flux[i] + weight * next.flux[i];
+        temperature = (1.0 - weight) * previous.temperature + weight * next.temperature;
+    }
+
+    // Equilibrium loading of component i in cell k from an evaluated batch. Dual numbers carry
+    // their tangent through the analytic derivatives of the isotherm.
+    double Equilibrium(const IsothermBatch& batch, size_t i, size_t k, const double*, const double&)
+    {
+        return batch.loading[i][k];
+    }
+
+    Dual Equilibrium(const IsothermBatch& batch, size_t i, size_t k, const Dual* partialPressure, const Dual& temperature)
+    {
+        const size_t nc = batch.loading.size();
+        double derivative = batch.dLoadingdTemperature[i][k] * temperature.derivative;
+        for (size_t j = 0; j < nc; ++j) derivative += batch.dLoadingdPressure[i * nc + j][k] * partialPressure[j].derivative;
+        return Dual(batch.loading[i][k], derivative);
+    }
+
+    void ColumnModel::FillIsothermBatch(const double* y, IsothermBatch& batch) const
+    {
+        const size_t nc = numComponents;
+        for (size_t k = 0; k < numCells; ++k) {
+            const double* cell = y + k * blockSize;
+            double last = 1.0;
+            for (size_t i = 0; i + 1 < nc; ++i) {
+                batch.partialPressure[i][k] = cell[1 + i] * cell[0];
+                last -= cell[1 + i];
+            }
+            batch.partialPressure[nc - 1][k] = last * cell[0];
+            batch.temperature[k] = cell[2 * nc];
+        }
+    }
+
+    template <typename T>
+    void ColumnModel::CellGas(const T* cell, T* c, T& total, T& pressure, T& density, T& heatCapacity) const
+    {
+        const size_t nc = numComponents;
+        const T& temperature = cell[2 * nc];
+
+        pressure = cell[0] * Pascal;
+        total = pressure / (GasConstant * temperature);
+        T last = 1.0;
+        for (size_t i = 0; i + 1 < nc; ++i) {
+            c[i] = total * cell[1 + i];
+            last -= cell[1 + i];
+        }
+        c[nc - 1] = total * last;
+
+        T mass = 0.0, cp = 0.0;
+        for (size_t i = 0; i < nc; ++i) {
+            mass += c[i] * molarMass[i];
+            cp += c[i] * MolarHeatCapacity(temperature, i);
+        }
+        density = mass;
+        heatCapacity = cp / total;
+    }
+
+    template <typename T>
+    void ColumnModel::EndFlux(const ColumnBoundary& boundary, double time, double startPressure, bool isInlet, const T* c, const T& pressure,
+        const T& density, const T& temperature, T* flux, T& heat) const
+    {
+        const size_t nc = numComponents;
+        for (size_t i = 0; i < nc; ++i) flux[i] = 0.0;
+        heat = 0.0;
+
+        const double sign = isInlet ? 1.0 : -1.0;
+        if (boundary.type == ColumnBoundary::Type::Stream) {
+            // Recorded inflow, every component enters at the stream temperature
+            double streamTemperature = 0.0;
+            SampleStream(boundary.stream, time, flux, streamTemperature);
+            for (size_t i = 0; i < nc; ++i) {
+                heat += flux[i] * MolarHeatCapacity(T(streamTemperature), i) * (streamTemperature - temperature);
+                flux[i] *= sign;
+            }
+            return;
+        }
+
+        const double boundaryPressure = BoundaryPressure(boundary, startPressure, time);
+        T velocity = 0.0;
+        if (boundary.type == ColumnBoundary::Type::Flow) {
+            velocity = boundary.velocity;
+        }
+        else if (boundary.type == ColumnBoundary::Type::Pressure) {
+            T drop = isInlet ? boundaryPressure - pressure : pressure - boundaryPressure;
+            velocity = ErgunVelocity(drop / (0.5 * dz), density);
+        }
+        else {
+            return;
+        }
+
+        if (ValueOf(velocity) * sign > 0.0) {
+            T boundaryTotal = (boundary.type == ColumnBoundary::Type::Pressure ? T(boundaryPressure) : pressure) / (GasConstant * boundary.temperature);
+            T cp = 0.0;
+            for (size_t i = 0; i < nc; ++i) {
+                flux[i] = velocity * boundaryTotal * boundary.moleFraction[i];
+                cp += boundary.moleFraction[i] * MolarHeatCapacity(T(boundary.temperature), i);
+            }
+            heat = sign * velocity * boundaryTotal * cp * (boundary.temperature - temperature);
+        }
+        else {
+            for (size_t i = 0; i < nc; ++i) flux[i] = velocity * c[i];
+        }
+    }
+
+    template <typename T>
+    void ColumnModel::Derivatives(double time, const T* y, T* dydt, IsothermBatch& batch) const
+    {
+        const size_t nc = numComponents;
+        const size_t m = blockSize;
+        const size_t n = numCells;
+
+        // Cell concentrations [mol/m3], pressure [Pa], mass density and molar heat capacity
+        std::vector<T> concentration(n * nc), total(n), pressure(n), density(n), heatCapacity(n);
+        for (size_t k = 0; k < n; ++k) {
+            CellGas(y + k * m, &concentration[k * nc], total[k], pressure[k], density[k], heatCapacity[k]);
+        }
+
+        // Net molar inflow of each component [mol/m3/s] and of heat [W/m3] from the face fluxes.
+        // Convection is upwind, dispersion and conduction are central and vanish at the ends.
+        std::vector<T> inflow(n * nc, T(0.0)), heatInflow(n, T(0.0));
+
+        std::vector<T> endFlux(nc);
+        T endHeat = 0.0;
+        EndFlux(inlet, time, inletStartPressure, true, &concentration[0], pressure[0], density[0],
+            y[2 * nc], endFlux.data(), endHeat);
+        for (size_t i = 0; i < nc; ++i) inflow[i] += endFlux[i] / dz;
+        heatInflow[0] += endHeat / dz;
+
+        const size_t last = n - 1;
+        EndFlux(outlet, time, outletStartPressure, false, &concentration[last * nc], pressure[last], density[last],
+            y[last * m + 2 * nc], endFlux.data(), endHeat);
+        for (size_t i = 0; i < nc; ++i) inflow[last * nc + i] -= endFlux[i] / dz;
+        heatInflow[last] += endHeat / dz;
+
+        for (size_t k = 1; k < n; ++k) {
+            const T* left = &concentration[(k - 1) * nc];
+            const T* right = &concentration[k * nc];
+
+            T velocity = ErgunVelocity((pressure[k - 1] - pressure[k]) / dz, 0.5 * (density[k - 1] + density[k]));
+            const bool forward = ValueOf(velocity) >= 0.0;
+            const T* upwind = forward ? left : right;
+            T faceTotal = 0.5 * (total[k - 1] + total[k]);
+
+            for (size_t i = 0; i < nc; ++i) {
+                T gradient = (right[i] / total[k] - left[i] / total[k - 1]) / dz;
+                T flux = velocity * upwind[i] - voidage * dispersion * faceTotal * gradient;
+                inflow[(k - 1) * nc + i] -= flux / dz;
+                inflow[k * nc + i] += flux / dz;
+            }
+
+            // Energy carried into the downstream cell, in advective form
+            const T& leftT = y[(k - 1) * m + 2 * nc];
+            const T& rightT = y[k * m + 2 * nc];
+            if (forward)
+                heatInflow[k] += velocity * total[k - 1] * heatCapacity[k - 1] * (leftT - rightT) / dz;
+            else
+                heatInflow[k - 1] -= velocity * total[k] * heatCapacity[k] * (rightT - leftT) / dz;
+
+            T conduction = conductivity * (rightT - leftT) / (dz * dz);
+            heatInflow[k - 1] += conduction;
+            heatInflow[k] -= conduction;
+        }
+
+        // Uptake, heat release and accumulation in each cell
+        PrepareEquilibrium(y, batch);
+        std::vector<T> partialPressure(nc), accumulation(nc);
+        for (size_t k = 0; k < n; ++k) {
+            const T* cell = y + k * m;
+            const T* q = cell + nc;
+            const T* c = &concentration[k * nc];
+            const T& temperature = cell[2 * nc];
+            T* out = dydt + k * m;
+
+            for (size_t i = 0; i < nc; ++i) partialPressure[i] = c[i] * (GasConstant * temperature / Pascal);
+
+            T heat = 0.0, totalAccumulation = 0.0;
+            for (size_t i = 0; i < nc; ++i) {
+                T uptake = massTransfer[i] * (Equilibrium(batch, i, k, partialPressure.data(), temperature) - q[i]);
+                out[nc + i] = uptake;
+                heat += heatOfAdsorption[i] * uptake;
+
+                // Gas phase accumulation, dc/dt
+                accumulation[i] = (inflow[k * nc + i] - bulkDensity * uptake) / voidage;
+                totalAccumulation += accumulation[i];
+            }
+
+            T capacity = voidage * total[k] * heatCapacity[k] + bulkDensity * solidHeatCapacity;
+            T dTdt = (heatInflow[k] + bulkDensity * heat - wallLoss * (temperature - ambientTemperature)) / capacity;
+            out[2 * nc] = dTdt;
+
+            // P = C R T and y = c / C
+            out[0] = GasConstant * (temperature * totalAccumulation + total[k] * dTdt) / Pascal;
+            for (size_t i = 0; i + 1 < nc; ++i) {
+                out[1 + i] = (accumulation[i] - cell[1 + i] * totalAccumulation) / total[k];
+            }
+        }
+    }
+
+    // Exact Jacobian blocks. Cells three apart do not share a face, so seeding one variable in
+    // every third cell gives the columns of all of them in a single Dual evaluation.
+    void ColumnModel::Jacobian(double time, const std::vector<double>& y, BlockTridiagonal& jacobian, std::vector<Dual>& values,
+        std::vector<Dual>& derivatives, IsothermBatch& batch) const
+    {
+        const size_t m = blockSize;
+        const size_t n = numCells;
+        values.resize(y.size());
+        derivatives.resize(y.size());
+
+        FillIsothermBatch(y.data(), batch);
+        isotherm.Evaluate(batch, true);
+
+        for (size_t colour = 0; colour < 3; ++colour) {
+            for (size_t v = 0; v < m; ++v) {
+                for (size_t j = 0; j < y.size(); ++j) values[j] = Dual(y[j]);
+                for (size_t k = colour; k < n; k += 3) values[k * m + v].derivative = 1.0;
+
+                Derivatives(time, values.data(), derivatives.data(), batch);
+
+                for (size_t k = 0; k < n; ++k) {
+                    double* block = nullptr;
+                    if (k % 3 == colour) block = jacobian.Diagonal(k);
+                    else if (k > 0 && (k - 1) % 3 == colour) block = jacobian.Lower(k);
+                    else if (k + 1 < n && (k + 1) % 3 == colour) block = jacobian.Upper(k);
+                    if (!block) continue;
+
+                    for (size_t r = 0; r < m; ++r) block[r * m + v] = derivatives[k * m + r].derivative;
+                }
+            }
+        }
+    }
+
+    void ColumnModel::EndFluxes(double time, const double* y, double* inletFlux, double* outletFlux) const
+    {
+        const size_t nc = numComponents;
+        std::vector<double> c(nc);
+        double total = 0.0, pressure = 0.0, density = 0.0, heatCapacity = 0.0, heat = 0.0;
+
+        CellGas(y, c.data(), total, pressure, density, heatCapacity);
+        EndFlux(inlet, time, inletStartPressure, true, c.data(), pressure, density, y[2 * nc], inletFlux, heat);
+
+        const double* cell = y + (numCells - 1) * blockSize;
+        CellGas(cell, c.data(), total, pressure, density, heatCapacity);
+        EndFlux(outlet, time, outletStartPressure, false, c.data(), pressure, density, cell[2 * nc], outletFlux, heat);
+    }
+
+    double WeightedNorm(const std::vector<double>& x, const std::vector<double>& weight)
+    {
+        double sum = 0.0;
+        for (size_t j = 0; j < x.size(); ++j) {
+            double scaled = x[j] / weight[j];
+            sum += scaled * scaled;
+        }
+        return std::sqrt(sum / x.size());
+    }
+}
+
+ColumnBoundary ColumnBoundary::Flow(double velocity, double temperature, const std::vector<double>& moleFraction)
+{
+    ColumnBoundary boundary;
+    boundary.type = Type::Flow;
+    boundary.velocity = velocity;
+    boundary.temperature = temperature;
+    boundary.moleFraction = moleFraction;
+    return boundary;
+}
+
+ColumnBoundary ColumnBoundary::Stream(const std::vector<ColumnStreamSample>& stream)
+{
+    ColumnBoundary boundary;
+    boundary.type = Type::Stream;
+    boundary.stream = stream;
+    return boundary;
+}
+
+ColumnBoundary ColumnBoundary::Pressure(double pressure, double temperature, const std::vector<double>& moleFraction, double rampTime)
+{
+    ColumnBoundary boundary;
+    boundary.type = Type::Pressure;
+    boundary.pressure = pressure;
+    boundary.rampTime = rampTime;
+    boundary.temperature = temperature;
+    boundary.moleFraction = moleFraction;
+    return boundary;
+}
+
+AdsorptionColumn::AdsorptionColumn()
+{
+    // CO2 capture from flue gas on zeolite 13X
+    AdsorbateProperties carbonDioxide;
+    carbonDioxide.component = "Carbon Dioxide";
+    carbonDioxide.saturationLoading = 5.0;
+    carbonDioxide.affinity = 7.4e-6;
+    carbonDioxide.heatOfAdsorption = 35000.0;
+    carbonDioxide.massTransferCoefficient = 0.1;
+
+    AdsorbateProperties nitrogen;
+    nitrogen.component = "Nitrogen";
+    nitrogen.saturationLoading = 3.0;
+    nitrogen.affinity = 1.9e-4;
+    nitrogen.heatOfAdsorption = 15000.0;
+    nitrogen.massTransferCoefficient = 0.5;
+
+    adsorbates = { carbonDioxide, nitrogen };
+    feedMoleFraction = { 0.15, 0.85 };
+    initialMoleFraction = { 0.0, 1.0 };
+}
+
+bool AdsorptionColumn::Validate(std::string& message) const
+{
+    const size_t nc = adsorbates.size();
+    if (nc == 0) {
+        message = "The column has no components";
+        return false;
+    }
+    for (const auto& adsorbate : adsorbates) {
+        if (!FindComponent(adsorbate.component)) {
+            message = "Unknown component: " + adsorbate.component;
+            return false;
+        }
+        if (adsorbate.saturationLoading < 0.0 || adsorbate.affinity < 0.0 || adsorbate.massTransferCoefficient <= 0.0 ||
+            adsorbate.saturationLoading2 < 0.0 || adsorbate.affinity2 < 0.0 || adsorbate.heterogeneity <= 0.0) {
+            message = "Invalid isotherm or mass transfer coefficient for " + adsorbate.component;
+            return false;
+        }
+    }
+    if (column.length <= 0.0 || column.diameter <= 0.0 || column.particleDiameter <= 0.0 ||
+        column.bedVoidage <= 0.0 || column.bedVoidage >= 1.0 || column.bulkDensity < 0.0 || column.gasViscosity <= 0.0) {
+        message = "Invalid column geometry or packing";
+        return false;
+    }
+    if (integrator.numCells < 3) {
+        message = "The column needs at least 3 cells";
+        return false;
+    }
+    for (const auto* fractions : { &feedMoleFraction, &initialMoleFraction }) {
+        double sum = 0.0;
+        for (double x : *fractions) sum += x;
+        if (fractions->size() != nc || std::fabs(sum - 1.0) > 1e-6) {
+            message = "Mole fractions must be given for every component and sum to one";
+            return false;
+        }
+    }
+    if (outletPressure <= 0.0 || feedTemperature <= 0.0) {
+        message = "Invalid feed conditions";
+        return false;
+    }
+    return true;
+}
+
+std::vector<double> AdsorptionColumn::GetEquilibriumState(const std::vector<double>& moleFraction, double pressure, double temperature) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t m = GetBlockSize();
+    std::vector<double> block(m);
+
+    std::vector<double> partialPressure(nc);
+    for (size_t i = 0; i < nc; ++i) partialPressure[i] = moleFraction[i] * pressure;
+    std::vector<double> loading = Isotherm(isotherm, adsorbates).GetLoading(partialPressure, temperature);
+
+    block[0] = pressure;
+    for (size_t i = 0; i + 1 < nc; ++i) block[1 + i] = moleFraction[i];
+    for (size_t i = 0; i < nc; ++i) block[nc + i] = loading[i];
+    block[2 * nc] = temperature;
+
+    std::vector<double> state;
+    state.reserve(m * integrator.numCells);
+    for (int k = 0; k < integrator.numCells; ++k) state.insert(state.end(), block.begin(), block.end());
+    return state;
+}
+
+ColumnProfile AdsorptionColumn::GetProfile(const std::vector<double>& state) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t m = GetBlockSize();
+    const size_t n = state.size() / m;
+    const double dz = column.length / n;
+
+    ColumnProfile profile;
+    profile.moleFraction.assign(nc, std::vector<double>(n));
+    profile.loading.assign(nc, std::vector<double>(n));
+    for (size_t k = 0; k < n; ++k) {
+        const double* cell = &state[k * m];
+        profile.position.push_back((k + 0.5) * dz);
+        profile.pressure.push_back(cell[0]);
+        profile.temperature.push_back(cell[2 * nc]);
+
+        double last = 1.0;
+        for (size_t i = 0; i + 1 < nc; ++i) {
+            profile.moleFraction[i][k] = cell[1 + i];
+            last -= cell[1 + i];
+        }
+        profile.moleFraction[nc - 1][k] = last;
+        for (size_t i = 0; i < nc; ++i) profile.loading[i][k] = cell[nc + i];
+    }
+    return profile;
+}
+
+std::vector<double> AdsorptionColumn::GetInventory(const std::vector<double>& state) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t m = GetBlockSize();
+    const size_t n = state.size() / m;
+    const double dz = column.length / n;
+
+    std::vector<double> inventory(nc, 0.0);
+    for (size_t k = 0; k < n; ++k) {
+        const double* cell = &state[k * m];
+        const double total = cell[0] * Pascal / (GasConstant * cell[2 * nc]);
+
+        double last = 1.0;
+        for (size_t i = 0; i < nc; ++i) {
+            double fraction = i + 1 < nc ? cell[1 + i] : last;
+            if (i + 1 < nc) last -= cell[1 + i];
+            inventory[i] += (column.bedVoidage * total * fraction + column.bulkDensity * cell[nc + i]) * dz;
+        }
+    }
+    return inventory;
+}
+
+bool AdsorptionColumn::Integrate(std::vector<double>& state, double duration, const ColumnBoundary& inlet, const ColumnBoundary& outlet,
+    ColumnStatistics& statistics, std::string& message, const StepObserver& observer, ColumnFlows* flows) const
+{
+    auto startTime = std::chrono::steady_clock::now();
+    ColumnModel model(*this, inlet, outlet);
+    const size_t m = model.blockSize;
+    const size_t n = model.numCells;
+    const size_t size = state.size();
+    const size_t nc = model.numComponents;
+
+    if (size != n * m) {
+        message = "State does not match the column discretisation";
+        return false;
+    }
+    for (const ColumnBoundary* boundary : { &inlet, &outlet }) {
+        bool valid = boundary->type != ColumnBoundary::Type::Stream || !boundary->stream.empty();
+        for (const auto& sample : boundary->stream) valid = valid && sample.flux.size() == nc;
+        if (!valid) {
+            message = "A stream boundary needs samples with a flux for every component";
+            return false;
+        }
+    }
+    model.inletStartPressure = state[0] * Pascal;
+    model.outletStartPressure = state[size - m] * Pascal;
+
+    // End fluxes at the last accepted point, integrated with the trapezoidal rule
+    std::vector<double> inletFlux(nc), outletFlux(nc), nextInletFlux(nc), nextOutletFlux(nc);
+    // Appends the end streams at time to flows
+    auto recordStreams = [&](double time) {
+        flows->inletStream.push_back({ time, state[2 * nc], inletFlux });
+        flows->outletStream.push_back({ time, state[size - m + 2 * nc], outletFlux });
+    };
+
+    if (flows) {
+        if (flows->inlet.size() != nc) flows->inlet.assign(nc, 0.0);
+        if (flows->outlet.size() != nc) flows->outlet.assign(nc, 0.0);
+        model.EndFluxes(0.0, state.data(), inletFlux.data(), outletFlux.data());
+        if (flows->record) recordStreams(0.0);
+    }
+
+    // Absolute tolerances scaled by the mole fractions, the capacity and the temperature. The
+    // velocities follow from pressure differences of a few pascal between cells, so the pressure
+    // is held to a much tighter relative tolerance than the rest of the state.
+    std::vector<double> relative(m, integrator.relativeTolerance), absolute(m, integrator.absoluteTolerance);
+    relative[0] *= PressureToleranceFactor;
+    absolute[0] = 0.0;
+    for (size_t i = 0; i < nc; ++i) absolute[nc + i] *= std::max(adsorbates[i].GetCapacity(), 1e-3);
+    absolute[2 * nc] *= model.ambientTemperature;
+
+    BlockTridiagonal jacobian, iteration;
+    jacobian.Resize(n, m);
+    iteration.Resize(n, m);
+    std::vector<Dual> dualValues, dualDerivatives;
+    IsothermBatch isothermBatch;
+    isothermBatch.Resize(n, nc);
+
+    // History: y_n, y_n-1, y_n-2 and the steps between them
+    std::vector<double> previous(size), older(size);
+    double previousStep = 0.0, olderStep = 0.0;
+    int numHistory = 0;
+
+    std::vector<double> weight(size), predicted(size), corrected(size), psi(size), f(size), delta(size);
+
+    double time = 0.0;
+    double step = std::min(integrator.initialStep, duration);
+    double factoredGamma = 0.0;
+    bool jacobianCurrent = false;
+    bool haveJacobian = false;
+    int stepsSinceJacobian = 0;
+    const int firstStep = statistics.numSteps;     // statistics may carry counts from earlier calls
+
+    while (time < duration * (1.0 - 1e-12)) {
+        if (statistics.numSteps - firstStep >= integrator.maxSteps) {
+            message = "Too many steps";
+            return false;
+        }
+
+        step = std::min(step, duration - time);
+        for (size_t j = 0; j < size; ++j) weight[j] = relative[j % m] * std::fabs(state[j]) + absolute[j % m];
+
+        // BDF coefficients and predictor for this step
+        const int order = numHistory >= 2 ? 2 : 1;
+        double a1 = 1.0, a2 = 0.0, beta = 1.0, errorConstant = 0.0;
+        if (order == 1) {
+            // Backward Euler, predictor extrapolates the last step
+            double slope = numHistory >= 1 ? step / previousStep : 0.0;
+            for (size_t j = 0; j < size; ++j) predicted[j] = state[j] + slope * (state[j] - previous[j]);
+            errorConstant = numHistory >= 1 ? step / (2.0 * step + previousStep) : 1.0;
+        }
+        else {
+            const double w = step / previousStep;
+            a1 = (1.0 + w) * (1.0 + w) / (1.0 + 2.0 * w);
+            a2 = -w * w / (1.0 + 2.0 * w);
+            beta = (1.0 + w) / (1.0 + 2.0 * w);
+
+            // Quadratic through the last three points
+            const double h = step, h1 = previousStep, h2 = olderStep;
+            const double l0 = (h + h1) * (h + h1 + h2) / (h1 * (h1 + h2));
+            const double l1 = -h * (h + h1 + h2) / (h1 * h2);
+            const double l2 = h * (h + h1) / ((h1 + h2) * h2);
+            for (size_t j = 0; j < size; ++j) predicted[j] = l0 * state[j] + l1 * previous[j] + l2 * older[j];
+
+            // Milne's estimate from the truncation errors of the corrector and the predictor
+            const double corrector = (a1 * h * h * h + a2 * (h + h1) * (h + h1) * (h + h1)) / 6.0;
+            const double predictor = h * (h + h1) * (h + h1 + h2) / 6.0;
+            errorConstant = std::fabs(corrector) / std::fabs(predictor - corrector);
+        }
+        for (size_t j = 0; j < size; ++j) psi[j] = a1 * state[j] + a2 * previous[j];
+        const double gamma = beta * step;
+
+        // Modified Newton on y - psi - gamma f(y) = 0
+        bool converged = false;
+        for (int attempt = 0; attempt < 2 && !converged; ++attempt) {
+            if (!haveJacobian || (attempt > 0 && !jacobianCurrent)) {
+                model.Jacobian(time, state, jacobian, dualValues, dualDerivatives, isothermBatch);
+                ++statistics.numJacobians;
+                haveJacobian = true;
+                jacobianCurrent = true;
+                stepsSinceJacobian = 0;
+                factoredGamma = 0.0;
+            }
+            if (factoredGamma == 0.0 || std::fabs(gamma / factoredGamma - 1.0) > 0.3) {
+                for (size_t k = 0; k < n; ++k) {
+                    for (size_t e = 0; e < m * m; ++e) {
+                        iteration.Lower(k)[e] = -gamma * jacobian.Lower(k)[e];
+                        iteration.Diagonal(k)[e] = -gamma * jacobian.Diagonal(k)[e];
+                        iteration.Upper(k)[e] = -gamma * jacobian.Upper(k)[e];
+                    }
+                    for (size_t r = 0; r < m; ++r) iteration.Diagonal(k)[r * m + r] += 1.0;
+                }
+                ++statistics.numFactorizations;
+                if (!iteration.Factorize()) {
+                    factoredGamma = 0.0;
+                    break;
+                }
+                factoredGamma = gamma;
+            }
+
+            // Scaling the update corrects for gamma having moved since the factorization
+            const double correction = 2.0 / (1.0 + gamma / factoredGamma);
+            corrected = predicted;
+            double previousNorm = 0.0, rate = 1.0;
+            for (int iter = 0; iter < 4; ++iter) {
+                model.Derivatives(time + step, corrected.data(), f.data(), isothermBatch);
+                ++statistics.numNewtonIterations;
+                for (size_t j = 0; j < size; ++j) delta[j] = psi[j] + gamma * f[j] - corrected[j];
+                iteration.Solve(delta.data());
+
+                double norm = 0.0;
+                for (size_t j = 0; j < size; ++j) {
+                    delta[j] *= correction;
+                    corrected[j] += delta[j];
+                }
+                norm = WeightedNorm(delta, weight);
+                if (!std::isfinite(norm)) break;
+
+                if (iter > 0) {
+                    rate = norm / previousNorm;
+                    if (rate > 0.9) break;
+                }
+                if (norm * std::min(1.0, rate / (1.0 - std::min(rate, 0.5))) < 0.1 || norm < 1e-3) {
+                    converged = true;
+                    break;
+                }
+                previousNorm = norm;
+            }
+
+            if (!converged && jacobianCurrent) break;
+        }
+
+        if (!converged) {
+            ++statistics.numRejectedSteps;
+            step *= 0.25;
+            if (step < 1e-10 * std::max(duration, 1.0)) {
+                message = "Newton iteration failed at t = " + std::to_string(time) + " s";
+                return false;
+            }
+            continue;
+        }
+
+        // Local error test
+        for (size_t j = 0; j < size; ++j) delta[j] = errorConstant * (corrected[j] - predicted[j]);
+        const double error = WeightedNorm(delta, weight);
+        const double exponent = -1.0 / (order + 1);
+
+        if (error > 1.0) {
+            ++statistics.numRejectedSteps;
+            step *= std::max(0.2, 0.9 * std::pow(error, exponent));
+            continue;
+        }
+
+        // Accept
+        older.swap(previous);
+        previous.swap(state);
+        state.swap(corrected);
+        olderStep = previousStep;
+        previousStep = step;
+        numHistory = std::min(numHistory + 1, 2);
+        time += step;
+        ++statistics.numSteps;
+        jacobianCurrent = false;
+
+        // Rebuild the Jacobian now and then, the front moves through the bed
+        if (++stepsSinceJacobian >= 20) haveJacobian = false;
+
+        if (flows) {
+            model.EndFluxes(time, state.data(), nextInletFlux.data(), nextOutletFlux.data());
+            for (size_t i = 0; i < nc; ++i) {
+                flows->inlet[i] += 0.5 * step * (inletFlux[i] + nextInletFlux[i]);
+                flows->outlet[i] += 0.5 * step * (outletFlux[i] + nextOutletFlux[i]);
+            }
+            inletFlux.swap(nextInletFlux);
+            outletFlux.swap(nextOutletFlux);
+            if (flows->record) recordStreams(time);
+        }
+
+        step = std::min(integrator.maxStep, step * std::min(4.0, std::max(0.2, 0.9 * std::pow(std::max(error, 1e-10), exponent))));
+
+        if (observer && !observer(time, state)) break;
+    }
+
+    statistics.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+BreakthroughResult AdsorptionColumn::RunBreakthrough(const BreakthroughObserver& observer) const
+{
+    BreakthroughResult result;
+    if (!Validate(result.message)) return result;
+
+    const size_t nc = GetNumComponents();
+    const size_t m = GetBlockSize();
+    result.outletMoleFraction.resize(nc);
+
+    auto record = [&](double time, const std::vector<double>& state) {
+        const double* last = &state[state.size() - m];
+        double remainder = 1.0;
+        result.time.push_back(time);
+        for (size_t i = 0; i + 1 < nc; ++i) {
+            result.outletMoleFraction[i].push_back(last[1 + i]);
+            remainder -= last[1 + i];
+        }
+        result.outletMoleFraction[nc - 1].push_back(remainder);
+        result.outletTemperature.push_back(last[2 * nc]);
+        result.pressureDrop.push_back(state[0] - outletPressure);
+        return !observer || observer(result);
+    };
+
+    std::vector<double> state = GetEquilibriumState(initialMoleFraction, outletPressure, feedTemperature);
+    record(0.0, state);
+
+    ColumnBoundary inlet = ColumnBoundary::Flow(feedVelocity, feedTemperature, feedMoleFraction);
+    ColumnBoundary outlet = ColumnBoundary::Pressure(outletPressure, feedTemperature, initialMoleFraction);
+
+    std::string message;
+    if (!Integrate(state, duration, inlet, outlet, result.statistics, message, record)) {
+        result.message = message;
+        result.finalProfile = GetProfile(state);
+        return result;
+    }
+
+    result.finalProfile = GetProfile(state);
+    result.completed = result.time.back() >= duration * (1.0 - 1e-9);
+    result.message = result.completed ? "Breakthrough complete" : "Stopped";
+    return result;
+}
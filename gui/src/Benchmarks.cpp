@@ -0,0 +1,997 @@
+#include "Benchmarks.h"
+#include "UnitOperations.h"
+#include "CubicEOS.h"
+#include "PropertyTable.h"
+#include "AdsorptionColumn.h"
+#include "PsaCycle.h"
+#include "Isotherm.h"
+#include "MultiBedPsa.h"
+#include "Decimation.h"
+#include "SeriesStream.h"
+#include "ResultFile.h"
+#include "FlowsheetIO.h"
+#include "SpatialGrid.h"
+#include "UndoJournal.h"
+
+// JSON Includes
+#include "nlohmann/json.hpp"
+
+// STL Includes
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <cstdlib>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double ElapsedNanoseconds(Clock::time_point start, int evaluations)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / evaluations;
+    }
+
+    // Dense Jacobian (equations x locals) by forward differences
+    void FiniteDifferenceJacobian(const Node& node, std::vector<double>& x, std::vector<double>& jacobian,
+        std::vector<double>& base, std::vector<double>& perturbed)
+    {
+        const int m = node.GetNumEquations();
+        const int n = static_cast<int>(x.size());
+
+        node.EvaluateResiduals(x.data(), base.data());
+        for (int j = 0; j < n; ++j) {
+            double saved = x[j];
+            double h = 1e-7 * std::max(1.0, std::fabs(saved));
+            x[j] = saved + h;
+            node.EvaluateResiduals(x.data(), perturbed.data());
+            x[j] = saved;
+
+            for (int i = 0; i < m; ++i) {
+                jacobian[i * n + j] = (perturbed[i] - base[i]) / h;
+            }
+        }
+    }
+
+    // Dense Jacobian (equations x locals) by forward-mode AD
+    void DualJacobian(const Node& node, std::vector<Dual>& values, std::vector<double>& jacobian, std::vector<Dual>& residuals)
+    {
+        const int m = node.GetNumEquations();
+        const int n = static_cast<int>(values.size());
+
+        for (int j = 0; j < n; ++j) {
+            values[j].derivative = 1.0;
+            node.EvaluateResiduals(values.data(), residuals.data());
+            values[j].derivative = 0.0;
+
+            for (int i = 0; i < m; ++i) {
+                jacobian[i * n + j] = residuals[i].derivative;
+            }
+        }
+    }
+
+    void BenchmarkNode(Node& node, int evaluations, std::ostringstream& out)
+    {
+        std::vector<double*> locals;
+        node.GetEquationVariables(locals);
+
+        std::vector<double> x(locals.size());
+        for (size_t j = 0; j < locals.size(); ++j) x[j] = *locals[j];
+
+        const size_t size = node.GetNumEquations() * x.size();
+        std::vector<double> fd(size), ad(size);
+        std::vector<double> base(node.GetNumEquations()), perturbed(node.GetNumEquations());
+        std::vector<Dual> values(x.begin(), x.end()), residuals(node.GetNumEquations());
+
+        auto start = Clock::now();
+        for (int e = 0; e < evaluations; ++e) FiniteDifferenceJacobian(node, x, fd, base, perturbed);
+        double fdTime = ElapsedNanoseconds(start, evaluations);
+
+        start = Clock::now();
+        for (int e = 0; e < evaluations; ++e) DualJacobian(node, values, ad, residuals);
+        double adTime = ElapsedNanoseconds(start, evaluations);
+
+        double maxError = 0.0;
+        for (size_t k = 0; k < size; ++k) {
+            maxError = std::max(maxError, std::fabs(fd[k] - ad[k]) / std::max(1.0, std::fabs(ad[k])));
+        }
+
+        out << std::left << std::setw(8) << node.type
+            << std::right << std::setw(10) << std::fixed << std::setprecision(1) << fdTime
+            << std::setw(10) << adTime
+            << std::setw(10) << std::setprecision(2) << fdTime / adTime
+            << std::setw(14) << std::scientific << std::setprecision(2) << maxError << "\n";
+    }
+}
+
+std::string RunJacobianBenchmark(int evaluations)
+{
+    std::ostringstream out;
+    out << "Unit Jacobian, " << evaluations << " evaluations per model\n";
+    out << std::left << std::setw(8) << "Model"
+        << std::right << std::setw(10) << "FD [ns]" << std::setw(10) << "AD [ns]"
+        << std::setw(10) << "Speedup" << std::setw(14) << "FD error" << "\n";
+
+    Valve valve("Valve", Vec2(0, 0));
+    valve.inputs[0].stream = { 10.0, 320.0, 0.8 };
+    valve.Calculate();
+    BenchmarkNode(valve, evaluations, out);
+
+    Inlet inlet("Inlet", Vec2(0, 0));
+    inlet.Calculate();
+    BenchmarkNode(inlet, evaluations, out);
+
+    return out.str();
+}
+
+std::string RunPropertyBenchmark(int states)
+{
+    const std::vector<Component> components = {
+        *FindComponent("Nitrogen"), *FindComponent("Oxygen"), *FindComponent("Carbon Dioxide"), *FindComponent("Water")
+    };
+    const size_t nc = components.size();
+
+    // Humid flue gas like states
+    PropertyBatch batch;
+    batch.Resize(states, nc);
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int k = 0; k < states; ++k) {
+        batch.temperature[k] = 280.0 + 120.0 * uniform(generator);
+        batch.pressure[k] = 1.0 + 30.0 * uniform(generator);
+        double fractions[] = { 0.70 + 0.1 * uniform(generator), 0.05, 0.10 + 0.1 * uniform(generator), 0.01 };
+        double sum = fractions[0] + fractions[1] + fractions[2] + fractions[3];
+        for (size_t i = 0; i < nc; ++i) batch.moleFraction[i][k] = fractions[i] / sum;
+    }
+
+    PropertyBatch single;
+    single.Resize(1, nc);
+
+    std::ostringstream out;
+    out << "Cubic EOS, " << states << " states of " << nc << " components\n";
+    out << std::left << std::setw(20) << "Model"
+        << std::right << std::setw(14) << "Single [ns]" << std::setw(14) << "Batch [ns]" << std::setw(10) << "Speedup" << "\n";
+
+    for (CubicModel model : { CubicModel::PengRobinson, CubicModel::SoaveRedlichKwong }) {
+        CubicEOS eos(model, components);
+
+        auto start = Clock::now();
+        double checksum = 0.0;
+        for (int k = 0; k < states; ++k) {
+            single.temperature[0] = batch.temperature[k];
+            single.pressure[0] = batch.pressure[k];
+            for (size_t i = 0; i < nc; ++i) single.moleFraction[i][0] = batch.moleFraction[i][k];
+            eos.Evaluate(single);
+            checksum += single.density[0];
+        }
+        double singleTime = ElapsedNanoseconds(start, states);
+
+        start = Clock::now();
+        eos.Evaluate(batch);
+        double batchTime = ElapsedNanoseconds(start, states);
+
+        for (int k = 0; k < states; ++k) checksum -= batch.density[k];
+
+        out << std::left << std::setw(20) << (model == CubicModel::PengRobinson ? "Peng-Robinson" : "SRK")
+            << std::right << std::setw(14) << std::fixed << std::setprecision(1) << singleTime
+            << std::setw(14) << batchTime
+            << std::setw(10) << std::setprecision(2) << singleTime / batchTime
+            << (std::fabs(checksum) > 1e-6 * states ? "  (mismatch)" : "") << "\n";
+    }
+
+    // Tabulated look-up for a single composition, first pass builds the table
+    const std::vector<double> composition = { 0.76, 0.05, 0.18, 0.01 };
+    for (int k = 0; k < states; ++k) {
+        for (size_t i = 0; i < nc; ++i) batch.moleFraction[i][k] = composition[i];
+    }
+
+    CubicEOS eos(CubicModel::PengRobinson, components);
+    eos.Evaluate(batch);
+    const std::vector<double> exact = batch.density;
+
+    PropertyTable table(eos, composition, PropertyTableSettings());
+    auto start = Clock::now();
+    table.Evaluate(batch);
+    double coldTime = ElapsedNanoseconds(start, states);
+
+    start = Clock::now();
+    table.Evaluate(batch);
+    double warmTime = ElapsedNanoseconds(start, states);
+
+    double maxError = 0.0;
+    for (int k = 0; k < states; ++k) {
+        maxError = std::max(maxError, std::fabs(batch.density[k] - exact[k]) / exact[k]);
+    }
+
+    out << "\nPeng-Robinson table, " << table.GetNumLeaves() << " cells, "
+        << table.GetNumEquationOfStateCalls() << " EOS states to build\n"
+        << "  First pass " << std::setprecision(1) << coldTime << " ns/state, warm look-up "
+        << warmTime << " ns/state, max density error " << std::scientific << std::setprecision(2) << maxError << "\n";
+
+    return out.str();
+}
+
+std::string RunIsothermBenchmark(int states)
+{
+    // CO2, N2 and H2O on a zeolite, with second sites and exponents for the models that use them
+    std::vector<AdsorbateProperties> adsorbates(3);
+    adsorbates[0] = { "Carbon Dioxide", 3.0, 1.6e-4, 35000.0, 0.1, 1.5, 2.0e-5, 30000.0, 0.8 };
+    adsorbates[1] = { "Nitrogen", 1.5, 2.6e-4, 18000.0, 1.0, 0.5, 1.0e-4, 15000.0, 0.9 };
+    adsorbates[2] = { "Water", 8.0, 4.0e-6, 50000.0, 0.05, 2.0, 1.0e-6, 45000.0, 0.7 };
+    const size_t nc = adsorbates.size();
+
+    IsothermBatch batch;
+    batch.Resize(states, nc);
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int k = 0; k < states; ++k) {
+        batch.temperature[k] = 280.0 + 120.0 * uniform(generator);
+        for (size_t i = 0; i < nc; ++i) batch.partialPressure[i][k] = 1e-3 + 2.0 * uniform(generator);
+    }
+
+    std::ostringstream out;
+    out << "Isotherms, " << states << " states of " << nc << " components\n";
+    out << std::left << std::setw(20) << "Model"
+        << std::right << std::setw(14) << "Single [ns]" << std::setw(14) << "Batch [ns]" << std::setw(14) << "Batch+d [ns]"
+        << std::setw(10) << "Speedup" << std::setw(16) << "Derivative err" << "\n";
+
+    for (IsothermModel model : { IsothermModel::Langmuir, IsothermModel::ExtendedLangmuir, IsothermModel::DualSiteLangmuir,
+                                 IsothermModel::Sips, IsothermModel::Toth }) {
+        Isotherm isotherm(model, adsorbates);
+
+        auto start = Clock::now();
+        double checksum = 0.0;
+        std::vector<double> pressure(nc);
+        for (int k = 0; k < states; ++k) {
+            for (size_t i = 0; i < nc; ++i) pressure[i] = batch.partialPressure[i][k];
+            checksum += isotherm.GetLoading(pressure, batch.temperature[k])[0];
+        }
+        double singleTime = ElapsedNanoseconds(start, states);
+
+        start = Clock::now();
+        isotherm.Evaluate(batch, false);
+        double batchTime = ElapsedNanoseconds(start, states);
+
+        start = Clock::now();
+        isotherm.Evaluate(batch, true);
+        double derivativeTime = ElapsedNanoseconds(start, states);
+
+        for (int k = 0; k < states; ++k) checksum -= batch.loading[0][k];
+
+        // Analytic derivatives against central differences on a sample of the states
+        double maxError = 0.0;
+        const int stride = std::max(states / 1000, 1);
+        for (int k = 0; k < states; k += stride) {
+            for (size_t i = 0; i < nc; ++i) pressure[i] = batch.partialPressure[i][k];
+            const double temperature = batch.temperature[k];
+
+            for (size_t j = 0; j <= nc; ++j) {
+                std::vector<double> up = pressure, down = pressure;
+                double upTemperature = temperature, downTemperature = temperature;
+                double h;
+                if (j < nc) {
+                    h = 1e-4 * pressure[j];
+                    up[j] += h;
+                    down[j] -= h;
+                }
+                else {
+                    h = 1e-2;
+                    upTemperature += h;
+                    downTemperature -= h;
+                }
+                std::vector<double> qUp = isotherm.GetLoading(up, upTemperature);
+                std::vector<double> qDown = isotherm.GetLoading(down, downTemperature);
+
+                for (size_t i = 0; i < nc; ++i) {
+                    double numeric = (qUp[i] - qDown[i]) / (2.0 * h);
+                    double analytic = j < nc ? batch.dLoadingdPressure[i * nc + j][k] : batch.dLoadingdTemperature[i][k];
+                    double magnitude = std::max(std::fabs(numeric), 1e-8 * (j < nc ? 1.0 : 1e-2));
+                    maxError = std::max(maxError, std::fabs(analytic - numeric) / magnitude);
+                }
+            }
+        }
+
+        out << std::left << std::setw(20) << Isotherm::GetName(model)
+            << std::right << std::setw(14) << std::fixed << std::setprecision(1) << singleTime
+            << std::setw(14) << batchTime << std::setw(14) << derivativeTime
+            << std::setw(10) << std::setprecision(2) << singleTime / batchTime
+            << std::setw(16) << std::scientific << maxError << std::defaultfloat
+            << (std::fabs(checksum) > 1e-6 * states ? "  (mismatch)" : "") << "\n";
+    }
+
+    return out.str();
+}
+
+std::string RunKernelBenchmark(int states)
+{
+    const std::vector<Component> gases = {
+        *FindComponent("Carbon Dioxide"), *FindComponent("Nitrogen"), *FindComponent("Oxygen"), *FindComponent("Water")
+    };
+    std::vector<AdsorbateProperties> adsorbates(4);
+    adsorbates[0] = { "Carbon Dioxide", 3.0, 1.6e-4, 35000.0, 0.1, 1.5, 2.0e-5, 30000.0, 0.8 };
+    adsorbates[1] = { "Nitrogen", 1.5, 2.6e-4, 18000.0, 1.0, 0.5, 1.0e-4, 15000.0, 0.9 };
+    adsorbates[2] = { "Oxygen", 1.2, 2.0e-4, 17000.0, 1.0, 0.4, 1.0e-4, 14000.0, 1.1 };
+    adsorbates[3] = { "Water", 8.0, 4.0e-6, 50000.0, 0.05, 2.0, 1.0e-6, 45000.0, 0.7 };
+
+    std::ostringstream out;
+    out << "Fixed component count kernels against the runtime kernels, ns per state\n";
+    out << std::left << std::setw(20) << "Model" << std::setw(12) << "Components"
+        << std::right << std::setw(12) << "Runtime" << std::setw(10) << "Fixed" << std::setw(10) << "Speedup"
+        << std::setw(12) << "Runtime" << std::setw(10) << "Fixed" << std::setw(10) << "Speedup" << "\n";
+    out << std::left << std::setw(32) << "" << std::right << std::setw(32) << "50 states (a column)"
+        << std::setw(32) << (std::to_string(states) + " states") << "\n";
+
+    // Time per state of evaluate() on a batch of the given size, repeated to the same total work
+    auto timeBatch = [states](int size, const std::function<void()>& evaluate) {
+        const int repeats = std::max(states / size, 1);
+        auto start = Clock::now();
+        for (int r = 0; r < repeats; ++r) evaluate();
+        return ElapsedNanoseconds(start, repeats * size);
+    };
+
+    auto writeRow = [&out](const char* name, size_t nc, const double* times, bool same) {
+        out << std::left << std::setw(20) << name << std::setw(12) << nc
+            << std::right << std::fixed << std::setprecision(1);
+        for (int size = 0; size < 2; ++size) {
+            out << std::setw(12) << times[2 * size] << std::setw(10) << times[2 * size + 1]
+                << std::setw(10) << std::setprecision(2) << times[2 * size] / times[2 * size + 1] << std::setprecision(1);
+        }
+        out << (same ? "" : "  (mismatch)") << "\n";
+    };
+
+    // Largest difference between the outputs of the two kernels, relative to 1 + |value|
+    double maxDifference = 0.0;
+    auto compare = [&maxDifference](const std::vector<double>& runtime, const std::vector<double>& fixed) {
+        double difference = 0.0;
+        for (size_t k = 0; k < runtime.size(); ++k)
+            difference = std::max(difference, std::fabs(runtime[k] - fixed[k]) / (1.0 + std::fabs(runtime[k])));
+        maxDifference = std::max(maxDifference, difference);
+        return difference;
+    };
+    const double tolerance = 1e-8;
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t nc = 2; nc <= 4; ++nc) {
+        const std::vector<Component> components(gases.begin(), gases.begin() + nc);
+        const std::vector<AdsorbateProperties> adsorbed(adsorbates.begin(), adsorbates.begin() + nc);
+
+        double eosTimes[4];
+        CubicEOS fixedEos(CubicModel::PengRobinson, components), runtimeEos(CubicModel::PengRobinson, components);
+        runtimeEos.SetKernel(ComponentKernel::Runtime);
+
+        double isothermTimes[5][4];
+        const IsothermModel models[] = { IsothermModel::Langmuir, IsothermModel::ExtendedLangmuir, IsothermModel::DualSiteLangmuir,
+                                         IsothermModel::Sips, IsothermModel::Toth };
+
+        // Both kernels have to give the same results before their times mean anything
+        bool eosSame = true;
+        bool isothermSame[5] = { true, true, true, true, true };
+
+        int column = 0;
+        for (int size : { 50, states }) {
+            PropertyBatch properties;
+            properties.Resize(size, nc);
+            IsothermBatch isotherms;
+            isotherms.Resize(size, nc);
+            for (int k = 0; k < size; ++k) {
+                properties.temperature[k] = isotherms.temperature[k] = 280.0 + 120.0 * uniform(generator);
+                properties.pressure[k] = 1.0 + 30.0 * uniform(generator);
+                double sum = 0.0;
+                for (size_t i = 0; i < nc; ++i) sum += properties.moleFraction[i][k] = 0.05 + uniform(generator);
+                for (size_t i = 0; i < nc; ++i) {
+                    properties.moleFraction[i][k] /= sum;
+                    isotherms.partialPressure[i][k] = properties.moleFraction[i][k] * properties.pressure[k];
+                }
+            }
+
+            PropertyBatch fixedProperties = properties;
+            runtimeEos.Evaluate(properties);
+            fixedEos.Evaluate(fixedProperties);
+            double difference = std::max({ compare(properties.compressibility, fixedProperties.compressibility),
+                compare(properties.density, fixedProperties.density), compare(properties.enthalpy, fixedProperties.enthalpy) });
+            for (size_t i = 0; i < nc; ++i)
+                difference = std::max(difference, compare(properties.lnFugacityCoefficient[i], fixedProperties.lnFugacityCoefficient[i]));
+            eosSame = eosSame && difference <= tolerance;
+
+            eosTimes[column] = timeBatch(size, [&]() { runtimeEos.Evaluate(properties); });
+            eosTimes[column + 1] = timeBatch(size, [&]() { fixedEos.Evaluate(properties); });
+
+            for (int m = 0; m < 5; ++m) {
+                Isotherm fixedIsotherm(models[m], adsorbed), runtimeIsotherm(models[m], adsorbed);
+                runtimeIsotherm.SetKernel(ComponentKernel::Runtime);
+
+                IsothermBatch fixedIsotherms = isotherms;
+                runtimeIsotherm.Evaluate(isotherms);
+                fixedIsotherm.Evaluate(fixedIsotherms);
+                double isothermDifference = 0.0;
+                for (size_t i = 0; i < nc; ++i) {
+                    isothermDifference = std::max({ isothermDifference, compare(isotherms.loading[i], fixedIsotherms.loading[i]),
+                        compare(isotherms.dLoadingdTemperature[i], fixedIsotherms.dLoadingdTemperature[i]) });
+                }
+                for (size_t ij = 0; ij < nc * nc; ++ij)
+                    isothermDifference = std::max(isothermDifference, compare(isotherms.dLoadingdPressure[ij], fixedIsotherms.dLoadingdPressure[ij]));
+                isothermSame[m] = isothermSame[m] && isothermDifference <= tolerance;
+
+                isothermTimes[m][column] = timeBatch(size, [&]() { runtimeIsotherm.Evaluate(isotherms); });
+                isothermTimes[m][column + 1] = timeBatch(size, [&]() { fixedIsotherm.Evaluate(isotherms); });
+            }
+            column += 2;
+        }
+
+        writeRow("Peng-Robinson", nc, eosTimes, eosSame);
+        for (int m = 0; m < 5; ++m) writeRow(Isotherm::GetName(models[m]), nc, isothermTimes[m], isothermSame[m]);
+    }
+
+    out << std::scientific << std::setprecision(1)
+        << (maxDifference <= tolerance ? "Both kernels agree, largest difference " : "The kernels disagree, largest difference ")
+        << maxDifference << "\n";
+    return out.str();
+}
+
+std::string RunColumnBenchmark()
+{
+    std::ostringstream out;
+    out << "CO2 / N2 breakthrough on zeolite 13X\n";
+    out << std::left << std::setw(8) << "Cells"
+        << std::right << std::setw(8) << "Steps" << std::setw(10) << "Rejected" << std::setw(8) << "Newton"
+        << std::setw(11) << "Jacobians" << std::setw(10) << "Time [s]" << std::setw(18) << "Breakthrough [s]" << "\n";
+
+    for (int cells : { 50, 100, 200, 400 }) {
+        AdsorptionColumn column;
+        column.integrator.numCells = cells;
+        BreakthroughResult result = column.RunBreakthrough();
+
+        // First time the outlet reaches half the feed CO2
+        double breakthrough = 0.0;
+        for (size_t j = 0; j < result.time.size(); ++j) {
+            if (result.outletMoleFraction[0][j] >= 0.5 * column.feedMoleFraction[0]) {
+                breakthrough = result.time[j];
+                break;
+            }
+        }
+
+        const ColumnStatistics& statistics = result.statistics;
+        out << std::left << std::setw(8) << cells
+            << std::right << std::setw(8) << statistics.numSteps << std::setw(10) << statistics.numRejectedSteps
+            << std::setw(8) << statistics.numNewtonIterations << std::setw(11) << statistics.numJacobians
+            << std::setw(10) << std::fixed << std::setprecision(3) << statistics.seconds
+            << std::setw(18) << std::setprecision(1) << breakthrough
+            << (result.completed ? "" : "  (" + result.message + ")") << "\n";
+    }
+
+    return out.str();
+}
+
+std::string RunCycleBenchmark()
+{
+    std::ostringstream out;
+    out << "Cyclic steady state of the four step LPP cycle, CO2 / N2 on zeolite 13X\n";
+    out << std::left << std::setw(16) << "Method"
+        << std::right << std::setw(8) << "Cycles" << std::setw(10) << "Steps" << std::setw(10) << "Time [s]"
+        << std::setw(10) << "Purity" << std::setw(10) << "Recovery" << std::setw(14) << "Mass balance" << "\n";
+
+    for (bool accelerate : { false, true }) {
+        PsaCycle cycle;
+        cycle.settings.accelerate = accelerate;
+        CyclicSteadyStateResult result = cycle.SolveCyclicSteadyState();
+
+        CycleSummary last;
+        if (!result.history.empty()) last = result.history.back();
+
+        out << std::left << std::setw(16) << (accelerate ? "Anderson" : "Repeated")
+            << std::right << std::setw(8) << last.cycle << std::setw(10) << result.statistics.numSteps
+            << std::setw(10) << std::fixed << std::setprecision(2) << result.statistics.seconds
+            << std::setw(10) << std::setprecision(4) << last.purity << std::setw(10) << last.recovery
+            << std::setw(14) << std::scientific << std::setprecision(1) << last.massBalanceError << std::defaultfloat
+            << (result.converged ? "" : "  (" + result.message + ")") << "\n";
+    }
+
+    return out.str();
+}
+
+std::string RunMultiBedBenchmark(int cycles)
+{
+    std::ostringstream out;
+    out << "Multi-bed PSA with equalisation, " << cycles << " cycles, "
+        << std::thread::hardware_concurrency() << " hardware threads\n";
+    out << std::right << std::setw(6) << "Beds" << std::setw(8) << "Slots" << std::setw(8) << "Links"
+        << std::setw(12) << "Serial [s]" << std::setw(14) << "Parallel [s]" << std::setw(10) << "Speedup"
+        << std::setw(12) << "Residual" << "\n";
+
+    for (int numBeds : { 2, 4, 6 }) {
+        MultiBedPsa psa;
+        psa.settings.numBeds = numBeds;
+        psa.settings.maxCycles = cycles;
+
+        psa.settings.parallel = false;
+        MultiBedResult serial = psa.Run();
+        psa.settings.parallel = true;
+        MultiBedResult parallel = psa.Run();
+
+        // Both runs exchange the same streams at the same points, so they must agree exactly
+        const bool same = !serial.history.empty() && !parallel.history.empty()
+            && serial.history.back().residual == parallel.history.back().residual;
+
+        out << std::setw(6) << numBeds << std::setw(8) << serial.numSlots << std::setw(8) << serial.numLinks
+            << std::fixed << std::setprecision(2) << std::setw(12) << serial.seconds << std::setw(14) << parallel.seconds
+            << std::setw(9) << serial.seconds / std::max(parallel.seconds, 1e-9) << "x"
+            << std::setw(12) << std::scientific << std::setprecision(2)
+            << (serial.history.empty() ? 0.0 : serial.history.back().residual) << std::defaultfloat
+            << (same ? "" : "  (serial and parallel differ)") << "\n";
+    }
+
+    return out.str();
+}
+
+std::string RunPlotBenchmark(int points)
+{
+    using Clock = std::chrono::steady_clock;
+    const size_t n = static_cast<size_t>(points);
+    const int pixels = 1600;
+
+    // Breakthrough shaped front with noise and one spike
+    std::vector<double> x(n), y(n);
+    std::mt19937 generator(7);
+    std::normal_distribution<double> noise(0.0, 0.002);
+    for (size_t k = 0; k < n; ++k) {
+        x[k] = 1000.0 * k / (n - 1);
+        y[k] = 0.15 / (1.0 + std::exp(-(x[k] - 500.0) / 20.0)) + noise(generator);
+    }
+    y[n / 20] = 0.5;
+    const double yMax = *std::max_element(y.begin(), y.end());
+
+    std::ostringstream out;
+    out << "Decimation of " << n << " points to " << pixels << " pixel columns\n";
+    out << std::left << std::setw(10) << "Method" << std::setw(10) << "Range"
+        << std::right << std::setw(12) << "Time [ms]" << std::setw(10) << "Points" << std::setw(10) << "Spike" << "\n";
+
+    std::vector<double> xOut, yOut;
+    for (auto method : { DecimationMethod::MinMax, DecimationMethod::Lttb }) {
+        for (double visible : { 1.0, 0.1 }) {
+            auto start = Clock::now();
+            DecimateSeries(method, x.data(), y.data(), n, 0.0, 1000.0 * visible, pixels, xOut, yOut);
+            const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            const bool spike = *std::max_element(yOut.begin(), yOut.end()) == yMax;
+
+            out << std::left << std::setw(10) << GetDecimationName(method) << std::setw(10) << (visible == 1.0 ? "All" : "10 %")
+                << std::right << std::fixed << std::setprecision(2) << std::setw(12) << ms << std::defaultfloat
+                << std::setw(10) << xOut.size() << std::setw(10) << (spike ? "kept" : "lost") << "\n";
+        }
+    }
+
+    // Rows of a two component breakthrough through the ring, read as they arrive
+    SeriesStream stream(4);
+    std::vector<std::vector<double>> columns;
+    std::atomic<bool> done{ false };
+    auto start = Clock::now();
+    std::thread writer([&]() {
+        double row[4];
+        for (size_t k = 0; k < n; ++k) {
+            row[0] = x[k];
+            row[1] = y[k];
+            row[2] = 1.0 - y[k];
+            row[3] = 298.15;
+            stream.Append(row);
+        }
+        while (!stream.Flush()) std::this_thread::yield();
+        done = true;
+    });
+    while (!done.load()) {
+        if (stream.Drain(columns) == 0) std::this_thread::yield();
+    }
+    writer.join();
+    stream.Drain(columns);
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    out << "\nStreamed " << columns[0].size() << " rows of 4 values in " << std::fixed << std::setprecision(3) << seconds
+        << " s, " << std::setprecision(1) << columns[0].size() / seconds / 1e6 << " million rows/s"
+        << (columns[0] == x ? "" : "  (rows lost or out of order)") << "\n";
+    return out.str();
+}
+
+std::string RunResultFileBenchmark(int rows)
+{
+    using Clock = std::chrono::steady_clock;
+    auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    const size_t n = static_cast<size_t>(rows);
+    const size_t numColumns = 5;
+    const auto directory = std::filesystem::temp_directory_path();
+    const std::string binaryPath = (directory / "thermatix_benchmark.thxr").string();
+    const std::string csvPath = (directory / "thermatix_benchmark.csv").string();
+
+    // Time, three mole fractions and a temperature, like a three component breakthrough
+    auto makeRow = [](size_t k, double* row) {
+        const double t = 0.01 * k;
+        const double front = 1.0 / (1.0 + std::exp(-(t - 5000.0) / 200.0));
+        row[0] = t;
+        row[1] = 0.15 * front;
+        row[2] = 0.05 * front;
+        row[3] = 1.0 - row[1] - row[2];
+        row[4] = 298.15 + 20.0 * front * (1.0 - front);
+    };
+
+    std::ostringstream out;
+    out << "Result files, " << n << " rows of " << numColumns << " columns\n";
+    out << std::left << std::setw(8) << "Format" << std::right << std::setw(12) << "Write [s]" << std::setw(14) << "Size [MB]"
+        << std::setw(16) << "Column [s]" << std::setw(16) << "1 % window [s]" << "\n";
+
+    double row[numColumns];
+    std::string message;
+
+    // Binary
+    auto start = Clock::now();
+    {
+        ResultWriter writer;
+        writer.Open(binaryPath, { { "time", "s" }, { "y CO2", "-" }, { "y H2O", "-" }, { "y N2", "-" }, { "temperature", "K" } }, message);
+        for (size_t k = 0; k < n; ++k) {
+            makeRow(k, row);
+            writer.Append(row);
+        }
+        writer.Close(message);
+    }
+    const double binaryWrite = elapsed(start);
+
+    std::vector<double> column, window;
+    ResultReader reader;
+    start = Clock::now();
+    const bool opened = reader.Open(binaryPath, message);
+    if (opened) reader.ReadColumn(1, column);
+    const double binaryColumn = elapsed(start);
+    const double windowStart = 0.01 * n * 0.5;
+    start = Clock::now();
+    if (opened) reader.ReadRange(1, windowStart, windowStart + 0.01 * n * 0.01, window);
+    const double binaryWindow = elapsed(start);
+    const bool mapped = reader.IsMapped();
+    reader.Close();
+
+    // CSV, with every value written and parsed back as text
+    start = Clock::now();
+    {
+        std::ofstream file(csvPath, std::ios::binary);
+        file << "time [s],y CO2 [-],y H2O [-],y N2 [-],temperature [K]\n";
+        file.precision(17);
+        for (size_t k = 0; k < n; ++k) {
+            makeRow(k, row);
+            file << row[0] << "," << row[1] << "," << row[2] << "," << row[3] << "," << row[4] << "\n";
+        }
+    }
+    const double csvWrite = elapsed(start);
+
+    std::vector<double> csvColumn, csvWindow;
+    auto readCsv = [&](double from, double to, std::vector<double>& values) {
+        std::ifstream file(csvPath, std::ios::binary);
+        std::string line;
+        std::getline(file, line);
+        while (std::getline(file, line)) {
+            const char* text = line.c_str();
+            char* end = nullptr;
+            const double t = std::strtod(text, &end);
+            const double y = std::strtod(end + 1, &end);
+            if (t >= from && t <= to) values.push_back(y);
+        }
+    };
+    start = Clock::now();
+    readCsv(-1e300, 1e300, csvColumn);
+    const double csvColumnTime = elapsed(start);
+    start = Clock::now();
+    readCsv(windowStart, windowStart + 0.01 * n * 0.01, csvWindow);
+    const double csvWindowTime = elapsed(start);
+
+    std::error_code error;
+    const double binaryMB = std::filesystem::file_size(binaryPath, error) / 1e6;
+    const double csvMB = std::filesystem::file_size(csvPath, error) / 1e6;
+    std::filesystem::remove(binaryPath, error);
+    std::filesystem::remove(csvPath, error);
+
+    out << std::fixed;
+    out << std::left << std::setw(8) << "Binary" << std::right << std::setprecision(3) << std::setw(12) << binaryWrite
+        << std::setprecision(1) << std::setw(14) << binaryMB << std::setprecision(4) << std::setw(16) << binaryColumn
+        << std::setw(16) << binaryWindow << (mapped ? "  (mapped)" : "") << "\n";
+    out << std::left << std::setw(8) << "CSV" << std::right << std::setprecision(3) << std::setw(12) << csvWrite
+        << std::setprecision(1) << std::setw(14) << csvMB << std::setprecision(4) << std::setw(16) << csvColumnTime
+        << std::setw(16) << csvWindowTime << "\n";
+    out << std::defaultfloat;
+
+    const bool same = opened && column == csvColumn && window == csvWindow;
+    out << (same ? "Both formats read back the same values\n" : "The formats disagree: " + message + "\n");
+    return out.str();
+}
+
+std::string RunFlowsheetIOBenchmark(int units)
+{
+    using Clock = std::chrono::steady_clock;
+    auto milliseconds = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    // A feed and a chain of valves laid out on a grid
+    NodeFactory factory;
+    Flowsheet flowsheet;
+    Node* previous = nullptr;
+    for (int i = 0; i < units; ++i) {
+        const Vec2 pos(120.0f * (i % 100), 100.0f * (i / 100));
+        Node* node = flowsheet.AddNode(factory.CreateNode(i == 0 ? "Inlet" : "Valve", "Unit " + std::to_string(i + 1), pos));
+        node->data[0].value += 1e-3 * i;
+        node->outputs[0].stream.massFlowRate = 1.0 + 1e-6 * i;
+        if (previous) flowsheet.Connect(&previous->outputs[0], &node->inputs[0]);
+        previous = node;
+    }
+
+    std::ostringstream out;
+    out << "Flowsheet files, " << flowsheet.nodes.size() << " units and " << flowsheet.connections.size() << " streams\n";
+    out << std::left << std::setw(10) << "Format" << std::right << std::setw(12) << "Save [ms]" << std::setw(12) << "Load [ms]" << std::setw(12) << "Size [kB]" << "\n";
+
+    std::string error;
+    bool same = true;
+    const std::string reference = SaveFlowsheet(flowsheet);
+
+    auto run = [&](const char* name, const std::function<std::string(const Flowsheet&)>& save,
+        const std::function<bool(const std::string&, Flowsheet&)>& load) {
+        auto start = Clock::now();
+        const std::string data = save(flowsheet);
+        const double saveTime = milliseconds(start);
+
+        Flowsheet loaded;
+        start = Clock::now();
+        const bool ok = load(data, loaded);
+        const double loadTime = milliseconds(start);
+        same = same && ok && SaveFlowsheet(loaded) == reference;
+
+        out << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1) << std::setw(12) << saveTime
+            << std::setw(12) << loadTime << std::setw(12) << data.size() / 1e3 << std::defaultfloat << "\n";
+    };
+
+    run("JSON", SaveFlowsheet, [&](const std::string& data, Flowsheet& loaded) { return LoadFlowsheet(data, factory, loaded, error); });
+    run("Snapshot", SaveFlowsheetSnapshot, [&](const std::string& data, Flowsheet& loaded) { return LoadFlowsheetSnapshot(data, factory, loaded, error); });
+
+    // What building a JSON document alone costs, before a single unit exists
+    auto start = Clock::now();
+    const nlohmann::json document = nlohmann::json::parse(reference);
+    out << "Parsing the JSON of " << document["units"].size() << " units into a document alone takes " << std::fixed << std::setprecision(1)
+        << milliseconds(start) << " ms\n" << std::defaultfloat;
+
+    out << (same ? "Both formats load the same flowsheet\n" : "The formats disagree: " + error + "\n");
+    return out.str();
+}
+
+std::string RunHitTestBenchmark(int units)
+{
+    // Valves on a square grid, about as dense as a drawn flowsheet
+    NodeFactory factory;
+    Flowsheet flowsheet;
+    const int columns = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(units))));
+    for (int i = 0; i < units; ++i) {
+        flowsheet.AddNode(factory.CreateNode("Valve", "Valve " + std::to_string(i + 1), Vec2(120.0f * (i % columns), 100.0f * (i / columns))));
+    }
+
+    // Each valve feeds the next, the last of a row runs back across the canvas to the next row
+    for (int i = 0; i + 1 < units; ++i) flowsheet.Connect(&flowsheet.nodes[i]->outputs[0], &flowsheet.nodes[i + 1]->inputs[0]);
+
+    const int queries = 5000;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> x(-50.0f, 120.0f * columns + 50.0f);
+    std::uniform_real_distribution<float> y(-50.0f, 100.0f * ((units + columns - 1) / columns) + 50.0f);
+    std::vector<Vec2> points(queries);
+    for (auto& point : points) point = Vec2(x(random), y(random));
+
+    auto start = Clock::now();
+    SpatialGrid grid;
+    grid.Rebuild(flowsheet.nodes);
+    const double rebuild = ElapsedNanoseconds(start, 1) * 1e-6;
+
+    // Every node tested for every query, as the editor did
+    std::vector<Node*> linearHits(queries), gridHits(queries);
+    std::vector<ConnectionPoint*> linearPorts(queries), gridPorts(queries);
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        for (auto it = flowsheet.nodes.rbegin(); it != flowsheet.nodes.rend(); ++it) {
+            if ((*it)->Contains(points[q])) {
+                linearHits[q] = it->get();
+                break;
+            }
+        }
+    }
+    const double linearHit = ElapsedNanoseconds(start, queries);
+
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        float minDistSq = 25.0f * 25.0f;
+        for (const auto& node : flowsheet.nodes) {
+            for (auto* ports : { &node->outputs, &node->inputs }) {
+                for (auto& port : *ports) {
+                    Vec2 delta = node->GetConnectionPointPos(port) - points[q];
+                    float distSq = delta.x * delta.x + delta.y * delta.y;
+                    if (distSq < minDistSq) {
+                        minDistSq = distSq;
+                        linearPorts[q] = &port;
+                    }
+                }
+            }
+        }
+    }
+    const double linearSnap = ElapsedNanoseconds(start, queries);
+
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) gridHits[q] = grid.FindNodeAt(points[q]);
+    const double gridHit = ElapsedNanoseconds(start, queries);
+
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) gridPorts[q] = grid.FindNearestPort(points[q], 25.0f, false, false);
+    const double gridSnap = ElapsedNanoseconds(start, queries);
+
+    // Units in a 1600 x 900 view in the middle of the flowsheet, from the grid against testing
+    // every unit, as drawing them all would
+    const Vec2 viewMin(60.0f * columns - 800.0f, 50.0f * columns - 450.0f);
+    const Vec2 viewMax(viewMin.x + 1600.0f, viewMin.y + 900.0f);
+    const int views = 1000;
+    std::vector<Node*> visible;
+    start = Clock::now();
+    for (int k = 0; k < views; ++k) grid.QueryRect(viewMin, viewMax, visible);
+    const double gridView = ElapsedNanoseconds(start, views) * 1e-3;
+    size_t numLinear = 0;
+    start = Clock::now();
+    for (int k = 0; k < views; ++k) {
+        numLinear = 0;
+        for (const auto& node : flowsheet.nodes) {
+            if (node->pos.x - 25.0f <= viewMax.x && node->pos.x + node->size.x + 25.0f >= viewMin.x &&
+                node->pos.y - 25.0f <= viewMax.y && node->pos.y + node->size.y + 25.0f >= viewMin.y) ++numLinear;
+        }
+    }
+    const double linearView = ElapsedNanoseconds(start, views) * 1e-3;
+
+    // Streams in the same view, through the units around it against testing every stream
+    std::vector<Connection*> visibleStreams, linearStreams;
+    start = Clock::now();
+    for (int k = 0; k < views; ++k) grid.QueryConnections(viewMin, viewMax, visibleStreams);
+    const double gridStreams = ElapsedNanoseconds(start, views) * 1e-3;
+    start = Clock::now();
+    for (int k = 0; k < views; ++k) {
+        linearStreams.clear();
+        for (const auto& connection : flowsheet.connections) {
+            const Vec2 a = connection->from->node->GetConnectionPointPos(*connection->from);
+            const Vec2 b = connection->to->node->GetConnectionPointPos(*connection->to);
+            if (std::max(a.x, b.x) >= viewMin.x && std::min(a.x, b.x) <= viewMax.x &&
+                std::max(a.y, b.y) >= viewMin.y && std::min(a.y, b.y) <= viewMax.y) linearStreams.push_back(connection.get());
+        }
+    }
+    const double linearStreamView = ElapsedNanoseconds(start, views) * 1e-3;
+
+    // One node dragged across the canvas a pixel at a time
+    Node* dragged = flowsheet.nodes.front().get();
+    const int steps = 100000;
+    start = Clock::now();
+    for (int k = 0; k < steps; ++k) {
+        dragged->pos.x = static_cast<float>(k % (120 * columns));
+        grid.Update(dragged);
+    }
+    const double drag = ElapsedNanoseconds(start, steps);
+
+    std::ostringstream out;
+    out << "Canvas hit-testing and culling, " << units << " units, " << queries << " random queries\n";
+    out << std::left << std::setw(10) << "Method" << std::right << std::setw(14) << "Click [ns]" << std::setw(14) << "Snap [ns]" << "\n";
+    out << std::fixed << std::setprecision(0);
+    out << std::left << std::setw(10) << "Linear" << std::right << std::setw(14) << linearHit << std::setw(14) << linearSnap << "\n";
+    out << std::left << std::setw(10) << "Grid" << std::right << std::setw(14) << gridHit << std::setw(14) << gridSnap << "\n";
+    out << std::setprecision(2) << "Finding the " << visible.size() << " units in a 1600 x 900 view takes " << gridView << " us, testing every unit "
+        << linearView << " us\n";
+    out << "Finding the " << visibleStreams.size() << " streams in it takes " << gridStreams << " us, testing every stream "
+        << linearStreamView << " us\n";
+    out << "Building the grid took " << rebuild << " ms, moving a node " << drag << " ns per step\n" << std::defaultfloat;
+    const bool same = linearHits == gridHits && linearPorts == gridPorts && visible.size() == numLinear && visibleStreams == linearStreams;
+    out << (same ? "Both methods find the same units, ports and streams\n" : "The methods disagree\n");
+    return out.str();
+}
+
+std::string RunUndoBenchmark(int units)
+{
+    // A chain of valves, every outlet feeding the next inlet
+    NodeFactory factory;
+    Flowsheet flowsheet;
+    const int columns = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(units))));
+    for (int i = 0; i < units; ++i) {
+        flowsheet.AddNode(factory.CreateNode("Valve", "Valve " + std::to_string(i + 1), Vec2(120.0f * (i % columns), 100.0f * (i / columns))));
+    }
+    for (int i = 0; i + 1 < units; ++i) flowsheet.Connect(&flowsheet.nodes[i]->outputs[0], &flowsheet.nodes[i + 1]->inputs[0]);
+
+    UndoJournal journal;
+    JournalChange change;
+    const std::string before = SaveFlowsheetSnapshot(flowsheet);
+    const int repeats = 1000;
+
+    // One step of each kind, then every undo and redo of it timed
+    auto undoRedo = [&]() {
+        auto start = Clock::now();
+        for (int k = 0; k < repeats; ++k) {
+            journal.Undo(flowsheet, change);
+            journal.Redo(flowsheet, change);
+        }
+        return ElapsedNanoseconds(start, 2 * repeats) * 1e-3;
+    };
+
+    // 100 units dragged together
+    std::vector<UndoJournal::Move> moves;
+    for (int i = 0; i < 100; ++i) {
+        Node* node = flowsheet.nodes[i * (units / 100)].get();
+        moves.push_back({ node, node->pos, node->pos + Vec2(35.0f, -12.0f) });
+        node->pos = moves.back().to;
+    }
+    journal.RecordMove(moves);
+    const double move = undoRedo();
+
+    // A value typed in, one keystroke at a time, is one step
+    Node* edited = flowsheet.nodes[units / 2].get();
+    for (int key = 0; key < 10; ++key) {
+        const double old = edited->data[0].value;
+        edited->data[0].value = 10.0 * key;
+        journal.RecordValue(edited, 0, old, edited->data[0].isSelected);
+    }
+    journal.Seal();
+    const double value = undoRedo();
+
+    // Ten units in the middle of the chain, with their twenty streams
+    std::vector<Node*> deleted;
+    for (int i = 0; i < 10; ++i) deleted.push_back(flowsheet.nodes[units / 2 + 7 * i + 1].get());
+    auto start = Clock::now();
+    journal.DeleteNodes(flowsheet, deleted);
+    const double deleteTime = ElapsedNanoseconds(start, 1) * 1e-3;
+    const double deleteStep = undoRedo();
+    const size_t stepBytes = journal.GetNumBytes();
+
+    // Everything undone gives the flowsheet back, everything redone the edited one
+    const std::string after = SaveFlowsheetSnapshot(flowsheet);
+    while (journal.Undo(flowsheet, change)) {}
+    const bool undone = SaveFlowsheetSnapshot(flowsheet) == before;
+    while (journal.Redo(flowsheet, change)) {}
+    const bool redone = SaveFlowsheetSnapshot(flowsheet) == after;
+
+    // A snapshot per step instead, saved after the edit and loaded to undo it
+    start = Clock::now();
+    const std::string snapshot = SaveFlowsheetSnapshot(flowsheet);
+    const double snapshotSave = ElapsedNanoseconds(start, 1) * 1e-3;
+    Flowsheet restored;
+    std::string error;
+    start = Clock::now();
+    LoadFlowsheetSnapshot(snapshot, factory, restored, error);
+    const double snapshotLoad = ElapsedNanoseconds(start, 1) * 1e-3;
+
+    // A long session of single-unit drags and value edits
+    const int edits = 200000;
+    size_t peakBytes = 0;
+    for (int k = 0; k < edits; ++k) {
+        Node* node = flowsheet.nodes[(k * 7919) % flowsheet.nodes.size()].get();
+        if (k % 2) {
+            const Vec2 from = node->pos;
+            node->pos = node->pos + Vec2(1.0f, 0.0f);
+            journal.RecordMove({ { node, from, node->pos } });
+        }
+        else {
+            const double old = node->data[1].value;
+            node->data[1].value += 1.0;
+            journal.RecordValue(node, 1, old, node->data[1].isSelected);
+            journal.Seal();
+        }
+        peakBytes = std::max(peakBytes, journal.GetNumBytes());
+    }
+
+    std::ostringstream out;
+    out << "Undo journal on a chain of " << units << " units\n";
+    out << std::left << std::setw(30) << "Step" << std::right << std::setw(20) << "Undo or redo [us]" << "\n";
+    out << std::fixed << std::setprecision(2);
+    out << std::left << std::setw(30) << "Drag of 100 units" << std::right << std::setw(20) << move << "\n";
+    out << std::left << std::setw(30) << "Value typed in 10 keys" << std::right << std::setw(20) << value << "\n";
+    out << std::left << std::setw(30) << "Delete of 10 units" << std::right << std::setw(20) << deleteStep << "\n";
+    out << "Deleting the 10 units took " << deleteTime << " us, the three steps hold " << stepBytes << " bytes\n";
+    out << "A snapshot per step would hold " << snapshot.size() << " bytes, saving it takes " << snapshotSave << " us and undoing from it "
+        << snapshotLoad << " us\n";
+    out << "After " << edits << " more edits the journal holds " << journal.GetNumSteps() << " steps in " << journal.GetNumBytes()
+        << " bytes, at most " << peakBytes << "\n" << std::defaultfloat;
+    out << (undone && redone ? "Undoing and redoing everything restores both flowsheets\n" : "Undo or redo did not restore the flowsheet\n");
+    return out.str();
+}
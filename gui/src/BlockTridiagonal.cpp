@@ -0,0 +1,139 @@
+#include "BlockTridiagonal.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    // In-place LU of a dense m x m block with partial pivoting
+    bool FactorizeBlock(double* a, int* pivot, size_t m)
+    {
+        for (size_t c = 0; c < m; ++c) {
+            size_t best = c;
+            for (size_t r = c + 1; r < m; ++r) {
+                if (std::fabs(a[r * m + c]) > std::fabs(a[best * m + c])) best = r;
+            }
+            pivot[c] = static_cast<int>(best);
+            if (a[best * m + c] == 0.0) return false;
+
+            if (best != c) {
+                for (size_t j = 0; j < m; ++j) std::swap(a[c * m + j], a[best * m + j]);
+            }
+
+            const double inverse = 1.0 / a[c * m + c];
+            for (size_t r = c + 1; r < m; ++r) {
+                double factor = a[r * m + c] * inverse;
+                a[r * m + c] = factor;
+                for (size_t j = c + 1; j < m; ++j) a[r * m + j] -= factor * a[c * m + j];
+            }
+        }
+        return true;
+    }
+
+    // Solve with a factorized block, x is read and written with the given stride
+    void SolveBlock(const double* lu, const int* pivot, double* x, size_t m, size_t stride)
+    {
+        for (size_t c = 0; c < m; ++c) {
+            if (static_cast<size_t>(pivot[c]) != c) std::swap(x[c * stride], x[pivot[c] * stride]);
+        }
+        for (size_t r = 1; r < m; ++r) {
+            double sum = x[r * stride];
+            for (size_t j = 0; j < r; ++j) sum -= lu[r * m + j] * x[j * stride];
+            x[r * stride] = sum;
+        }
+        for (size_t r = m; r-- > 0;) {
+            double sum = x[r * stride];
+            for (size_t j = r + 1; j < m; ++j) sum -= lu[r * m + j] * x[j * stride];
+            x[r * stride] = sum / lu[r * m + r];
+        }
+    }
+}
+
+void BlockTridiagonal::Resize(size_t numBlocks, size_t blockSize)
+{
+    this->numBlocks = numBlocks;
+    this->blockSize = blockSize;
+
+    const size_t size = numBlocks * blockSize * blockSize;
+    lower.assign(size, 0.0);
+    diagonal.assign(size, 0.0);
+    upper.assign(size, 0.0);
+    factor.assign(size, 0.0);
+    eliminated.assign(size, 0.0);
+    pivot.assign(numBlocks * blockSize, 0);
+}
+
+void BlockTridiagonal::SetZero()
+{
+    std::fill(lower.begin(), lower.end(), 0.0);
+    std::fill(diagonal.begin(), diagonal.end(), 0.0);
+    std::fill(upper.begin(), upper.end(), 0.0);
+}
+
+bool BlockTridiagonal::Factorize()
+{
+    const size_t m = blockSize;
+    const size_t mm = m * m;
+
+    for (size_t k = 0; k < numBlocks; ++k) {
+        double* d = &factor[k * mm];
+        std::copy(Diagonal(k), Diagonal(k) + mm, d);
+
+        // D_k - L_k W_k-1
+        if (k > 0) {
+            const double* l = Lower(k);
+            const double* w = &eliminated[(k - 1) * mm];
+            for (size_t r = 0; r < m; ++r) {
+                for (size_t q = 0; q < m; ++q) {
+                    const double lrq = l[r * m + q];
+                    if (lrq == 0.0) continue;
+                    for (size_t c = 0; c < m; ++c) d[r * m + c] -= lrq * w[q * m + c];
+                }
+            }
+        }
+
+        if (!FactorizeBlock(d, &pivot[k * m], m)) return false;
+
+        if (k + 1 < numBlocks) {
+            double* w = &eliminated[k * mm];
+            std::copy(Upper(k), Upper(k) + mm, w);
+            for (size_t c = 0; c < m; ++c) SolveBlock(d, &pivot[k * m], w + c, m, m);
+        }
+    }
+    return true;
+}
+
+void BlockTridiagonal::Solve(double* b) const
+{
+    if (numBlocks == 0) return;
+    const size_t m = blockSize;
+    const size_t mm = m * m;
+
+    // Forward elimination
+    for (size_t k = 0; k < numBlocks; ++k) {
+        double* x = b + k * m;
+        if (k > 0) {
+            const double* l = Lower(k);
+            const double* previous = x - m;
+            for (size_t r = 0; r < m; ++r) {
+                double sum = 0.0;
+                for (size_t q = 0; q < m; ++q) sum += l[r * m + q] * previous[q];
+                x[r] -= sum;
+            }
+        }
+        SolveBlock(&factor[k * mm], &pivot[k * m], x, m, 1);
+    }
+
+    // Back substitution
+    for (size_t k = numBlocks - 1; k-- > 0;) {
+        const double* w = &eliminated[k * mm];
+        double* x = b + k * m;
+        const double* next = x + m;
+        for (size_t r = 0; r < m; ++r) {
+            double sum = 0.0;
+            for (size_t q = 0; q < m; ++q) sum += w[r * m + q] * next[q];
+            x[r] -= sum;
+        }
+    }
+}
@@ -0,0 +1,240 @@
+#include "CaseStudy.h"
+#include "FlowsheetIO.h"
+#include "EquationOrientedSolver.h"
+#include "WorkStealingPool.h"
+
+// STL Includes
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+    // Everything one worker needs to solve cases on its own copy of the flowsheet
+    struct CaseWorker {
+        Flowsheet flowsheet;
+        FlowsheetSolver solver{ 0 };
+        EquationOrientedSolver equationSolver;
+        std::vector<double*> state;      // Data values and port streams of every unit
+        std::vector<double*> inputs;
+        std::vector<double*> outputs;
+        int lastConverged = -1;
+    };
+
+    void GetState(Flowsheet& flowsheet, std::vector<double*>& state)
+    {
+        std::vector<double*> variables;
+        state.clear();
+        for (const auto& node : flowsheet.nodes) {
+            node->GetEquationVariables(variables);
+            state.insert(state.end(), variables.begin(), variables.end());
+        }
+    }
+}
+
+int CaseStudy::GetNumCases() const
+{
+    int numCases = ranges.empty() ? 0 : 1;
+    for (const auto& range : ranges) {
+        numCases *= std::max(range.numPoints, 0);
+    }
+    return numCases;
+}
+
+void CaseStudy::GetGridPoint(int index, std::vector<int>& point) const
+{
+    point.resize(ranges.size());
+    for (size_t d = ranges.size(); d-- > 0;) {
+        point[d] = index % ranges[d].numPoints;
+        index /= ranges[d].numPoints;
+    }
+}
+
+int CaseStudy::GetIndex(const std::vector<int>& point) const
+{
+    int index = 0;
+    for (size_t d = 0; d < ranges.size(); ++d) {
+        index = index * ranges[d].numPoints + point[d];
+    }
+    return index;
+}
+
+std::vector<int> CaseStudy::GetSnakeOrder() const
+{
+    const int numCases = GetNumCases();
+    std::vector<int> order(numCases);
+    std::vector<int> point(ranges.size());
+
+    for (int step = 0; step < numCases; ++step) {
+        // Peel off the outer dimensions. An odd outer coordinate reverses the traversal of the
+        // dimensions inside it, so every step moves one coordinate by one.
+        int remainder = step;
+        int stride = numCases;
+        for (size_t d = 0; d < ranges.size(); ++d) {
+            stride /= ranges[d].numPoints;
+            point[d] = remainder / stride;
+            remainder %= stride;
+            if (point[d] % 2 == 1) remainder = stride - 1 - remainder;
+        }
+        order[step] = GetIndex(point);
+    }
+    return order;
+}
+
+CaseStudyReport CaseStudy::Run(const Flowsheet& flowsheet, const NodeFactory& factory, const std::function<void(const CaseResult&)>& onCaseFinished)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    CaseStudyReport summary;
+    summary.numCases = GetNumCases();
+
+    if (summary.numCases == 0) {
+        summary.message = "Nothing to sweep";
+        return summary;
+    }
+
+    for (const auto& range : ranges) {
+        const DoubleDataVariable* variable = flowsheet.FindVariable(range.variable.unit, range.variable.parameter);
+        if (!variable) {
+            summary.message = "Unknown variable " + range.variable.unit + "." + range.variable.parameter;
+            return summary;
+        }
+        if (!variable->isSelected) {
+            summary.message = range.variable.unit + "." + range.variable.parameter + " is calculated, select it to sweep it";
+            return summary;
+        }
+    }
+    for (const auto& output : outputs) {
+        if (!flowsheet.FindVariable(output.unit, output.parameter)) {
+            summary.message = "Unknown variable " + output.unit + "." + output.parameter;
+            return summary;
+        }
+    }
+
+    // Every worker gets its own copy, the solvers write into the flowsheet
+    const std::string snapshot = SaveFlowsheetSnapshot(flowsheet);
+    WorkStealingPool pool(numWorkers);
+    std::vector<std::unique_ptr<CaseWorker>> workers;
+    for (size_t w = 0; w < pool.GetWorkerCount(); ++w) {
+        auto worker = std::make_unique<CaseWorker>();
+        std::string error;
+        if (!LoadFlowsheetSnapshot(snapshot, factory, worker->flowsheet, error)) {
+            summary.message = error;
+            return summary;
+        }
+        GetState(worker->flowsheet, worker->state);
+        for (const auto& range : ranges) {
+            worker->inputs.push_back(&worker->flowsheet.FindVariable(range.variable.unit, range.variable.parameter)->value);
+        }
+        for (const auto& output : outputs) {
+            worker->outputs.push_back(&worker->flowsheet.FindVariable(output.unit, output.parameter)->value);
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    std::vector<double> baseState;
+    for (double* value : workers[0]->state) baseState.push_back(*value);
+
+    // Converged states, published with release stores on the flags
+    std::vector<std::vector<double>> states(summary.numCases);
+    std::unique_ptr<std::atomic<bool>[]> isConverged(new std::atomic<bool>[summary.numCases]);
+    for (int c = 0; c < summary.numCases; ++c) isConverged[c] = false;
+
+    // Squared grid distance with every range scaled to unit length
+    auto distance = [this](const std::vector<int>& a, const std::vector<int>& b) {
+        double sum = 0.0;
+        for (size_t d = 0; d < ranges.size(); ++d) {
+            if (ranges[d].numPoints < 2) continue;
+            double delta = double(a[d] - b[d]) / (ranges[d].numPoints - 1);
+            sum += delta * delta;
+        }
+        return sum;
+    };
+
+    // Nearest converged case among the surrounding grid cell and the worker's previous case
+    auto findWarmStart = [&](const std::vector<int>& point, int lastConverged, std::vector<int>& scratch) {
+        int best = -1;
+        double bestDistance = std::numeric_limits<double>::max();
+
+        if (lastConverged >= 0) {
+            GetGridPoint(lastConverged, scratch);
+            best = lastConverged;
+            bestDistance = distance(point, scratch);
+        }
+
+        int numOffsets = 1;
+        for (size_t d = 0; d < ranges.size(); ++d) numOffsets *= 3;
+
+        scratch.resize(ranges.size());
+        for (int offset = 0; offset < numOffsets; ++offset) {
+            bool inside = true;
+            int code = offset;
+            for (size_t d = 0; d < ranges.size(); ++d) {
+                scratch[d] = point[d] + code % 3 - 1;
+                code /= 3;
+                if (scratch[d] < 0 || scratch[d] >= ranges[d].numPoints) inside = false;
+            }
+            if (!inside) continue;
+
+            int neighbour = GetIndex(scratch);
+            if (!isConverged[neighbour].load(std::memory_order_acquire)) continue;
+
+            double neighbourDistance = distance(point, scratch);
+            if (neighbourDistance < bestDistance) {
+                best = neighbour;
+                bestDistance = neighbourDistance;
+            }
+        }
+        return best;
+    };
+
+    std::mutex resultMutex;
+    auto runCase = [&](int index, int workerIndex) {
+        CaseWorker& worker = *workers[workerIndex];
+        std::vector<int> point, scratch;
+        GetGridPoint(index, point);
+
+        int source = warmStart ? findWarmStart(point, worker.lastConverged, scratch) : -1;
+        const std::vector<double>& initial = source >= 0 ? states[source] : baseState;
+        for (size_t i = 0; i < worker.state.size(); ++i) *worker.state[i] = initial[i];
+
+        CaseResult result;
+        result.index = index;
+        result.warmStarted = source >= 0;
+        for (size_t r = 0; r < ranges.size(); ++r) {
+            *worker.inputs[r] = ranges[r].GetValue(point[r]);
+            result.inputs.push_back(*worker.inputs[r]);
+        }
+
+        result.report = useEquationOriented
+            ? worker.equationSolver.Solve(worker.flowsheet.nodes, worker.flowsheet.connections)
+            : worker.solver.Solve(worker.flowsheet.nodes, worker.flowsheet.connections);
+
+        for (double* output : worker.outputs) result.outputs.push_back(*output);
+
+        if (result.report.converged) {
+            std::vector<double>& converged = states[index];
+            converged.reserve(worker.state.size());
+            for (double* value : worker.state) converged.push_back(*value);
+            isConverged[index].store(true, std::memory_order_release);
+            worker.lastConverged = index;
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (result.report.converged) ++summary.numConverged;
+        if (result.warmStarted) ++summary.numWarmStarted;
+        if (onCaseFinished) onCaseFinished(result);
+    };
+
+    pool.Run(GetSnakeOrder(), runCase);
+
+    summary.numWorkers = pool.GetWorkerCount();
+    summary.numSteals = pool.GetNumSteals();
+    summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    summary.message = std::to_string(summary.numConverged) + " of " + std::to_string(summary.numCases) + " cases converged";
+    return summary;
+}
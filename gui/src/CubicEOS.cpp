@@ -0,0 +1,404 @@
+#include "CubicEOS.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr double GasConstant = 8.314462618;     // [J/mol/K]
+    constexpr double ReferenceTemperature = 298.15; // [K]
+    constexpr int NewtonStepsPerCheck = 4;
+    constexpr int MaxNewtonSteps = 64;
+    constexpr size_t FixedChunkSize = 64;           // States per pass of the fixed count kernels
+
+    // Coefficients of Z^3 + c2 Z^2 + c1 Z + c0 = 0 for the generic two-parameter cubic
+    struct CubicCoefficients {
+        double c2, c1, c0;
+    };
+
+    inline CubicCoefficients GetCoefficients(double A, double B, double u, double w)
+    {
+        return {
+            -(1.0 + B - u * B),
+            A + w * B * B - u * B - u * B * B,
+            -(A * B + w * B * B + w * B * B * B)
+        };
+    }
+
+    // Newton steps on the cubic from z, without branches or reductions so the loop vectorises
+    void NewtonSteps(const double* A, const double* B, double* z, size_t n, double u, double w, int steps)
+    {
+        for (int s = 0; s < steps; ++s) {
+            for (size_t k = 0; k < n; ++k) {
+                CubicCoefficients c = GetCoefficients(A[k], B[k], u, w);
+                double zk = z[k];
+                double f = ((zk + c.c2) * zk + c.c1) * zk + c.c0;
+                double df = (3.0 * zk + 2.0 * c.c2) * zk + c.c1;
+                z[k] = zk - f / std::max(df, 1e-300);
+            }
+        }
+    }
+
+    // Would the next Newton step move any state by more than the tolerance
+    bool IsConverged(const double* A, const double* B, const double* z, size_t n, double u, double w)
+    {
+        for (size_t k = 0; k < n; ++k) {
+            CubicCoefficients c = GetCoefficients(A[k], B[k], u, w);
+            double zk = z[k];
+            double f = ((zk + c.c2) * zk + c.c1) * zk + c.c0;
+            double df = (3.0 * zk + 2.0 * c.c2) * zk + c.c1;
+            if (!(std::fabs(f) <= 1e-13 * zk * std::max(df, 1e-300))) return false;
+        }
+        return true;
+    }
+
+    void SolveRoots(const double* A, const double* B, double* z, size_t n, double u, double w)
+    {
+        for (int done = 0; done < MaxNewtonSteps; done += NewtonStepsPerCheck) {
+            NewtonSteps(A, B, z, n, u, w, NewtonStepsPerCheck);
+            if (IsConverged(A, B, z, n, u, w))
+                break;
+        }
+    }
+}
+
+void PropertyBatch::Resize(size_t numStates, size_t numComponents)
+{
+    for (auto* column : { &temperature, &pressure, &compressibility, &density, &molarMass, &enthalpy,
+                          &a, &dadT, &b, &A, &B, &zVapour, &zLiquid }) {
+        column->resize(numStates);
+    }
+    for (auto* table : { &moleFraction, &lnFugacityCoefficient, &sqrtA, &mixingSum }) {
+        table->resize(numComponents);
+        for (auto& column : *table) column.resize(numStates);
+    }
+}
+
+CubicEOS::CubicEOS(CubicModel model, const std::vector<Component>& components)
+    : model(model), components(components)
+{
+    double omegaA, omegaB;
+    if (model == CubicModel::PengRobinson) {
+        delta1 = 1.0 + std::sqrt(2.0);
+        delta2 = 1.0 - std::sqrt(2.0);
+        omegaA = 0.45724;
+        omegaB = 0.07780;
+    }
+    else {
+        delta1 = 1.0;
+        delta2 = 0.0;
+        omegaA = 0.42748;
+        omegaB = 0.08664;
+    }
+
+    for (const auto& component : components) {
+        double Tc = component.criticalTemperature;
+        double Pc = component.criticalPressure * 1e5;
+        double omega = component.acentricFactor;
+
+        ac.push_back(omegaA * GasConstant * GasConstant * Tc * Tc / Pc);
+        bc.push_back(omegaB * GasConstant * Tc / Pc);
+        kappa.push_back(model == CubicModel::PengRobinson
+            ? 0.37464 + 1.54226 * omega - 0.26992 * omega * omega
+            : 0.480 + 1.574 * omega - 0.176 * omega * omega);
+        criticalTemperature.push_back(Tc);
+        molarMass.push_back(component.molarMass);
+    }
+
+    kij.assign(components.size() * components.size(), 0.0);
+    kernel = SelectComponentKernel(components.size());
+}
+
+void CubicEOS::SetKernel(ComponentKernel value)
+{
+    kernel = SelectComponentKernel(components.size()) == value ? value : ComponentKernel::Runtime;
+}
+
+void CubicEOS::SetInteraction(size_t i, size_t j, double value)
+{
+    kij[i * components.size() + j] = value;
+    kij[j * components.size() + i] = value;
+}
+
+void CubicEOS::ComputeMixtureParameters(PropertyBatch& batch) const
+{
+    const size_t n = batch.GetSize();
+    const size_t nc = components.size();
+    const double* T = batch.temperature.data();
+    const double* P = batch.pressure.data();
+
+    double* a = batch.a.data();
+    double* dadT = batch.dadT.data();
+    double* b = batch.b.data();
+    double* mixtureMolarMass = batch.molarMass.data();
+    std::fill(a, a + n, 0.0);
+    std::fill(dadT, dadT + n, 0.0);
+    std::fill(b, b + n, 0.0);
+    std::fill(mixtureMolarMass, mixtureMolarMass + n, 0.0);
+
+    // sqrt(a_i(T)) with the Soave alpha function, stored in sqrtA
+    for (size_t i = 0; i < nc; ++i) {
+        double* sqrtA = batch.sqrtA[i].data();
+        const double* x = batch.moleFraction[i].data();
+        const double sqrtAc = std::sqrt(ac[i]);
+        const double inverseTc = 1.0 / criticalTemperature[i];
+        const double kappaI = kappa[i], bI = bc[i], molarMassI = molarMass[i];
+        for (size_t k = 0; k < n; ++k) {
+            sqrtA[k] = sqrtAc * (1.0 + kappaI * (1.0 - std::sqrt(T[k] * inverseTc)));
+            b[k] += x[k] * bI;
+            mixtureMolarMass[k] += x[k] * molarMassI;
+        }
+    }
+
+    // a = sum_i x_i sqrt(a_i) S_i with S_i = sum_j x_j (1 - k_ij) sqrt(a_j), and the same sums give da/dT
+    for (size_t i = 0; i < nc; ++i) {
+        double* S = batch.mixingSum[i].data();
+        std::fill(batch.mixingSum[i].begin(), batch.mixingSum[i].end(), 0.0);
+        for (size_t j = 0; j < nc; ++j) {
+            const double weight = 1.0 - kij[i * nc + j];
+            const double* x = batch.moleFraction[j].data();
+            const double* sqrtA = batch.sqrtA[j].data();
+            for (size_t k = 0; k < n; ++k) {
+                S[k] += weight * x[k] * sqrtA[k];
+            }
+        }
+
+        const double* x = batch.moleFraction[i].data();
+        const double* sqrtA = batch.sqrtA[i].data();
+        const double sqrtAc = std::sqrt(ac[i]);
+        const double factor = -kappa[i] * sqrtAc * 0.5 / std::sqrt(criticalTemperature[i]);
+        for (size_t k = 0; k < n; ++k) {
+            // d sqrt(a_i) / dT, so x_i S_i d sqrt(a_i)/dT summed over i and doubled is da/dT
+            double dSqrtA = factor / std::sqrt(T[k]);
+            a[k] += x[k] * sqrtA[k] * S[k];
+            dadT[k] += 2.0 * x[k] * dSqrtA * S[k];
+        }
+    }
+
+    double* A = batch.A.data();
+    double* B = batch.B.data();
+    for (size_t k = 0; k < n; ++k) {
+        double RT = GasConstant * T[k];
+        double pressure = P[k] * 1e5;
+        A[k] = a[k] * pressure / (RT * RT);
+        B[k] = b[k] * pressure / RT;
+    }
+}
+
+void CubicEOS::SolveCompressibility(const double* A, const double* B, double* zVapour, double* zLiquid, double* Z, size_t n, Phase phase) const
+{
+    const double u = delta1 + delta2;
+    const double w = delta1 * delta2;
+
+    // The Cauchy bound lies above every root and above the inflection point, where the cubic is
+    // increasing and convex, so Newton descends monotonically onto the largest root
+    for (size_t k = 0; k < n; ++k) {
+        CubicCoefficients c = GetCoefficients(A[k], B[k], u, w);
+        zVapour[k] = 1.0 + std::max(std::fabs(c.c2), std::max(std::fabs(c.c1), std::fabs(c.c0)));
+    }
+    SolveRoots(A, B, zVapour, n, u, w);
+
+    if (phase != Phase::Vapour) {
+        // Divide out the largest root, the smaller root of the remaining quadratic is the liquid
+        // root if it is real and above the co-volume, otherwise there is only one phase
+        for (size_t k = 0; k < n; ++k) {
+            CubicCoefficients c = GetCoefficients(A[k], B[k], u, w);
+            double p = c.c2 + zVapour[k];
+            double q = c.c1 + zVapour[k] * p;
+            double discriminant = p * p - 4.0 * q;
+            double root = 0.5 * (-p - std::sqrt(std::max(discriminant, 0.0)));
+            zLiquid[k] = (discriminant >= 0.0 && root > B[k]) ? root : zVapour[k];
+        }
+    }
+
+    if (phase == Phase::Vapour) {
+        std::copy(zVapour, zVapour + n, Z);
+    }
+    else if (phase == Phase::Liquid) {
+        std::copy(zLiquid, zLiquid + n, Z);
+    }
+    else {
+        // Residual Gibbs energy of each root, the lower one is stable
+        const double scale = 1.0 / (delta1 - delta2);
+        for (size_t k = 0; k < n; ++k) {
+            double zV = zVapour[k], zL = zLiquid[k];
+            double coefficient = A[k] / B[k] * scale;
+            double gV = zV - 1.0 - std::log(zV - B[k]) - coefficient * std::log((zV + delta1 * B[k]) / (zV + delta2 * B[k]));
+            double gL = zL - 1.0 - std::log(zL - B[k]) - coefficient * std::log((zL + delta1 * B[k]) / (zL + delta2 * B[k]));
+            Z[k] = gL < gV ? zL : zV;
+        }
+    }
+}
+
+void CubicEOS::ComputeProperties(PropertyBatch& batch) const
+{
+    const size_t n = batch.GetSize();
+    const size_t nc = components.size();
+    const double* T = batch.temperature.data();
+    const double* P = batch.pressure.data();
+    const double* Z = batch.compressibility.data();
+    const double scale = 1.0 / (delta1 - delta2);
+
+    const double* A = batch.A.data();
+    const double* B = batch.B.data();
+    const double* a = batch.a.data();
+    const double* dadT = batch.dadT.data();
+    const double* b = batch.b.data();
+    const double* mixtureMolarMass = batch.molarMass.data();
+    double* density = batch.density.data();
+    double* enthalpy = batch.enthalpy.data();
+
+    // Reuse zLiquid for ln((Z + delta1 B) / (Z + delta2 B)) and zVapour for ln(Z - B)
+    double* logRatio = batch.zLiquid.data();
+    double* logFree = batch.zVapour.data();
+
+    for (size_t k = 0; k < n; ++k) {
+        logRatio[k] = std::log((Z[k] + delta1 * B[k]) / (Z[k] + delta2 * B[k]));
+        logFree[k] = std::log(Z[k] - B[k]);
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+        density[k] = P[k] * 1e5 * mixtureMolarMass[k] / (Z[k] * GasConstant * T[k]);
+    }
+
+    // Residual enthalpy, the ideal gas part is added per component below
+    for (size_t k = 0; k < n; ++k) {
+        enthalpy[k] = GasConstant * T[k] * (Z[k] - 1.0) + (T[k] * dadT[k] - a[k]) / b[k] * scale * logRatio[k];
+    }
+
+    for (size_t i = 0; i < nc; ++i) {
+        const double* x = batch.moleFraction[i].data();
+        const double* sqrtA = batch.sqrtA[i].data();
+        const double* S = batch.mixingSum[i].data();
+        double* lnPhi = batch.lnFugacityCoefficient[i].data();
+
+        const double* cp = components[i].cp;
+        const double c0 = cp[0], c1 = cp[1] / 2.0, c2 = cp[2] / 3.0, c3 = cp[3] / 4.0;
+        const double T0 = ReferenceTemperature;
+        const double H0 = (((c3 * T0 + c2) * T0 + c1) * T0 + c0) * T0;
+        const double bI = bc[i];
+
+        // Ideal gas enthalpy from the heat capacity polynomial
+        for (size_t k = 0; k < n; ++k) {
+            enthalpy[k] += x[k] * ((((c3 * T[k] + c2) * T[k] + c1) * T[k] + c0) * T[k] - H0);
+        }
+
+        for (size_t k = 0; k < n; ++k) {
+            double bRatio = bI / b[k];
+            double aRatio = 2.0 * sqrtA[k] * S[k] / a[k];
+            lnPhi[k] = bRatio * (Z[k] - 1.0) - logFree[k] - A[k] / B[k] * scale * (aRatio - bRatio) * logRatio[k];
+        }
+    }
+}
+
+// Same equations as the runtime functions, run chunk by chunk on stack arrays so every loop stays
+// in cache and vectorises without aliasing checks. sqrt(T / Tc) is taken as sqrt(T) sqrt(1 / Tc).
+template <size_t N>
+void CubicEOS::EvaluateFixed(PropertyBatch& batch, Phase phase) const
+{
+    const size_t n = batch.GetSize();
+    const double scale = 1.0 / (delta1 - delta2);
+
+    double sqrtAc[N], sqrtInverseTc[N], kappaI[N], bI[N], molarMassI[N], dSqrtAFactor[N], weight[N * N];
+    double c0[N], c1[N], c2[N], c3[N], H0[N];
+    for (size_t i = 0; i < N; ++i) {
+        sqrtAc[i] = std::sqrt(ac[i]);
+        sqrtInverseTc[i] = std::sqrt(1.0 / criticalTemperature[i]);
+        kappaI[i] = kappa[i];
+        bI[i] = bc[i];
+        molarMassI[i] = molarMass[i];
+        dSqrtAFactor[i] = -kappa[i] * sqrtAc[i] * 0.5 * sqrtInverseTc[i];
+        for (size_t j = 0; j < N; ++j) weight[i * N + j] = 1.0 - kij[i * N + j];
+
+        const double* cp = components[i].cp;
+        c0[i] = cp[0];
+        c1[i] = cp[1] / 2.0;
+        c2[i] = cp[2] / 3.0;
+        c3[i] = cp[3] / 4.0;
+        const double T0 = ReferenceTemperature;
+        H0[i] = (((c3[i] * T0 + c2[i]) * T0 + c1[i]) * T0 + c0[i]) * T0;
+    }
+
+    for (size_t start = 0; start < n; start += FixedChunkSize) {
+        const size_t m = std::min(FixedChunkSize, n - start);
+        const double* T = batch.temperature.data() + start;
+        const double* P = batch.pressure.data() + start;
+
+        double x[N][FixedChunkSize], sqrtA[N][FixedChunkSize], S[N][FixedChunkSize];
+        double sqrtT[FixedChunkSize], a[FixedChunkSize], dadT[FixedChunkSize], b[FixedChunkSize], mixtureMolarMass[FixedChunkSize];
+        double A[FixedChunkSize], B[FixedChunkSize], zVapour[FixedChunkSize], zLiquid[FixedChunkSize], Z[FixedChunkSize];
+
+        // Mixing rules, see ComputeMixtureParameters
+        for (size_t k = 0; k < m; ++k) {
+            sqrtT[k] = std::sqrt(T[k]);
+            a[k] = dadT[k] = b[k] = mixtureMolarMass[k] = 0.0;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            const double* moleFraction = batch.moleFraction[i].data() + start;
+            for (size_t k = 0; k < m; ++k) {
+                x[i][k] = moleFraction[k];
+                sqrtA[i][k] = sqrtAc[i] * (1.0 + kappaI[i] * (1.0 - sqrtT[k] * sqrtInverseTc[i]));
+                b[k] += x[i][k] * bI[i];
+                mixtureMolarMass[k] += x[i][k] * molarMassI[i];
+            }
+        }
+        for (size_t i = 0; i < N; ++i) {
+            for (size_t k = 0; k < m; ++k) S[i][k] = 0.0;
+            for (size_t j = 0; j < N; ++j) {
+                const double weightIJ = weight[i * N + j];
+                for (size_t k = 0; k < m; ++k) S[i][k] += weightIJ * x[j][k] * sqrtA[j][k];
+            }
+            for (size_t k = 0; k < m; ++k) {
+                a[k] += x[i][k] * sqrtA[i][k] * S[i][k];
+                dadT[k] += 2.0 * x[i][k] * dSqrtAFactor[i] / sqrtT[k] * S[i][k];
+            }
+        }
+        for (size_t k = 0; k < m; ++k) {
+            const double RT = GasConstant * T[k];
+            const double pressure = P[k] * 1e5;
+            A[k] = a[k] * pressure / (RT * RT);
+            B[k] = b[k] * pressure / RT;
+        }
+
+        SolveCompressibility(A, B, zVapour, zLiquid, Z, m, phase);
+
+        // Properties, see ComputeProperties. zLiquid and zVapour take the logarithms.
+        double* logRatio = zLiquid;
+        double* logFree = zVapour;
+        double* density = batch.density.data() + start;
+        double* enthalpy = batch.enthalpy.data() + start;
+        for (size_t k = 0; k < m; ++k) {
+            logRatio[k] = std::log((Z[k] + delta1 * B[k]) / (Z[k] + delta2 * B[k]));
+            logFree[k] = std::log(Z[k] - B[k]);
+            density[k] = P[k] * 1e5 * mixtureMolarMass[k] / (Z[k] * GasConstant * T[k]);
+            enthalpy[k] = GasConstant * T[k] * (Z[k] - 1.0) + (T[k] * dadT[k] - a[k]) / b[k] * scale * logRatio[k];
+        }
+        for (size_t i = 0; i < N; ++i) {
+            double* lnPhi = batch.lnFugacityCoefficient[i].data() + start;
+            for (size_t k = 0; k < m; ++k) {
+                enthalpy[k] += x[i][k] * ((((c3[i] * T[k] + c2[i]) * T[k] + c1[i]) * T[k] + c0[i]) * T[k] - H0[i]);
+
+                const double bRatio = bI[i] / b[k];
+                const double aRatio = 2.0 * sqrtA[i][k] * S[i][k] / a[k];
+                lnPhi[k] = bRatio * (Z[k] - 1.0) - logFree[k] - A[k] / B[k] * scale * (aRatio - bRatio) * logRatio[k];
+            }
+        }
+        std::copy(Z, Z + m, batch.compressibility.begin() + start);
+        std::copy(mixtureMolarMass, mixtureMolarMass + m, batch.molarMass.begin() + start);
+    }
+}
+
+void CubicEOS::Evaluate(PropertyBatch& batch, Phase phase) const
+{
+    switch (kernel) {
+    case ComponentKernel::Two: EvaluateFixed<2>(batch, phase); return;
+    case ComponentKernel::Three: EvaluateFixed<3>(batch, phase); return;
+    case ComponentKernel::Four: EvaluateFixed<4>(batch, phase); return;
+    case ComponentKernel::Runtime: break;
+    }
+
+    ComputeMixtureParameters(batch);
+    SolveCompressibility(batch.A.data(), batch.B.data(), batch.zVapour.data(), batch.zLiquid.data(), batch.compressibility.data(), batch.GetSize(), phase);
+    ComputeProperties(batch);
+}
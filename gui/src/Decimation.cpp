@@ -0,0 +1,158 @@
+#include "Decimation.h"
+
+// STL Includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Lowest and highest point of every pixel column, in the order they occur
+    void DecimateMinMax(const double* x, const double* y, size_t first, size_t last, int pixels,
+        std::vector<double>& xOut, std::vector<double>& yOut)
+    {
+        const double lo = x[first];
+        const double width = (x[last - 1] - lo) / pixels;
+
+        xOut.push_back(x[first]);
+        yOut.push_back(y[first]);
+        size_t i = first + 1;
+        while (i + 1 < last) {
+            // Points up to the end of the column of point i
+            const double columnEnd = width > 0.0 ? lo + (std::floor((x[i] - lo) / width) + 1.0) * width : x[last - 1];
+            size_t lowest = i, highest = i, j = i + 1;
+            for (; j + 1 < last && x[j] < columnEnd; ++j) {
+                if (y[j] < y[lowest]) lowest = j;
+                if (y[j] > y[highest]) highest = j;
+            }
+
+            const size_t a = std::min(lowest, highest), b = std::max(lowest, highest);
+            xOut.push_back(x[a]);
+            yOut.push_back(y[a]);
+            if (b != a) {
+                xOut.push_back(x[b]);
+                yOut.push_back(y[b]);
+            }
+            i = j;
+        }
+        xOut.push_back(x[last - 1]);
+        yOut.push_back(y[last - 1]);
+    }
+
+    // Largest triangle three buckets: the ends, and from each of the buckets between them the
+    // point that spans the largest triangle with the point kept before it and the average of the
+    // next bucket
+    void DecimateLttb(const double* x, const double* y, size_t first, size_t last, size_t target,
+        std::vector<double>& xOut, std::vector<double>& yOut)
+    {
+        const double bucketSize = static_cast<double>(last - first - 2) / (target - 2);
+
+        xOut.push_back(x[first]);
+        yOut.push_back(y[first]);
+        size_t kept = first;
+        for (size_t b = 0; b + 2 < target; ++b) {
+            const size_t start = first + 1 + static_cast<size_t>(b * bucketSize);
+            const size_t end = first + 1 + static_cast<size_t>((b + 1) * bucketSize);
+            const size_t nextEnd = std::min(first + 1 + static_cast<size_t>((b + 2) * bucketSize), last);
+
+            double averageX = 0.0, averageY = 0.0;
+            for (size_t j = end; j < nextEnd; ++j) {
+                averageX += x[j];
+                averageY += y[j];
+            }
+            const size_t nextCount = nextEnd > end ? nextEnd - end : 0;
+            if (nextCount > 0) {
+                averageX /= nextCount;
+                averageY /= nextCount;
+            }
+            else {
+                averageX = x[last - 1];
+                averageY = y[last - 1];
+            }
+
+            size_t best = start;
+            double bestArea = -1.0;
+            for (size_t j = start; j < end; ++j) {
+                const double area = std::fabs((x[kept] - averageX) * (y[j] - y[kept]) - (x[kept] - x[j]) * (averageY - y[kept]));
+                if (area > bestArea) {
+                    bestArea = area;
+                    best = j;
+                }
+            }
+            xOut.push_back(x[best]);
+            yOut.push_back(y[best]);
+            kept = best;
+        }
+        xOut.push_back(x[last - 1]);
+        yOut.push_back(y[last - 1]);
+    }
+}
+
+const char* GetDecimationName(DecimationMethod method)
+{
+    switch (method) {
+    case DecimationMethod::None: return "None";
+    case DecimationMethod::MinMax: return "Min-max";
+    case DecimationMethod::Lttb: return "LTTB";
+    }
+    return "";
+}
+
+void DecimateSeries(DecimationMethod method, const double* x, const double* y, size_t count,
+    double xMin, double xMax, int pixels, std::vector<double>& xOut, std::vector<double>& yOut)
+{
+    xOut.clear();
+    yOut.clear();
+    if (count == 0) return;
+
+    // Points in the range, and one neighbour either side
+    size_t first = static_cast<size_t>(std::lower_bound(x, x + count, xMin) - x);
+    size_t last = static_cast<size_t>(std::upper_bound(x, x + count, xMax) - x);
+    if (first > 0) --first;
+    if (last < count) ++last;
+    if (last <= first) last = std::min(first + 1, count);
+
+    pixels = std::max(pixels, 1);
+    const size_t target = 2 * static_cast<size_t>(pixels);
+    const size_t visible = last - first;
+
+    if (first > 0) {
+        xOut.push_back(x[0]);
+        yOut.push_back(y[0]);
+    }
+
+    if (method == DecimationMethod::None || visible <= target + 2) {
+        xOut.insert(xOut.end(), x + first, x + last);
+        yOut.insert(yOut.end(), y + first, y + last);
+    }
+    else if (method == DecimationMethod::MinMax) {
+        DecimateMinMax(x, y, first, last, pixels, xOut, yOut);
+    }
+    else {
+        DecimateLttb(x, y, first, last, target, xOut, yOut);
+    }
+
+    if (last < count) {
+        xOut.push_back(x[count - 1]);
+        yOut.push_back(y[count - 1]);
+    }
+}
+
+void DecimatedSeries::Update(DecimationMethod method, const double* x, const double* y, size_t count, double xMin, double xMax, int pixels)
+{
+    const bool same = method == this->method && x == sourceX && y == sourceY && count == this->count
+        && xMin == this->xMin && xMax == this->xMax && pixels == this->pixels
+        && (count == 0 || (x[count - 1] == lastX && y[count - 1] == lastY));
+    if (same) return;
+
+    DecimateSeries(method, x, y, count, xMin, xMax, pixels, this->x, this->y);
+
+    this->method = method;
+    sourceX = x;
+    sourceY = y;
+    this->count = count;
+    lastX = count > 0 ? x[count - 1] : 0.0;
+    lastY = count > 0 ? y[count - 1] : 0.0;
+    this->xMin = xMin;
+    this->xMax = xMax;
+    this->pixels = pixels;
+}
@@ -0,0 +1,244 @@
+#include "EquationOrientedSolver.h"
+#include "Flowsheet.h"
+
+// STL Includes
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double InfinityNorm(const std::vector<double>& v)
+    {
+        double norm = 0.0;
+        for (double value : v) norm = std::max(norm, std::fabs(value));
+        return norm;
+    }
+
+    double TwoNorm(const std::vector<double>& v)
+    {
+        double sum = 0.0;
+        for (double value : v) sum += value * value;
+        return std::sqrt(sum);
+    }
+}
+
+bool EquationOrientedSolver::BuildSystem(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections, SolveReport& report)
+{
+    units.clear();
+    unknowns.clear();
+    links.clear();
+    numEquations = 0;
+
+    // Unknowns: calculated data variables and every output stream
+    std::unordered_map<const double*, int> unknownIndex;
+    auto addUnknown = [&](double* value) {
+        unknownIndex[value] = static_cast<int>(unknowns.size());
+        unknowns.push_back(value);
+    };
+
+    for (const auto& node : nodes) {
+        for (auto& variable : node->data) {
+            if (!variable.isSelected) addUnknown(&variable.value);
+        }
+        for (auto& point : node->outputs) {
+            addUnknown(&point.stream.pressure);
+            addUnknown(&point.stream.temperature);
+            addUnknown(&point.stream.massFlowRate);
+        }
+    }
+
+    // Connected inputs alias the upstream output stream. Unconnected inputs are fixed boundaries.
+    std::unordered_map<const double*, const double*> aliasOf;
+    for (const auto& connection : connections) {
+        if (!connection->from || !connection->to) continue;
+        Stream* to = &connection->to->stream;
+        const Stream* from = &connection->from->stream;
+        links.emplace_back(to, from);
+        aliasOf[&to->pressure] = &from->pressure;
+        aliasOf[&to->temperature] = &from->temperature;
+        aliasOf[&to->massFlowRate] = &from->massFlowRate;
+    }
+
+    std::vector<std::pair<int, int>> newPattern;
+    for (const auto& node : nodes) {
+        UnitEquations unit;
+        unit.node = node.get();
+        unit.numEquations = node->GetNumEquations();
+        if (unit.numEquations == 0) continue;
+
+        unit.firstEquation = numEquations;
+        unit.firstEntry = static_cast<int>(newPattern.size());
+        node->GetEquationVariables(unit.locals);
+
+        for (double* local : unit.locals) {
+            const double* storage = local;
+            auto alias = aliasOf.find(local);
+            if (alias != aliasOf.end()) storage = alias->second;
+
+            auto found = unknownIndex.find(storage);
+            unit.globalOfLocal.push_back(found != unknownIndex.end() ? found->second : -1);
+        }
+
+        for (int i = 0; i < unit.numEquations; ++i) {
+            for (int global : unit.globalOfLocal) {
+                if (global >= 0) newPattern.emplace_back(unit.firstEquation + i, global);
+            }
+        }
+
+        numEquations += unit.numEquations;
+        units.push_back(std::move(unit));
+    }
+
+    report.numEquations = numEquations;
+    report.numUnknowns = static_cast<int>(unknowns.size());
+
+    int degreesOfFreedom = report.numUnknowns - report.numEquations;
+    if (degreesOfFreedom > 0) {
+        report.message = "Under-specified: select " + std::to_string(degreesOfFreedom) + " more variable(s)";
+        return false;
+    }
+    if (degreesOfFreedom < 0) {
+        report.message = "Over-specified: deselect " + std::to_string(-degreesOfFreedom) + " variable(s)";
+        return false;
+    }
+
+    // Keep the symbolic factorisation while the structure is unchanged
+    if (newPattern != pattern) {
+        pattern = std::move(newPattern);
+        jacobian = SparseMatrix::FromPattern(numEquations, numEquations, pattern, slotOfEntry);
+        lu = SparseLU();
+    }
+
+    return true;
+}
+
+void EquationOrientedSolver::ScatterUnknowns(const std::vector<double>& x)
+{
+    for (size_t i = 0; i < unknowns.size(); ++i) {
+        *unknowns[i] = x[i];
+    }
+    for (auto& link : links) {
+        *link.first = *link.second;
+    }
+}
+
+void EquationOrientedSolver::GatherUnknowns(std::vector<double>& x) const
+{
+    x.resize(unknowns.size());
+    for (size_t i = 0; i < unknowns.size(); ++i) {
+        x[i] = *unknowns[i];
+    }
+}
+
+void EquationOrientedSolver::EvaluateResiduals(std::vector<double>& residuals)
+{
+    residuals.resize(numEquations);
+    std::vector<double> values;
+    for (const UnitEquations& unit : units) {
+        values.resize(unit.locals.size());
+        for (size_t j = 0; j < unit.locals.size(); ++j) values[j] = *unit.locals[j];
+        unit.node->EvaluateResiduals(values.data(), &residuals[unit.firstEquation]);
+    }
+}
+
+void EquationOrientedSolver::EvaluateJacobian()
+{
+    std::fill(jacobian.values.begin(), jacobian.values.end(), 0.0);
+
+    // Forward-mode AD: one residual evaluation per unknown local, seeded with derivative 1
+    std::vector<Dual> values, residuals;
+    for (const UnitEquations& unit : units) {
+        values.resize(unit.locals.size());
+        residuals.resize(unit.numEquations);
+        for (size_t j = 0; j < unit.locals.size(); ++j) values[j] = Dual(*unit.locals[j]);
+
+        int column = 0;
+        const int numColumns = static_cast<int>(std::count_if(unit.globalOfLocal.begin(), unit.globalOfLocal.end(), [](int g) { return g >= 0; }));
+
+        for (size_t j = 0; j < unit.locals.size(); ++j) {
+            if (unit.globalOfLocal[j] < 0) continue;
+
+            values[j].derivative = 1.0;
+            unit.node->EvaluateResiduals(values.data(), residuals.data());
+            values[j].derivative = 0.0;
+
+            for (int i = 0; i < unit.numEquations; ++i) {
+                int entry = unit.firstEntry + i * numColumns + column;
+                jacobian.values[slotOfEntry[entry]] += residuals[i].derivative;
+            }
+            ++column;
+        }
+    }
+}
+
+SolveReport EquationOrientedSolver::Solve(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections)
+{
+    // The whole system is solved at once, so every pending edit is consumed
+    for (const auto& node : nodes) {
+        node->isDirty = false;
+    }
+
+    SolveReport report;
+    if (!BuildSystem(nodes, connections, report))
+        return report;
+
+    if (numEquations == 0) {
+        report.converged = true;
+        report.message = "Nothing to solve";
+        return report;
+    }
+
+    std::vector<double> x, residuals, step, trial, trialResiduals;
+    GatherUnknowns(x);
+    ScatterUnknowns(x);
+    EvaluateResiduals(residuals);
+
+    for (int iteration = 0; iteration <= maxIterations; ++iteration) {
+        report.newtonIterations = iteration;
+        report.residualNorm = InfinityNorm(residuals);
+
+        if (report.residualNorm < tolerance) {
+            report.converged = true;
+            break;
+        }
+        if (iteration == maxIterations || !std::isfinite(report.residualNorm))
+            break;
+
+        EvaluateJacobian();
+        if (!lu.IsAnalyzed() || !lu.Factorize(jacobian)) {
+            if (!lu.Analyze(jacobian)) {
+                report.message = "Singular Jacobian, check the variable specification";
+                return report;
+            }
+        }
+
+        step.resize(numEquations);
+        for (int i = 0; i < numEquations; ++i) step[i] = -residuals[i];
+        lu.Solve(step);
+
+        // Backtracking line search on the residual 2-norm
+        double norm = TwoNorm(residuals);
+        double alpha = 1.0;
+        trial.resize(x.size());
+        while (true) {
+            for (size_t i = 0; i < x.size(); ++i) trial[i] = x[i] + alpha * step[i];
+            ScatterUnknowns(trial);
+            EvaluateResiduals(trialResiduals);
+
+            double trialNorm = TwoNorm(trialResiduals);
+            if ((std::isfinite(trialNorm) && trialNorm <= (1.0 - 1e-4 * alpha) * norm) || alpha < 1e-3)
+                break;
+            alpha *= 0.5;
+        }
+
+        x.swap(trial);
+        residuals.swap(trialResiduals);
+    }
+
+    report.numSymbolicFactorizations = lu.GetNumAnalyses();
+    report.message = report.converged
+        ? "Converged"
+        : "Newton did not converge (residual " + std::to_string(report.residualNorm) + ")";
+    return report;
+}
@@ -0,0 +1,784 @@
+#include "FlowsheetIO.h"
+
+// JSON Includes
+#include "nlohmann/json.hpp"
+
+// STL Includes
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <charconv>
+#include <type_traits>
+
+using nlohmann::json;
+
+namespace
+{
+    const char SnapshotMagic[4] = { 'T', 'H', 'X', 'F' };
+    const uint32_t SnapshotVersion = 1;
+
+    json StreamToJson(const Stream& stream)
+    {
+        return json{
+            { "pressure", stream.pressure },
+            { "temperature", stream.temperature },
+            { "massFlowRate", stream.massFlowRate }
+        };
+    }
+
+    json PortsToJson(const Node& node)
+    {
+        json ports = json::object();
+        for (const auto* points : { &node.inputs, &node.outputs }) {
+            for (const auto& point : *points) {
+                ports[point.name] = StreamToJson(point.stream);
+            }
+        }
+        return ports;
+    }
+
+    ConnectionPoint* FindPoint(std::vector<ConnectionPoint>& points, const std::string& name)
+    {
+        for (auto& point : points) {
+            if (point.name == name) return &point;
+        }
+        return nullptr;
+    }
+
+    // Connects an outlet to an inlet of another unit, shared by both encodings
+    bool ConnectPorts(Flowsheet& flowsheet, Node* fromNode, ConnectionPoint* from, Node* toNode, ConnectionPoint* to, std::string& error)
+    {
+        if (!fromNode || !toNode) {
+            error = "Stream refers to a unit that does not exist";
+            return false;
+        }
+        if (!from || from->isInput || !to || !to->isInput || !flowsheet.Connect(from, to)) {
+            error = "Invalid stream from \"" + fromNode->name + "\" to \"" + toNode->name + "\"";
+            return false;
+        }
+        return true;
+    }
+
+    // Builds the flowsheet straight from the parser events, without a document tree. Keys may
+    // come in any order (nlohmann writes them alphabetically), so a unit is only created once
+    // its object ends and streams are connected after the whole file, when every unit exists
+    // and the version is known.
+    class FlowsheetReader : public nlohmann::json_sax<json> {
+    public:
+        FlowsheetReader(const NodeFactory& factory, Flowsheet& flowsheet, std::string& error)
+            : factory(factory), flowsheet(flowsheet), error(error) {}
+
+        bool null() override { return true; }
+        bool boolean(bool value) override
+        {
+            if (Top() == Scope::Variable && currentKey == "selected") {
+                variable->selected = value;
+                variable->hasSelected = true;
+            }
+            return true;
+        }
+        bool number_integer(number_integer_t value) override { return Number(static_cast<double>(value)); }
+        bool number_unsigned(number_unsigned_t value) override { return Number(static_cast<double>(value)); }
+        bool number_float(number_float_t value, const string_t&) override { return Number(value); }
+        bool binary(binary_t&) override { return true; }
+
+        bool string(string_t& value) override
+        {
+            if (Top() == Scope::Unit && currentKey == "type") unit.type = value;
+            else if (Top() == Scope::Unit && currentKey == "name") {
+                unit.name = value;
+                unit.hasName = true;
+            }
+            else if (Top() == Scope::End && currentKey == "port") {
+                end->portName = value;
+                end->byName = true;
+            }
+            return true;
+        }
+
+        bool key(string_t& value) override
+        {
+            currentKey = value;
+            return true;
+        }
+
+        bool start_object(std::size_t) override
+        {
+            Scope next = Scope::Skip;
+            if (scopes.empty()) next = Scope::Root;
+            else if (Top() == Scope::Units) {
+                next = Scope::Unit;
+                BeginUnit();
+            }
+            else if (Top() == Scope::Unit && currentKey == "data") next = Scope::Data;
+            else if (Top() == Scope::Unit && currentKey == "ports") next = Scope::Ports;
+            else if (Top() == Scope::Data) {
+                next = Scope::Variable;
+                variable = &Append(unit.data, unit.numData);
+                variable->parameter = currentKey;
+                variable->hasValue = variable->hasSelected = false;
+            }
+            else if (Top() == Scope::Ports) {
+                next = Scope::Port;
+                port = &Append(unit.ports, unit.numPorts);
+                port->name = currentKey;
+                port->has[0] = port->has[1] = port->has[2] = false;
+            }
+            else if (Top() == Scope::Streams) {
+                next = Scope::Stream;
+                stream = StreamRecord();
+            }
+            else if (Top() == Scope::Stream && (currentKey == "from" || currentKey == "to")) {
+                next = Scope::End;
+                end = currentKey == "from" ? &stream.from : &stream.to;
+            }
+            scopes.push_back(next);
+            return true;
+        }
+
+        bool end_object() override
+        {
+            const Scope scope = Top();
+            scopes.pop_back();
+            if (scope == Scope::Unit) return FinishUnit();
+            if (scope == Scope::Stream) streams.push_back(stream);
+            return true;
+        }
+
+        bool start_array(std::size_t) override
+        {
+            if (scopes.empty()) {
+                error = "Not a flowsheet file";
+                return false;
+            }
+
+            Scope next = Scope::Skip;
+            if (Top() == Scope::Root && currentKey == "units") {
+                next = Scope::Units;
+                hasUnits = true;
+            }
+            else if (Top() == Scope::Root && currentKey == "streams") next = Scope::Streams;
+            else if (Top() == Scope::Unit && currentKey == "position") {
+                next = Scope::Position;
+                positionIndex = 0;
+            }
+            scopes.push_back(next);
+            return true;
+        }
+
+        bool end_array() override
+        {
+            scopes.pop_back();
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) override
+        {
+            error = e.what();
+            return false;
+        }
+
+        // Checks the version and connects the streams once the whole file is read
+        bool Finish()
+        {
+            if (!hasUnits) {
+                error = "Not a flowsheet file";
+                return false;
+            }
+            if (version > FlowsheetVersion) {
+                error = "Flowsheet file version " + std::to_string(version) + " is newer than this build";
+                return false;
+            }
+
+            for (const auto& record : streams) {
+                Node* fromNode = FindNode(record.from);
+                Node* toNode = FindNode(record.to);
+                if (!ConnectPorts(flowsheet, fromNode, FindPort(fromNode, record.from, false), toNode, FindPort(toNode, record.to, true), error))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        enum class Scope { Root, Units, Unit, Position, Data, Variable, Ports, Port, Streams, Stream, End, Skip };
+
+        struct VariableRecord {
+            std::string parameter;
+            double value = 0.0;
+            bool hasValue = false;
+            bool selected = false;
+            bool hasSelected = false;
+        };
+
+        struct PortRecord {
+            std::string name;
+            double values[3] = {};              // Pressure, temperature, mass flow rate
+            bool has[3] = {};
+        };
+
+        // Records are reused from unit to unit, so their strings keep their capacity
+        struct UnitRecord {
+            std::string type;
+            std::string name;
+            bool hasName = false;
+            uint32_t id = 0;
+            Vec2 pos;
+            std::vector<VariableRecord> data;
+            size_t numData = 0;
+            std::vector<PortRecord> ports;
+            size_t numPorts = 0;
+        };
+
+        // One end of a stream: a unit id (a unit index before version 2) and a port id or name
+        struct EndRecord {
+            uint32_t unit = 0;
+            uint32_t port = 0;
+            std::string portName;
+            bool byName = false;
+        };
+
+        struct StreamRecord {
+            EndRecord from;
+            EndRecord to;
+        };
+
+        Scope Top() const { return scopes.empty() ? Scope::Skip : scopes.back(); }
+
+        template <typename T>
+        static T& Append(std::vector<T>& records, size_t& count)
+        {
+            if (count == records.size()) records.emplace_back();
+            return records[count++];
+        }
+
+        bool Number(double value)
+        {
+            const uint32_t index = value > 0.0 ? static_cast<uint32_t>(value) : 0;
+            switch (Top()) {
+            case Scope::Root:
+                if (currentKey == "version") version = static_cast<int>(value);
+                break;
+            case Scope::Unit:
+                if (currentKey == "id") unit.id = index;
+                break;
+            case Scope::Position:
+                if (positionIndex == 0) unit.pos.x = static_cast<float>(value);
+                else if (positionIndex == 1) unit.pos.y = static_cast<float>(value);
+                ++positionIndex;
+                break;
+            case Scope::Variable:
+                if (currentKey == "value") {
+                    variable->value = value;
+                    variable->hasValue = true;
+                }
+                break;
+            case Scope::Port: {
+                const int field = currentKey == "pressure" ? 0 : currentKey == "temperature" ? 1 : currentKey == "massFlowRate" ? 2 : -1;
+                if (field >= 0) {
+                    port->values[field] = value;
+                    port->has[field] = true;
+                }
+                break;
+            }
+            case Scope::End:
+                if (currentKey == "unit") end->unit = index;
+                else if (currentKey == "port") {
+                    end->port = index;
+                    end->byName = false;
+                }
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+
+        void BeginUnit()
+        {
+            unit.type.clear();
+            unit.name.clear();
+            unit.hasName = false;
+            unit.id = 0;
+            unit.pos = Vec2();
+            unit.numData = 0;
+            unit.numPorts = 0;
+        }
+
+        bool FinishUnit()
+        {
+            if (unit.name.size() > Node::MaxNameLength) {
+                error = "Unit name longer than " + std::to_string(Node::MaxNameLength) + " characters";
+                return false;
+            }
+            auto node = factory.CreateNode(unit.type, unit.hasName ? unit.name : unit.type, unit.pos);
+            if (!node) {
+                error = "Unknown unit type \"" + unit.type + "\"";
+                return false;
+            }
+
+            for (size_t i = 0; i < unit.numData; ++i) {
+                const VariableRecord& record = unit.data[i];
+                for (auto& variable : node->data) {
+                    if (variable.parameter != record.parameter) continue;
+                    if (record.hasValue) variable.value = record.value;
+                    if (record.hasSelected) variable.isSelected = record.selected;
+                    break;
+                }
+            }
+
+            for (size_t i = 0; i < unit.numPorts; ++i) {
+                const PortRecord& record = unit.ports[i];
+                ConnectionPoint* point = FindPoint(node->inputs, record.name);
+                if (!point) point = FindPoint(node->outputs, record.name);
+                if (!point) continue;
+                if (record.has[0]) point->stream.pressure = record.values[0];
+                if (record.has[1]) point->stream.temperature = record.values[1];
+                if (record.has[2]) point->stream.massFlowRate = record.values[2];
+            }
+
+            node->id = unit.id;
+            Node* added = flowsheet.AddNode(std::move(node));
+            if (!nodeById.emplace(added->id, added).second) {
+                error = "Two units share the id " + std::to_string(added->id);
+                return false;
+            }
+            return true;
+        }
+
+        Node* FindNode(const EndRecord& record) const
+        {
+            if (version < 2) return record.unit < flowsheet.nodes.size() ? flowsheet.nodes[record.unit].get() : nullptr;
+            auto found = nodeById.find(record.unit);
+            return found != nodeById.end() ? found->second : nullptr;
+        }
+
+        static ConnectionPoint* FindPort(Node* node, const EndRecord& record, bool isInput)
+        {
+            if (!node) return nullptr;
+            if (record.byName) return FindPoint(isInput ? node->inputs : node->outputs, record.portName);
+            return node->FindPoint(record.port);
+        }
+
+        const NodeFactory& factory;
+        Flowsheet& flowsheet;
+        std::string& error;
+
+        std::vector<Scope> scopes;
+        std::string currentKey;
+        int version = 1;                        // Files without a version are version 1
+        bool hasUnits = false;
+
+        UnitRecord unit;
+        VariableRecord* variable = nullptr;
+        PortRecord* port = nullptr;
+        int positionIndex = 0;
+
+        StreamRecord stream;
+        EndRecord* end = nullptr;
+        std::vector<StreamRecord> streams;
+        std::unordered_map<uint32_t, Node*> nodeById;
+    };
+
+    // JSON text written directly, one unit or stream per line, rather than through a document.
+    // Numbers use the shortest text that reads back to the same value.
+    class JsonWriter {
+    public:
+        void String(const std::string& text)
+        {
+            out += '"';
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out += escaped;
+                }
+                else out += c;
+            }
+            out += '"';
+        }
+
+        template <typename T>
+        void Number(T value)
+        {
+            // JSON has no NaN or infinity, they are written as null like nlohmann does
+            if constexpr (std::is_floating_point_v<T>) {
+                if (!std::isfinite(value)) {
+                    out += "null";
+                    return;
+                }
+            }
+            char text[32];
+            const auto result = std::to_chars(text, text + sizeof(text), value);
+            out.append(text, result.ptr);
+        }
+
+        std::string out;
+    };
+
+    // Little endian snapshot encoding
+    class SnapshotWriter {
+    public:
+        template <typename T>
+        void Write(T value) { bytes.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+        void WriteString(const std::string& text)
+        {
+            const uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), 65535));
+            Write(length);
+            bytes.append(text.data(), length);
+        }
+
+        std::string bytes;
+    };
+
+    // Bounds checked reads of a snapshot
+    class SnapshotReader {
+    public:
+        explicit SnapshotReader(const std::string& data) : data(data) {}
+
+        template <typename T>
+        bool Read(T& value)
+        {
+            if (position + sizeof(T) > data.size()) return false;
+            std::memcpy(&value, data.data() + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        bool ReadString(std::string& text)
+        {
+            uint16_t length = 0;
+            if (!Read(length) || position + length > data.size()) return false;
+            text.assign(data.data() + position, length);
+            position += length;
+            return true;
+        }
+
+        size_t GetRemaining() const { return data.size() - position; }
+
+    private:
+        const std::string& data;
+        size_t position = 0;
+    };
+
+    // Parameter names and port count of a unit type, written once per type
+    struct SnapshotType {
+        std::string name;
+        std::vector<std::string> parameters;
+        uint16_t numPorts = 0;
+        std::vector<int> dataIndex;             // Saved parameter to index in Node::data, -1 if gone
+        bool isMapped = false;
+    };
+}
+
+std::string SaveFlowsheet(const Flowsheet& flowsheet)
+{
+    JsonWriter writer;
+    writer.out.reserve(64 + flowsheet.nodes.size() * 512);
+
+    writer.out += "{\"version\":";
+    writer.Number(static_cast<uint32_t>(FlowsheetVersion));
+    writer.out += ",\n\"units\":[";
+    for (size_t i = 0; i < flowsheet.nodes.size(); ++i) {
+        const Node& node = *flowsheet.nodes[i];
+        writer.out += i == 0 ? "\n{\"id\":" : ",\n{\"id\":";
+        writer.Number(node.id);
+        writer.out += ",\"type\":";
+        writer.String(node.type);
+        writer.out += ",\"name\":";
+        writer.String(node.name);
+        writer.out += ",\"position\":[";
+        writer.Number(node.pos.x);
+        writer.out += ',';
+        writer.Number(node.pos.y);
+
+        writer.out += "],\"data\":{";
+        for (size_t j = 0; j < node.data.size(); ++j) {
+            if (j > 0) writer.out += ',';
+            writer.String(node.data[j].parameter);
+            writer.out += ":{\"value\":";
+            writer.Number(node.data[j].value);
+            writer.out += node.data[j].isSelected ? ",\"selected\":true}" : ",\"selected\":false}";
+        }
+
+        writer.out += "},\"ports\":{";
+        bool first = true;
+        for (const auto* points : { &node.inputs, &node.outputs }) {
+            for (const auto& point : *points) {
+                if (!first) writer.out += ',';
+                first = false;
+                writer.String(point.name);
+                writer.out += ":{\"id\":";
+                writer.Number(point.id);
+                writer.out += ",\"pressure\":";
+                writer.Number(point.stream.pressure);
+                writer.out += ",\"temperature\":";
+                writer.Number(point.stream.temperature);
+                writer.out += ",\"massFlowRate\":";
+                writer.Number(point.stream.massFlowRate);
+                writer.out += '}';
+            }
+        }
+        writer.out += "}}";
+    }
+
+    writer.out += "\n],\n\"streams\":[";
+    bool first = true;
+    for (const auto& connection : flowsheet.connections) {
+        if (!connection->from || !connection->to) continue;
+        writer.out += first ? "\n{\"from\":{\"unit\":" : ",\n{\"from\":{\"unit\":";
+        first = false;
+        writer.Number(connection->from->node->id);
+        writer.out += ",\"port\":";
+        writer.Number(connection->from->id);
+        writer.out += "},\"to\":{\"unit\":";
+        writer.Number(connection->to->node->id);
+        writer.out += ",\"port\":";
+        writer.Number(connection->to->id);
+        writer.out += "}}";
+    }
+    writer.out += "\n]}\n";
+
+    return std::move(writer.out);
+}
+
+bool LoadFlowsheet(const std::string& text, const NodeFactory& factory, Flowsheet& flowsheet, std::string& error)
+{
+    flowsheet.Clear();
+
+    FlowsheetReader reader(factory, flowsheet, error);
+    if (!json::sax_parse(text, &reader) || !reader.Finish()) {
+        flowsheet.Clear();
+        return false;
+    }
+    return true;
+}
+
+std::string SaveFlowsheetSnapshot(const Flowsheet& flowsheet)
+{
+    std::vector<SnapshotType> types;
+    std::unordered_map<std::string, uint32_t> typeIndex;
+    std::vector<uint32_t> unitTypes;
+    unitTypes.reserve(flowsheet.nodes.size());
+
+    for (const auto& node : flowsheet.nodes) {
+        auto found = typeIndex.emplace(node->type, static_cast<uint32_t>(types.size()));
+        if (found.second) {
+            SnapshotType type;
+            type.name = node->type;
+            for (const auto& variable : node->data) type.parameters.push_back(variable.parameter);
+            type.numPorts = static_cast<uint16_t>(node->GetNumPoints());
+            types.push_back(std::move(type));
+        }
+        unitTypes.push_back(found.first->second);
+    }
+
+    size_t numStreams = 0;
+    for (const auto& connection : flowsheet.connections) {
+        if (connection->from && connection->to) ++numStreams;
+    }
+
+    SnapshotWriter writer;
+    writer.bytes.reserve(64 + flowsheet.nodes.size() * 128 + numStreams * 16);
+    writer.bytes.append(SnapshotMagic, sizeof(SnapshotMagic));
+    writer.Write(SnapshotVersion);
+    writer.Write(static_cast<uint32_t>(types.size()));
+    writer.Write(static_cast<uint32_t>(flowsheet.nodes.size()));
+    writer.Write(static_cast<uint32_t>(numStreams));
+
+    for (const auto& type : types) {
+        writer.WriteString(type.name);
+        writer.Write(static_cast<uint16_t>(type.parameters.size()));
+        for (const auto& parameter : type.parameters) writer.WriteString(parameter);
+        writer.Write(type.numPorts);
+    }
+
+    // Units of one type share the layout their constructor registers, so only values are written
+    for (size_t i = 0; i < flowsheet.nodes.size(); ++i) {
+        const Node& node = *flowsheet.nodes[i];
+        const SnapshotType& type = types[unitTypes[i]];
+        writer.Write(unitTypes[i]);
+        writer.Write(node.id);
+        writer.WriteString(node.name);
+        writer.Write(node.pos.x);
+        writer.Write(node.pos.y);
+        for (size_t j = 0; j < type.parameters.size(); ++j) writer.Write(j < node.data.size() ? node.data[j].value : 0.0);
+        for (size_t j = 0; j < type.parameters.size(); ++j) writer.Write(static_cast<uint8_t>(j < node.data.size() && node.data[j].isSelected));
+        for (uint32_t id = 0; id < type.numPorts; ++id) {
+            const ConnectionPoint* point = node.FindPoint(id);
+            const Stream stream = point ? point->stream : Stream();
+            writer.Write(stream.pressure);
+            writer.Write(stream.temperature);
+            writer.Write(stream.massFlowRate);
+        }
+    }
+
+    for (const auto& connection : flowsheet.connections) {
+        if (!connection->from || !connection->to) continue;
+        writer.Write(connection->from->node->id);
+        writer.Write(connection->from->id);
+        writer.Write(connection->to->node->id);
+        writer.Write(connection->to->id);
+    }
+
+    return std::move(writer.bytes);
+}
+
+bool IsFlowsheetSnapshot(const std::string& data)
+{
+    return data.size() >= sizeof(SnapshotMagic) && std::memcmp(data.data(), SnapshotMagic, sizeof(SnapshotMagic)) == 0;
+}
+
+bool LoadFlowsheetSnapshot(const std::string& data, const NodeFactory& factory, Flowsheet& flowsheet, std::string& error)
+{
+    flowsheet.Clear();
+
+    if (!IsFlowsheetSnapshot(data)) {
+        error = "Not a flowsheet snapshot";
+        return false;
+    }
+
+    SnapshotReader reader(data);
+    uint32_t magic = 0, version = 0, numTypes = 0, numUnits = 0, numStreams = 0;
+    if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(numTypes) || !reader.Read(numUnits) || !reader.Read(numStreams)) {
+        error = "Flowsheet snapshot is truncated";
+        return false;
+    }
+    if (version > SnapshotVersion) {
+        error = "Flowsheet snapshot version " + std::to_string(version) + " is newer than this build";
+        return false;
+    }
+
+    auto fail = [&](const std::string& message) {
+        error = message;
+        flowsheet.Clear();
+        return false;
+    };
+
+    // Every type needs at least its name length, parameter count and port count
+    if (numTypes > reader.GetRemaining() / 6) return fail("Flowsheet snapshot is truncated");
+    std::vector<SnapshotType> types(numTypes);
+    for (auto& type : types) {
+        uint16_t numParameters = 0;
+        if (!reader.ReadString(type.name) || !reader.Read(numParameters)) return fail("Flowsheet snapshot is truncated");
+        type.parameters.resize(numParameters);
+        for (auto& parameter : type.parameters) {
+            if (!reader.ReadString(parameter)) return fail("Flowsheet snapshot is truncated");
+        }
+        if (!reader.Read(type.numPorts)) return fail("Flowsheet snapshot is truncated");
+    }
+
+    std::unordered_map<uint32_t, Node*> nodeById;
+    const size_t expectedUnits = std::min<size_t>(numUnits, reader.GetRemaining() / 18);
+    flowsheet.nodes.reserve(expectedUnits);
+    nodeById.reserve(expectedUnits);
+
+    std::string name;
+    std::vector<double> values;
+    for (uint32_t i = 0; i < numUnits; ++i) {
+        uint32_t typeIndex = 0, id = 0;
+        Vec2 pos;
+        if (!reader.Read(typeIndex) || !reader.Read(id) || !reader.ReadString(name) || !reader.Read(pos.x) || !reader.Read(pos.y))
+            return fail("Flowsheet snapshot is truncated");
+        if (typeIndex >= types.size()) return fail("Flowsheet snapshot refers to a unit type that does not exist");
+        if (name.size() > Node::MaxNameLength) return fail("Unit name longer than " + std::to_string(Node::MaxNameLength) + " characters");
+
+        SnapshotType& type = types[typeIndex];
+        auto node = factory.CreateNode(type.name, name, pos);
+        if (!node) return fail("Unknown unit type \"" + type.name + "\"");
+
+        // Parameters are matched by name once per type, so a unit that gained or lost a
+        // parameter since the snapshot was taken still loads
+        if (!type.isMapped) {
+            for (const auto& parameter : type.parameters) {
+                int index = -1;
+                for (size_t j = 0; j < node->data.size(); ++j) {
+                    if (node->data[j].parameter == parameter) index = static_cast<int>(j);
+                }
+                type.dataIndex.push_back(index);
+            }
+            type.isMapped = true;
+        }
+
+        const size_t numParameters = type.parameters.size();
+        values.resize(numParameters);
+        for (double& value : values) {
+            if (!reader.Read(value)) return fail("Flowsheet snapshot is truncated");
+        }
+        for (size_t j = 0; j < numParameters; ++j) {
+            uint8_t selected = 0;
+            if (!reader.Read(selected)) return fail("Flowsheet snapshot is truncated");
+            const int index = type.dataIndex[j];
+            if (index < 0) continue;
+            node->data[index].value = values[j];
+            node->data[index].isSelected = selected != 0;
+        }
+        for (uint32_t portId = 0; portId < type.numPorts; ++portId) {
+            Stream stream;
+            if (!reader.Read(stream.pressure) || !reader.Read(stream.temperature) || !reader.Read(stream.massFlowRate))
+                return fail("Flowsheet snapshot is truncated");
+            if (ConnectionPoint* point = node->FindPoint(portId)) point->stream = stream;
+        }
+
+        node->id = id;
+        Node* added = flowsheet.AddNode(std::move(node));
+        if (!nodeById.emplace(added->id, added).second) return fail("Two units share the id " + std::to_string(added->id));
+    }
+
+    if (numStreams > reader.GetRemaining() / 16) return fail("Flowsheet snapshot is truncated");
+    flowsheet.connections.reserve(numStreams);
+    for (uint32_t i = 0; i < numStreams; ++i) {
+        uint32_t fromUnit = 0, fromPort = 0, toUnit = 0, toPort = 0;
+        reader.Read(fromUnit);
+        reader.Read(fromPort);
+        reader.Read(toUnit);
+        reader.Read(toPort);
+
+        auto from = nodeById.find(fromUnit);
+        auto to = nodeById.find(toUnit);
+        Node* fromNode = from != nodeById.end() ? from->second : nullptr;
+        Node* toNode = to != nodeById.end() ? to->second : nullptr;
+        if (!ConnectPorts(flowsheet, fromNode, fromNode ? fromNode->FindPoint(fromPort) : nullptr, toNode, toNode ? toNode->FindPoint(toPort) : nullptr, error)) {
+            flowsheet.Clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string SaveResults(const Flowsheet& flowsheet, const SolveReport& report)
+{
+    json units = json::array();
+    for (const auto& node : flowsheet.nodes) {
+        json data = json::object();
+        for (const auto& variable : node->data) {
+            data[variable.parameter] = variable.value;
+        }
+        units.push_back({
+            { "name", node->name },
+            { "type", node->type },
+            { "data", data },
+            { "ports", PortsToJson(*node) }
+        });
+    }
+
+    json summary = {
+        { "converged", report.converged },
+        { "message", report.message },
+        { "unitsEvaluated", report.unitsEvaluated },
+        { "maxRecycleIterations", report.maxRecycleIterations },
+        { "numTearStreams", report.numTearStreams },
+        { "numEquations", report.numEquations },
+        { "newtonIterations", report.newtonIterations },
+        { "residualNorm", report.residualNorm }
+    };
+
+    return json{ { "report", summary }, { "units", units } }.dump(2);
+}
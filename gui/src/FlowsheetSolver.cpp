@@ -0,0 +1,457 @@
+#include "FlowsheetSolver.h"
+#include "Flowsheet.h"
+
+// STL Includes
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <cmath>
+
+namespace
+{
+    // Iterative Tarjan. Components are returned in reverse topological order.
+    std::vector<std::vector<int>> FindStronglyConnectedComponents(const FlowsheetGraph& graph)
+    {
+        const int n = static_cast<int>(graph.units.size());
+        std::vector<int> index(n, -1), lowLink(n, 0);
+        std::vector<bool> onStack(n, false);
+        std::vector<int> stack;
+        std::vector<std::vector<int>> components;
+        int counter = 0;
+
+        // (unit, next outgoing edge position)
+        std::vector<std::pair<int, size_t>> callStack;
+
+        for (int root = 0; root < n; ++root) {
+            if (index[root] != -1) continue;
+
+            callStack.emplace_back(root, 0);
+            while (!callStack.empty()) {
+                int v = callStack.back().first;
+                size_t& edge = callStack.back().second;
+
+                if (edge == 0 && index[v] == -1) {
+                    index[v] = lowLink[v] = counter++;
+                    stack.push_back(v);
+                    onStack[v] = true;
+                }
+
+                if (edge < graph.outgoing[v].size()) {
+                    int w = graph.streamTo[graph.outgoing[v][edge++]];
+                    if (index[w] == -1) {
+                        callStack.emplace_back(w, 0);
+                    }
+                    else if (onStack[w]) {
+                        lowLink[v] = std::min(lowLink[v], index[w]);
+                    }
+                    continue;
+                }
+
+                if (lowLink[v] == index[v]) {
+                    std::vector<int> component;
+                    int w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = false;
+                        component.push_back(w);
+                    } while (w != v);
+                    components.push_back(std::move(component));
+                }
+
+                callStack.pop_back();
+                if (!callStack.empty()) {
+                    int parent = callStack.back().first;
+                    lowLink[parent] = std::min(lowLink[parent], lowLink[v]);
+                }
+            }
+        }
+
+        return components;
+    }
+}
+
+void FlowsheetGraph::Build(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections)
+{
+    *this = FlowsheetGraph();
+
+    std::unordered_map<const Node*, int> unitIndex;
+    for (const auto& node : nodes) {
+        unitIndex[node.get()] = static_cast<int>(units.size());
+        units.push_back(node.get());
+    }
+
+    incoming.resize(units.size());
+    outgoing.resize(units.size());
+
+    for (const auto& connection : connections) {
+        if (!connection->from || !connection->to) continue;
+
+        auto fromIt = unitIndex.find(connection->from->node);
+        auto toIt = unitIndex.find(connection->to->node);
+        if (fromIt == unitIndex.end() || toIt == unitIndex.end()) continue;
+
+        int s = static_cast<int>(streams.size());
+        streams.push_back(connection.get());
+        streamFrom.push_back(fromIt->second);
+        streamTo.push_back(toIt->second);
+        outgoing[fromIt->second].push_back(s);
+        incoming[toIt->second].push_back(s);
+    }
+
+    isTear.assign(streams.size(), false);
+    blockOfUnit.assign(units.size(), -1);
+
+    // Tarjan gives reverse topological order
+    std::vector<std::vector<int>> components = FindStronglyConnectedComponents(*this);
+    std::reverse(components.begin(), components.end());
+
+    blocks.resize(components.size());
+    for (size_t b = 0; b < components.size(); ++b) {
+        for (int unit : components[b]) {
+            blockOfUnit[unit] = static_cast<int>(b);
+        }
+    }
+
+    for (size_t b = 0; b < components.size(); ++b) {
+        Block& block = blocks[b];
+        const std::vector<int>& members = components[b];
+
+        // Tear the back edges of a depth first search restricted to the block.
+        // Removing them leaves the block acyclic.
+        std::unordered_map<int, int> state; // 0 = unvisited, 1 = on path, 2 = done
+        for (int unit : members) state[unit] = 0;
+
+        for (int root : members) {
+            if (state[root] != 0) continue;
+
+            std::vector<std::pair<int, size_t>> path;
+            path.emplace_back(root, 0);
+            state[root] = 1;
+
+            while (!path.empty()) {
+                int v = path.back().first;
+                size_t& edge = path.back().second;
+
+                if (edge < outgoing[v].size()) {
+                    int s = outgoing[v][edge++];
+                    int w = streamTo[s];
+                    if (blockOfUnit[w] != static_cast<int>(b)) continue;
+
+                    if (state[w] == 1) {
+                        isTear[s] = true;
+                        block.tears.push_back(s);
+                    }
+                    else if (state[w] == 0) {
+                        state[w] = 1;
+                        path.emplace_back(w, 0);
+                    }
+                    continue;
+                }
+
+                state[v] = 2;
+                path.pop_back();
+            }
+        }
+
+        // Order the units of the block with the tear streams removed (Kahn's algorithm)
+        std::unordered_map<int, int> inDegree;
+        for (int unit : members) inDegree[unit] = 0;
+        for (int unit : members) {
+            for (int s : outgoing[unit]) {
+                if (!isTear[s] && blockOfUnit[streamTo[s]] == static_cast<int>(b))
+                    ++inDegree[streamTo[s]];
+            }
+        }
+
+        std::vector<int> ready;
+        for (int unit : members) {
+            if (inDegree[unit] == 0) ready.push_back(unit);
+        }
+
+        while (!ready.empty()) {
+            int unit = ready.back();
+            ready.pop_back();
+            block.units.push_back(unit);
+
+            for (int s : outgoing[unit]) {
+                int w = streamTo[s];
+                if (isTear[s] || blockOfUnit[w] != static_cast<int>(b)) continue;
+                if (--inDegree[w] == 0) ready.push_back(w);
+            }
+        }
+
+        // Links to downstream blocks
+        for (int unit : members) {
+            for (int s : outgoing[unit]) {
+                int target = blockOfUnit[streamTo[s]];
+                if (target != static_cast<int>(b))
+                    block.successors.push_back(target);
+            }
+        }
+
+        std::sort(block.successors.begin(), block.successors.end());
+        block.successors.erase(std::unique(block.successors.begin(), block.successors.end()), block.successors.end());
+    }
+
+    for (const Block& block : blocks) {
+        for (int successor : block.successors) {
+            ++blocks[successor].numPredecessors;
+        }
+    }
+}
+
+bool FlowsheetGraph::Matches(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections) const
+{
+    if (nodes.size() != units.size()) return false;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].get() != units[i]) return false;
+    }
+
+    size_t s = 0;
+    for (const auto& connection : connections) {
+        if (!connection->from || !connection->to) continue;
+        if (s >= streams.size() || streams[s] != connection.get() ||
+            units[streamFrom[s]] != connection->from->node || units[streamTo[s]] != connection->to->node)
+            return false;
+        ++s;
+    }
+    return s == streams.size();
+}
+
+FlowsheetSolver::FlowsheetSolver(size_t numThreads)
+    : pool(numThreads)
+{
+}
+
+SolveReport FlowsheetSolver::Solve(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections)
+{
+    graph.Build(nodes, connections);
+    for (Node* unit : graph.units) {
+        unit->isDirty = true;
+    }
+    return SolveStale();
+}
+
+SolveReport FlowsheetSolver::SolveIncremental(const std::vector<std::unique_ptr<Node>>& nodes, const std::vector<std::unique_ptr<Connection>>& connections)
+{
+    // Structural edits mark the affected nodes dirty themselves, so a rebuilt graph
+    // still only needs the stale part solved.
+    if (!graph.Matches(nodes, connections))
+        graph.Build(nodes, connections);
+
+    return SolveStale();
+}
+
+bool FlowsheetSolver::BlockNeedsSolve(int b) const
+{
+    for (int unit : graph.blocks[b].units) {
+        if (graph.units[unit]->isDirty) return true;
+
+        for (int s : graph.incoming[unit]) {
+            if (graph.blockOfUnit[graph.streamFrom[s]] != b && graph.streams[s]->from->isDirty)
+                return true;
+        }
+    }
+    return false;
+}
+
+SolveReport FlowsheetSolver::SolveStale()
+{
+    SolveReport report;
+    report.numBlocks = static_cast<int>(graph.blocks.size());
+    report.numTearStreams = static_cast<int>(std::count(graph.isTear.begin(), graph.isTear.end(), true));
+
+    for (Node* unit : graph.units) {
+        for (auto& point : unit->outputs) {
+            point.isDirty = false;
+        }
+    }
+
+    // Blocks are stored in topological order, so one sweep marks everything downstream
+    // of a dirty node
+    std::vector<char> stale(graph.blocks.size(), 0);
+    std::vector<std::atomic<int>> pending(graph.blocks.size());
+    int numStale = 0;
+
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        pending[b] = 0;
+        if (!stale[b]) {
+            for (int unit : graph.blocks[b].units) {
+                if (graph.units[unit]->isDirty) {
+                    stale[b] = 1;
+                    break;
+                }
+            }
+        }
+        if (!stale[b]) continue;
+
+        ++numStale;
+        for (int successor : graph.blocks[b].successors) {
+            stale[successor] = 1;
+        }
+    }
+
+    if (numStale == 0) {
+        report.converged = true;
+        report.message = "Up to date";
+        return report;
+    }
+
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        if (!stale[b]) continue;
+        for (int successor : graph.blocks[b].successors) {
+            ++pending[successor];
+        }
+    }
+
+    std::mutex reportMutex;
+    std::atomic<int> unitsEvaluated{ 0 };
+    int failedBlocks = 0;
+
+    std::function<void(int)> runBlock = [&](int b) {
+        const FlowsheetGraph::Block& block = graph.blocks[b];
+
+        if (BlockNeedsSolve(b)) {
+            int iterations = SolveBlock(block);
+            unitsEvaluated += static_cast<int>(block.units.size()) * std::max(1, std::abs(iterations));
+
+            std::lock_guard<std::mutex> lock(reportMutex);
+            if (iterations < 0) ++failedBlocks;
+            report.maxRecycleIterations = std::max(report.maxRecycleIterations, std::abs(iterations));
+        }
+
+        // Release downstream blocks whose inputs are now all available
+        for (int successor : block.successors) {
+            if (--pending[successor] == 0)
+                pool.Submit([&runBlock, successor]() { runBlock(successor); });
+        }
+    };
+
+    for (size_t b = 0; b < graph.blocks.size(); ++b) {
+        if (stale[b] && pending[b] == 0) {
+            int root = static_cast<int>(b);
+            pool.Submit([&runBlock, root]() { runBlock(root); });
+        }
+    }
+
+    try {
+        pool.Wait();
+    }
+    catch (const std::exception& e) {
+        report.converged = false;
+        report.message = std::string("Unit calculation failed: ") + e.what();
+        return report;
+    }
+
+    report.unitsEvaluated = unitsEvaluated;
+    report.converged = failedBlocks == 0;
+    report.message = report.converged
+        ? "Converged"
+        : std::to_string(failedBlocks) + " recycle loop(s) did not converge";
+
+    return report;
+}
+
+void FlowsheetSolver::EvaluateUnit(int unit)
+{
+    // Pull the latest upstream values. Tear streams keep their current guess.
+    for (int s : graph.incoming[unit]) {
+        if (graph.isTear[s]) continue;
+        Connection* connection = graph.streams[s];
+        connection->to->stream = connection->from->stream;
+    }
+
+    graph.units[unit]->Calculate();
+}
+
+int FlowsheetSolver::SolveBlock(const FlowsheetGraph::Block& block)
+{
+    // Remember the outputs so that changed ports can be flagged for downstream blocks
+    std::vector<Stream> previous;
+    for (int unit : block.units) {
+        for (const auto& point : graph.units[unit]->outputs) {
+            previous.push_back(point.stream);
+        }
+    }
+
+    int iterations = ConvergeBlock(block);
+
+    size_t k = 0;
+    for (int unit : block.units) {
+        graph.units[unit]->isDirty = false;
+        for (auto& point : graph.units[unit]->outputs) {
+            point.isDirty = Stream::Difference(point.stream, previous[k++]) > tolerance;
+        }
+    }
+
+    return iterations;
+}
+
+int FlowsheetSolver::ConvergeBlock(const FlowsheetGraph::Block& block)
+{
+    if (block.tears.empty()) {
+        for (int unit : block.units) {
+            EvaluateUnit(unit);
+        }
+        return 0;
+    }
+
+    // Bounded Wegstein on every tear stream variable. x is the guess and g(x) the calculated value.
+    const size_t numVars = block.tears.size() * 3;
+    std::vector<double> x(numVars), gx(numVars), xPrev(numVars), gxPrev(numVars);
+
+    auto gather = [&](std::vector<double>& values, bool calculated) {
+        for (size_t t = 0; t < block.tears.size(); ++t) {
+            const Connection* connection = graph.streams[block.tears[t]];
+            const Stream& stream = calculated ? connection->from->stream : connection->to->stream;
+            values[3 * t + 0] = stream.pressure;
+            values[3 * t + 1] = stream.temperature;
+            values[3 * t + 2] = stream.massFlowRate;
+        }
+    };
+
+    for (int iteration = 1; iteration <= maxIterations; ++iteration) {
+        for (int unit : block.units) {
+            EvaluateUnit(unit);
+        }
+
+        gather(x, false);
+        gather(gx, true);
+
+        double error = 0.0;
+        for (int s : block.tears) {
+            const Connection* connection = graph.streams[s];
+            error = std::max(error, Stream::Difference(connection->from->stream, connection->to->stream));
+        }
+
+        if (error < tolerance)
+            return iteration;
+
+        for (size_t i = 0; i < numVars; ++i) {
+            double q = 0.0;
+            if (iteration > 2) {
+                double dx = x[i] - xPrev[i];
+                if (std::fabs(dx) > 1e-14) {
+                    double slope = (gx[i] - gxPrev[i]) / dx;
+                    if (std::fabs(slope - 1.0) > 1e-12)
+                        q = std::clamp(slope / (slope - 1.0), -5.0, 0.0);
+                }
+            }
+            xPrev[i] = x[i];
+            gxPrev[i] = gx[i];
+            x[i] = q * x[i] + (1.0 - q) * gx[i];
+        }
+
+        // Write the new guesses back onto the tear streams
+        for (size_t t = 0; t < block.tears.size(); ++t) {
+            Stream& stream = graph.streams[block.tears[t]]->to->stream;
+            stream.pressure = x[3 * t + 0];
+            stream.temperature = x[3 * t + 1];
+            stream.massFlowRate = x[3 * t + 2];
+        }
+    }
+
+    return -maxIterations;
+}
@@ -0,0 +1,132 @@
+#include "IconAtlas.h"
+
+// STL Includes
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace
+{
+    // Empty pixels between icons, so filtering at an icon's edge does not pick up its neighbour
+    const int Gutter = 2;
+
+    // Area average of the source pixels under every target pixel. Colours are weighted by alpha,
+    // so transparent pixels do not darken the edges of an icon.
+    void Shrink(const unsigned char* rgba, int width, int height, int targetWidth, int targetHeight, std::vector<unsigned char>& out)
+    {
+        out.assign(static_cast<size_t>(targetWidth) * targetHeight * 4, 0);
+        for (int y = 0; y < targetHeight; ++y) {
+            const int y0 = y * height / targetHeight;
+            const int y1 = std::max(y0 + 1, (y + 1) * height / targetHeight);
+            for (int x = 0; x < targetWidth; ++x) {
+                const int x0 = x * width / targetWidth;
+                const int x1 = std::max(x0 + 1, (x + 1) * width / targetWidth);
+
+                double sum[4] = {};
+                for (int sy = y0; sy < y1; ++sy) {
+                    for (int sx = x0; sx < x1; ++sx) {
+                        const unsigned char* p = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+                        const double alpha = p[3];
+                        sum[0] += p[0] * alpha;
+                        sum[1] += p[1] * alpha;
+                        sum[2] += p[2] * alpha;
+                        sum[3] += alpha;
+                    }
+                }
+
+                unsigned char* q = out.data() + (static_cast<size_t>(y) * targetWidth + x) * 4;
+                const double count = static_cast<double>(x1 - x0) * (y1 - y0);
+                if (sum[3] > 0.0) {
+                    for (int c = 0; c < 3; ++c) q[c] = static_cast<unsigned char>(std::lround(sum[c] / sum[3]));
+                }
+                q[3] = static_cast<unsigned char>(std::lround(sum[3] / count));
+            }
+        }
+    }
+}
+
+int IconAtlas::Add(const std::string& path, const unsigned char* rgba, int width, int height)
+{
+    auto found = handles.find(path);
+    if (found != handles.end()) return found->second;
+    if (!rgba || width <= 0 || height <= 0) return NoIcon;
+
+    Source source;
+    const double scale = std::min(1.0, static_cast<double>(maxIconSize) / std::max(width, height));
+    source.width = std::max(1, static_cast<int>(std::lround(width * scale)));
+    source.height = std::max(1, static_cast<int>(std::lround(height * scale)));
+    if (scale < 1.0) Shrink(rgba, width, height, source.width, source.height, source.rgba);
+    else source.rgba.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+    const int handle = static_cast<int>(sources.size());
+    sources.push_back(std::move(source));
+    icons.emplace_back();
+    handles.emplace(path, handle);
+    return handle;
+}
+
+bool IconAtlas::Build(int maxAtlasSize)
+{
+    pixels.clear();
+    width = height = 0;
+    if (sources.empty()) return true;
+
+    // Tallest first, in shelves as wide as the square root of the total area
+    std::vector<int> order(sources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return sources[a].height > sources[b].height; });
+
+    double area = 0.0;
+    int widest = 0;
+    for (const auto& source : sources) {
+        area += static_cast<double>(source.width + Gutter) * (source.height + Gutter);
+        widest = std::max(widest, source.width + Gutter);
+    }
+    int atlasWidth = 1;
+    while (atlasWidth < std::max(widest, static_cast<int>(std::ceil(std::sqrt(area))))) atlasWidth *= 2;
+    if (atlasWidth > maxAtlasSize) return false;
+
+    std::vector<int> x(sources.size()), y(sources.size());
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+    for (int i : order) {
+        const Source& source = sources[i];
+        if (shelfX + source.width + Gutter > atlasWidth) {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        x[i] = shelfX + Gutter / 2;
+        y[i] = shelfY + Gutter / 2;
+        shelfX += source.width + Gutter;
+        shelfHeight = std::max(shelfHeight, source.height + Gutter);
+    }
+    int atlasHeight = 1;
+    while (atlasHeight < shelfY + shelfHeight) atlasHeight *= 2;
+    if (atlasHeight > maxAtlasSize) return false;
+
+    width = atlasWidth;
+    height = atlasHeight;
+    pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const Source& source = sources[i];
+        for (int row = 0; row < source.height; ++row) {
+            std::copy_n(source.rgba.data() + static_cast<size_t>(row) * source.width * 4, source.width * 4,
+                pixels.data() + (static_cast<size_t>(y[i] + row) * width + x[i]) * 4);
+        }
+
+        Icon& icon = icons[i];
+        icon.width = source.width;
+        icon.height = source.height;
+        icon.u0 = static_cast<float>(x[i]) / width;
+        icon.v0 = static_cast<float>(y[i]) / height;
+        icon.u1 = static_cast<float>(x[i] + source.width) / width;
+        icon.v1 = static_cast<float>(y[i] + source.height) / height;
+    }
+    return true;
+}
+
+int IconAtlas::Find(const std::string& path) const
+{
+    auto found = handles.find(path);
+    return found != handles.end() ? found->second : NoIcon;
+}
@@ -0,0 +1,503 @@
+#include "Isotherm.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr double GasConstant = 8.314462618;     // [J/mol/K]
+    constexpr double PressureFloor = 1e-12;         // Keeps fractional powers finite at zero [bar]
+    constexpr double HenryPressure = 1e-6;          // Sips terms are linear in p below this [bar]
+
+    // Per component constants of a fixed count kernel, copied to the stack once per batch
+    template <size_t N>
+    struct FixedConstants {
+        double qs[N], b0[N], scaled[N];             // scaled = dH / R
+        double qs2[N], b02[N], scaled2[N];
+        double exponent[N];
+        double logB0[N];                            // -inf for a component with no affinity
+    };
+
+    // b_i = b0 exp(dH / RT) of one state and db_i/dT = -b_i dH / RT^2
+    template <size_t N>
+    inline void FixedAffinities(const double* b0, const double* scaled, double inverseT, double* b, double* db)
+    {
+        for (size_t i = 0; i < N; ++i) {
+            b[i] = b0[i] * std::exp(scaled[i] * inverseT);
+            db[i] = -b[i] * scaled[i] * inverseT * inverseT;
+        }
+    }
+
+    // The per-state forms below add to q, dqdp and dqdT, which start at zero. See the runtime
+    // functions of the same model for the derivation.
+    template <size_t N>
+    inline void FixedCompetitive(const double* qs, const double* b, const double* db, const double* p,
+        double* q, double* dqdp, double* dqdT)
+    {
+        double sum = 1.0, dSumdT = 0.0;
+        for (size_t j = 0; j < N; ++j) {
+            sum += b[j] * p[j];
+            dSumdT += db[j] * p[j];
+        }
+        const double inverse = 1.0 / sum;
+
+        for (size_t i = 0; i < N; ++i) {
+            const double site = qs[i] * b[i] * p[i] * inverse;
+            q[i] += site;
+            dqdT[i] += (qs[i] * db[i] * p[i] - site * dSumdT) * inverse;
+            for (size_t j = 0; j < N; ++j) dqdp[i * N + j] += ((i == j ? qs[i] * b[i] : 0.0) - site * b[j]) * inverse;
+        }
+    }
+
+    template <size_t N>
+    inline void FixedIndependent(const double* qs, const double* b, const double* db, const double* p,
+        double* q, double* dqdp, double* dqdT)
+    {
+        for (size_t i = 0; i < N; ++i) {
+            const double inverse = 1.0 / (1.0 + b[i] * p[i]);
+            q[i] += qs[i] * b[i] * p[i] * inverse;
+            dqdT[i] += qs[i] * db[i] * p[i] * inverse * inverse;
+            dqdp[i * N + i] += qs[i] * b[i] * inverse * inverse;
+        }
+    }
+
+    // Works on ln b = ln b0 + dH / RT, so the affinity itself is never needed
+    template <size_t N>
+    inline void FixedSips(const double* qs, const double* exponent, const double* scaled, const double* logB0, double inverseT,
+        const double* p, double* q, double* dqdp, double* dqdT)
+    {
+        const double logFloor = std::log(PressureFloor);
+        double x[N], dxdp[N], dxdT[N];
+        double sum = 1.0, dSumdT = 0.0;
+        for (size_t j = 0; j < N; ++j) {
+            const double pressure = std::max(p[j], HenryPressure);
+            const double logB = logB0[j] + scaled[j] * inverseT;
+            const double power = std::exp(exponent[j] * std::max(logB + std::log(pressure), logFloor));
+            x[j] = power * std::max(p[j], 0.0) / pressure;
+            dxdp[j] = power / pressure * (p[j] < HenryPressure ? 1.0 : exponent[j]);
+            dxdT[j] = -exponent[j] * x[j] * scaled[j] * inverseT * inverseT;
+            sum += x[j];
+            dSumdT += dxdT[j];
+        }
+        const double inverse = 1.0 / sum;
+
+        for (size_t i = 0; i < N; ++i) {
+            q[i] += qs[i] * x[i] * inverse;
+            dqdT[i] += (qs[i] * dxdT[i] - q[i] * dSumdT) * inverse;
+            for (size_t j = 0; j < N; ++j) dqdp[i * N + j] += ((i == j ? qs[i] * dxdp[i] : 0.0) - q[i] * dxdp[j]) * inverse;
+        }
+    }
+
+    template <size_t N>
+    inline void FixedToth(const double* qs, const double* exponent, const double* b, const double* db, const double* p,
+        double* q, double* dqdp, double* dqdT)
+    {
+        double sum = 0.0, dSumdT = 0.0;
+        for (size_t j = 0; j < N; ++j) {
+            sum += b[j] * p[j];
+            dSumdT += db[j] * p[j];
+        }
+        const double s = std::max(sum, PressureFloor);
+        const double logS = std::log(s);
+
+        for (size_t i = 0; i < N; ++i) {
+            const double power = std::exp(exponent[i] * logS);
+            const double inverse = std::exp(-std::log1p(power) / exponent[i]);
+            const double slope = power / (s * (1.0 + power));
+            q[i] += qs[i] * b[i] * p[i] * inverse;
+            dqdT[i] += qs[i] * db[i] * p[i] * inverse - q[i] * slope * dSumdT;
+            for (size_t j = 0; j < N; ++j) dqdp[i * N + j] += (i == j ? qs[i] * b[i] * inverse : 0.0) - q[i] * slope * b[j];
+        }
+    }
+
+    // Calls kernel(inverseT, p, q, dqdp, dqdT) for every state of the batch with its inputs and
+    // zeroed outputs on the stack, then stores the outputs
+    template <size_t N, typename Kernel>
+    void ForEachState(IsothermBatch& batch, bool derivatives, const Kernel& kernel)
+    {
+        const size_t n = batch.GetSize();
+        const double* T = batch.temperature.data();
+        const double* pressure[N];
+        double* loading[N];
+        double* loadingdT[N];
+        double* loadingdP[N * N];
+        for (size_t i = 0; i < N; ++i) {
+            pressure[i] = batch.partialPressure[i].data();
+            loading[i] = batch.loading[i].data();
+            loadingdT[i] = batch.dLoadingdTemperature[i].data();
+        }
+        for (size_t ij = 0; ij < N * N; ++ij) loadingdP[ij] = batch.dLoadingdPressure[ij].data();
+
+        for (size_t k = 0; k < n; ++k) {
+            double p[N], q[N] = {}, dqdp[N * N] = {}, dqdT[N] = {};
+            for (size_t i = 0; i < N; ++i) p[i] = pressure[i][k];
+
+            kernel(1.0 / T[k], p, q, dqdp, dqdT);
+
+            for (size_t i = 0; i < N; ++i) loading[i][k] = q[i];
+            if (!derivatives) continue;
+            for (size_t i = 0; i < N; ++i) loadingdT[i][k] = dqdT[i];
+            for (size_t ij = 0; ij < N * N; ++ij) loadingdP[ij][k] = dqdp[ij];
+        }
+    }
+}
+
+void IsothermBatch::Resize(size_t numStates, size_t numComponents)
+{
+    temperature.resize(numStates);
+    for (auto* column : { &sum, &dSumdT, &factor, &dFactor }) {
+        column->resize(numStates);
+    }
+    for (auto* table : { &partialPressure, &loading, &dLoadingdTemperature, &affinity, &dAffinitydT, &site, &dSitedT, &dSitedP }) {
+        table->resize(numComponents);
+        for (auto& column : *table) column.resize(numStates);
+    }
+    dLoadingdPressure.resize(numComponents * numComponents);
+    for (auto& column : dLoadingdPressure) column.resize(numStates);
+}
+
+Isotherm::Isotherm(IsothermModel model, const std::vector<AdsorbateProperties>& adsorbates)
+    : model(model)
+{
+    for (const auto& adsorbate : adsorbates) {
+        saturationLoading.push_back(adsorbate.saturationLoading);
+        affinity.push_back(adsorbate.affinity);
+        heatOfAdsorption.push_back(adsorbate.heatOfAdsorption);
+        saturationLoading2.push_back(adsorbate.saturationLoading2);
+        affinity2.push_back(adsorbate.affinity2);
+        heatOfAdsorption2.push_back(adsorbate.heatOfAdsorption2);
+        heterogeneity.push_back(adsorbate.heterogeneity);
+    }
+    kernel = SelectComponentKernel(adsorbates.size());
+}
+
+void Isotherm::SetKernel(ComponentKernel value)
+{
+    kernel = SelectComponentKernel(GetNumComponents()) == value ? value : ComponentKernel::Runtime;
+}
+
+const char* Isotherm::GetName(IsothermModel model)
+{
+    switch (model) {
+    case IsothermModel::Langmuir: return "Langmuir";
+    case IsothermModel::ExtendedLangmuir: return "Extended Langmuir";
+    case IsothermModel::DualSiteLangmuir: return "Dual-Site Langmuir";
+    case IsothermModel::Sips: return "Sips";
+    case IsothermModel::Toth: return "Toth";
+    }
+    return "";
+}
+
+void Isotherm::Evaluate(IsothermBatch& batch, bool derivatives) const
+{
+    switch (kernel) {
+    case ComponentKernel::Two: EvaluateFixed<2>(batch, derivatives); return;
+    case ComponentKernel::Three: EvaluateFixed<3>(batch, derivatives); return;
+    case ComponentKernel::Four: EvaluateFixed<4>(batch, derivatives); return;
+    case ComponentKernel::Runtime: break;
+    }
+
+    switch (model) {
+    case IsothermModel::Langmuir:
+        ComputeAffinities(batch, affinity, heatOfAdsorption);
+        Independent(batch, derivatives);
+        break;
+    case IsothermModel::ExtendedLangmuir:
+        ComputeAffinities(batch, affinity, heatOfAdsorption);
+        Competitive(batch, saturationLoading, false, derivatives);
+        break;
+    case IsothermModel::DualSiteLangmuir:
+        ComputeAffinities(batch, affinity, heatOfAdsorption);
+        Competitive(batch, saturationLoading, false, derivatives);
+        ComputeAffinities(batch, affinity2, heatOfAdsorption2);
+        Competitive(batch, saturationLoading2, true, derivatives);
+        break;
+    case IsothermModel::Sips:
+        ComputeAffinities(batch, affinity, heatOfAdsorption);
+        Sips(batch, derivatives);
+        break;
+    case IsothermModel::Toth:
+        ComputeAffinities(batch, affinity, heatOfAdsorption);
+        Toth(batch, derivatives);
+        break;
+    }
+}
+
+template <size_t N>
+void Isotherm::EvaluateFixed(IsothermBatch& batch, bool derivatives) const
+{
+    FixedConstants<N> c;
+    for (size_t i = 0; i < N; ++i) {
+        c.qs[i] = saturationLoading[i];
+        c.b0[i] = affinity[i];
+        c.scaled[i] = heatOfAdsorption[i] / GasConstant;
+        c.qs2[i] = saturationLoading2[i];
+        c.b02[i] = affinity2[i];
+        c.scaled2[i] = heatOfAdsorption2[i] / GasConstant;
+        c.exponent[i] = heterogeneity[i];
+        c.logB0[i] = std::log(affinity[i]);
+    }
+
+    switch (model) {
+    case IsothermModel::Langmuir:
+        ForEachState<N>(batch, derivatives, [&c](double inverseT, const double* p, double* q, double* dqdp, double* dqdT) {
+            double b[N], db[N];
+            FixedAffinities<N>(c.b0, c.scaled, inverseT, b, db);
+            FixedIndependent<N>(c.qs, b, db, p, q, dqdp, dqdT);
+        });
+        break;
+    case IsothermModel::ExtendedLangmuir:
+        ForEachState<N>(batch, derivatives, [&c](double inverseT, const double* p, double* q, double* dqdp, double* dqdT) {
+            double b[N], db[N];
+            FixedAffinities<N>(c.b0, c.scaled, inverseT, b, db);
+            FixedCompetitive<N>(c.qs, b, db, p, q, dqdp, dqdT);
+        });
+        break;
+    case IsothermModel::DualSiteLangmuir:
+        ForEachState<N>(batch, derivatives, [&c](double inverseT, const double* p, double* q, double* dqdp, double* dqdT) {
+            double b[N], db[N];
+            FixedAffinities<N>(c.b0, c.scaled, inverseT, b, db);
+            FixedCompetitive<N>(c.qs, b, db, p, q, dqdp, dqdT);
+            FixedAffinities<N>(c.b02, c.scaled2, inverseT, b, db);
+            FixedCompetitive<N>(c.qs2, b, db, p, q, dqdp, dqdT);
+        });
+        break;
+    case IsothermModel::Sips:
+        ForEachState<N>(batch, derivatives, [&c](double inverseT, const double* p, double* q, double* dqdp, double* dqdT) {
+            FixedSips<N>(c.qs, c.exponent, c.scaled, c.logB0, inverseT, p, q, dqdp, dqdT);
+        });
+        break;
+    case IsothermModel::Toth:
+        ForEachState<N>(batch, derivatives, [&c](double inverseT, const double* p, double* q, double* dqdp, double* dqdT) {
+            double b[N], db[N];
+            FixedAffinities<N>(c.b0, c.scaled, inverseT, b, db);
+            FixedToth<N>(c.qs, c.exponent, b, db, p, q, dqdp, dqdT);
+        });
+        break;
+    }
+}
+
+std::vector<double> Isotherm::GetLoading(const std::vector<double>& partialPressure, double temperature) const
+{
+    const size_t nc = GetNumComponents();
+    IsothermBatch batch;
+    batch.Resize(1, nc);
+    batch.temperature[0] = temperature;
+    for (size_t i = 0; i < nc; ++i) batch.partialPressure[i][0] = partialPressure[i];
+    Evaluate(batch, false);
+
+    std::vector<double> loading(nc);
+    for (size_t i = 0; i < nc; ++i) loading[i] = batch.loading[i][0];
+    return loading;
+}
+
+// b_i = b0 exp(dH / RT) and db_i/dT = -b_i dH / RT^2
+void Isotherm::ComputeAffinities(IsothermBatch& batch, const std::vector<double>& b0, const std::vector<double>& heat) const
+{
+    const size_t n = batch.GetSize();
+    const double* T = batch.temperature.data();
+
+    for (size_t i = 0; i < b0.size(); ++i) {
+        double* b = batch.affinity[i].data();
+        double* db = batch.dAffinitydT[i].data();
+        const double scaled = heat[i] / GasConstant;
+        for (size_t k = 0; k < n; ++k) {
+            const double inverseT = 1.0 / T[k];
+            b[k] = b0[i] * std::exp(scaled * inverseT);
+            db[k] = -b[k] * scaled * inverseT * inverseT;
+        }
+    }
+}
+
+// One site shared by every component: q_i = qs b_i p_i / D with D = 1 + sum_j b_j p_j, so
+// dq_i/dp_j = qs b_i delta_ij / D - q_i b_j / D. With accumulate the site is added to the outputs.
+void Isotherm::Competitive(IsothermBatch& batch, const std::vector<double>& qs, bool accumulate, bool derivatives) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t n = batch.GetSize();
+    double* sum = batch.sum.data();
+    double* dSumdT = batch.dSumdT.data();
+    double* inverse = batch.factor.data();
+
+    std::fill(sum, sum + n, 1.0);
+    std::fill(dSumdT, dSumdT + n, 0.0);
+    for (size_t j = 0; j < nc; ++j) {
+        const double* b = batch.affinity[j].data();
+        const double* db = batch.dAffinitydT[j].data();
+        const double* p = batch.partialPressure[j].data();
+        for (size_t k = 0; k < n; ++k) {
+            sum[k] += b[k] * p[k];
+            dSumdT[k] += db[k] * p[k];
+        }
+    }
+    for (size_t k = 0; k < n; ++k) inverse[k] = 1.0 / sum[k];
+
+    const double keep = accumulate ? 1.0 : 0.0;
+    for (size_t i = 0; i < nc; ++i) {
+        const double* b = batch.affinity[i].data();
+        const double* db = batch.dAffinitydT[i].data();
+        const double* p = batch.partialPressure[i].data();
+        double* q = batch.loading[i].data();
+        double* siteLoading = batch.site[i].data();
+        for (size_t k = 0; k < n; ++k) {
+            siteLoading[k] = qs[i] * b[k] * p[k] * inverse[k];
+            q[k] = keep * q[k] + siteLoading[k];
+        }
+        if (!derivatives) continue;
+
+        double* dqdT = batch.dLoadingdTemperature[i].data();
+        for (size_t k = 0; k < n; ++k) {
+            dqdT[k] = keep * dqdT[k] + (qs[i] * db[k] * p[k] - siteLoading[k] * dSumdT[k]) * inverse[k];
+        }
+        for (size_t j = 0; j < nc; ++j) {
+            const double* bj = batch.affinity[j].data();
+            const double self = i == j ? qs[i] : 0.0;
+            double* dqdp = batch.dLoadingdPressure[i * nc + j].data();
+            for (size_t k = 0; k < n; ++k) {
+                dqdp[k] = keep * dqdp[k] + (self * b[k] - siteLoading[k] * bj[k]) * inverse[k];
+            }
+        }
+    }
+}
+
+// Every component on its own site: q_i = qs b p_i / (1 + b p_i)
+void Isotherm::Independent(IsothermBatch& batch, bool derivatives) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t n = batch.GetSize();
+    double* inverse = batch.factor.data();
+
+    for (size_t i = 0; i < nc; ++i) {
+        const double qs = saturationLoading[i];
+        const double* b = batch.affinity[i].data();
+        const double* db = batch.dAffinitydT[i].data();
+        const double* p = batch.partialPressure[i].data();
+        double* q = batch.loading[i].data();
+
+        for (size_t k = 0; k < n; ++k) {
+            inverse[k] = 1.0 / (1.0 + b[k] * p[k]);
+            q[k] = qs * b[k] * p[k] * inverse[k];
+        }
+        if (!derivatives) continue;
+
+        double* dqdT = batch.dLoadingdTemperature[i].data();
+        for (size_t k = 0; k < n; ++k) dqdT[k] = qs * db[k] * p[k] * inverse[k] * inverse[k];
+
+        for (size_t j = 0; j < nc; ++j) {
+            const double self = i == j ? qs : 0.0;
+            double* dqdp = batch.dLoadingdPressure[i * nc + j].data();
+            for (size_t k = 0; k < n; ++k) dqdp[k] = self * b[k] * inverse[k] * inverse[k];
+        }
+    }
+}
+
+// x_i = (b_i p_i)^n_i, q_i = qs x_i / D with D = 1 + sum_j x_j, so
+// dq_i/dp_j = qs dx_i/dp_i delta_ij / D - q_i dx_j/dp_j / D. With n < 1 the slope of x is
+// unbounded at zero pressure, which makes nearly clean cells very stiff, so below HenryPressure x
+// follows the chord to the origin instead.
+void Isotherm::Sips(IsothermBatch& batch, bool derivatives) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t n = batch.GetSize();
+    double* sum = batch.sum.data();
+    double* dSumdT = batch.dSumdT.data();
+    double* inverse = batch.factor.data();
+
+    std::fill(sum, sum + n, 1.0);
+    std::fill(dSumdT, dSumdT + n, 0.0);
+    const double* T = batch.temperature.data();
+    for (size_t j = 0; j < nc; ++j) {
+        const double exponent = heterogeneity[j];
+        const double scaled = heatOfAdsorption[j] / GasConstant;
+        const double* b = batch.affinity[j].data();
+        const double* p = batch.partialPressure[j].data();
+        double* x = batch.site[j].data();
+        double* dxdT = batch.dSitedT[j].data();
+        double* dxdp = batch.dSitedP[j].data();
+        for (size_t k = 0; k < n; ++k) {
+            // d ln b / dT = -dH / RT^2, which stays finite for a component with no affinity
+            const double pressure = std::max(p[k], HenryPressure);
+            const double power = std::exp(exponent * std::log(std::max(b[k] * pressure, PressureFloor)));
+            const double linear = std::max(p[k], 0.0) / pressure;
+            x[k] = power * linear;
+            dxdp[k] = power / pressure * (p[k] < HenryPressure ? 1.0 : exponent);
+            dxdT[k] = -exponent * x[k] * scaled / (T[k] * T[k]);
+            sum[k] += x[k];
+            dSumdT[k] += dxdT[k];
+        }
+    }
+    for (size_t k = 0; k < n; ++k) inverse[k] = 1.0 / sum[k];
+
+    for (size_t i = 0; i < nc; ++i) {
+        const double qs = saturationLoading[i];
+        const double* x = batch.site[i].data();
+        double* q = batch.loading[i].data();
+        for (size_t k = 0; k < n; ++k) q[k] = qs * x[k] * inverse[k];
+        if (!derivatives) continue;
+
+        const double* dxdT = batch.dSitedT[i].data();
+        double* dqdT = batch.dLoadingdTemperature[i].data();
+        for (size_t k = 0; k < n; ++k) dqdT[k] = (qs * dxdT[k] - q[k] * dSumdT[k]) * inverse[k];
+
+        for (size_t j = 0; j < nc; ++j) {
+            const double self = i == j ? qs : 0.0;
+            const double* dxidp = batch.dSitedP[i].data();
+            const double* dxjdp = batch.dSitedP[j].data();
+            double* dqdp = batch.dLoadingdPressure[i * nc + j].data();
+            for (size_t k = 0; k < n; ++k) dqdp[k] = (self * dxidp[k] - q[k] * dxjdp[k]) * inverse[k];
+        }
+    }
+}
+
+// S = sum_j b_j p_j, q_i = qs b_i p_i / F_i with F_i = (1 + S^t_i)^(1/t_i). With
+// g_i = d ln F_i / dS = S^(t_i - 1) / (1 + S^t_i), dq_i/dp_j = qs b_i delta_ij / F_i - q_i g_i b_j.
+void Isotherm::Toth(IsothermBatch& batch, bool derivatives) const
+{
+    const size_t nc = GetNumComponents();
+    const size_t n = batch.GetSize();
+    double* sum = batch.sum.data();
+    double* dSumdT = batch.dSumdT.data();
+    double* inverse = batch.factor.data();
+    double* slope = batch.dFactor.data();
+
+    std::fill(sum, sum + n, 0.0);
+    std::fill(dSumdT, dSumdT + n, 0.0);
+    for (size_t j = 0; j < nc; ++j) {
+        const double* b = batch.affinity[j].data();
+        const double* db = batch.dAffinitydT[j].data();
+        const double* p = batch.partialPressure[j].data();
+        for (size_t k = 0; k < n; ++k) {
+            sum[k] += b[k] * p[k];
+            dSumdT[k] += db[k] * p[k];
+        }
+    }
+
+    for (size_t i = 0; i < nc; ++i) {
+        const double qs = saturationLoading[i];
+        const double t = heterogeneity[i];
+        const double* b = batch.affinity[i].data();
+        const double* db = batch.dAffinitydT[i].data();
+        const double* p = batch.partialPressure[i].data();
+        double* q = batch.loading[i].data();
+
+        for (size_t k = 0; k < n; ++k) {
+            const double s = std::max(sum[k], PressureFloor);
+            const double power = std::exp(t * std::log(s));
+            inverse[k] = std::exp(-std::log1p(power) / t);
+            slope[k] = power / (s * (1.0 + power));
+            q[k] = qs * b[k] * p[k] * inverse[k];
+        }
+        if (!derivatives) continue;
+
+        double* dqdT = batch.dLoadingdTemperature[i].data();
+        for (size_t k = 0; k < n; ++k) dqdT[k] = qs * db[k] * p[k] * inverse[k] - q[k] * slope[k] * dSumdT[k];
+
+        for (size_t j = 0; j < nc; ++j) {
+            const double self = i == j ? qs : 0.0;
+            const double* bj = batch.affinity[j].data();
+            double* dqdp = batch.dLoadingdPressure[i * nc + j].data();
+            for (size_t k = 0; k < n; ++k) dqdp[k] = self * b[k] * inverse[k] - q[k] * slope[k] * bj[k];
+        }
+    }
+}
@@ -0,0 +1,376 @@
+#include "MultiBedPsa.h"
+#include "SpscBuffer.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+    using StreamBuffer = SpscBuffer<std::vector<ColumnStreamSample>>;
+
+    // Holds every bed at a step boundary until the last one arrives
+    class StepBarrier {
+    public:
+        explicit StepBarrier(size_t count) : count(count) {}
+
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            const size_t current = generation;
+            if (++arrived == count) {
+                arrived = 0;
+                ++generation;
+                released.notify_all();
+                return;
+            }
+            released.wait(lock, [&]() { return generation != current; });
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable released;
+        size_t count;
+        size_t arrived = 0;
+        size_t generation = 0;
+    };
+
+    // Slots of the cycle and the step every bed is on in each of them
+    struct Schedule {
+        std::vector<double> start, duration;            // [slot] [s]
+        std::vector<std::vector<size_t>> step;          // [slot][bed]
+    };
+
+    Schedule BuildSchedule(const std::vector<CycleStep>& steps, size_t numBeds)
+    {
+        double cycleTime = 0.0;
+        for (const auto& step : steps) cycleTime += step.duration;
+
+        // Step boundaries of every bed, in the time of the first one
+        std::vector<double> boundaries;
+        for (size_t b = 0; b < numBeds; ++b) {
+            double time = b * cycleTime / numBeds;
+            for (const auto& step : steps) {
+                boundaries.push_back(std::fmod(time, cycleTime));
+                time += step.duration;
+            }
+        }
+        std::sort(boundaries.begin(), boundaries.end());
+        const double tolerance = 1e-9 * cycleTime;
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end(),
+            [tolerance](double a, double b) { return b - a < tolerance; }), boundaries.end());
+
+        Schedule schedule;
+        for (size_t s = 0; s < boundaries.size(); ++s) {
+            const double end = s + 1 < boundaries.size() ? boundaries[s + 1] : cycleTime;
+            schedule.start.push_back(boundaries[s]);
+            schedule.duration.push_back(end - boundaries[s]);
+
+            // Each bed is on the step that holds the middle of the slot
+            std::vector<size_t> bedSteps(numBeds, 0);
+            const double middle = 0.5 * (boundaries[s] + end);
+            for (size_t b = 0; b < numBeds; ++b) {
+                double local = std::fmod(middle - b * cycleTime / numBeds + cycleTime, cycleTime);
+                size_t index = 0;
+                while (index + 1 < steps.size() && local >= steps[index].duration) {
+                    local -= steps[index].duration;
+                    ++index;
+                }
+                bedSteps[b] = index;
+            }
+            schedule.step.push_back(std::move(bedSteps));
+        }
+        return schedule;
+    }
+
+    // Gas handed from one bed to another in one slot of every cycle
+    struct StreamLink {
+        size_t slot = 0;
+        size_t donor = 0;
+        size_t receiver = 0;
+        std::unique_ptr<StreamBuffer> buffer;
+    };
+
+    // Step a receiving step takes its gas from, or the step itself if it takes none
+    CycleStep::Type GetDonorType(CycleStep::Type type)
+    {
+        switch (type) {
+        case CycleStep::Type::EqualisationUp: return CycleStep::Type::EqualisationDown;
+        case CycleStep::Type::Purge:
+        case CycleStep::Type::LightProductPressurisation: return CycleStep::Type::Adsorption;
+        default: return type;
+        }
+    }
+
+    // Amount weighted composition and temperature of the gas in a recorded stream. Returns false
+    // if nothing flowed.
+    bool AverageStream(const std::vector<ColumnStreamSample>& stream, std::vector<double>& moleFraction, double& temperature)
+    {
+        const size_t nc = moleFraction.size();
+        std::vector<double> amount(nc, 0.0);
+        double total = 0.0, heat = 0.0;
+        for (size_t k = 1; k < stream.size(); ++k) {
+            const double dt = stream[k].time - stream[k - 1].time;
+            for (size_t i = 0; i < nc; ++i) {
+                const double a = 0.5 * dt * (std::max(stream[k - 1].flux[i], 0.0) + std::max(stream[k].flux[i], 0.0));
+                amount[i] += a;
+                total += a;
+                heat += a * 0.5 * (stream[k - 1].temperature + stream[k].temperature);
+            }
+        }
+        if (total <= 0.0) return false;
+
+        for (size_t i = 0; i < nc; ++i) moleFraction[i] = amount[i] / total;
+        temperature = heat / total;
+        return true;
+    }
+
+    struct Bed {
+        std::vector<double> state;
+        std::vector<double> cycleStart;
+        ColumnStatistics statistics;
+        CycleBalance balance;
+        std::vector<std::vector<ColumnStreamSample>> received;  // [slot] Last stream from the donor
+    };
+}
+
+MultiBedPsa::MultiBedPsa()
+{
+    // Each bed equalises down into the other while it equalises up, and purges with the light
+    // product of the other while it is on feed
+    auto makeStep = [](CycleStep::Type type, double duration, double pressure, double velocity = 0.0) {
+        CycleStep step;
+        step.type = type;
+        step.duration = duration;
+        step.pressure = pressure;
+        step.velocity = velocity;
+        return step;
+    };
+
+    cycle.steps = {
+        makeStep(CycleStep::Type::Adsorption, 140.0, 1.0),
+        makeStep(CycleStep::Type::EqualisationDown, 20.0, 0.5),
+        makeStep(CycleStep::Type::CnBlowdown, 60.0, 0.05),
+        makeStep(CycleStep::Type::Purge, 100.0, 0.05, 0.3),
+        makeStep(CycleStep::Type::EqualisationUp, 20.0, 0.5),
+        makeStep(CycleStep::Type::Pressurisation, 20.0, 1.0)
+    };
+}
+
+bool MultiBedPsa::Validate(std::string& message) const
+{
+    if (!cycle.Validate(message)) return false;
+
+    if (settings.numBeds < 1 || settings.numBeds > 12) {
+        message = "The number of beds must be between 1 and 12";
+        return false;
+    }
+    if (settings.maxCycles < 1 || settings.tolerance <= 0.0) {
+        message = "Invalid multi-bed settings";
+        return false;
+    }
+    return true;
+}
+
+MultiBedResult MultiBedPsa::Run(const CycleObserver& observer) const
+{
+    MultiBedResult result;
+    if (!Validate(result.message)) return result;
+
+    auto wallStart = std::chrono::steady_clock::now();
+    const auto& steps = cycle.steps;
+    const size_t numBeds = static_cast<size_t>(settings.numBeds);
+    const Schedule schedule = BuildSchedule(steps, numBeds);
+    const size_t numSlots = schedule.start.size();
+    result.numSlots = static_cast<int>(numSlots);
+
+    // Every receiving step with a donor beside it gets its own buffer
+    std::vector<StreamLink> links;
+    for (size_t s = 0; s < numSlots; ++s) {
+        for (size_t r = 0; r < numBeds; ++r) {
+            const CycleStep::Type type = steps[schedule.step[s][r]].type;
+            const CycleStep::Type donorType = GetDonorType(type);
+            if (donorType == type) continue;
+
+            for (size_t d = 0; d < numBeds; ++d) {
+                if (d != r && steps[schedule.step[s][d]].type == donorType) {
+                    StreamLink link;
+                    link.slot = s;
+                    link.donor = d;
+                    link.receiver = r;
+                    link.buffer = std::make_unique<StreamBuffer>(2);
+                    links.push_back(std::move(link));
+                    break;
+                }
+            }
+        }
+    }
+    result.numLinks = static_cast<int>(links.size());
+
+    const std::vector<double> start = cycle.column.GetEquilibriumState(cycle.column.feedMoleFraction,
+        cycle.column.outletPressure, cycle.column.feedTemperature);
+    const std::vector<double> scale = cycle.GetStateScale();
+    const size_t nc = cycle.column.GetNumComponents();
+
+    std::vector<Bed> beds(numBeds);
+    for (auto& bed : beds) {
+        bed.state = start;
+        bed.cycleStart = start;
+        bed.received.resize(numSlots);
+    }
+
+    std::atomic<bool> failed{ false };
+    std::mutex messageMutex;
+    bool stop = false;
+
+    // Advances bed b through slot s and hands its outflow to the beds that take it
+    auto runSlot = [&](size_t b, size_t s) {
+        if (failed.load()) return;
+        Bed& bed = beds[b];
+        const CycleStep& step = steps[schedule.step[s][b]];
+
+        ColumnBoundary inlet, outlet;
+        cycle.GetBoundaries(step, inlet, outlet);
+
+        const auto& stream = bed.received[s];
+        if (!stream.empty()) {
+            std::vector<double> moleFraction(nc);
+            double temperature = 0.0;
+            if (step.type == CycleStep::Type::EqualisationUp) {
+                // The donor's outflow as it left, without any backflow
+                std::vector<ColumnStreamSample> inflow = stream;
+                for (auto& sample : inflow) {
+                    for (double& flux : sample.flux) flux = std::max(flux, 0.0);
+                }
+                outlet = ColumnBoundary::Stream(inflow);
+            }
+            else if (AverageStream(stream, moleFraction, temperature)) {
+                outlet.moleFraction = moleFraction;
+                outlet.temperature = temperature;
+            }
+        }
+
+        ColumnFlows flows;
+        for (const auto& link : links) flows.record = flows.record || (link.slot == s && link.donor == b);
+
+        std::string message;
+        if (!cycle.column.Integrate(bed.state, schedule.duration[s], inlet, outlet, bed.statistics, message, nullptr, &flows)) {
+            std::lock_guard<std::mutex> lock(messageMutex);
+            if (!failed.exchange(true)) {
+                result.message = "Bed " + std::to_string(b + 1) + ", " + CycleStep::GetName(step.type) + ": " + message;
+            }
+            return;
+        }
+        bed.balance.Add(flows);
+
+        for (auto& link : links) {
+            if (link.slot != s || link.donor != b) continue;
+            std::vector<ColumnStreamSample> outflow = flows.outletStream;
+            link.buffer->Push(outflow);
+        }
+    };
+
+    // Takes the streams that arrived for bed b during slot s, for the same slot of the next cycle
+    auto receiveStreams = [&](size_t b, size_t s) {
+        for (auto& link : links) {
+            if (link.slot != s || link.receiver != b) continue;
+            std::vector<ColumnStreamSample> stream;
+            while (link.buffer->Pop(stream)) beds[b].received[s] = std::move(stream);
+        }
+    };
+
+    // Convergence and performance of the unit after every bed has finished cycle
+    auto endCycle = [&](int cycleNumber) {
+        if (failed.load()) {
+            stop = true;
+            return;
+        }
+
+        CycleSummary summary;
+        summary.cycle = cycleNumber;
+        CycleBalance unit;
+        for (auto& bed : beds) {
+            double sum = 0.0;
+            for (size_t j = 0; j < bed.state.size(); ++j) {
+                const double change = (bed.state[j] - bed.cycleStart[j]) / scale[j];
+                sum += change * change;
+            }
+            summary.residual = std::max(summary.residual, std::sqrt(sum / bed.state.size()));
+            unit.Add(bed.balance);
+            bed.balance = CycleBalance();
+            bed.cycleStart = bed.state;
+        }
+        unit.Summarise(summary);
+        result.history.push_back(summary);
+
+        if (observer && !observer(summary)) {
+            result.message = "Stopped";
+            stop = true;
+        }
+        else if (!std::isfinite(summary.residual)) {
+            result.message = "Cycle " + std::to_string(cycleNumber) + " diverged";
+            stop = true;
+        }
+        else if (summary.residual < settings.tolerance) {
+            result.converged = true;
+            result.message = "Cyclic steady state after " + std::to_string(cycleNumber) + " cycles";
+            stop = true;
+        }
+        else if (cycleNumber >= settings.maxCycles) {
+            result.message = "No cyclic steady state after " + std::to_string(cycleNumber) + " cycles";
+            stop = true;
+        }
+    };
+
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+    const bool parallel = false;
+#else
+    const bool parallel = settings.parallel && numBeds > 1;
+#endif
+
+    if (parallel) {
+        // The calling thread runs the first bed
+        StepBarrier barrier(numBeds);
+        auto bedLoop = [&](size_t b) {
+            for (int c = 1; ; ++c) {
+                for (size_t s = 0; s < numSlots; ++s) {
+                    runSlot(b, s);
+                    barrier.Wait();
+                    receiveStreams(b, s);
+                }
+                barrier.Wait();
+                if (b == 0) endCycle(c);
+                barrier.Wait();
+                if (stop) break;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t b = 1; b < numBeds; ++b) threads.emplace_back(bedLoop, b);
+        bedLoop(0);
+        for (auto& thread : threads) thread.join();
+    }
+    else {
+        for (int c = 1; !stop; ++c) {
+            for (size_t s = 0; s < numSlots; ++s) {
+                for (size_t b = 0; b < numBeds; ++b) runSlot(b, s);
+                for (size_t b = 0; b < numBeds; ++b) receiveStreams(b, s);
+            }
+            endCycle(c);
+        }
+    }
+
+    for (auto& bed : beds) {
+        result.profiles.push_back(cycle.column.GetProfile(bed.state));
+        result.statistics.push_back(bed.statistics);
+        result.states.push_back(std::move(bed.state));
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return result;
+}
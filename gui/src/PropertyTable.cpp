@@ -0,0 +1,554 @@
+#include "PropertyTable.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+    constexpr double GasConstant = 8.314462618;     // [J/mol/K]
+    constexpr uint32_t TableMagic = 0x54505854;     // "TXPT"
+    constexpr uint32_t CacheMagic = 0x43505854;     // "TXPC"
+    constexpr uint32_t FileVersion = 1;
+
+    // Deepest refinement a table file may hold, the finest lattice index still fits an int
+    constexpr int MaxDepth = 20;
+    constexpr int MaxRootCells = 1024;
+
+    bool IsValid(const PropertyTableSettings& settings)
+    {
+        return std::isfinite(settings.minTemperature) && std::isfinite(settings.maxTemperature) &&
+            std::isfinite(settings.minPressure) && std::isfinite(settings.maxPressure) &&
+            settings.minTemperature < settings.maxTemperature && settings.minPressure < settings.maxPressure &&
+            settings.temperatureCells >= 1 && settings.temperatureCells <= MaxRootCells &&
+            settings.pressureCells >= 1 && settings.pressureCells <= MaxRootCells &&
+            settings.maxDepth >= 0 && settings.maxDepth <= MaxDepth && settings.tolerance > 0.0;
+    }
+
+    // Hermite basis, f(s) = [1 s s^2 s^3] M [f(0) f(1) f'(0) f'(1)]^T
+    constexpr double Hermite[4][4] = {
+        {  1.0,  0.0,  0.0,  0.0 },
+        {  0.0,  0.0,  1.0,  0.0 },
+        { -3.0,  3.0, -2.0, -1.0 },
+        {  2.0, -2.0,  1.0,  1.0 }
+    };
+
+    // Finite difference stencil around a node: centre, +-T, +-P and the four diagonals
+    constexpr int StencilSize = 9;
+    constexpr int StencilT[StencilSize] = { 0, 1, -1, 0, 0, 1, 1, -1, -1 };
+    constexpr int StencilP[StencilSize] = { 0, 0, 0, 1, -1, 1, -1, 1, -1 };
+    constexpr double RelativeStep = 1e-4;
+
+    uint64_t NodeKey(int i, int j)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(i)) << 32) | static_cast<uint32_t>(j);
+    }
+
+    template <typename T>
+    void WriteValue(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadValue(std::istream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template <typename T>
+    void WriteVector(std::ostream& out, const std::vector<T>& values)
+    {
+        WriteValue(out, static_cast<uint64_t>(values.size()));
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadVector(std::istream& in, std::vector<T>& values)
+    {
+        uint64_t size = 0;
+        if (!ReadValue(in, size) || size > (1ull << 32)) return false;
+
+        // Grow as the data arrives, a corrupt size in a short file fails before it allocates
+        constexpr size_t ChunkSize = (1u << 20) / sizeof(T);
+        values.clear();
+        while (values.size() < size) {
+            const size_t start = values.size();
+            values.resize(start + std::min<size_t>(ChunkSize, size - start));
+            if (!in.read(reinterpret_cast<char*>(values.data() + start), (values.size() - start) * sizeof(T))) return false;
+        }
+        return true;
+    }
+}
+
+PropertyTable::PropertyTable(const CubicEOS& eos, const std::vector<double>& composition, const PropertyTableSettings& settings)
+    : eos(eos), composition(composition), settings(settings)
+{
+    const int finest = 1 << settings.maxDepth;
+    latticeTemperature = (settings.maxTemperature - settings.minTemperature) / (settings.temperatureCells * finest);
+    latticePressure = (settings.maxPressure - settings.minPressure) / (settings.pressureCells * finest);
+
+    for (int a = 0; a < settings.temperatureCells; ++a) {
+        for (int b = 0; b < settings.pressureCells; ++b) {
+            Cell cell;
+            cell.i = a * finest;
+            cell.j = b * finest;
+            cells.push_back(cell);
+        }
+    }
+
+    for (size_t c = 0; c < composition.size(); ++c) {
+        mixtureMolarMass += composition[c] * eos.GetComponents()[c].molarMass;
+    }
+}
+
+bool PropertyTable::IsInside(double T, double P) const
+{
+    return T >= settings.minTemperature && T <= settings.maxTemperature &&
+        P >= settings.minPressure && P <= settings.maxPressure;
+}
+
+int PropertyTable::FindLeaf(double T, double P) const
+{
+    int a = static_cast<int>((T - settings.minTemperature) / (settings.maxTemperature - settings.minTemperature) * settings.temperatureCells);
+    int b = static_cast<int>((P - settings.minPressure) / (settings.maxPressure - settings.minPressure) * settings.pressureCells);
+    a = std::min(std::max(a, 0), settings.temperatureCells - 1);
+    b = std::min(std::max(b, 0), settings.pressureCells - 1);
+
+    int index = a * settings.pressureCells + b;
+    while (cells[index].firstChild >= 0) {
+        const Cell& cell = cells[index];
+        int half = GetCellSize(cell.depth + 1);
+        int upperT = T >= GetTemperature(cell.i + half) ? 1 : 0;
+        int upperP = P >= GetPressure(cell.j + half) ? 1 : 0;
+        index = cell.firstChild + upperT + 2 * upperP;
+    }
+    return index;
+}
+
+int PropertyTable::RefineLeaf(double T, double P)
+{
+    int index = FindLeaf(T, P);
+    std::vector<double> patch;
+
+    while (cells[index].patch < 0) {
+        const Cell cell = cells[index];
+        BuildPatch(cell, patch);
+
+        if (cell.depth < settings.maxDepth && GetPatchError(cell, patch) > settings.tolerance) {
+            // Split and continue in the child that holds the state
+            int half = GetCellSize(cell.depth + 1);
+            int firstChild = static_cast<int>(cells.size());
+            for (int c = 0; c < 4; ++c) {
+                Cell child;
+                child.i = cell.i + (c % 2) * half;
+                child.j = cell.j + (c / 2) * half;
+                child.depth = cell.depth + 1;
+                cells.push_back(child);
+            }
+            cells[index].firstChild = firstChild;
+
+            int upperT = T >= GetTemperature(cell.i + half) ? 1 : 0;
+            int upperP = P >= GetPressure(cell.j + half) ? 1 : 0;
+            index = firstChild + upperT + 2 * upperP;
+        }
+        else {
+            cells[index].patch = static_cast<int>(patches.size());
+            patches.insert(patches.end(), patch.begin(), patch.end());
+        }
+    }
+    return index;
+}
+
+const double* PropertyTable::GetNode(int i, int j)
+{
+    auto found = nodes.find(NodeKey(i, j));
+    if (found == nodes.end()) {
+        EvaluateNodes({ { i, j } });
+        found = nodes.find(NodeKey(i, j));
+    }
+    return found->second.data();
+}
+
+void PropertyTable::EvaluateNodes(const std::vector<std::pair<int, int>>& requested)
+{
+    std::vector<std::pair<int, int>> missing;
+    for (const auto& node : requested) {
+        if (!nodes.count(NodeKey(node.first, node.second)) &&
+            std::find(missing.begin(), missing.end(), node) == missing.end())
+            missing.push_back(node);
+    }
+    if (missing.empty()) return;
+
+    const size_t nc = composition.size();
+    const size_t numStates = missing.size() * StencilSize;
+    work.Resize(numStates, nc);
+
+    for (size_t m = 0; m < missing.size(); ++m) {
+        double T = GetTemperature(missing[m].first);
+        double P = GetPressure(missing[m].second);
+        for (int s = 0; s < StencilSize; ++s) {
+            size_t k = m * StencilSize + s;
+            work.temperature[k] = T * (1.0 + RelativeStep * StencilT[s]);
+            work.pressure[k] = P * (1.0 + RelativeStep * StencilP[s]);
+            for (size_t c = 0; c < nc; ++c) work.moleFraction[c][k] = composition[c];
+        }
+    }
+
+    eos.Evaluate(work, Phase::Vapour);
+    numEquationOfStateCalls += numStates;
+
+    const size_t np = GetNumProperties();
+    for (size_t m = 0; m < missing.size(); ++m) {
+        double hT = RelativeStep * GetTemperature(missing[m].first);
+        double hP = RelativeStep * GetPressure(missing[m].second);
+        std::vector<double> data(4 * np);
+
+        for (size_t p = 0; p < np; ++p) {
+            const double* column = p == 0 ? work.compressibility.data()
+                : p == 1 ? work.density.data()
+                : p == 2 ? work.enthalpy.data()
+                : work.lnFugacityCoefficient[p - 3].data();
+            const double* v = column + m * StencilSize;
+
+            data[4 * p + 0] = v[0];
+            data[4 * p + 1] = (v[1] - v[2]) / (2.0 * hT);
+            data[4 * p + 2] = (v[3] - v[4]) / (2.0 * hP);
+            data[4 * p + 3] = (v[5] - v[6] - v[7] + v[8]) / (4.0 * hT * hP);
+        }
+        nodes[NodeKey(missing[m].first, missing[m].second)] = std::move(data);
+    }
+}
+
+void PropertyTable::BuildPatch(const Cell& cell, std::vector<double>& patch)
+{
+    const int size = GetCellSize(cell.depth);
+    const double dT = size * latticeTemperature;
+    const double dP = size * latticePressure;
+
+    EvaluateNodes({ { cell.i, cell.j }, { cell.i + size, cell.j }, { cell.i, cell.j + size }, { cell.i + size, cell.j + size } });
+    const double* corner[2][2] = {
+        { GetNode(cell.i, cell.j), GetNode(cell.i, cell.j + size) },
+        { GetNode(cell.i + size, cell.j), GetNode(cell.i + size, cell.j + size) }
+    };
+
+    const size_t np = GetNumProperties();
+    patch.assign(16 * np, 0.0);
+    for (size_t p = 0; p < np; ++p) {
+        // Corner values and derivatives scaled to the unit square, [f fP; fT fTP]
+        double F[4][4];
+        for (int a = 0; a < 2; ++a) {
+            for (int b = 0; b < 2; ++b) {
+                const double* node = corner[a][b] + 4 * p;
+                F[a][b] = node[0];
+                F[a][2 + b] = node[2] * dP;
+                F[2 + a][b] = node[1] * dT;
+                F[2 + a][2 + b] = node[3] * dT * dP;
+            }
+        }
+
+        // Coefficients = Hermite F Hermite^T
+        double HF[4][4];
+        for (int r = 0; r < 4; ++r)
+            for (int c = 0; c < 4; ++c) {
+                HF[r][c] = 0.0;
+                for (int q = 0; q < 4; ++q) HF[r][c] += Hermite[r][q] * F[q][c];
+            }
+
+        double* coefficients = &patch[16 * p];
+        for (int r = 0; r < 4; ++r)
+            for (int c = 0; c < 4; ++c) {
+                double sum = 0.0;
+                for (int q = 0; q < 4; ++q) sum += HF[r][q] * Hermite[c][q];
+                coefficients[4 * r + c] = sum;
+            }
+    }
+}
+
+double PropertyTable::GetPatchError(const Cell& cell, const std::vector<double>& patch)
+{
+    // The test points become corners of the children, so a split reuses them
+    const int size = GetCellSize(cell.depth);
+    const int half = size / 2;
+    const std::pair<int, int> testPoints[] = {
+        { cell.i + half, cell.j + half },
+        { cell.i + half, cell.j }, { cell.i + half, cell.j + size },
+        { cell.i, cell.j + half }, { cell.i + size, cell.j + half }
+    };
+    EvaluateNodes(std::vector<std::pair<int, int>>(std::begin(testPoints), std::end(testPoints)));
+
+    const size_t np = GetNumProperties();
+    double error = 0.0;
+    for (const auto& point : testPoints) {
+        const double* node = GetNode(point.first, point.second);
+        const double s = double(point.first - cell.i) / size;
+        const double t = double(point.second - cell.j) / size;
+        const double RT = GasConstant * GetTemperature(point.first);
+
+        for (size_t p = 0; p < np; ++p) {
+            const double* a = &patch[16 * p];
+            double value = 0.0;
+            for (int r = 3; r >= 0; --r) {
+                value = value * s + (((a[4 * r + 3] * t + a[4 * r + 2]) * t + a[4 * r + 1]) * t + a[4 * r]);
+            }
+
+            double exact = node[4 * p];
+            double scale = p <= 1 ? std::fabs(exact) : p == 2 ? RT : 1.0;
+            error = std::max(error, std::fabs(value - exact) / scale);
+        }
+    }
+    return error;
+}
+
+void PropertyTable::Interpolate(const Cell& cell, double T, double P, PropertyBatch& batch, size_t k) const
+{
+    const int size = GetCellSize(cell.depth);
+    const double s = (T - GetTemperature(cell.i)) / (size * latticeTemperature);
+    const double t = (P - GetPressure(cell.j)) / (size * latticePressure);
+    const double* patch = &patches[cell.patch];
+
+    // Tensor product basis s^r t^c, shared by all the properties
+    double weight[16];
+    for (int r = 0, index = 0; r < 4; ++r) {
+        double sr = r == 0 ? 1.0 : r == 1 ? s : r == 2 ? s * s : s * s * s;
+        weight[index++] = sr;
+        weight[index++] = sr * t;
+        weight[index++] = sr * t * t;
+        weight[index++] = sr * t * t * t;
+    }
+
+    auto evaluate = [&](size_t p) {
+        const double* a = patch + 16 * p;
+        double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+        for (int q = 0; q < 16; q += 4) {
+            for (int c = 0; c < 4; ++c) sum[c] += a[q + c] * weight[q + c];
+        }
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    };
+
+    batch.compressibility[k] = evaluate(0);
+    batch.density[k] = evaluate(1);
+    batch.enthalpy[k] = evaluate(2);
+    for (size_t c = 0; c < composition.size(); ++c) {
+        batch.lnFugacityCoefficient[c][k] = evaluate(3 + c);
+    }
+    batch.molarMass[k] = mixtureMolarMass;
+}
+
+void PropertyTable::Evaluate(PropertyBatch& batch)
+{
+    const size_t n = batch.GetSize();
+    std::vector<size_t> pending, outside;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (size_t k = 0; k < n; ++k) {
+            double T = batch.temperature[k], P = batch.pressure[k];
+            if (!IsInside(T, P)) {
+                outside.push_back(k);
+                continue;
+            }
+            const Cell& leaf = cells[FindLeaf(T, P)];
+            if (leaf.patch < 0)
+                pending.push_back(k);
+            else
+                Interpolate(leaf, T, P, batch, k);
+        }
+    }
+
+    if (!pending.empty()) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (size_t k : pending) {
+            double T = batch.temperature[k], P = batch.pressure[k];
+            Interpolate(cells[RefineLeaf(T, P)], T, P, batch, k);
+        }
+    }
+
+    if (!outside.empty()) {
+        const size_t nc = composition.size();
+        PropertyBatch direct;
+        direct.Resize(outside.size(), nc);
+        for (size_t m = 0; m < outside.size(); ++m) {
+            direct.temperature[m] = batch.temperature[outside[m]];
+            direct.pressure[m] = batch.pressure[outside[m]];
+            for (size_t c = 0; c < nc; ++c) direct.moleFraction[c][m] = composition[c];
+        }
+
+        eos.Evaluate(direct, Phase::Vapour);
+
+        for (size_t m = 0; m < outside.size(); ++m) {
+            size_t k = outside[m];
+            batch.compressibility[k] = direct.compressibility[m];
+            batch.density[k] = direct.density[m];
+            batch.enthalpy[k] = direct.enthalpy[m];
+            batch.molarMass[k] = direct.molarMass[m];
+            for (size_t c = 0; c < nc; ++c) batch.lnFugacityCoefficient[c][k] = direct.lnFugacityCoefficient[c][m];
+        }
+    }
+}
+
+bool PropertyTable::HasValidCells() const
+{
+    const size_t numRoots = static_cast<size_t>(settings.temperatureCells) * settings.pressureCells;
+    const size_t patchSize = 16 * GetNumProperties();
+    const int64_t finest = int64_t(1) << settings.maxDepth;
+    if (cells.size() < numRoots || cells.size() > static_cast<size_t>(INT32_MAX) || patches.size() > static_cast<size_t>(INT32_MAX)) return false;
+
+    for (size_t index = 0; index < cells.size(); ++index) {
+        const Cell& cell = cells[index];
+        if (cell.depth < 0 || cell.depth > settings.maxDepth || (index < numRoots) != (cell.depth == 0)) return false;
+        if (cell.i < 0 || cell.j < 0 || cell.i >= settings.temperatureCells * finest || cell.j >= settings.pressureCells * finest) return false;
+
+        // Children come after their parent, so FindLeaf always ends
+        if (cell.firstChild >= 0) {
+            if (cell.patch >= 0 || static_cast<size_t>(cell.firstChild) <= index || static_cast<size_t>(cell.firstChild) + 4 > cells.size()) return false;
+            for (int c = 0; c < 4; ++c) {
+                if (cells[cell.firstChild + c].depth != cell.depth + 1) return false;
+            }
+        }
+        else if (cell.firstChild != -1) return false;
+
+        if (cell.patch >= 0) {
+            if (static_cast<size_t>(cell.patch) + patchSize > patches.size()) return false;
+        }
+        else if (cell.patch != -1) return false;
+    }
+    return true;
+}
+
+size_t PropertyTable::GetNumLeaves() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return std::count_if(cells.begin(), cells.end(), [](const Cell& cell) { return cell.firstChild < 0; });
+}
+
+void PropertyTable::Write(std::ostream& out) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    WriteValue(out, TableMagic);
+    WriteValue(out, FileVersion);
+    WriteValue(out, static_cast<int32_t>(eos.GetModel()));
+    WriteValue(out, static_cast<uint32_t>(composition.size()));
+    for (const auto& component : eos.GetComponents()) {
+        WriteValue(out, static_cast<uint32_t>(component.name.size()));
+        out.write(component.name.data(), component.name.size());
+    }
+    WriteVector(out, composition);
+    WriteValue(out, settings);
+    WriteVector(out, cells);
+    WriteVector(out, patches);
+
+    WriteValue(out, static_cast<uint64_t>(nodes.size()));
+    for (const auto& node : nodes) {
+        WriteValue(out, node.first);
+        out.write(reinterpret_cast<const char*>(node.second.data()), node.second.size() * sizeof(double));
+    }
+}
+
+std::unique_ptr<PropertyTable> PropertyTable::Read(std::istream& in, const CubicEOS& eos, std::string& error)
+{
+    uint32_t magic = 0, version = 0, numComponents = 0;
+    int32_t model = 0;
+    if (!ReadValue(in, magic) || magic != TableMagic || !ReadValue(in, version) || version != FileVersion) {
+        error = "Not a property table file";
+        return nullptr;
+    }
+    if (!ReadValue(in, model) || model != static_cast<int32_t>(eos.GetModel()) ||
+        !ReadValue(in, numComponents) || numComponents != eos.GetNumComponents()) {
+        error = "Property table was built for a different equation of state";
+        return nullptr;
+    }
+    for (const auto& component : eos.GetComponents()) {
+        uint32_t length = 0;
+        if (!ReadValue(in, length) || length > 256) {
+            error = "Corrupt property table";
+            return nullptr;
+        }
+        std::string name(length, '\0');
+        in.read(&name[0], length);
+        if (name != component.name) {
+            error = "Property table was built for a different component list";
+            return nullptr;
+        }
+    }
+
+    std::vector<double> composition;
+    PropertyTableSettings settings;
+    if (!ReadVector(in, composition) || composition.size() != numComponents || !ReadValue(in, settings) || !IsValid(settings)) {
+        error = "Corrupt property table";
+        return nullptr;
+    }
+
+    auto table = std::make_unique<PropertyTable>(eos, composition, settings);
+    uint64_t numNodes = 0;
+    if (!ReadVector(in, table->cells) || !ReadVector(in, table->patches) || !table->HasValidCells() || !ReadValue(in, numNodes)) {
+        error = "Corrupt property table";
+        return nullptr;
+    }
+
+    const size_t nodeSize = 4 * table->GetNumProperties();
+    for (uint64_t n = 0; n < numNodes; ++n) {
+        uint64_t key = 0;
+        std::vector<double> data(nodeSize);
+        if (!ReadValue(in, key) || !in.read(reinterpret_cast<char*>(data.data()), nodeSize * sizeof(double))) {
+            error = "Corrupt property table";
+            return nullptr;
+        }
+        table->nodes[key] = std::move(data);
+    }
+    return table;
+}
+
+PropertyTableCache::PropertyTableCache(const CubicEOS& eos, const PropertyTableSettings& settings)
+    : eos(eos), settings(settings)
+{
+}
+
+PropertyTable& PropertyTableCache::GetTable(const std::vector<double>& composition)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& table = tables[composition];
+    if (!table) table = std::make_unique<PropertyTable>(eos, composition, settings);
+    return *table;
+}
+
+size_t PropertyTableCache::GetNumTables() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return tables.size();
+}
+
+bool PropertyTableCache::Save(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    WriteValue(out, CacheMagic);
+    WriteValue(out, static_cast<uint64_t>(tables.size()));
+    for (const auto& table : tables) {
+        table.second->Write(out);
+    }
+    return static_cast<bool>(out);
+}
+
+bool PropertyTableCache::Load(const std::string& path, std::string& error)
+{
+    std::ifstream in(path, std::ios::binary);
+    uint32_t magic = 0;
+    uint64_t count = 0;
+    if (!in || !ReadValue(in, magic) || magic != CacheMagic || !ReadValue(in, count)) {
+        error = "Cannot read property tables from " + path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint64_t t = 0; t < count; ++t) {
+        auto table = PropertyTable::Read(in, eos, error);
+        if (!table) return false;
+        tables[table->GetComposition()] = std::move(table);
+    }
+    return true;
+}
@@ -0,0 +1,344 @@
+#include "PsaCycle.h"
+
+// STL Includes
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // Solves the n x n system a x = b in place by Gaussian elimination with partial pivoting
+    bool SolveDense(std::vector<double>& a, std::vector<double>& b, size_t n)
+    {
+        for (size_t col = 0; col < n; ++col) {
+            size_t pivot = col;
+            for (size_t row = col + 1; row < n; ++row) {
+                if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col])) pivot = row;
+            }
+            if (a[pivot * n + col] == 0.0) return false;
+            if (pivot != col) {
+                for (size_t j = 0; j < n; ++j) std::swap(a[col * n + j], a[pivot * n + j]);
+                std::swap(b[col], b[pivot]);
+            }
+            for (size_t row = col + 1; row < n; ++row) {
+                const double factor = a[row * n + col] / a[col * n + col];
+                for (size_t j = col; j < n; ++j) a[row * n + j] -= factor * a[col * n + j];
+                b[row] -= factor * b[col];
+            }
+        }
+        for (size_t col = n; col-- > 0;) {
+            for (size_t j = col + 1; j < n; ++j) b[col] -= a[col * n + j] * b[j];
+            b[col] /= a[col * n + col];
+        }
+        return true;
+    }
+}
+
+const char* CycleStep::GetName(Type type)
+{
+    switch (type) {
+    case Type::Adsorption: return "Adsorption";
+    case Type::Pressurisation: return "Pressurisation";
+    case Type::CoBlowdown: return "CoBLO";
+    case Type::CnBlowdown: return "CnBLO";
+    case Type::LightProductPressurisation: return "LPP";
+    case Type::Purge: return "Purge";
+    case Type::EqualisationDown: return "EQ Down";
+    case Type::EqualisationUp: return "EQ Up";
+    }
+    return "";
+}
+
+PsaCycle::PsaCycle()
+{
+    // Four step cycle with light product pressurisation for CO2 capture from flue gas
+    CycleStep adsorption;
+    adsorption.type = CycleStep::Type::Adsorption;
+    adsorption.duration = 300.0;
+
+    CycleStep coBlowdown;
+    coBlowdown.type = CycleStep::Type::CoBlowdown;
+    coBlowdown.duration = 60.0;
+    coBlowdown.pressure = 0.2;
+
+    CycleStep cnBlowdown;
+    cnBlowdown.type = CycleStep::Type::CnBlowdown;
+    cnBlowdown.duration = 120.0;
+    cnBlowdown.pressure = 0.05;
+
+    CycleStep lightProductPressurisation;
+    lightProductPressurisation.type = CycleStep::Type::LightProductPressurisation;
+    lightProductPressurisation.duration = 30.0;
+
+    steps = { adsorption, coBlowdown, cnBlowdown, lightProductPressurisation };
+    lightProductMoleFraction = { 0.0, 1.0 };
+    column.integrator.numCells = 50;
+}
+
+bool PsaCycle::Validate(std::string& message) const
+{
+    if (!column.Validate(message)) return false;
+
+    if (steps.empty()) {
+        message = "The cycle has no steps";
+        return false;
+    }
+    for (const auto& step : steps) {
+        if (step.duration <= 0.0 || step.pressure <= 0.0 || step.velocity < 0.0 || step.rampTime < 0.0) {
+            message = std::string("Invalid settings for the ") + CycleStep::GetName(step.type) + " step";
+            return false;
+        }
+    }
+
+    double sum = 0.0;
+    for (double x : lightProductMoleFraction) sum += x;
+    if (lightProductMoleFraction.size() != column.GetNumComponents() || std::fabs(sum - 1.0) > 1e-6) {
+        message = "The light product composition must be given for every component and sum to one";
+        return false;
+    }
+    if (settings.historySize < 1 || settings.maxCycles < 1 || settings.tolerance <= 0.0) {
+        message = "Invalid cyclic steady state settings";
+        return false;
+    }
+    return true;
+}
+
+void CycleBalance::Add(const ColumnFlows& flows)
+{
+    for (size_t i = 0; i < flows.inlet.size(); ++i) {
+        if (flows.inlet[i] < 0.0) heavyTotal -= flows.inlet[i];
+    }
+    fed += std::max(flows.inlet[0], 0.0);
+    heavy += std::max(-flows.inlet[0], 0.0);
+    entered += std::max(flows.inlet[0], 0.0) + std::max(-flows.outlet[0], 0.0);
+    gained += flows.inlet[0] - flows.outlet[0];
+}
+
+void CycleBalance::Add(const CycleBalance& other)
+{
+    fed += other.fed;
+    heavy += other.heavy;
+    heavyTotal += other.heavyTotal;
+    entered += other.entered;
+    gained += other.gained;
+}
+
+void CycleBalance::Summarise(CycleSummary& summary) const
+{
+    summary.purity = heavyTotal > 0.0 ? heavy / heavyTotal : 0.0;
+    summary.recovery = fed > 0.0 ? heavy / fed : 0.0;
+    summary.massBalanceError = entered > 0.0 ? std::fabs(gained) / entered : 0.0;
+}
+
+void PsaCycle::GetBoundaries(const CycleStep& step, ColumnBoundary& inlet, ColumnBoundary& outlet) const
+{
+    const double highPressure = column.outletPressure;
+    const double temperature = column.feedTemperature;
+    const auto& feed = column.feedMoleFraction;
+    const auto& light = lightProductMoleFraction;
+
+    inlet = ColumnBoundary::Closed();
+    outlet = ColumnBoundary::Closed();
+    switch (step.type) {
+    case CycleStep::Type::Adsorption:
+        inlet = ColumnBoundary::Flow(column.feedVelocity, temperature, feed);
+        outlet = ColumnBoundary::Pressure(highPressure, temperature, light, step.rampTime);
+        break;
+    case CycleStep::Type::Pressurisation:
+        inlet = ColumnBoundary::Pressure(highPressure, temperature, feed, step.rampTime);
+        break;
+    case CycleStep::Type::CoBlowdown:
+    case CycleStep::Type::EqualisationDown:
+        outlet = ColumnBoundary::Pressure(step.pressure, temperature, light, step.rampTime);
+        break;
+    case CycleStep::Type::CnBlowdown:
+        inlet = ColumnBoundary::Pressure(step.pressure, temperature, feed, step.rampTime);
+        break;
+    case CycleStep::Type::LightProductPressurisation:
+        outlet = ColumnBoundary::Pressure(highPressure, temperature, light, step.rampTime);
+        break;
+    case CycleStep::Type::Purge:
+        inlet = ColumnBoundary::Pressure(step.pressure, temperature, feed, step.rampTime);
+        outlet = ColumnBoundary::Flow(-step.velocity, temperature, light);
+        break;
+    case CycleStep::Type::EqualisationUp:
+        outlet = ColumnBoundary::Pressure(step.pressure, temperature, light, step.rampTime);
+        break;
+    }
+}
+
+std::vector<double> PsaCycle::GetStateScale() const
+{
+    const size_t nc = column.GetNumComponents();
+    const size_t m = column.GetBlockSize();
+    std::vector<double> scale(m * column.integrator.numCells);
+    for (size_t j = 0; j < scale.size(); ++j) {
+        const size_t v = j % m;
+        if (v == 0) scale[j] = column.outletPressure;
+        else if (v < nc) scale[j] = 1.0;
+        else if (v < 2 * nc) scale[j] = std::max(column.adsorbates[v - nc].GetCapacity(), 1e-3);
+        else scale[j] = column.column.ambientTemperature;
+    }
+    return scale;
+}
+
+bool PsaCycle::RunCycle(std::vector<double>& state, CycleSummary& summary, ColumnStatistics& statistics, std::string& message) const
+{
+    CycleBalance balance;
+    for (const auto& step : steps) {
+        ColumnBoundary inlet, outlet;
+        GetBoundaries(step, inlet, outlet);
+
+        ColumnFlows flows;
+        if (!column.Integrate(state, step.duration, inlet, outlet, statistics, message, nullptr, &flows)) {
+            message = std::string(CycleStep::GetName(step.type)) + ": " + message;
+            return false;
+        }
+        balance.Add(flows);
+    }
+
+    balance.Summarise(summary);
+    return true;
+}
+
+CyclicSteadyStateResult PsaCycle::SolveCyclicSteadyState(const CycleObserver& observer) const
+{
+    CyclicSteadyStateResult result;
+    if (!Validate(result.message)) return result;
+
+    const size_t nc = column.GetNumComponents();
+    const size_t m = column.GetBlockSize();
+
+    // Start of the cycle, x, and its image after one cycle, g. A bed saturated with feed is
+    // closer to the cyclic steady state of a capture cycle than a clean one.
+    std::vector<double> x = column.GetEquilibriumState(column.feedMoleFraction, column.outletPressure, column.feedTemperature);
+    const size_t size = x.size();
+
+    // Same scales as the absolute tolerances of the integrator
+    const std::vector<double> scale = GetStateScale();
+
+    // Anderson history: differences of the scaled residuals f = (g - x) / scale and of the images g
+    std::vector<std::vector<double>> residualDifferences, imageDifferences;
+    std::vector<double> g, f(size), previousF, previousG;
+    double bestResidual = std::numeric_limits<double>::infinity();
+    bool accelerated = false;
+
+    for (int cycle = 1; cycle <= settings.maxCycles; ++cycle) {
+        CycleSummary summary;
+        summary.cycle = cycle;
+        summary.accelerated = accelerated;
+
+        g = x;
+        std::string message;
+        if (!RunCycle(g, summary, result.statistics, message)) {
+            if (!accelerated || previousG.empty()) {
+                result.message = "Cycle " + std::to_string(cycle) + " failed. " + message;
+                break;
+            }
+
+            // Restart from the last cycle that was not extrapolated
+            residualDifferences.clear();
+            imageDifferences.clear();
+            x = previousG;
+            previousF.clear();
+            previousG.clear();
+            accelerated = false;
+            continue;
+        }
+
+        double sum = 0.0;
+        for (size_t j = 0; j < size; ++j) {
+            f[j] = (g[j] - x[j]) / scale[j];
+            sum += f[j] * f[j];
+        }
+        summary.residual = std::sqrt(sum / size);
+        result.history.push_back(summary);
+        result.state = g;
+
+        if (observer && !observer(summary)) {
+            result.message = "Stopped";
+            break;
+        }
+        if (!std::isfinite(summary.residual)) {
+            result.message = "Cycle " + std::to_string(cycle) + " diverged";
+            break;
+        }
+        if (summary.residual < settings.tolerance) {
+            result.converged = true;
+            result.message = "Cyclic steady state after " + std::to_string(cycle) + " cycles";
+            break;
+        }
+
+        // A growing residual means the history no longer describes the map near x
+        if (accelerated && summary.residual > 2.0 * bestResidual) {
+            residualDifferences.clear();
+            imageDifferences.clear();
+            previousF.clear();
+        }
+        bestResidual = std::min(bestResidual, summary.residual);
+
+        if (!previousF.empty()) {
+            std::vector<double> df(size), dg(size);
+            for (size_t j = 0; j < size; ++j) {
+                df[j] = f[j] - previousF[j];
+                dg[j] = g[j] - previousG[j];
+            }
+            residualDifferences.push_back(std::move(df));
+            imageDifferences.push_back(std::move(dg));
+            if (static_cast<int>(residualDifferences.size()) > settings.historySize) {
+                residualDifferences.erase(residualDifferences.begin());
+                imageDifferences.erase(imageDifferences.begin());
+            }
+        }
+        previousF = f;
+        previousG = g;
+
+        // Successive substitution, x = g, until there is a history to extrapolate from
+        x = g;
+        accelerated = false;
+        const size_t depth = residualDifferences.size();
+        if (!settings.accelerate || cycle < settings.plainCycles || depth == 0) continue;
+
+        // Least squares mixing weights from the normal equations, lightly regularised
+        std::vector<double> normal(depth * depth), weights(depth);
+        double trace = 0.0;
+        for (size_t a = 0; a < depth; ++a) {
+            for (size_t b = 0; b <= a; ++b) {
+                double dot = 0.0;
+                for (size_t j = 0; j < size; ++j) dot += residualDifferences[a][j] * residualDifferences[b][j];
+                normal[a * depth + b] = normal[b * depth + a] = dot;
+            }
+            double dot = 0.0;
+            for (size_t j = 0; j < size; ++j) dot += residualDifferences[a][j] * f[j];
+            weights[a] = dot;
+            trace += normal[a * depth + a];
+        }
+        for (size_t a = 0; a < depth; ++a) normal[a * depth + a] += 1e-10 * trace;
+        if (!SolveDense(normal, weights, depth)) continue;
+
+        for (size_t a = 0; a < depth; ++a) {
+            for (size_t j = 0; j < size; ++j) x[j] -= weights[a] * imageDifferences[a][j];
+        }
+
+        // Keep the extrapolated bed physical
+        for (size_t k = 0; k < size / m; ++k) {
+            double* cell = &x[k * m];
+            cell[0] = std::max(cell[0], 1e-3 * column.outletPressure);
+            double fractions = 0.0;
+            for (size_t i = 0; i + 1 < nc; ++i) {
+                cell[1 + i] = std::clamp(cell[1 + i], 0.0, 1.0);
+                fractions += cell[1 + i];
+            }
+            if (fractions > 1.0) {
+                for (size_t i = 0; i + 1 < nc; ++i) cell[1 + i] /= fractions;
+            }
+            for (size_t i = 0; i < nc; ++i) cell[nc + i] = std::max(cell[nc + i], 0.0);
+            cell[2 * nc] = std::clamp(cell[2 * nc], 0.5 * column.column.ambientTemperature, 2.0 * column.column.ambientTemperature);
+        }
+        accelerated = true;
+    }
+
+    if (result.message.empty()) result.message = "No cyclic steady state after " + std::to_string(settings.maxCycles) + " cycles";
+    if (!result.state.empty()) result.profile = column.GetProfile(result.state);
+    return result;
+}
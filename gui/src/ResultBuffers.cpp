@@ -0,0 +1,172 @@
+#include "ResultBuffers.h"
+
+#include "nlohmann/json.hpp"
+
+// STL Includes
+#include <algorithm>
+
+using nlohmann::json;
+
+ResultBuffers& ResultBuffers::Get()
+{
+    static ResultBuffers instance;
+    return instance;
+}
+
+int ResultBuffers::Publish(const std::string& name, const std::vector<ResultColumn>& columns, size_t rows, std::vector<double>&& values)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& buffer : buffers) {
+        if (buffer->name == name) buffer->released = true;
+    }
+
+    auto buffer = std::make_unique<Buffer>();
+    buffer->handle = nextHandle++;
+    buffer->name = name;
+    buffer->columns = columns;
+    buffer->rows = rows;
+    buffer->values = std::move(values);
+    buffer->values.resize(rows * columns.size());
+    const int handle = buffer->handle;
+    buffers.push_back(std::move(buffer));
+
+    Collect();
+    return handle;
+}
+
+void ResultBuffers::Release(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& buffer : buffers) {
+        if (buffer->name == name) buffer->released = true;
+    }
+    Collect();
+}
+
+int ResultBuffers::Find(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& buffer : buffers) {
+        if (buffer->name == name && !buffer->released) return buffer->handle;
+    }
+    return 0;
+}
+
+bool ResultBuffers::Pin(int handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Buffer* buffer = FindHandle(handle);
+    if (!buffer) return false;
+    ++buffer->pins;
+    return true;
+}
+
+void ResultBuffers::Unpin(int handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Buffer* buffer = FindHandle(handle);
+    if (buffer && buffer->pins > 0) --buffer->pins;
+    Collect();
+}
+
+const double* ResultBuffers::GetData(int handle) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Buffer* buffer = FindHandle(handle);
+    return buffer ? buffer->values.data() : nullptr;
+}
+
+size_t ResultBuffers::GetNumRows(int handle) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Buffer* buffer = FindHandle(handle);
+    return buffer ? buffer->rows : 0;
+}
+
+size_t ResultBuffers::GetNumColumns(int handle) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const Buffer* buffer = FindHandle(handle);
+    return buffer ? buffer->columns.size() : 0;
+}
+
+std::string ResultBuffers::GetManifest() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    json manifest = json::array();
+    for (const auto& buffer : buffers) {
+        if (buffer->released) continue;
+
+        json columns = json::array();
+        for (const auto& column : buffer->columns) columns.push_back({ { "name", column.name }, { "unit", column.unit } });
+        manifest.push_back({
+            { "handle", buffer->handle },
+            { "name", buffer->name },
+            { "rows", buffer->rows },
+            { "columns", columns }
+        });
+    }
+    return manifest.dump();
+}
+
+size_t ResultBuffers::GetNumBuffers() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return buffers.size();
+}
+
+ResultBuffers::Buffer* ResultBuffers::FindHandle(int handle) const
+{
+    for (const auto& buffer : buffers) {
+        if (buffer->handle == handle) return buffer.get();
+    }
+    return nullptr;
+}
+
+void ResultBuffers::Collect()
+{
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+        [](const std::unique_ptr<Buffer>& buffer) { return buffer->released && buffer->pins == 0; }), buffers.end());
+}
+
+extern "C" {
+
+const char* thermatix_result_manifest()
+{
+    // Valid until the next call
+    static std::string manifest;
+    manifest = ResultBuffers::Get().GetManifest();
+    return manifest.c_str();
+}
+
+int thermatix_result_find(const char* name)
+{
+    return name ? ResultBuffers::Get().Find(name) : 0;
+}
+
+int thermatix_result_pin(int handle)
+{
+    return ResultBuffers::Get().Pin(handle) ? 1 : 0;
+}
+
+void thermatix_result_unpin(int handle)
+{
+    ResultBuffers::Get().Unpin(handle);
+}
+
+const double* thermatix_result_data(int handle)
+{
+    return ResultBuffers::Get().GetData(handle);
+}
+
+int thermatix_result_rows(int handle)
+{
+    return static_cast<int>(ResultBuffers::Get().GetNumRows(handle));
+}
+
+int thermatix_result_columns(int handle)
+{
+    return static_cast<int>(ResultBuffers::Get().GetNumColumns(handle));
+}
+
+}
@@ -0,0 +1,443 @@
+#include "ResultFile.h"
+
+#include "nlohmann/json.hpp"
+
+// STL Includes
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <cmath>
+#include <iterator>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif !defined(EMSCRIPTEN)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char HeaderMagic[4] = { 'T', 'H', 'X', 'R' };
+    const char FooterMagic[8] = { 'T', 'H', 'X', 'R', 'E', 'N', 'D', '\0' };
+    const uint32_t Version = 1;
+    const size_t FooterSize = 32;
+    const size_t IndexEntrySize = 32;
+
+    size_t GetTypeSize(ResultType type) { return type == ResultType::Float32 ? sizeof(float) : sizeof(double); }
+    size_t PadTo8(size_t bytes) { return (bytes + 7) & ~static_cast<size_t>(7); }
+
+    template <typename T>
+    void Write(std::ofstream& file, T value) { file.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    void WritePadding(std::ofstream& file, size_t bytes)
+    {
+        static const char zeros[8] = {};
+        file.write(zeros, PadTo8(bytes) - bytes);
+    }
+
+    void WriteString(std::ofstream& file, const std::string& text)
+    {
+        const uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), 65535));
+        Write(file, length);
+        file.write(text.data(), length);
+    }
+
+    // Bounds checked reads from the start of the file
+    class ByteCursor {
+    public:
+        ByteCursor(const unsigned char* data, size_t size, size_t position) : data(data), size(size), position(position) {}
+
+        template <typename T>
+        bool Read(T& value)
+        {
+            if (position + sizeof(T) > size) return false;
+            std::memcpy(&value, data + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        bool ReadString(std::string& text)
+        {
+            uint16_t length = 0;
+            if (!Read(length) || position + length > size) return false;
+            text.assign(reinterpret_cast<const char*>(data + position), length);
+            position += length;
+            return true;
+        }
+
+        size_t GetPosition() const { return position; }
+
+    private:
+        const unsigned char* data;
+        size_t size;
+        size_t position;
+    };
+}
+
+ResultWriter::~ResultWriter()
+{
+    std::string message;
+    if (IsOpen()) Close(message);
+}
+
+bool ResultWriter::Open(const std::string& path, const std::vector<ResultColumn>& columns, std::string& message, size_t chunkRows)
+{
+    if (IsOpen()) Close(message);
+    if (columns.empty() || chunkRows == 0) {
+        message = "A result file needs at least one column";
+        return false;
+    }
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        message = "Cannot write " + path;
+        return false;
+    }
+
+    this->columns = columns;
+    this->chunkRows = chunkRows;
+    numRows = 0;
+    chunks.clear();
+    pending.assign(columns.size(), std::vector<double>());
+    for (auto& column : pending) column.reserve(chunkRows);
+
+    size_t bytes = sizeof(HeaderMagic) + 2 * sizeof(uint32_t);
+    file.write(HeaderMagic, sizeof(HeaderMagic));
+    Write(file, Version);
+    Write(file, static_cast<uint32_t>(columns.size()));
+    for (const auto& column : columns) {
+        Write(file, static_cast<uint8_t>(column.type));
+        WriteString(file, column.name);
+        WriteString(file, column.unit);
+        bytes += 1 + 2 * sizeof(uint16_t) + std::min<size_t>(column.name.size(), 65535) + std::min<size_t>(column.unit.size(), 65535);
+    }
+    WritePadding(file, bytes);
+    return true;
+}
+
+void ResultWriter::Append(const double* values)
+{
+    for (size_t j = 0; j < columns.size(); ++j) pending[j].push_back(values[j]);
+    ++numRows;
+    if (pending[0].size() >= chunkRows) WriteChunk();
+}
+
+void ResultWriter::WriteChunk()
+{
+    const size_t rows = pending[0].size();
+    if (rows == 0) return;
+
+    ResultChunk chunk;
+    chunk.offset = static_cast<uint64_t>(file.tellp());
+    chunk.rows = rows;
+    const auto range = std::minmax_element(pending[0].begin(), pending[0].end());
+    chunk.keyMin = *range.first;
+    chunk.keyMax = *range.second;
+
+    std::vector<float> narrow;
+    for (size_t j = 0; j < columns.size(); ++j) {
+        if (columns[j].type == ResultType::Float32) {
+            narrow.assign(pending[j].begin(), pending[j].end());
+            file.write(reinterpret_cast<const char*>(narrow.data()), rows * sizeof(float));
+            WritePadding(file, rows * sizeof(float));
+        }
+        else {
+            file.write(reinterpret_cast<const char*>(pending[j].data()), rows * sizeof(double));
+        }
+        pending[j].clear();
+    }
+    chunks.push_back(chunk);
+}
+
+bool ResultWriter::Close(std::string& message)
+{
+    if (!IsOpen()) return true;
+
+    WriteChunk();
+    const uint64_t indexOffset = static_cast<uint64_t>(file.tellp());
+    for (const auto& chunk : chunks) {
+        Write(file, chunk.offset);
+        Write(file, chunk.rows);
+        Write(file, chunk.keyMin);
+        Write(file, chunk.keyMax);
+    }
+    Write(file, indexOffset);
+    Write(file, static_cast<uint64_t>(chunks.size()));
+    Write(file, static_cast<uint64_t>(numRows));
+    file.write(FooterMagic, sizeof(FooterMagic));
+
+    const bool written = static_cast<bool>(file);
+    file.close();
+    if (!written) {
+        message = "Writing the result file failed";
+        return false;
+    }
+    return true;
+}
+
+ResultReader::~ResultReader()
+{
+    Close();
+}
+
+bool ResultReader::Open(const std::string& path, std::string& message)
+{
+    Close();
+
+#if defined(_WIN32)
+    const HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fileSize;
+        if (::GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && static_cast<unsigned long long>(fileSize.QuadPart) <= std::numeric_limits<size_t>::max()) {
+            const HANDLE view = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (view) {
+                void* address = ::MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+                if (address) {
+                    mapping = address;
+                    data = static_cast<const unsigned char*>(address);
+                    size = static_cast<size_t>(fileSize.QuadPart);
+                }
+                // The mapped view keeps the mapping open
+                ::CloseHandle(view);
+            }
+        }
+        ::CloseHandle(file);
+    }
+#elif !defined(EMSCRIPTEN)
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor >= 0) {
+        struct stat status;
+        if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+            void* address = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (address != MAP_FAILED) {
+                mapping = address;
+                data = static_cast<const unsigned char*>(address);
+                size = static_cast<size_t>(status.st_size);
+            }
+        }
+        ::close(descriptor);
+    }
+#endif
+
+    if (!mapping) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            message = "Cannot read " + path;
+            return false;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+    }
+
+    if (!Parse(message)) {
+        message = path + ": " + message;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool ResultReader::Parse(std::string& message)
+{
+    if (size < sizeof(HeaderMagic) + FooterSize || std::memcmp(data, HeaderMagic, sizeof(HeaderMagic)) != 0) {
+        message = "Not a result file";
+        return false;
+    }
+    if (std::memcmp(data + size - sizeof(FooterMagic), FooterMagic, sizeof(FooterMagic)) != 0) {
+        message = "The result file has no index, it was not closed";
+        return false;
+    }
+
+    ByteCursor header(data, size, sizeof(HeaderMagic));
+    uint32_t version = 0, numColumns = 0;
+    if (!header.Read(version) || !header.Read(numColumns) || version != Version || numColumns == 0 || numColumns > size) {
+        message = "Unsupported result file version";
+        return false;
+    }
+    columns.resize(numColumns);
+    for (auto& column : columns) {
+        uint8_t type = 0;
+        if (!header.Read(type) || type > static_cast<uint8_t>(ResultType::Float32) || !header.ReadString(column.name) || !header.ReadString(column.unit)) {
+            message = "Corrupt column header";
+            return false;
+        }
+        column.type = static_cast<ResultType>(type);
+    }
+    const size_t dataStart = PadTo8(header.GetPosition());
+
+    ByteCursor footer(data, size, size - FooterSize);
+    uint64_t indexOffset = 0, numChunks = 0, rows = 0;
+    footer.Read(indexOffset);
+    footer.Read(numChunks);
+    footer.Read(rows);
+    // Compared without sums or products of file values, which a crafted file could wrap around
+    const uint64_t indexEnd = size - FooterSize;
+    if (indexOffset < dataStart || indexOffset > indexEnd || (indexEnd - indexOffset) % IndexEntrySize != 0 ||
+        numChunks != (indexEnd - indexOffset) / IndexEntrySize) {
+        message = "Corrupt index";
+        return false;
+    }
+
+    ByteCursor index(data, size, static_cast<size_t>(indexOffset));
+    chunks.resize(static_cast<size_t>(numChunks));
+    uint64_t total = 0;
+    for (auto& chunk : chunks) {
+        index.Read(chunk.offset);
+        index.Read(chunk.rows);
+        index.Read(chunk.keyMin);
+        index.Read(chunk.keyMax);
+
+        // Columns are read in place as doubles and floats, so chunks start on 8 bytes. A row
+        // takes at least 4 bytes per column, which bounds the rows before any product is taken.
+        if (chunk.offset < dataStart || chunk.offset > indexOffset || chunk.offset % 8 != 0 || chunk.rows > (indexOffset - chunk.offset) / 4) {
+            message = "Corrupt index";
+            return false;
+        }
+        const uint64_t room = indexOffset - chunk.offset;
+        uint64_t bytes = 0;
+        for (const auto& column : columns) {
+            bytes += PadTo8(static_cast<size_t>(chunk.rows) * GetTypeSize(column.type));
+            if (bytes > room) {
+                message = "Corrupt index";
+                return false;
+            }
+        }
+        total += chunk.rows;
+    }
+    if (total != rows) {
+        message = "Corrupt index";
+        return false;
+    }
+
+    numRows = static_cast<size_t>(rows);
+    return true;
+}
+
+void ResultReader::Close()
+{
+#if defined(_WIN32)
+    if (mapping) ::UnmapViewOfFile(mapping);
+#elif !defined(EMSCRIPTEN)
+    if (mapping) ::munmap(mapping, size);
+#endif
+    mapping = nullptr;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    data = nullptr;
+    size = 0;
+    columns.clear();
+    chunks.clear();
+    numRows = 0;
+}
+
+int ResultReader::FindColumn(const std::string& name) const
+{
+    for (size_t j = 0; j < columns.size(); ++j) {
+        if (columns[j].name == name) return static_cast<int>(j);
+    }
+    return -1;
+}
+
+const unsigned char* ResultReader::GetColumnData(const ResultChunk& chunk, size_t column) const
+{
+    size_t offset = static_cast<size_t>(chunk.offset);
+    for (size_t j = 0; j < column; ++j) offset += PadTo8(static_cast<size_t>(chunk.rows) * GetTypeSize(columns[j].type));
+    return data + offset;
+}
+
+void ResultReader::ReadColumn(size_t column, std::vector<double>& values) const
+{
+    values.clear();
+    values.reserve(numRows);
+    for (const auto& chunk : chunks) {
+        const unsigned char* source = GetColumnData(chunk, column);
+        const size_t rows = static_cast<size_t>(chunk.rows);
+        if (columns[column].type == ResultType::Float64) {
+            const size_t start = values.size();
+            values.resize(start + rows);
+            std::memcpy(values.data() + start, source, rows * sizeof(double));
+        }
+        else {
+            const float* narrow = reinterpret_cast<const float*>(source);
+            values.insert(values.end(), narrow, narrow + rows);
+        }
+    }
+}
+
+void ResultReader::ReadRange(size_t column, double from, double to, std::vector<double>& values) const
+{
+    values.clear();
+    for (const auto& chunk : chunks) {
+        if (chunk.keyMax < from || chunk.keyMin > to) continue;
+
+        const unsigned char* keys = GetColumnData(chunk, 0);
+        const unsigned char* source = GetColumnData(chunk, column);
+        for (size_t r = 0; r < chunk.rows; ++r) {
+            const double key = columns[0].type == ResultType::Float64
+                ? reinterpret_cast<const double*>(keys)[r] : reinterpret_cast<const float*>(keys)[r];
+            if (key < from || key > to) continue;
+            values.push_back(columns[column].type == ResultType::Float64
+                ? reinterpret_cast<const double*>(source)[r] : reinterpret_cast<const float*>(source)[r]);
+        }
+    }
+}
+
+const double* ResultReader::GetChunkData(size_t chunk, size_t column, size_t& rows) const
+{
+    rows = static_cast<size_t>(chunks[chunk].rows);
+    if (columns[column].type != ResultType::Float64) return nullptr;
+    return reinterpret_cast<const double*>(GetColumnData(chunks[chunk], column));
+}
+
+void ExportCsv(const ResultReader& reader, std::ostream& out)
+{
+    const auto& columns = reader.GetColumns();
+    for (size_t j = 0; j < columns.size(); ++j) {
+        if (j > 0) out << ",";
+        out << columns[j].name;
+        if (!columns[j].unit.empty()) out << " [" << columns[j].unit << "]";
+    }
+    out << "\n";
+
+    std::vector<std::vector<double>> values(columns.size());
+    for (size_t j = 0; j < columns.size(); ++j) reader.ReadColumn(j, values[j]);
+
+    out.precision(std::numeric_limits<double>::max_digits10);
+    for (size_t r = 0; r < reader.GetNumRows(); ++r) {
+        for (size_t j = 0; j < columns.size(); ++j) {
+            if (j > 0) out << ",";
+            out << values[j][r];
+        }
+        out << "\n";
+    }
+}
+
+void ExportJson(const ResultReader& reader, std::ostream& out)
+{
+    const auto& columns = reader.GetColumns();
+    out.precision(std::numeric_limits<double>::max_digits10);
+    out << "{";
+
+    std::vector<double> values;
+    for (size_t j = 0; j < columns.size(); ++j) {
+        reader.ReadColumn(j, values);
+        out << (j > 0 ? ",\n  " : "\n  ") << nlohmann::json(columns[j].name).dump() << ": [";
+        for (size_t r = 0; r < values.size(); ++r) {
+            if (r > 0) out << ",";
+            if (std::isfinite(values[r])) out << values[r];
+            else out << "null";
+        }
+        out << "]";
+    }
+    out << "\n}\n";
+}
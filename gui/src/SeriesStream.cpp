@@ -0,0 +1,40 @@
+#include "SeriesStream.h"
+
+SeriesStream::SeriesStream(size_t numColumns, size_t chunkRows, size_t capacity)
+    : numColumns(numColumns), chunkRows(chunkRows), ring(capacity)
+{
+    pending.reserve(numColumns * chunkRows);
+}
+
+void SeriesStream::Append(const double* values)
+{
+    pending.insert(pending.end(), values, values + numColumns);
+    if (pending.size() >= numColumns * chunkRows) Flush();
+}
+
+bool SeriesStream::Flush()
+{
+    if (pending.empty()) return true;
+    if (!ring.Push(pending)) return false;
+
+    pending = std::vector<double>();
+    pending.reserve(numColumns * chunkRows);
+    return true;
+}
+
+size_t SeriesStream::Drain(std::vector<std::vector<double>>& columns)
+{
+    columns.resize(numColumns);
+
+    size_t rows = 0;
+    std::vector<double> chunk;
+    while (ring.Pop(chunk)) {
+        const size_t count = chunk.size() / numColumns;
+        for (size_t j = 0; j < numColumns; ++j) {
+            auto& column = columns[j];
+            for (size_t r = 0; r < count; ++r) column.push_back(chunk[r * numColumns + j]);
+        }
+        rows += count;
+    }
+    return rows;
+}
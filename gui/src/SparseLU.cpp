@@ -0,0 +1,193 @@
+#include "SparseLU.h"
+
+// STL Includes
+#include <queue>
+#include <functional>
+#include <numeric>
+#include <cmath>
+
+bool SparseLU::Analyze(const SparseMatrix& A)
+{
+    analyzed = false;
+    if (A.rows != A.cols) return false;
+
+    n = A.rows;
+    ++numAnalyses;
+
+    // Eliminate the sparsest rows first to limit fill
+    rowOrder.resize(n);
+    std::iota(rowOrder.begin(), rowOrder.end(), 0);
+    std::stable_sort(rowOrder.begin(), rowOrder.end(), [&](int a, int b) {
+        return A.rowStart[a + 1] - A.rowStart[a] < A.rowStart[b + 1] - A.rowStart[b];
+    });
+
+    std::vector<int> colCount(n, 0);
+    for (int c : A.colIndex) ++colCount[c];
+
+    pivotCol.assign(n, -1);
+    stepOfCol.assign(n, -1);
+    lStart.assign(1, 0);
+    uStart.assign(1, 0);
+    lStep.clear();
+    lValue.clear();
+    uCol.clear();
+    uValue.clear();
+    work.assign(n, 0.0);
+    marked.assign(n, 0);
+
+    std::vector<int> touched;
+    std::priority_queue<int, std::vector<int>, std::greater<int>> pending;
+
+    for (int step = 0; step < n; ++step) {
+        int row = rowOrder[step];
+        touched.clear();
+
+        for (int p = A.rowStart[row]; p < A.rowStart[row + 1]; ++p) {
+            int c = A.colIndex[p];
+            if (!marked[c]) {
+                marked[c] = 1;
+                touched.push_back(c);
+                if (stepOfCol[c] >= 0) pending.push(stepOfCol[c]);
+            }
+            work[c] += A.values[p];
+        }
+
+        // Eliminate against earlier pivots in step order. Fill may add later steps to the queue.
+        while (!pending.empty()) {
+            int k = pending.top();
+            pending.pop();
+
+            int c = pivotCol[k];
+            double multiplier = work[c] / uValue[uStart[k]];
+            work[c] = 0.0;
+            lStep.push_back(k);
+            lValue.push_back(multiplier);
+
+            for (int q = uStart[k] + 1; q < uStart[k + 1]; ++q) {
+                int col = uCol[q];
+                if (!marked[col]) {
+                    marked[col] = 1;
+                    touched.push_back(col);
+                    if (stepOfCol[col] >= 0) pending.push(stepOfCol[col]);
+                }
+                work[col] -= multiplier * uValue[q];
+            }
+        }
+        lStart.push_back(static_cast<int>(lStep.size()));
+
+        // Threshold partial pivoting over the columns that are still free
+        double maxAbs = 0.0;
+        for (int c : touched) {
+            if (stepOfCol[c] < 0) maxAbs = std::max(maxAbs, std::fabs(work[c]));
+        }
+
+        int best = -1;
+        if (maxAbs > 0.0) {
+            for (int c : touched) {
+                if (stepOfCol[c] >= 0 || std::fabs(work[c]) < pivotThreshold * maxAbs) continue;
+                if (best < 0 || colCount[c] < colCount[best] ||
+                    (colCount[c] == colCount[best] && std::fabs(work[c]) > std::fabs(work[best])))
+                    best = c;
+            }
+        }
+
+        if (best < 0) {
+            // Singular, structurally or numerically
+            for (int c : touched) {
+                work[c] = 0.0;
+                marked[c] = 0;
+            }
+            return false;
+        }
+
+        pivotCol[step] = best;
+        stepOfCol[best] = step;
+
+        uCol.push_back(best);
+        uValue.push_back(work[best]);
+        for (int c : touched) {
+            if (c != best && stepOfCol[c] < 0) {
+                uCol.push_back(c);
+                uValue.push_back(work[c]);
+            }
+        }
+        uStart.push_back(static_cast<int>(uCol.size()));
+
+        for (int c : touched) {
+            work[c] = 0.0;
+            marked[c] = 0;
+        }
+    }
+
+    analyzed = true;
+    return true;
+}
+
+bool SparseLU::Factorize(const SparseMatrix& A)
+{
+    if (!analyzed || A.rows != n || A.cols != n) return false;
+
+    for (int step = 0; step < n; ++step) {
+        if (!EliminateRow(A, step)) {
+            analyzed = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SparseLU::EliminateRow(const SparseMatrix& A, int step)
+{
+    int row = rowOrder[step];
+
+    for (int p = A.rowStart[row]; p < A.rowStart[row + 1]; ++p) {
+        work[A.colIndex[p]] += A.values[p];
+    }
+
+    for (int p = lStart[step]; p < lStart[step + 1]; ++p) {
+        int k = lStep[p];
+        int c = pivotCol[k];
+        double multiplier = work[c] / uValue[uStart[k]];
+        work[c] = 0.0;
+        lValue[p] = multiplier;
+
+        for (int q = uStart[k] + 1; q < uStart[k + 1]; ++q) {
+            work[uCol[q]] -= multiplier * uValue[q];
+        }
+    }
+
+    double maxAbs = 0.0;
+    for (int q = uStart[step]; q < uStart[step + 1]; ++q) {
+        uValue[q] = work[uCol[q]];
+        work[uCol[q]] = 0.0;
+        maxAbs = std::max(maxAbs, std::fabs(uValue[q]));
+    }
+
+    double pivot = std::fabs(uValue[uStart[step]]);
+    return pivot > 0.0 && pivot >= refactorThreshold * maxAbs;
+}
+
+void SparseLU::Solve(std::vector<double>& b) const
+{
+    std::vector<double> y(n);
+    for (int step = 0; step < n; ++step) {
+        double sum = b[rowOrder[step]];
+        for (int p = lStart[step]; p < lStart[step + 1]; ++p) {
+            sum -= lValue[p] * y[lStep[p]];
+        }
+        y[step] = sum;
+    }
+
+    for (int step = n - 1; step >= 0; --step) {
+        double sum = y[step];
+        for (int q = uStart[step] + 1; q < uStart[step + 1]; ++q) {
+            sum -= uValue[q] * b[uCol[q]];
+        }
+        b[pivotCol[step]] = sum / uValue[uStart[step]];
+    }
+}
+
+int SparseLU::GetFillIn() const
+{
+    return static_cast<int>(lValue.size() + uValue.size());
+}
@@ -0,0 +1,281 @@
+#include "SpatialGrid.h"
+
+// STL Includes
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::Clear()
+{
+    cells.clear();
+    slotNodes.clear();
+    minX.clear();
+    minY.clear();
+    maxX.clear();
+    maxY.clear();
+    orders.clear();
+    ranges.clear();
+    longLinks.clear();
+    nextOrder = 0;
+    numNodes = 0;
+}
+
+void SpatialGrid::Rebuild(const std::vector<std::unique_ptr<Node>>& nodes)
+{
+    Clear();
+    for (const auto& node : nodes) Insert(node.get());
+}
+
+void SpatialGrid::Insert(Node* node)
+{
+    if (!node || node->slot == NodeHandle::NoSlot || IsListed(node)) return;
+
+    const uint32_t slot = node->slot;
+    if (slot >= slotNodes.size()) {
+        const size_t size = slot + 1;
+        slotNodes.resize(size, nullptr);
+        minX.resize(size);
+        minY.resize(size);
+        maxX.resize(size);
+        maxY.resize(size);
+        orders.resize(size);
+        ranges.resize(size);
+    }
+
+    // The slot may still list a unit that left the flowsheet without being removed
+    if (slotNodes[slot]) {
+        RemoveFromCells(slot, ranges[slot]);
+        --numNodes;
+    }
+
+    slotNodes[slot] = node;
+    orders[slot] = nextOrder++;
+    SetBounds(slot, *node);
+    ranges[slot] = GetRange(slot);
+    AddToCells(slot, ranges[slot]);
+    ++numNodes;
+    UpdateConnections(*node);
+}
+
+void SpatialGrid::Update(Node* node)
+{
+    if (!IsListed(node)) {
+        Insert(node);
+        return;
+    }
+
+    const uint32_t slot = node->slot;
+    SetBounds(slot, *node);
+    UpdateConnections(*node);
+    const CellRange range = GetRange(slot);
+    if (range == ranges[slot]) return;
+    RemoveFromCells(slot, ranges[slot]);
+    AddToCells(slot, range);
+    ranges[slot] = range;
+}
+
+void SpatialGrid::Remove(Node* node)
+{
+    if (!IsListed(node)) return;
+    for (auto& point : node->outputs) longLinks.erase(&point);
+    RemoveFromCells(node->slot, ranges[node->slot]);
+    slotNodes[node->slot] = nullptr;
+    --numNodes;
+}
+
+void SpatialGrid::QueryPoint(const Vec2& point, std::vector<Node*>& nodes) const
+{
+    nodes.clear();
+    const std::vector<uint32_t>* slots = GetSlots(point);
+    if (!slots) return;
+
+    scratch.clear();
+    for (uint32_t slot : *slots) scratch.emplace_back(orders[slot], slot);
+    std::sort(scratch.begin(), scratch.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (const auto& item : scratch) nodes.push_back(slotNodes[item.second]);
+}
+
+void SpatialGrid::QueryRect(const Vec2& min, const Vec2& max, std::vector<Node*>& nodes) const
+{
+    nodes.clear();
+    scratch.clear();
+
+    // A rectangle covering more cells than there are units, zoomed far out, is cheaper to
+    // answer by streaming through the bounds
+    const double numCells = (static_cast<double>(GetCell(max.x)) - GetCell(min.x) + 1.0) * (static_cast<double>(GetCell(max.y)) - GetCell(min.y) + 1.0);
+    if (numCells > static_cast<double>(numNodes)) {
+        for (uint32_t slot = 0; slot < slotNodes.size(); ++slot) {
+            if (slotNodes[slot] && Overlaps(slot, min, max)) scratch.emplace_back(orders[slot], slot);
+        }
+    }
+    else {
+        for (int x = GetCell(min.x); x <= GetCell(max.x); ++x) {
+            for (int y = GetCell(min.y); y <= GetCell(max.y); ++y) {
+                auto cell = cells.find(GetKey(x, y));
+                if (cell == cells.end()) continue;
+                for (uint32_t slot : cell->second) {
+                    if (Overlaps(slot, min, max)) scratch.emplace_back(orders[slot], slot);
+                }
+            }
+        }
+    }
+
+    // Units spanning several cells are listed in each of them
+    std::sort(scratch.begin(), scratch.end());
+    scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+    for (const auto& item : scratch) nodes.push_back(slotNodes[item.second]);
+}
+
+void SpatialGrid::UpdateConnection(Connection* connection)
+{
+    if (!connection || !connection->from || !connection->to) return;
+    const Vec2 a = connection->from->node->GetConnectionPointPos(*connection->from);
+    const Vec2 b = connection->to->node->GetConnectionPointPos(*connection->to);
+    if (std::fabs(a.x - b.x) > linkReach || std::fabs(a.y - b.y) > linkReach) longLinks.insert(connection->from);
+    else longLinks.erase(connection->from);
+}
+
+void SpatialGrid::QueryConnections(const Vec2& min, const Vec2& max, std::vector<Connection*>& connections) const
+{
+    connections.clear();
+    auto overlaps = [&](const Connection& connection) {
+        const Vec2 a = connection.from->node->GetConnectionPointPos(*connection.from);
+        const Vec2 b = connection.to->node->GetConnectionPointPos(*connection.to);
+        return std::max(a.x, b.x) >= min.x && std::min(a.x, b.x) <= max.x && std::max(a.y, b.y) >= min.y && std::min(a.y, b.y) <= max.y;
+    };
+
+    // A stream up to linkReach long that overlaps the rectangle has its outlet within linkReach of it
+    const Vec2 reach(linkReach, linkReach);
+    QueryRect(min - reach, max + reach, nearNodes);
+    for (const Node* node : nearNodes) {
+        node->GetOutgoing(adjacent);
+        for (Connection* connection : adjacent) {
+            if (connection->to && !longLinks.count(connection->from) && overlaps(*connection)) connections.push_back(connection);
+        }
+    }
+
+    // Outlets whose stream was removed since are skipped
+    for (ConnectionPoint* point : longLinks) {
+        Connection* connection = point->connection;
+        if (connection && connection->from == point && connection->to && overlaps(*connection)) connections.push_back(connection);
+    }
+
+    std::sort(connections.begin(), connections.end(), [](const Connection* a, const Connection* b) { return a->index < b->index; });
+}
+
+Node* SpatialGrid::FindNodeAt(const Vec2& point) const
+{
+    const std::vector<uint32_t>* slots = GetSlots(point);
+    if (!slots) return nullptr;
+
+    uint32_t top = NodeHandle::NoSlot;
+    for (uint32_t slot : *slots) {
+        if (Contains(slot, point) && (top == NodeHandle::NoSlot || orders[slot] > orders[top])) top = slot;
+    }
+    return top != NodeHandle::NoSlot ? slotNodes[top] : nullptr;
+}
+
+ConnectionPoint* SpatialGrid::FindNearestPort(const Vec2& point, float maxDist, bool inputsOnly, bool outputsOnly, const Node* exclude) const
+{
+    const std::vector<uint32_t>* slots = GetSlots(point);
+    if (!slots) return nullptr;
+
+    // Squared distances, no square root per port
+    const float limit = std::min(maxDist, margin);
+    float minDistSq = limit * limit;
+    ConnectionPoint* nearest = nullptr;
+
+    for (uint32_t slot : *slots) {
+        // Ports lie on the bounds, a unit further away than the limit has none in reach
+        if (point.x < minX[slot] - limit || point.x > maxX[slot] + limit || point.y < minY[slot] - limit || point.y > maxY[slot] + limit) continue;
+
+        Node* node = slotNodes[slot];
+        if (node == exclude) continue;
+        for (auto* points : { &node->outputs, &node->inputs }) {
+            if ((points == &node->outputs && inputsOnly) || (points == &node->inputs && outputsOnly)) continue;
+            for (auto& port : *points) {
+                const Vec2 delta = node->GetConnectionPointPos(port) - point;
+                const float distSq = delta.x * delta.x + delta.y * delta.y;
+                if (distSq < minDistSq) {
+                    minDistSq = distSq;
+                    nearest = &port;
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+int SpatialGrid::GetCell(float coordinate) const
+{
+    return static_cast<int>(std::floor(coordinate / cellSize));
+}
+
+SpatialGrid::CellRange SpatialGrid::GetRange(uint32_t slot) const
+{
+    CellRange range;
+    range.x0 = GetCell(minX[slot] - margin);
+    range.y0 = GetCell(minY[slot] - margin);
+    range.x1 = GetCell(maxX[slot] + margin);
+    range.y1 = GetCell(maxY[slot] + margin);
+    return range;
+}
+
+void SpatialGrid::SetBounds(uint32_t slot, const Node& node)
+{
+    minX[slot] = node.pos.x;
+    minY[slot] = node.pos.y;
+    maxX[slot] = node.pos.x + node.size.x;
+    maxY[slot] = node.pos.y + node.size.y;
+}
+
+bool SpatialGrid::Overlaps(uint32_t slot, const Vec2& min, const Vec2& max) const
+{
+    return minX[slot] - margin <= max.x && maxX[slot] + margin >= min.x &&
+        minY[slot] - margin <= max.y && maxY[slot] + margin >= min.y;
+}
+
+bool SpatialGrid::Contains(uint32_t slot, const Vec2& point) const
+{
+    return point.x >= minX[slot] && point.x <= maxX[slot] && point.y >= minY[slot] && point.y <= maxY[slot];
+}
+
+void SpatialGrid::UpdateConnections(const Node& node)
+{
+    node.GetIncoming(adjacent);
+    for (Connection* connection : adjacent) UpdateConnection(connection);
+    node.GetOutgoing(adjacent);
+    for (Connection* connection : adjacent) UpdateConnection(connection);
+}
+
+void SpatialGrid::AddToCells(uint32_t slot, const CellRange& range)
+{
+    for (int x = range.x0; x <= range.x1; ++x) {
+        for (int y = range.y0; y <= range.y1; ++y) {
+            cells[GetKey(x, y)].push_back(slot);
+        }
+    }
+}
+
+void SpatialGrid::RemoveFromCells(uint32_t slot, const CellRange& range)
+{
+    for (int x = range.x0; x <= range.x1; ++x) {
+        for (int y = range.y0; y <= range.y1; ++y) {
+            auto cell = cells.find(GetKey(x, y));
+            if (cell == cells.end()) continue;
+
+            auto& slots = cell->second;
+            auto item = std::find(slots.begin(), slots.end(), slot);
+            if (item != slots.end()) {
+                *item = slots.back();
+                slots.pop_back();
+            }
+            if (slots.empty()) cells.erase(cell);
+        }
+    }
+}
+
+const std::vector<uint32_t>* SpatialGrid::GetSlots(const Vec2& point) const
+{
+    auto cell = cells.find(GetKey(GetCell(point.x), GetCell(point.y)));
+    return cell != cells.end() ? &cell->second : nullptr;
+}
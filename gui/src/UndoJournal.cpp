@@ -0,0 +1,284 @@
+#include "UndoJournal.h"
+
+// STL Includes
+#include <unordered_set>
+#include <algorithm>
+
+namespace
+{
+    // Moves the elements at indices, ascending, out of items into out, closing the gaps. Only
+    // the elements after the first index move.
+    template <class T>
+    void TakeAt(std::vector<std::unique_ptr<T>>& items, const std::vector<size_t>& indices, std::vector<std::unique_ptr<T>>& out)
+    {
+        out.clear();
+        if (indices.empty()) return;
+        out.reserve(indices.size());
+
+        size_t write = indices.front();
+        size_t next = 0;
+        for (size_t read = write; read < items.size(); ++read) {
+            if (next < indices.size() && indices[next] == read) {
+                out.push_back(std::move(items[read]));
+                ++next;
+            }
+            else {
+                items[write++] = std::move(items[read]);
+            }
+        }
+        items.resize(write);
+    }
+
+    // Puts the elements TakeAt took back where they were
+    template <class T>
+    void PutAt(std::vector<std::unique_ptr<T>>& items, const std::vector<size_t>& indices, std::vector<std::unique_ptr<T>>& in)
+    {
+        size_t read = items.size();
+        items.resize(items.size() + in.size());
+        size_t next = in.size();
+        for (size_t write = items.size(); next > 0 && write-- > 0;) {
+            if (indices[next - 1] == write) items[write] = std::move(in[--next]);
+            else items[write] = std::move(items[--read]);
+        }
+        in.clear();
+    }
+
+    size_t GetNodeBytes(const Node& node)
+    {
+        size_t bytes = sizeof(Node) + node.name.capacity() + node.type.capacity() + node.imagePath.capacity();
+        for (auto* points : { &node.inputs, &node.outputs }) {
+            for (const auto& point : *points) bytes += sizeof(ConnectionPoint) + point.name.capacity();
+        }
+        for (const auto& variable : node.data) bytes += sizeof(DoubleDataVariable) + variable.parameter.capacity() + variable.unit.capacity();
+        return bytes;
+    }
+}
+
+void UndoJournal::RecordAdd(const Flowsheet& flowsheet, Node* node)
+{
+    Step step;
+    step.kind = Kind::Add;
+    step.nodes.push_back(node);
+    step.indices.push_back(flowsheet.nodes.size() - 1);
+    Push(std::move(step));
+}
+
+void UndoJournal::RecordConnect(Connection* connection)
+{
+    Step step;
+    step.kind = Kind::Connect;
+    step.links.push_back({ connection->from, connection->to, connection->index });
+    Push(std::move(step));
+}
+
+void UndoJournal::RecordMove(std::vector<Move> moves)
+{
+    if (moves.empty()) return;
+    Step step;
+    step.kind = Kind::Move;
+    step.moves = std::move(moves);
+    Push(std::move(step));
+}
+
+void UndoJournal::RecordValue(Node* node, size_t variable, double oldValue, bool oldSelected)
+{
+    const DoubleDataVariable& current = node->data[variable];
+    if (isOpen && !done.empty()) {
+        Step& last = done.back();
+        if (last.kind == Kind::Value && last.node == node && last.variable == variable) {
+            last.values[1] = current.value;
+            last.selected[1] = current.isSelected;
+            return;
+        }
+    }
+
+    Step step;
+    step.kind = Kind::Value;
+    step.node = node;
+    step.variable = variable;
+    step.values[0] = oldValue;
+    step.values[1] = current.value;
+    step.selected[0] = oldSelected;
+    step.selected[1] = current.isSelected;
+    Push(std::move(step));
+}
+
+void UndoJournal::RecordRename(Node* node, const std::string& oldName)
+{
+    if (isOpen && !done.empty()) {
+        Step& last = done.back();
+        if (last.kind == Kind::Rename && last.node == node) {
+            last.names[1] = node->name;
+            return;
+        }
+    }
+
+    Step step;
+    step.kind = Kind::Rename;
+    step.node = node;
+    step.names[0] = oldName;
+    step.names[1] = node->name;
+    Push(std::move(step));
+}
+
+void UndoJournal::DeleteNodes(Flowsheet& flowsheet, const std::vector<Node*>& nodes)
+{
+    if (nodes.empty()) return;
+    const std::unordered_set<Node*> deleted(nodes.begin(), nodes.end());
+
+    Step step;
+    step.kind = Kind::Delete;
+    for (size_t i = 0; i < flowsheet.nodes.size(); ++i) {
+        if (deleted.count(flowsheet.nodes[i].get())) {
+            step.nodes.push_back(flowsheet.nodes[i].get());
+            step.indices.push_back(i);
+        }
+    }
+
+    // The streams of the units come from their ports. A stream between two deleted units is
+    // found from both ends.
+    std::vector<Connection*> adjacent;
+    for (Node* node : nodes) {
+        node->GetIncoming(adjacent);
+        for (Connection* connection : adjacent) step.links.push_back({ connection->from, connection->to, connection->index });
+        node->GetOutgoing(adjacent);
+        for (Connection* connection : adjacent) step.links.push_back({ connection->from, connection->to, connection->index });
+    }
+    std::sort(step.links.begin(), step.links.end(), [](const Link& a, const Link& b) { return a.index < b.index; });
+    step.links.erase(std::unique(step.links.begin(), step.links.end(), [](const Link& a, const Link& b) { return a.index == b.index; }), step.links.end());
+
+    JournalChange change;
+    Apply(flowsheet, step, true, change);
+    Push(std::move(step));
+}
+
+bool UndoJournal::Undo(Flowsheet& flowsheet, JournalChange& change)
+{
+    change = JournalChange();
+    if (done.empty()) return false;
+    Seal();
+
+    Step step = std::move(done.back());
+    done.pop_back();
+    Apply(flowsheet, step, false, change);
+    undone.push_back(std::move(step));
+    return true;
+}
+
+bool UndoJournal::Redo(Flowsheet& flowsheet, JournalChange& change)
+{
+    change = JournalChange();
+    if (undone.empty()) return false;
+    Seal();
+
+    Step step = std::move(undone.back());
+    undone.pop_back();
+    Apply(flowsheet, step, true, change);
+    done.push_back(std::move(step));
+    return true;
+}
+
+void UndoJournal::Clear()
+{
+    done.clear();
+    undone.clear();
+    numBytes = 0;
+    isOpen = false;
+}
+
+void UndoJournal::Push(Step step)
+{
+    // A new edit ends the redo history
+    for (const auto& old : undone) numBytes -= old.bytes;
+    undone.clear();
+
+    step.bytes = GetBytes(step);
+    numBytes += step.bytes;
+    done.push_back(std::move(step));
+    isOpen = true;
+
+    // Keep at least the step just made
+    while (numBytes > maxBytes && done.size() > 1) {
+        numBytes -= done.front().bytes;
+        done.pop_front();
+    }
+}
+
+void UndoJournal::Apply(Flowsheet& flowsheet, Step& step, bool redo, JournalChange& change)
+{
+    // Taking connections out destroys them, which detaches their ports. Putting them back
+    // makes new ones on the same ports.
+    auto takeLinks = [&]() {
+        std::vector<size_t> indices;
+        for (const auto& link : step.links) indices.push_back(link.index);
+        std::vector<std::unique_ptr<Connection>> taken;
+        TakeAt(flowsheet.connections, indices, taken);
+        if (!indices.empty()) flowsheet.RenumberConnections(indices.front());
+    };
+    auto putLinks = [&]() {
+        std::vector<size_t> indices;
+        std::vector<std::unique_ptr<Connection>> made;
+        for (const auto& link : step.links) {
+            indices.push_back(link.index);
+            made.push_back(std::make_unique<Connection>(link.from, link.to));
+        }
+        for (const auto& connection : made) change.connected.push_back(connection.get());
+        PutAt(flowsheet.connections, indices, made);
+        if (!indices.empty()) flowsheet.RenumberConnections(indices.front());
+    };
+
+    switch (step.kind) {
+    case Kind::Add:
+    case Kind::Delete: {
+        // Redoing an add and undoing a delete both put the units back
+        const bool putBack = (step.kind == Kind::Add) == redo;
+        if (putBack) {
+            PutAt(flowsheet.nodes, step.indices, step.removed);
+            for (Node* node : step.nodes) flowsheet.Attach(node);
+            if (step.kind == Kind::Delete) putLinks();
+            change.added = step.nodes;
+        }
+        else {
+            if (step.kind == Kind::Delete) takeLinks();
+            TakeAt(flowsheet.nodes, step.indices, step.removed);
+            for (Node* node : step.nodes) flowsheet.Detach(node);
+            change.removed = step.nodes;
+        }
+        change.edited = true;
+        break;
+    }
+    case Kind::Connect:
+        if (redo) putLinks();
+        else takeLinks();
+        change.edited = true;
+        break;
+    case Kind::Move:
+        for (const auto& move : step.moves) {
+            move.node->pos = redo ? move.to : move.from;
+            change.moved.push_back(move.node);
+        }
+        break;
+    case Kind::Value: {
+        DoubleDataVariable& variable = step.node->data[step.variable];
+        variable.value = step.values[redo ? 1 : 0];
+        variable.isSelected = step.selected[redo ? 1 : 0];
+        step.node->isDirty = true;
+        change.edited = true;
+        break;
+    }
+    case Kind::Rename:
+        step.node->name = step.names[redo ? 1 : 0];
+        break;
+    }
+}
+
+size_t UndoJournal::GetBytes(const Step& step)
+{
+    size_t bytes = sizeof(Step) + step.nodes.capacity() * sizeof(Node*) + step.indices.capacity() * sizeof(size_t) +
+        step.links.capacity() * sizeof(Link) + step.moves.capacity() * sizeof(Move) +
+        step.names[0].capacity() + step.names[1].capacity();
+
+    // Added units are only held while undone, deleted ones while done. Count them either way.
+    for (const Node* node : step.nodes) bytes += GetNodeBytes(*node);
+    return bytes;
+}
@@ -0,0 +1,109 @@
+#include "WorkStealingPool.h"
+
+// STL Includes
+#include <thread>
+#include <exception>
+
+WorkStealingPool::WorkStealingPool(size_t numWorkers)
+    : numWorkers(numWorkers > 0 ? numWorkers : 1), queues(this->numWorkers)
+{
+}
+
+bool WorkStealingPool::Pop(size_t worker, int& task)
+{
+    WorkerQueue& queue = queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::Steal(size_t worker)
+{
+    // Retry while any deque still holds work, a victim may be drained between the scan and the lock
+    while (true) {
+        size_t victim = worker;
+        size_t largest = 0;
+        for (size_t i = 1; i < numWorkers; ++i) {
+            size_t candidate = (worker + i) % numWorkers;
+            std::lock_guard<std::mutex> lock(queues[candidate].mutex);
+            if (queues[candidate].tasks.size() > largest) {
+                largest = queues[candidate].tasks.size();
+                victim = candidate;
+            }
+        }
+        if (largest == 0) return false;
+
+        std::deque<int> stolen;
+        {
+            std::lock_guard<std::mutex> lock(queues[victim].mutex);
+            auto& tasks = queues[victim].tasks;
+            if (tasks.empty()) continue;
+            size_t count = (tasks.size() + 1) / 2;
+            stolen.assign(tasks.end() - count, tasks.end());
+            tasks.erase(tasks.end() - count, tasks.end());
+        }
+
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        queues[worker].tasks.insert(queues[worker].tasks.end(), stolen.begin(), stolen.end());
+        ++numSteals;
+        return true;
+    }
+}
+
+void WorkStealingPool::WorkerLoop(size_t worker, const std::function<void(int, int)>& task)
+{
+    // Tasks never create tasks, so once every deque is empty the batch is done
+    int next = 0;
+    while (!aborted) {
+        if (!Pop(worker, next)) {
+            if (!Steal(worker)) return;
+            continue;
+        }
+        task(next, static_cast<int>(worker));
+    }
+}
+
+void WorkStealingPool::Run(const std::vector<int>& order, const std::function<void(int, int)>& task)
+{
+    aborted = false;
+    numSteals = 0;
+
+    // Contiguous chunks keep neighbouring tasks on one worker
+    for (size_t w = 0; w < numWorkers; ++w) {
+        size_t begin = order.size() * w / numWorkers;
+        size_t end = order.size() * (w + 1) / numWorkers;
+        queues[w].tasks.assign(order.begin() + begin, order.begin() + end);
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+    auto guardedLoop = [&](size_t worker) {
+        try {
+            WorkerLoop(worker, task);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError) firstError = std::current_exception();
+            aborted = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers - 1);
+    for (size_t w = 1; w < numWorkers; ++w) {
+        threads.emplace_back(guardedLoop, w);
+    }
+    guardedLoop(0);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto& queue : queues) {
+        queue.tasks.clear();
+    }
+
+    if (firstError) std::rethrow_exception(firstError);
+}
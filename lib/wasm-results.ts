@@ -0,0 +1,53 @@
+// Result buffers published by the WASM app (gui/include/ResultBuffers.h), read in place from its
+// heap instead of being serialised to text.
+
+export interface ResultColumn {
+  name: string;
+  unit: string;
+}
+
+export interface ResultBufferInfo {
+  handle: number;
+  name: string;
+  rows: number;
+  columns: ResultColumn[];
+}
+
+// The parts of the Emscripten module the results API needs
+export interface ResultModule {
+  ccall: (name: string, returnType: string | null, argTypes: string[], args: unknown[]) => any;
+  UTF8ToString: (pointer: number) => string;
+  HEAPF64: Float64Array;
+}
+
+export interface PinnedResult {
+  info: ResultBufferInfo;
+  // Views on the current heap: every column one after the other, or one column by name. Make
+  // them again after every await, the app keeps running and growing its heap detaches old views.
+  data: () => Float64Array;
+  column: (name: string) => Float64Array | undefined;
+}
+
+export function listResults(module: ResultModule): ResultBufferInfo[] {
+  return JSON.parse(module.UTF8ToString(module.ccall('thermatix_result_manifest', 'number', [], [])));
+}
+
+// Pins the buffer, so its address stays valid, until use settles
+export async function withResult<T>(module: ResultModule, name: string, use: (result: PinnedResult) => Promise<T> | T): Promise<T | undefined> {
+  const info = listResults(module).find((entry) => entry.name === name);
+  if (!info || !module.ccall('thermatix_result_pin', 'number', ['number'], [info.handle])) {
+    return undefined;
+  }
+
+  try {
+    const pointer: number = module.ccall('thermatix_result_data', 'number', ['number'], [info.handle]);
+    const data = () => new Float64Array(module.HEAPF64.buffer, pointer, info.rows * info.columns.length);
+    const column = (name: string) => {
+      const j = info.columns.findIndex((entry) => entry.name === name);
+      return j < 0 ? undefined : new Float64Array(module.HEAPF64.buffer, pointer + 8 * j * info.rows, info.rows);
+    };
+    return await use({ info, data, column });
+  } finally {
+    module.ccall('thermatix_result_unpin', null, ['number'], [info.handle]);
+  }
+}
@@ -11,6 +11,18 @@ const nextConfig = {
       },
     ],
   },
+  // The WASM app runs its solvers on pthreads, which need SharedArrayBuffer, so the app and the
+  // page embedding it are served cross-origin isolated
+  async headers() {
+    const isolated = [
+      { key: 'Cross-Origin-Opener-Policy', value: 'same-origin' },
+      { key: 'Cross-Origin-Embedder-Policy', value: 'require-corp' },
+    ]
+    return [
+      { source: '/wasm_app/:path*', headers: isolated },
+      { source: '/protected', headers: isolated },
+    ]
+  },
 }
 
 module.exports = nextConfig 
\ No newline at end of file
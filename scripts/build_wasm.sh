@@ -52,4 +52,9 @@ cp -f build_wasm/thermo_plot.js   "$PROJECT_ROOT/public/wasm_app/"
 cp -f build_wasm/thermo_plot.wasm "$PROJECT_ROOT/public/wasm_app/"
 cp -f build_wasm/thermo_plot.data "$PROJECT_ROOT/public/wasm_app/"
 
+# Older Emscripten versions start the pthreads from a separate script
+if [ -f build_wasm/thermo_plot.worker.js ]; then
+    cp -f build_wasm/thermo_plot.worker.js "$PROJECT_ROOT/public/wasm_app/"
+fi
+
 echo "Build and copy complete!"
\ No newline at end of file